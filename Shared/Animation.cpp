@@ -0,0 +1,339 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Animation.h"
+
+using namespace DirectX;
+
+using namespace VSD3DStarter;
+
+#pragma region AnimationClip
+
+void AnimationClip::Initialize(const Mesh::AnimClip& clip, const std::vector<Mesh::BoneInfo>& bones)
+{
+    m_startTime = clip.StartTime;
+    m_endTime = clip.EndTime;
+
+    //
+    // bucket the flat keyframe list by bone, keeping each bucket sorted by time
+    //
+    std::vector<std::vector<const Mesh::Keyframe*>> boneKeys(bones.size());
+    for (const Mesh::Keyframe& keyframe : clip.Keyframes)
+    {
+        if (keyframe.BoneIndex < bones.size())
+        {
+            boneKeys[keyframe.BoneIndex].push_back(&keyframe);
+        }
+    }
+
+    m_tracks.clear();
+    m_tracks.resize(bones.size());
+
+    for (size_t b = 0; b < bones.size(); b++)
+    {
+        std::vector<const Mesh::Keyframe*>& keys = boneKeys[b];
+        std::stable_sort(keys.begin(), keys.end(), [] (const Mesh::Keyframe* a, const Mesh::Keyframe* b)
+        {
+            return a->Time < b->Time;
+        });
+
+        AnimationTrack& track = m_tracks[b];
+        size_t keyCount = std::max<size_t>(keys.size(), 1);
+        track.Times.reserve(keyCount);
+        track.Rotations.reserve(keyCount);
+        track.Translations.reserve(keyCount);
+        track.Scales.reserve(keyCount);
+
+        XMVECTOR previousRotation = XMQuaternionIdentity();
+
+        for (size_t k = 0; k < keyCount; k++)
+        {
+            //
+            // bones without keys in this clip hold their bind-time local transform
+            //
+            const XMFLOAT4X4& transform = keys.empty() ? bones[b].BoneLocalTransform : keys[k]->Transform;
+            float time = keys.empty() ? m_startTime : keys[k]->Time;
+
+            XMVECTOR scale, rotation, translation;
+            if (!XMMatrixDecompose(&scale, &rotation, &translation, XMLoadFloat4x4(&transform)))
+            {
+                scale = XMVectorSplatOne();
+                rotation = XMQuaternionIdentity();
+                translation = XMLoadFloat4x4(&transform).r[3];
+            }
+
+            //
+            // keep consecutive quaternions in the same hemisphere so interpolation takes the short arc
+            //
+            rotation = XMQuaternionNormalize(rotation);
+            if (k > 0 && XMVectorGetX(XMQuaternionDot(previousRotation, rotation)) < 0.0f)
+            {
+                rotation = XMVectorNegate(rotation);
+            }
+            previousRotation = rotation;
+
+            XMFLOAT4 r;
+            XMFLOAT3 t, s;
+            XMStoreFloat4(&r, rotation);
+            XMStoreFloat3(&t, translation);
+            XMStoreFloat3(&s, scale);
+
+            track.Times.push_back(time);
+            track.Rotations.push_back(r);
+            track.Translations.push_back(t);
+            track.Scales.push_back(s);
+        }
+    }
+}
+
+void AnimationClip::SampleLocalPose(float time, std::vector<UINT>& cursors, AnimationPose& pose) const
+{
+    UINT boneCount = BoneCount();
+    for (UINT b = 0; b < boneCount; b++)
+    {
+        const AnimationTrack& track = m_tracks[b];
+        UINT keyCount = track.KeyCount();
+
+        //
+        // move the cached cursor forward; only a wrap or a seek backwards restarts it
+        //
+        UINT k = cursors[b];
+        if (k >= keyCount || track.Times[k] > time)
+        {
+            k = 0;
+        }
+        while (k + 1 < keyCount && track.Times[k + 1] <= time)
+        {
+            k++;
+        }
+        cursors[b] = k;
+
+        if (k + 1 >= keyCount || time <= track.Times[k])
+        {
+            pose.Rotations[b] = track.Rotations[k];
+            pose.Translations[b] = track.Translations[k];
+            pose.Scales[b] = track.Scales[k];
+            continue;
+        }
+
+        float t = (time - track.Times[k]) / (track.Times[k + 1] - track.Times[k]);
+
+        XMVECTOR rotation = XMQuaternionSlerp(XMLoadFloat4(&track.Rotations[k]), XMLoadFloat4(&track.Rotations[k + 1]), t);
+        XMVECTOR translation = XMVectorLerp(XMLoadFloat3(&track.Translations[k]), XMLoadFloat3(&track.Translations[k + 1]), t);
+        XMVECTOR scale = XMVectorLerp(XMLoadFloat3(&track.Scales[k]), XMLoadFloat3(&track.Scales[k + 1]), t);
+
+        XMStoreFloat4(&pose.Rotations[b], rotation);
+        XMStoreFloat3(&pose.Translations[b], translation);
+        XMStoreFloat3(&pose.Scales[b], scale);
+    }
+}
+
+#pragma endregion
+
+#pragma region AnimationSet
+
+void AnimationSet::Initialize(Mesh& mesh, const AnimationCompressionSettings* compression)
+{
+    std::vector<Mesh::BoneInfo>& bones = mesh.BoneInfoCollection();
+    UINT boneCount = static_cast<UINT>(bones.size());
+
+    m_parents.resize(boneCount);
+    m_inverseBindPoses.resize(boneCount);
+    for (UINT b = 0; b < boneCount; b++)
+    {
+        INT parent = bones[b].ParentIndex;
+        m_parents[b] = (parent >= 0 && static_cast<UINT>(parent) < boneCount && static_cast<UINT>(parent) != b) ? parent : -1;
+        m_inverseBindPoses[b] = bones[b].InvBindPos;
+    }
+
+    //
+    // order the bones so that every parent is evaluated before its children
+    //
+    m_evaluationOrder.clear();
+    m_evaluationOrder.reserve(boneCount);
+    std::vector<bool> emitted(boneCount, false);
+
+    bool progress = true;
+    while (m_evaluationOrder.size() < boneCount)
+    {
+        if (!progress)
+        {
+            //
+            // the remaining bones form a cycle; break it by promoting the first one to a root
+            //
+            for (UINT b = 0; b < boneCount; b++)
+            {
+                if (!emitted[b])
+                {
+                    m_parents[b] = -1;
+                    break;
+                }
+            }
+        }
+
+        progress = false;
+        for (UINT b = 0; b < boneCount; b++)
+        {
+            if (!emitted[b] && (m_parents[b] < 0 || emitted[m_parents[b]]))
+            {
+                emitted[b] = true;
+                m_evaluationOrder.push_back(b);
+                progress = true;
+            }
+        }
+    }
+
+    m_clips.clear();
+    m_compressedClips.clear();
+    for (auto& clip : mesh.AnimationClips())
+    {
+        if (compression != nullptr)
+        {
+            AnimationClip source;
+            source.Initialize(clip.second, bones);
+            m_compressedClips[clip.first].Compress(source, *compression);
+        }
+        else
+        {
+            m_clips[clip.first].Initialize(clip.second, bones);
+        }
+    }
+}
+
+const AnimationClip* AnimationSet::FindClip(const std::wstring& name) const
+{
+    auto iter = m_clips.find(name);
+    return (iter != m_clips.end()) ? &iter->second : nullptr;
+}
+
+const CompressedAnimationClip* AnimationSet::FindCompressedClip(const std::wstring& name) const
+{
+    auto iter = m_compressedClips.find(name);
+    return (iter != m_compressedClips.end()) ? &iter->second : nullptr;
+}
+
+#pragma endregion
+
+#pragma region AnimationPlayer
+
+void AnimationPlayer::Initialize(const AnimationSet* set)
+{
+    m_set = set;
+    m_clip = nullptr;
+    m_compressedClip = nullptr;
+    m_time = 0.0f;
+
+    UINT boneCount = (set != nullptr) ? set->BoneCount() : 0;
+
+    XMFLOAT4X4 identity;
+    XMStoreFloat4x4(&identity, XMMatrixIdentity());
+
+    m_cursors.assign(boneCount, 0);
+    m_pose.Resize(boneCount);
+    m_boneTransforms.assign(boneCount, identity);
+    m_palette.assign(boneCount, identity);
+}
+
+bool AnimationPlayer::Play(const std::wstring& clipName, bool loop)
+{
+    if (m_set == nullptr)
+    {
+        return false;
+    }
+
+    const AnimationClip* clip = m_set->FindClip(clipName);
+    const CompressedAnimationClip* compressedClip = m_set->FindCompressedClip(clipName);
+
+    if (clip != nullptr && clip->BoneCount() == m_set->BoneCount())
+    {
+        m_time = clip->StartTime();
+        m_cursors.assign(clip->BoneCount(), 0);
+        compressedClip = nullptr;
+    }
+    else if (compressedClip != nullptr && compressedClip->BoneCount() == m_set->BoneCount())
+    {
+        m_time = compressedClip->StartTime();
+        m_cursors.assign(compressedClip->CursorCount(), 0);
+        clip = nullptr;
+    }
+    else
+    {
+        return false;
+    }
+
+    m_clip = clip;
+    m_compressedClip = compressedClip;
+    m_loop = loop;
+    return true;
+}
+
+void AnimationPlayer::Update(float timeDelta)
+{
+    if (!IsPlaying())
+    {
+        return;
+    }
+
+    float startTime = m_clip ? m_clip->StartTime() : m_compressedClip->StartTime();
+    float endTime = m_clip ? m_clip->EndTime() : m_compressedClip->EndTime();
+
+    m_time += timeDelta;
+    if (m_time > endTime)
+    {
+        float duration = endTime - startTime;
+        if (m_loop && duration > 0.0f)
+        {
+            m_time = startTime + std::fmod(m_time - startTime, duration);
+        }
+        else
+        {
+            m_time = endTime;
+        }
+    }
+
+    if (m_clip != nullptr)
+    {
+        m_clip->SampleLocalPose(m_time, m_cursors, m_pose);
+    }
+    else
+    {
+        m_compressedClip->SampleLocalPose(m_time, m_cursors, m_pose);
+    }
+
+    ComposeHierarchy();
+}
+
+void AnimationPlayer::ComposeHierarchy()
+{
+    const std::vector<INT>& parents = m_set->Parents();
+    const std::vector<XMFLOAT4X4>& inverseBindPoses = m_set->InverseBindPoses();
+
+    for (UINT b : m_set->EvaluationOrder())
+    {
+        XMMATRIX boneToModel = XMMatrixAffineTransformation(
+            XMLoadFloat3(&m_pose.Scales[b]),
+            XMVectorZero(),
+            XMLoadFloat4(&m_pose.Rotations[b]),
+            XMLoadFloat3(&m_pose.Translations[b])
+            );
+
+        if (parents[b] >= 0)
+        {
+            boneToModel = XMMatrixMultiply(boneToModel, XMLoadFloat4x4(&m_boneTransforms[parents[b]]));
+        }
+
+        XMStoreFloat4x4(&m_boneTransforms[b], boneToModel);
+        XMStoreFloat4x4(&m_palette[b], XMMatrixMultiply(XMLoadFloat4x4(&inverseBindPoses[b]), boneToModel));
+    }
+}
+
+#pragma endregion
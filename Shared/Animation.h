@@ -0,0 +1,230 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include <DirectXMath.h>
+
+#include "VSD3DStarter.h"
+
+namespace VSD3DStarter
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // AnimationTrack holds the keys of a single bone as separate arrays per channel, so the
+    // sampler only walks the time array to find its interval and then touches exactly two
+    // keys of each channel.
+    //
+    struct AnimationTrack
+    {
+        std::vector<float> Times;
+        std::vector<DirectX::XMFLOAT4> Rotations;       // unit quaternions, sign-aligned with the previous key
+        std::vector<DirectX::XMFLOAT3> Translations;
+        std::vector<DirectX::XMFLOAT3> Scales;
+
+        UINT KeyCount() const { return static_cast<UINT>(Times.size()); }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Local bone pose produced by sampling a clip, one entry per bone.
+    //
+    struct AnimationPose
+    {
+        void Resize(UINT boneCount)
+        {
+            Rotations.resize(boneCount);
+            Translations.resize(boneCount);
+            Scales.resize(boneCount);
+        }
+
+        std::vector<DirectX::XMFLOAT4> Rotations;
+        std::vector<DirectX::XMFLOAT3> Translations;
+        std::vector<DirectX::XMFLOAT3> Scales;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // AnimationClip is the runtime form of Mesh::AnimClip: the flat keyframe list is split into
+    // one track per bone and every 4x4 key is decomposed into scale/rotation/translation.
+    //
+    class AnimationClip
+    {
+    public:
+        AnimationClip() : m_startTime(0.0f), m_endTime(0.0f) { }
+
+        void Initialize(const Mesh::AnimClip& clip, const std::vector<Mesh::BoneInfo>& bones);
+
+        //
+        // samples the local pose at the given clip time; cursors holds one key index per bone
+        // and is advanced in place so playing forward never searches the key arrays
+        //
+        void SampleLocalPose(float time, std::vector<UINT>& cursors, AnimationPose& pose) const;
+
+        float StartTime() const { return m_startTime; }
+        float EndTime() const { return m_endTime; }
+        float Duration() const { return m_endTime - m_startTime; }
+        UINT BoneCount() const { return static_cast<UINT>(m_tracks.size()); }
+        const AnimationTrack& Track(UINT bone) const { return m_tracks[bone]; }
+
+    private:
+        float m_startTime;
+        float m_endTime;
+        std::vector<AnimationTrack> m_tracks;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Error bounds used when compressing a clip. Keys that linear interpolation of their
+    // neighbours reproduces within these tolerances are dropped.
+    //
+    struct AnimationCompressionSettings
+    {
+        AnimationCompressionSettings() :
+            RotationTolerance(0.002f),
+            TranslationTolerance(0.0005f),
+            ScaleTolerance(0.0005f)
+        {
+        }
+
+        float RotationTolerance;        // radians
+        float TranslationTolerance;     // model units
+        float ScaleTolerance;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // CompressedAnimationClip stores every bone as three independently reduced channels.
+    // Key times are 16-bit fractions of the clip duration, rotations use the 48-bit
+    // "smallest three" quaternion encoding and translations/scales are 16-bit fractions of
+    // the channel's range. A decoded pose matches AnimationClip::SampleLocalPose within the
+    // compression tolerances.
+    //
+    class CompressedAnimationClip
+    {
+    public:
+        CompressedAnimationClip() : m_startTime(0.0f), m_endTime(0.0f), m_timeToKey(0.0f) { }
+
+        void Compress(const AnimationClip& clip, const AnimationCompressionSettings& settings);
+
+        //
+        // cursors must hold CursorCount() entries, see AnimationClip::SampleLocalPose
+        //
+        void SampleLocalPose(float time, std::vector<UINT>& cursors, AnimationPose& pose) const;
+
+        //
+        // flat binary form, so clips can be compressed once and stored alongside the mesh
+        //
+        void Serialize(std::vector<BYTE>& data) const;
+        bool Deserialize(const BYTE* data, size_t dataSize);
+
+        float StartTime() const { return m_startTime; }
+        float EndTime() const { return m_endTime; }
+        float Duration() const { return m_endTime - m_startTime; }
+        UINT BoneCount() const { return static_cast<UINT>(m_channels.size() / ChannelsPerBone); }
+        UINT CursorCount() const { return static_cast<UINT>(m_channels.size()); }
+        size_t SizeInBytes() const;
+
+    private:
+        static const UINT ChannelsPerBone = 3;  // rotation, translation, scale
+
+        struct Channel
+        {
+            UINT FirstKey;
+            UINT KeyCount;
+            DirectX::XMFLOAT3 Minimum;  // dequantization offset (unused for rotations)
+            DirectX::XMFLOAT3 Step;     // dequantization scale (unused for rotations)
+        };
+
+        void FindKeys(const Channel& channel, float keyTime, UINT& cursor, UINT& key0, UINT& key1, float& t) const;
+
+        float m_startTime;
+        float m_endTime;
+        float m_timeToKey;              // seconds to 16-bit key time units
+        std::vector<Channel> m_channels;
+        std::vector<USHORT> m_keyTimes;
+        std::vector<USHORT> m_keyValues;  // three words per key
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // AnimationSet is the shared, read-only animation data of one mesh: the bone hierarchy
+    // sorted so that parents come before their children, and all of its clips.
+    //
+    class AnimationSet
+    {
+    public:
+        AnimationSet() { }
+
+        //
+        // pass compression settings to keep only the compressed form of every clip
+        //
+        void Initialize(Mesh& mesh, const AnimationCompressionSettings* compression = nullptr);
+
+        UINT BoneCount() const { return static_cast<UINT>(m_parents.size()); }
+        const std::vector<UINT>& EvaluationOrder() const { return m_evaluationOrder; }
+        const std::vector<INT>& Parents() const { return m_parents; }
+        const std::vector<DirectX::XMFLOAT4X4>& InverseBindPoses() const { return m_inverseBindPoses; }
+
+        const AnimationClip* FindClip(const std::wstring& name) const;
+        const CompressedAnimationClip* FindCompressedClip(const std::wstring& name) const;
+        const std::map<std::wstring, AnimationClip>& Clips() const { return m_clips; }
+        const std::map<std::wstring, CompressedAnimationClip>& CompressedClips() const { return m_compressedClips; }
+
+    private:
+        std::vector<UINT> m_evaluationOrder;
+        std::vector<INT> m_parents;
+        std::vector<DirectX::XMFLOAT4X4> m_inverseBindPoses;
+        std::map<std::wstring, AnimationClip> m_clips;
+        std::map<std::wstring, CompressedAnimationClip> m_compressedClips;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // AnimationPlayer plays one clip of an AnimationSet and produces the skinning palette
+    // (inverse bind pose * bone-to-model) for every bone. Transpose the palette entries
+    // before uploading them to an HLSL constant buffer.
+    //
+    class AnimationPlayer
+    {
+    public:
+        AnimationPlayer() : m_set(nullptr), m_clip(nullptr), m_compressedClip(nullptr), m_time(0.0f), m_loop(true) { }
+
+        void Initialize(const AnimationSet* set);
+
+        bool Play(const std::wstring& clipName, bool loop = true);
+        void Stop() { m_clip = nullptr; m_compressedClip = nullptr; }
+        void Update(float timeDelta);
+
+        bool IsPlaying() const { return m_clip != nullptr || m_compressedClip != nullptr; }
+        float Time() const { return m_time; }
+
+        const std::vector<DirectX::XMFLOAT4X4>& BoneTransforms() const { return m_boneTransforms; }
+        const std::vector<DirectX::XMFLOAT4X4>& SkinningPalette() const { return m_palette; }
+
+    private:
+        void ComposeHierarchy();
+
+        const AnimationSet* m_set;
+        const AnimationClip* m_clip;
+        const CompressedAnimationClip* m_compressedClip;
+        float m_time;
+        bool m_loop;
+
+        std::vector<UINT> m_cursors;
+        AnimationPose m_pose;
+        std::vector<DirectX::XMFLOAT4X4> m_boneTransforms;
+        std::vector<DirectX::XMFLOAT4X4> m_palette;
+    };
+    //
+    //
+    ///////////////////////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,445 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Animation.h"
+
+using namespace DirectX;
+
+using namespace VSD3DStarter;
+
+#pragma region Quantization
+
+namespace
+{
+    const UINT CompressedClipMagic = 0x50494C43;    // "CLIP"
+    const UINT CompressedClipVersion = 1;
+
+    const float SmallestThreeRange = 0.70710678f;   // |c| <= 1/sqrt(2) for all but the largest component
+    const float SmallestThreeScale = 32767.0f;      // 15 bits per component
+
+    //
+    // "smallest three": drop the largest component (forced positive) and store the other
+    // three in 15 bits each; the 2-bit index of the dropped one lives in the spare top bits
+    //
+    void EncodeQuaternion(const XMFLOAT4& q, USHORT* words)
+    {
+        float c[4] = { q.x, q.y, q.z, q.w };
+
+        UINT largest = 0;
+        for (UINT i = 1; i < 4; i++)
+        {
+            if (std::fabs(c[i]) > std::fabs(c[largest]))
+            {
+                largest = i;
+            }
+        }
+
+        float sign = (c[largest] < 0.0f) ? -1.0f : 1.0f;
+
+        UINT w = 0;
+        for (UINT i = 0; i < 4; i++)
+        {
+            if (i == largest)
+            {
+                continue;
+            }
+
+            float v = (sign * c[i] / SmallestThreeRange) * 0.5f + 0.5f;
+            v = std::min(std::max(v, 0.0f), 1.0f);
+            words[w++] = static_cast<USHORT>(v * SmallestThreeScale + 0.5f);
+        }
+
+        words[0] |= static_cast<USHORT>((largest >> 1) << 15);
+        words[1] |= static_cast<USHORT>((largest & 1) << 15);
+    }
+
+    XMVECTOR DecodeQuaternion(const USHORT* words)
+    {
+        UINT largest = ((words[0] >> 15) << 1) | (words[1] >> 15);
+
+        float small[3];
+        for (UINT i = 0; i < 3; i++)
+        {
+            small[i] = ((words[i] & 0x7FFF) / SmallestThreeScale * 2.0f - 1.0f) * SmallestThreeRange;
+        }
+
+        float sumSquares = small[0] * small[0] + small[1] * small[1] + small[2] * small[2];
+
+        float c[4];
+        UINT s = 0;
+        for (UINT i = 0; i < 4; i++)
+        {
+            c[i] = (i == largest) ? std::sqrt(std::max(0.0f, 1.0f - sumSquares)) : small[s++];
+        }
+
+        return XMVectorSet(c[0], c[1], c[2], c[3]);
+    }
+
+    void EncodeVector(const XMFLOAT3& v, const XMFLOAT3& minimum, const XMFLOAT3& step, USHORT* words)
+    {
+        float c[3] = { v.x, v.y, v.z };
+        float m[3] = { minimum.x, minimum.y, minimum.z };
+        float s[3] = { step.x, step.y, step.z };
+
+        for (UINT i = 0; i < 3; i++)
+        {
+            float q = (s[i] > 0.0f) ? (c[i] - m[i]) / s[i] : 0.0f;
+            words[i] = static_cast<USHORT>(std::min(std::max(q + 0.5f, 0.0f), 65535.0f));
+        }
+    }
+
+    inline XMVECTOR DecodeVector(const USHORT* words, FXMVECTOR minimum, FXMVECTOR step)
+    {
+        XMVECTOR q = XMVectorSet(words[0], words[1], words[2], 0.0f);
+        return XMVectorMultiplyAdd(q, step, minimum);
+    }
+
+    //
+    // normalized lerp on the short arc; cheaper than slerp and well within the key
+    // reduction tolerance for the small angles between neighbouring keys
+    //
+    inline XMVECTOR QuaternionNlerp(FXMVECTOR q0, FXMVECTOR q1, float t)
+    {
+        XMVECTOR end = (XMVectorGetX(XMVector4Dot(q0, q1)) < 0.0f) ? XMVectorNegate(q1) : q1;
+        return XMVector4Normalize(XMVectorLerp(q0, end, t));
+    }
+
+    template<typename T>
+    void Append(std::vector<BYTE>& data, const T* values, size_t count)
+    {
+        size_t offset = data.size();
+        data.resize(offset + sizeof(T) * count);
+        if (count > 0)
+        {
+            memcpy(&data[offset], values, sizeof(T) * count);
+        }
+    }
+
+    template<typename T>
+    bool Extract(const BYTE*& data, const BYTE* end, T* values, size_t count)
+    {
+        size_t size = sizeof(T) * count;
+        if (static_cast<size_t>(end - data) < size)
+        {
+            return false;
+        }
+
+        if (count > 0)
+        {
+            memcpy(values, data, size);
+        }
+        data += size;
+        return true;
+    }
+}
+
+#pragma endregion
+
+#pragma region CompressedAnimationClip
+
+void CompressedAnimationClip::Compress(const AnimationClip& clip, const AnimationCompressionSettings& settings)
+{
+    m_startTime = clip.StartTime();
+    m_endTime = clip.EndTime();
+    m_timeToKey = (clip.Duration() > 0.0f) ? 65535.0f / clip.Duration() : 0.0f;
+
+    m_channels.clear();
+    m_keyTimes.clear();
+    m_keyValues.clear();
+
+    float rotationDotTolerance = std::cos(settings.RotationTolerance * 0.5f);
+
+    std::vector<USHORT> times;
+    std::vector<USHORT> values;
+    std::vector<UINT> kept;
+
+    for (UINT b = 0; b < clip.BoneCount(); b++)
+    {
+        const AnimationTrack& track = clip.Track(b);
+        UINT keyCount = track.KeyCount();
+
+        times.resize(keyCount);
+        for (UINT k = 0; k < keyCount; k++)
+        {
+            float keyTime = (track.Times[k] - m_startTime) * m_timeToKey;
+            times[k] = static_cast<USHORT>(std::min(std::max(keyTime + 0.5f, 0.0f), 65535.0f));
+        }
+
+        for (UINT c = 0; c < ChannelsPerBone; c++)
+        {
+            Channel channel = {};
+            values.resize(keyCount * 3);
+
+            //
+            // quantize every key up front so the reduction below measures the error of
+            // what the decompressor will actually reconstruct
+            //
+            if (c == 0)
+            {
+                for (UINT k = 0; k < keyCount; k++)
+                {
+                    EncodeQuaternion(track.Rotations[k], &values[k * 3]);
+                }
+            }
+            else
+            {
+                const std::vector<XMFLOAT3>& source = (c == 1) ? track.Translations : track.Scales;
+
+                XMVECTOR minimum = XMLoadFloat3(&source[0]);
+                XMVECTOR maximum = minimum;
+                for (UINT k = 1; k < keyCount; k++)
+                {
+                    minimum = XMVectorMin(minimum, XMLoadFloat3(&source[k]));
+                    maximum = XMVectorMax(maximum, XMLoadFloat3(&source[k]));
+                }
+
+                XMStoreFloat3(&channel.Minimum, minimum);
+                XMStoreFloat3(&channel.Step, XMVectorScale(XMVectorSubtract(maximum, minimum), 1.0f / 65535.0f));
+
+                for (UINT k = 0; k < keyCount; k++)
+                {
+                    EncodeVector(source[k], channel.Minimum, channel.Step, &values[k * 3]);
+                }
+            }
+
+            XMVECTOR minimum = XMLoadFloat3(&channel.Minimum);
+            XMVECTOR step = XMLoadFloat3(&channel.Step);
+            float tolerance = (c == 1) ? settings.TranslationTolerance : settings.ScaleTolerance;
+
+            //
+            // true when interpolating between the kept keys first and last reproduces the
+            // source value of key k within tolerance
+            //
+            auto withinTolerance = [&] (UINT first, UINT last, UINT k) -> bool
+            {
+                float t = (times[last] > times[first]) ?
+                    static_cast<float>(times[k] - times[first]) / static_cast<float>(times[last] - times[first]) : 0.0f;
+
+                if (c == 0)
+                {
+                    XMVECTOR rotation = QuaternionNlerp(DecodeQuaternion(&values[first * 3]), DecodeQuaternion(&values[last * 3]), t);
+                    float dot = std::fabs(XMVectorGetX(XMVector4Dot(rotation, XMLoadFloat4(&track.Rotations[k]))));
+                    return dot >= rotationDotTolerance;
+                }
+
+                const std::vector<XMFLOAT3>& source = (c == 1) ? track.Translations : track.Scales;
+                XMVECTOR value = XMVectorLerp(DecodeVector(&values[first * 3], minimum, step), DecodeVector(&values[last * 3], minimum, step), t);
+                XMVECTOR error = XMVectorAbs(XMVectorSubtract(value, XMLoadFloat3(&source[k])));
+                return XMVector3LessOrEqual(error, XMVectorReplicate(tolerance));
+            };
+
+            //
+            // greedy key reduction: from each kept key, extend the segment as far as every
+            // key it skips stays within tolerance
+            //
+            kept.clear();
+            if (keyCount > 0)
+            {
+                kept.push_back(0);
+            }
+
+            UINT anchor = 0;
+            while (anchor + 1 < keyCount)
+            {
+                UINT end = anchor + 1;
+                while (end + 1 < keyCount)
+                {
+                    bool fits = true;
+                    for (UINT k = anchor + 1; k <= end && fits; k++)
+                    {
+                        fits = withinTolerance(anchor, end + 1, k);
+                    }
+
+                    if (!fits)
+                    {
+                        break;
+                    }
+                    end++;
+                }
+
+                kept.push_back(end);
+                anchor = end;
+            }
+
+            //
+            // a channel that never leaves the tolerance of its first key collapses to that key
+            //
+            if (kept.size() > 1)
+            {
+                bool constant = true;
+                for (UINT k = 1; k < keyCount && constant; k++)
+                {
+                    constant = withinTolerance(0, 0, k);
+                }
+
+                if (constant)
+                {
+                    kept.resize(1);
+                }
+            }
+
+            channel.FirstKey = static_cast<UINT>(m_keyTimes.size());
+            channel.KeyCount = static_cast<UINT>(kept.size());
+
+            for (UINT k : kept)
+            {
+                m_keyTimes.push_back(times[k]);
+                m_keyValues.insert(m_keyValues.end(), &values[k * 3], &values[k * 3] + 3);
+            }
+
+            m_channels.push_back(channel);
+        }
+    }
+
+    m_keyTimes.shrink_to_fit();
+    m_keyValues.shrink_to_fit();
+}
+
+void CompressedAnimationClip::FindKeys(const Channel& channel, float keyTime, UINT& cursor, UINT& key0, UINT& key1, float& t) const
+{
+    const USHORT* times = &m_keyTimes[channel.FirstKey];
+    UINT keyCount = channel.KeyCount;
+
+    UINT k = cursor;
+    if (k >= keyCount || times[k] > keyTime)
+    {
+        k = 0;
+    }
+    while (k + 1 < keyCount && times[k + 1] <= keyTime)
+    {
+        k++;
+    }
+    cursor = k;
+
+    key0 = channel.FirstKey + k;
+    if (k + 1 >= keyCount || keyTime <= times[k])
+    {
+        key1 = key0;
+        t = 0.0f;
+    }
+    else
+    {
+        key1 = key0 + 1;
+        t = (keyTime - times[k]) / static_cast<float>(times[k + 1] - times[k]);
+    }
+}
+
+void CompressedAnimationClip::SampleLocalPose(float time, std::vector<UINT>& cursors, AnimationPose& pose) const
+{
+    float keyTime = std::min(std::max((time - m_startTime) * m_timeToKey, 0.0f), 65535.0f);
+
+    UINT boneCount = BoneCount();
+    for (UINT b = 0; b < boneCount; b++)
+    {
+        UINT c = b * ChannelsPerBone;
+        UINT key0, key1;
+        float t;
+
+        FindKeys(m_channels[c], keyTime, cursors[c], key0, key1, t);
+        XMVECTOR rotation = DecodeQuaternion(&m_keyValues[key0 * 3]);
+        if (key1 != key0)
+        {
+            rotation = QuaternionNlerp(rotation, DecodeQuaternion(&m_keyValues[key1 * 3]), t);
+        }
+        XMStoreFloat4(&pose.Rotations[b], rotation);
+
+        for (UINT v = 1; v < ChannelsPerBone; v++)
+        {
+            const Channel& channel = m_channels[c + v];
+            XMVECTOR minimum = XMLoadFloat3(&channel.Minimum);
+            XMVECTOR step = XMLoadFloat3(&channel.Step);
+
+            FindKeys(channel, keyTime, cursors[c + v], key0, key1, t);
+            XMVECTOR value = DecodeVector(&m_keyValues[key0 * 3], minimum, step);
+            if (key1 != key0)
+            {
+                value = XMVectorLerp(value, DecodeVector(&m_keyValues[key1 * 3], minimum, step), t);
+            }
+            XMStoreFloat3((v == 1) ? &pose.Translations[b] : &pose.Scales[b], value);
+        }
+    }
+}
+
+void CompressedAnimationClip::Serialize(std::vector<BYTE>& data) const
+{
+    UINT header[5] =
+    {
+        CompressedClipMagic,
+        CompressedClipVersion,
+        static_cast<UINT>(m_channels.size()),
+        static_cast<UINT>(m_keyTimes.size()),
+        0
+    };
+    float times[3] = { m_startTime, m_endTime, m_timeToKey };
+
+    data.clear();
+    data.reserve(SizeInBytes());
+    Append(data, header, 5);
+    Append(data, times, 3);
+    Append(data, m_channels.data(), m_channels.size());
+    Append(data, m_keyTimes.data(), m_keyTimes.size());
+    Append(data, m_keyValues.data(), m_keyValues.size());
+}
+
+bool CompressedAnimationClip::Deserialize(const BYTE* data, size_t dataSize)
+{
+    const BYTE* end = data + dataSize;
+
+    UINT header[5];
+    float times[3];
+    if (!Extract(data, end, header, 5) || !Extract(data, end, times, 3))
+    {
+        return false;
+    }
+
+    if (header[0] != CompressedClipMagic || header[1] != CompressedClipVersion || (header[2] % ChannelsPerBone) != 0)
+    {
+        return false;
+    }
+
+    std::vector<Channel> channels(header[2]);
+    std::vector<USHORT> keyTimes(header[3]);
+    std::vector<USHORT> keyValues(header[3] * 3);
+    if (!Extract(data, end, channels.data(), channels.size()) ||
+        !Extract(data, end, keyTimes.data(), keyTimes.size()) ||
+        !Extract(data, end, keyValues.data(), keyValues.size()))
+    {
+        return false;
+    }
+
+    for (const Channel& channel : channels)
+    {
+        if (channel.KeyCount == 0 || channel.FirstKey > keyTimes.size() || channel.KeyCount > keyTimes.size() - channel.FirstKey)
+        {
+            return false;
+        }
+    }
+
+    m_startTime = times[0];
+    m_endTime = times[1];
+    m_timeToKey = times[2];
+    m_channels.swap(channels);
+    m_keyTimes.swap(keyTimes);
+    m_keyValues.swap(keyValues);
+    return true;
+}
+
+size_t CompressedAnimationClip::SizeInBytes() const
+{
+    return sizeof(UINT) * 5 + sizeof(float) * 3 +
+        m_channels.size() * sizeof(Channel) +
+        m_keyTimes.size() * sizeof(USHORT) +
+        m_keyValues.size() * sizeof(USHORT);
+}
+
+#pragma endregion
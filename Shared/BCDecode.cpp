@@ -0,0 +1,546 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "BCDecode.h"
+#include "GameClock.h"
+#include "JobSystem.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define BC_DECODE_SSE2
+#include <emmintrin.h>
+
+#if defined(_MSC_VER) && _MSC_VER >= 1700
+#define BC_DECODE_AVX2
+#define BC_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__GNUC__)
+#define BC_DECODE_AVX2
+#define BC_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    inline uint32_t Pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    inline uint32_t Load32(const uint8_t* bytes)
+    {
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+
+    //
+    // the four colours of a BC1-style colour block; BC2 and BC3 always use four colours
+    //
+    void ColorPalette(const uint8_t* block, bool allowTransparent, uint32_t palette[4])
+    {
+        uint32_t c0 = block[0] | (block[1] << 8);
+        uint32_t c1 = block[2] | (block[3] << 8);
+
+        uint32_t r0 = (c0 >> 11) & 0x1f, g0 = (c0 >> 5) & 0x3f, b0 = c0 & 0x1f;
+        uint32_t r1 = (c1 >> 11) & 0x1f, g1 = (c1 >> 5) & 0x3f, b1 = c1 & 0x1f;
+        r0 = (r0 << 3) | (r0 >> 2); g0 = (g0 << 2) | (g0 >> 4); b0 = (b0 << 3) | (b0 >> 2);
+        r1 = (r1 << 3) | (r1 >> 2); g1 = (g1 << 2) | (g1 >> 4); b1 = (b1 << 3) | (b1 >> 2);
+
+        palette[0] = Pack(r0, g0, b0, 255);
+        palette[1] = Pack(r1, g1, b1, 255);
+        if (c0 > c1 || !allowTransparent)
+        {
+            palette[2] = Pack((2 * r0 + r1 + 1) / 3, (2 * g0 + g1 + 1) / 3, (2 * b0 + b1 + 1) / 3, 255);
+            palette[3] = Pack((r0 + 2 * r1 + 1) / 3, (g0 + 2 * g1 + 1) / 3, (b0 + 2 * b1 + 1) / 3, 255);
+        }
+        else
+        {
+            palette[2] = Pack((r0 + r1 + 1) / 2, (g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2, 255);
+            palette[3] = 0;
+        }
+    }
+
+    //
+    // 2-bit index selection from the palette, the part of every colour block worth vectorizing
+    //
+    typedef void (*SelectFunction)(const uint32_t palette[4], uint32_t indices, uint32_t texels[16]);
+
+    void SelectScalar(const uint32_t palette[4], uint32_t indices, uint32_t texels[16])
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            texels[i] = palette[(indices >> (2 * i)) & 3];
+        }
+    }
+
+#ifdef BC_DECODE_SSE2
+    // a row of four texels at a time: each lane masks out its own index bits and compares
+    // them against the four possible values
+    void SelectSSE2(const uint32_t palette[4], uint32_t indices, uint32_t texels[16])
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_setr_epi32(0x01, 0x04, 0x10, 0x40);
+        const __m128i twos = _mm_setr_epi32(0x02, 0x08, 0x20, 0x80);
+        const __m128i threes = _mm_setr_epi32(0x03, 0x0c, 0x30, 0xc0);
+
+        __m128i p0 = _mm_set1_epi32(static_cast<int>(palette[0]));
+        __m128i p1 = _mm_set1_epi32(static_cast<int>(palette[1]));
+        __m128i p2 = _mm_set1_epi32(static_cast<int>(palette[2]));
+        __m128i p3 = _mm_set1_epi32(static_cast<int>(palette[3]));
+
+        for (int y = 0; y < 4; y++)
+        {
+            __m128i row = _mm_and_si128(_mm_set1_epi32(static_cast<int>((indices >> (8 * y)) & 0xff)), threes);
+            __m128i result = _mm_and_si128(p0, _mm_cmpeq_epi32(row, zero));
+            result = _mm_or_si128(result, _mm_and_si128(p1, _mm_cmpeq_epi32(row, ones)));
+            result = _mm_or_si128(result, _mm_and_si128(p2, _mm_cmpeq_epi32(row, twos)));
+            result = _mm_or_si128(result, _mm_and_si128(p3, _mm_cmpeq_epi32(row, threes)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + 4 * y), result);
+        }
+    }
+#endif
+
+#ifdef BC_DECODE_AVX2
+    // two rows at a time, with the palette doubled up so a permute does the lookup
+    BC_TARGET_AVX2 void SelectAVX2(const uint32_t palette[4], uint32_t indices, uint32_t texels[16])
+    {
+        const __m256i shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+        const __m256i mask = _mm256_set1_epi32(3);
+        __m256i lookup = _mm256_setr_epi32(
+            static_cast<int>(palette[0]), static_cast<int>(palette[1]), static_cast<int>(palette[2]), static_cast<int>(palette[3]),
+            static_cast<int>(palette[0]), static_cast<int>(palette[1]), static_cast<int>(palette[2]), static_cast<int>(palette[3]));
+
+        __m256i low = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(indices & 0xffff)), shifts), mask);
+        __m256i high = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(indices >> 16)), shifts), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(texels), _mm256_permutevar8x32_epi32(lookup, low));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(texels + 8), _mm256_permutevar8x32_epi32(lookup, high));
+    }
+
+    bool HasAVX2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+
+        // the OS must save the ymm registers as well
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+#endif
+
+    struct Selector
+    {
+        Selector()
+        {
+            Select = &SelectScalar;
+            Name = L"scalar";
+#ifdef BC_DECODE_SSE2
+            Select = &SelectSSE2;
+            Name = L"SSE2";
+#endif
+#ifdef BC_DECODE_AVX2
+            if (HasAVX2())
+            {
+                Select = &SelectAVX2;
+                Name = L"AVX2";
+            }
+#endif
+        }
+
+        SelectFunction Select;
+        const wchar_t* Name;
+    };
+
+    // chosen before main, so decoding threads never race to pick it
+    const Selector s_selector;
+
+    inline void DecodeColor(const uint8_t* block, bool allowTransparent, uint32_t texels[16])
+    {
+        uint32_t palette[4];
+        ColorPalette(block, allowTransparent, palette);
+        s_selector.Select(palette, Load32(block + 4), texels);
+    }
+
+    //
+    // the eight values of a BC3 alpha, BC4 or BC5 channel, and their 3-bit indices
+    //
+    void UnsignedChannelPalette(const uint8_t* block, int palette[8])
+    {
+        int v0 = block[0];
+        int v1 = block[1];
+        palette[0] = v0;
+        palette[1] = v1;
+        if (v0 > v1)
+        {
+            for (int i = 1; i < 7; i++)
+            {
+                palette[i + 1] = ((7 - i) * v0 + i * v1 + 3) / 7;
+            }
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+            {
+                palette[i + 1] = ((5 - i) * v0 + i * v1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    inline int DivideRounded(int value, int divisor)
+    {
+        return (value >= 0) ? (value + divisor / 2) / divisor : -((-value + divisor / 2) / divisor);
+    }
+
+    void SignedChannelPalette(const uint8_t* block, int palette[8])
+    {
+        // -128 and -127 both mean -1
+        int v0 = std::max(static_cast<int>(static_cast<int8_t>(block[0])), -127);
+        int v1 = std::max(static_cast<int>(static_cast<int8_t>(block[1])), -127);
+        palette[0] = v0;
+        palette[1] = v1;
+        if (v0 > v1)
+        {
+            for (int i = 1; i < 7; i++)
+            {
+                palette[i + 1] = DivideRounded((7 - i) * v0 + i * v1, 7);
+            }
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+            {
+                palette[i + 1] = DivideRounded((5 - i) * v0 + i * v1, 5);
+            }
+            palette[6] = -127;
+            palette[7] = 127;
+        }
+    }
+
+    //
+    // writes one channel of 8-bit values into the texels at the given bit position
+    //
+    void DecodeChannel(const uint8_t* block, bool isSigned, int shift, uint32_t texels[16])
+    {
+        int palette[8];
+        if (isSigned)
+        {
+            SignedChannelPalette(block, palette);
+        }
+        else
+        {
+            UnsignedChannelPalette(block, palette);
+        }
+
+        uint64_t indices = 0;
+        for (int i = 7; i >= 2; i--)
+        {
+            indices = (indices << 8) | block[i];
+        }
+
+        uint32_t keep = ~(0xffu << shift);
+        for (int i = 0; i < 16; i++)
+        {
+            uint32_t value = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+            texels[i] = (texels[i] & keep) | (value << shift);
+        }
+    }
+
+    typedef void (*BlockDecoder)(const uint8_t* block, uint32_t texels[16]);
+
+    void DecodeBC4Unsigned(const uint8_t* block, uint32_t texels[16]) { DecodeBC4Block(block, false, texels); }
+    void DecodeBC4Signed(const uint8_t* block, uint32_t texels[16]) { DecodeBC4Block(block, true, texels); }
+    void DecodeBC5Unsigned(const uint8_t* block, uint32_t texels[16]) { DecodeBC5Block(block, false, texels); }
+    void DecodeBC5Signed(const uint8_t* block, uint32_t texels[16]) { DecodeBC5Block(block, true, texels); }
+
+    // BC6H texels are twice as wide; the row decoder hands over room for 32
+    void DecodeBC6HUnsigned(const uint8_t* block, uint32_t texels[16])
+    {
+        uint16_t halves[64];
+        DecodeBC6HBlock(block, false, halves);
+        memcpy(texels, halves, sizeof(halves));
+    }
+
+    void DecodeBC6HSigned(const uint8_t* block, uint32_t texels[16])
+    {
+        uint16_t halves[64];
+        DecodeBC6HBlock(block, true, halves);
+        memcpy(texels, halves, sizeof(halves));
+    }
+
+    BlockDecoder FindDecoder(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_TYPELESS:
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return &DecodeBC1Block;
+
+        case DXGI_FORMAT_BC2_TYPELESS:
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+            return &DecodeBC2Block;
+
+        case DXGI_FORMAT_BC3_TYPELESS:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return &DecodeBC3Block;
+
+        case DXGI_FORMAT_BC4_TYPELESS:
+        case DXGI_FORMAT_BC4_UNORM:
+            return &DecodeBC4Unsigned;
+
+        case DXGI_FORMAT_BC4_SNORM:
+            return &DecodeBC4Signed;
+
+        case DXGI_FORMAT_BC5_TYPELESS:
+        case DXGI_FORMAT_BC5_UNORM:
+            return &DecodeBC5Unsigned;
+
+        case DXGI_FORMAT_BC5_SNORM:
+            return &DecodeBC5Signed;
+
+        case DXGI_FORMAT_BC6H_TYPELESS:
+        case DXGI_FORMAT_BC6H_UF16:
+            return &DecodeBC6HUnsigned;
+
+        case DXGI_FORMAT_BC6H_SF16:
+            return &DecodeBC6HSigned;
+
+        case DXGI_FORMAT_BC7_TYPELESS:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return &DecodeBC7Block;
+
+        default:
+            return nullptr;
+        }
+    }
+
+    struct DecodeRows
+    {
+        BlockDecoder Decoder;
+        const DDSSubresource* Source;
+        uint8_t* Destination;
+        size_t DestinationRowPitch;
+        size_t BlockBytes;
+        size_t BlocksWide;
+        size_t TexelBytes;
+
+        // row is a row of blocks counted across all slices
+        void operator()(unsigned int begin, unsigned int end) const
+        {
+            uint32_t texels[32];
+            for (unsigned int row = begin; row < end; row++)
+            {
+                size_t slice = row / Source->RowCount;
+                size_t blockY = row % Source->RowCount;
+                const uint8_t* block = Source->Data + slice * Source->SlicePitch + blockY * Source->RowPitch;
+
+                size_t y0 = blockY * 4;
+                size_t rows = std::min<size_t>(4, Source->Height - y0);
+                uint8_t* target = Destination + (slice * Source->Height + y0) * DestinationRowPitch;
+
+                for (size_t blockX = 0; blockX < BlocksWide; blockX++, block += BlockBytes)
+                {
+                    Decoder(block, texels);
+
+                    size_t x0 = blockX * 4;
+                    size_t columns = std::min<size_t>(4, Source->Width - x0);
+                    for (size_t y = 0; y < rows; y++)
+                    {
+                        memcpy(target + y * DestinationRowPitch + x0 * TexelBytes, reinterpret_cast<const uint8_t*>(texels) + 4 * y * TexelBytes, columns * TexelBytes);
+                    }
+                }
+            }
+        }
+    };
+}
+
+void DirectX::DecodeBC1Block(const uint8_t* block, uint32_t texels[16])
+{
+    DecodeColor(block, true, texels);
+}
+
+void DirectX::DecodeBC2Block(const uint8_t* block, uint32_t texels[16])
+{
+    DecodeColor(block + 8, false, texels);
+
+    // explicit 4-bit alpha
+    for (int i = 0; i < 16; i++)
+    {
+        uint32_t alpha = (block[i / 2] >> (4 * (i & 1))) & 0xf;
+        texels[i] = (texels[i] & 0x00ffffff) | ((alpha * 17) << 24);
+    }
+}
+
+void DirectX::DecodeBC3Block(const uint8_t* block, uint32_t texels[16])
+{
+    DecodeColor(block + 8, false, texels);
+    DecodeChannel(block, false, 24, texels);
+}
+
+void DirectX::DecodeBC4Block(const uint8_t* block, bool isSigned, uint32_t texels[16])
+{
+    uint32_t fill = isSigned ? Pack(0, 0, 0, 0x7f) : Pack(0, 0, 0, 0xff);
+    std::fill(texels, texels + 16, fill);
+    DecodeChannel(block, isSigned, 0, texels);
+}
+
+void DirectX::DecodeBC5Block(const uint8_t* block, bool isSigned, uint32_t texels[16])
+{
+    DecodeBC4Block(block, isSigned, texels);
+    DecodeChannel(block + 8, isSigned, 8, texels);
+}
+
+bool DirectX::CanDecodeBC(DXGI_FORMAT format)
+{
+    return FindDecoder(format) != nullptr;
+}
+
+DXGI_FORMAT DirectX::BCDecodedFormat(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_BC4_SNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+        return DXGI_FORMAT_R8G8B8A8_SNORM;
+
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+        return DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+    default:
+        return FindDecoder(format) ? DXGI_FORMAT_R8G8B8A8_UNORM : DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+bool DirectX::DecodeBC(DXGI_FORMAT format, const DDSSubresource& source, uint8_t* destination, size_t destinationRowPitch, JobSystem* jobs)
+{
+    BlockDecoder decoder = FindDecoder(format);
+    if (!decoder)
+    {
+        return false;
+    }
+
+    DecodeRows rows;
+    rows.Decoder = decoder;
+    rows.Source = &source;
+    rows.Destination = destination;
+    rows.DestinationRowPitch = destinationRowPitch;
+    rows.BlockBytes = BitsPerPixel(format) * 2;
+    rows.BlocksWide = source.RowPitch / rows.BlockBytes;
+    rows.TexelBytes = BitsPerPixel(BCDecodedFormat(format)) / 8;
+
+    unsigned int rowCount = static_cast<unsigned int>(source.RowCount * source.Depth);
+    if (jobs)
+    {
+        jobs->ParallelFor(0, rowCount, 0, rows);
+    }
+    else
+    {
+        rows(0, rowCount);
+    }
+
+    return true;
+}
+
+const wchar_t* DirectX::BCDecodeInstructionSet()
+{
+    return s_selector.Name;
+}
+
+void DirectX::RunBCDecodeBenchmark(JobSystem* jobs, std::vector<BCDecodeBenchmarkResult>& results, uint32_t size, unsigned int iterations)
+{
+    static const DXGI_FORMAT formats[] =
+    {
+        DXGI_FORMAT_BC1_UNORM,
+        DXGI_FORMAT_BC2_UNORM,
+        DXGI_FORMAT_BC3_UNORM,
+        DXGI_FORMAT_BC4_UNORM,
+        DXGI_FORMAT_BC4_SNORM,
+        DXGI_FORMAT_BC5_UNORM,
+        DXGI_FORMAT_BC5_SNORM,
+        DXGI_FORMAT_BC6H_UF16,
+        DXGI_FORMAT_BC6H_SF16,
+        DXGI_FORMAT_BC7_UNORM,
+    };
+
+    results.clear();
+
+    // random blocks exercise every palette mode
+    std::vector<uint8_t> blocks(static_cast<size_t>(size) * size);
+    uint32_t random = 0x12345678;
+    for (uint8_t& b : blocks)
+    {
+        random = random * 1664525 + 1013904223;
+        b = static_cast<uint8_t>(random >> 24);
+    }
+
+    std::vector<uint8_t> texels(static_cast<size_t>(size) * size * 8);
+    double megapixels = static_cast<double>(size) * size * iterations * 1e-6;
+
+    for (DXGI_FORMAT format : formats)
+    {
+        size_t rowPitch = size * (BitsPerPixel(BCDecodedFormat(format)) / 8);
+
+        DDSSubresource source;
+        source.Data = blocks.data();
+        GetSurfaceInfo(size, size, format, &source.SlicePitch, &source.RowPitch, &source.RowCount);
+        source.Width = size;
+        source.Height = size;
+        source.Depth = 1;
+
+        BCDecodeBenchmarkResult result;
+        result.Format = format;
+        result.ParallelMegapixelsPerSecond = 0.0;
+
+        int64_t start = GameClock::Now();
+        for (unsigned int i = 0; i < iterations; i++)
+        {
+            DecodeBC(format, source, texels.data(), rowPitch);
+        }
+        result.MegapixelsPerSecond = megapixels / ((GameClock::Now() - start) * 1e-9);
+
+        if (jobs)
+        {
+            start = GameClock::Now();
+            for (unsigned int i = 0; i < iterations; i++)
+            {
+                DecodeBC(format, source, texels.data(), rowPitch, jobs);
+            }
+            result.ParallelMegapixelsPerSecond = megapixels / ((GameClock::Now() - start) * 1e-9);
+        }
+
+        results.push_back(result);
+    }
+}
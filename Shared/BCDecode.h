@@ -0,0 +1,73 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "DDSTexture.h"
+
+class JobSystem;
+
+namespace DirectX
+{
+    //
+    // Block decoders. Each writes the 16 texels of one 4x4 block row by row, packed as
+    // R8G8B8A8 (red in the low byte). SNORM formats decode to R8G8B8A8_SNORM bit patterns,
+    // UNORM and sRGB formats to R8G8B8A8_UNORM with the encoded values left as they are.
+    //
+    void DecodeBC1Block(const uint8_t* block, uint32_t texels[16]);
+    void DecodeBC2Block(const uint8_t* block, uint32_t texels[16]);
+    void DecodeBC3Block(const uint8_t* block, uint32_t texels[16]);
+    void DecodeBC4Block(const uint8_t* block, bool isSigned, uint32_t texels[16]);
+    void DecodeBC5Block(const uint8_t* block, bool isSigned, uint32_t texels[16]);
+    void DecodeBC7Block(const uint8_t* block, uint32_t texels[16]);
+
+    //
+    // BC6H decodes to R16G16B16A16_FLOAT, four half bit patterns per texel with alpha 1
+    //
+    void DecodeBC6HBlock(const uint8_t* block, bool isSigned, uint16_t texels[64]);
+
+    bool CanDecodeBC(DXGI_FORMAT format);
+
+    //
+    // the format DecodeBC writes for a compressed format, or DXGI_FORMAT_UNKNOWN
+    //
+    DXGI_FORMAT BCDecodedFormat(DXGI_FORMAT format);
+
+    //
+    // Decodes a whole subresource, every slice of a volume one after the other, into
+    // destination rows of destinationRowPitch bytes in BCDecodedFormat. With jobs, rows of
+    // blocks are decoded in parallel. Returns false for formats CanDecodeBC rejects.
+    //
+    bool DecodeBC(DXGI_FORMAT format, const DDSSubresource& source, uint8_t* destination, size_t destinationRowPitch, JobSystem* jobs = nullptr);
+
+    //
+    // the instruction set the colour decoders picked for this processor
+    //
+    const wchar_t* BCDecodeInstructionSet();
+
+    //
+    // decodes a set of BC6H and BC7 blocks with known texels, covering every mode, and
+    // returns false on the first mismatch
+    //
+    bool CheckBPTCReferenceBlocks();
+
+    struct BCDecodeBenchmarkResult
+    {
+        DXGI_FORMAT Format;
+        double MegapixelsPerSecond;             // on the calling thread alone
+        double ParallelMegapixelsPerSecond;     // spread over jobs, when given
+    };
+
+    //
+    // decodes a size x size texture of random blocks in every supported format
+    //
+    void RunBCDecodeBenchmark(JobSystem* jobs, std::vector<BCDecodeBenchmarkResult>& results, uint32_t size = 1024, unsigned int iterations = 8);
+}
@@ -0,0 +1,1427 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <string.h>
+
+#include "BCDecode.h"
+#include "BCEncode.h"
+#include "BPTCTables.h"
+#include "GameClock.h"
+#include "JobSystem.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define BC_ENCODE_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+using namespace DirectX::BPTC;
+
+namespace
+{
+    inline uint32_t Channel(uint32_t texel, unsigned int c)
+    {
+        return (texel >> (8 * c)) & 0xff;
+    }
+
+    inline uint32_t Pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    inline int Clamp(int value, int low, int high)
+    {
+        return std::min(std::max(value, low), high);
+    }
+
+    inline int Round(float value)
+    {
+        return static_cast<int>(std::floor(value + 0.5f));
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Index selection: the nearest palette entry for every texel and the summed squared
+    // error, over the channels in channelMask and the texels in texelMask. Every endpoint
+    // the encoders consider goes through here.
+    //
+#ifdef BC_ENCODE_SSE2
+    //
+    // four texels at a time: bytes widen to 16 bits, madd squares and pairs the channels
+    //
+    uint32_t SelectIndices(const uint32_t texels[16], const uint32_t* palette, unsigned int paletteSize,
+        uint32_t channelMask, uint32_t texelMask, uint8_t indices[16])
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i channels = _mm_set1_epi32(static_cast<int>(channelMask));
+
+        __m128i colors[16];
+        for (unsigned int p = 0; p < paletteSize; p++)
+        {
+            colors[p] = _mm_unpacklo_epi8(_mm_and_si128(_mm_set1_epi32(static_cast<int>(palette[p])), channels), zero);
+        }
+
+        __m128i total = zero;
+        for (unsigned int group = 0; group < 4; group++)
+        {
+            __m128i pixels = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + 4 * group)), channels);
+            __m128i low = _mm_unpacklo_epi8(pixels, zero);
+            __m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+            __m128i best = _mm_set1_epi32(0x7fffffff);
+            __m128i bestIndex = zero;
+            for (unsigned int p = 0; p < paletteSize; p++)
+            {
+                __m128i dl = _mm_sub_epi16(low, colors[p]);
+                __m128i dh = _mm_sub_epi16(high, colors[p]);
+                __m128 sl = _mm_castsi128_ps(_mm_madd_epi16(dl, dl));
+                __m128 sh = _mm_castsi128_ps(_mm_madd_epi16(dh, dh));
+
+                // (r² + g²) and (b² + a²) of each texel, summed
+                __m128i error = _mm_add_epi32(
+                    _mm_castps_si128(_mm_shuffle_ps(sl, sh, _MM_SHUFFLE(2, 0, 2, 0))),
+                    _mm_castps_si128(_mm_shuffle_ps(sl, sh, _MM_SHUFFLE(3, 1, 3, 1))));
+
+                __m128i closer = _mm_cmplt_epi32(error, best);
+                best = _mm_or_si128(_mm_and_si128(closer, error), _mm_andnot_si128(closer, best));
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(p))), _mm_andnot_si128(closer, bestIndex));
+            }
+
+            uint32_t bits = texelMask >> (4 * group);
+            __m128i counted = _mm_set_epi32(-static_cast<int>((bits >> 3) & 1), -static_cast<int>((bits >> 2) & 1),
+                -static_cast<int>((bits >> 1) & 1), -static_cast<int>(bits & 1));
+            total = _mm_add_epi32(total, _mm_and_si128(best, counted));
+
+            // the indices are below 16, so packing twice leaves one per byte
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(bestIndex, zero), zero);
+            uint32_t four = static_cast<uint32_t>(_mm_cvtsi128_si32(packed));
+            memcpy(indices + 4 * group, &four, 4);
+        }
+
+        total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(1, 0, 3, 2)));
+        total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(total));
+    }
+#else
+    uint32_t SelectIndices(const uint32_t texels[16], const uint32_t* palette, unsigned int paletteSize,
+        uint32_t channelMask, uint32_t texelMask, uint8_t indices[16])
+    {
+        uint32_t total = 0;
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            uint32_t texel = texels[i] & channelMask;
+            uint32_t best = UINT32_MAX;
+            for (unsigned int p = 0; p < paletteSize; p++)
+            {
+                uint32_t color = palette[p] & channelMask;
+                uint32_t error = 0;
+                for (unsigned int c = 0; c < 4; c++)
+                {
+                    int d = static_cast<int>(Channel(texel, c)) - static_cast<int>(Channel(color, c));
+                    error += d * d;
+                }
+
+                if (error < best)
+                {
+                    best = error;
+                    indices[i] = static_cast<uint8_t>(p);
+                }
+            }
+
+            if (texelMask & (1 << i))
+            {
+                total += best;
+            }
+        }
+
+        return total;
+    }
+#endif
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Endpoint fitting shared by all formats, on up to four channels of the texels in Mask
+    //
+    struct BlockPoints
+    {
+        float Values[16][4];
+        uint32_t Mask;
+        unsigned int Channels;
+    };
+
+    void LoadPoints(const uint32_t texels[16], uint32_t mask, unsigned int firstChannel, unsigned int channels, BlockPoints& points)
+    {
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            for (unsigned int c = 0; c < channels; c++)
+            {
+                points.Values[i][c] = static_cast<float>(Channel(texels[i], firstChannel + c));
+            }
+        }
+
+        points.Mask = mask;
+        points.Channels = channels;
+    }
+
+    //
+    // Mean and principal axis by power iteration on the covariance. The residual is the
+    // squared distance of the points from that line, a cheap measure of how well two
+    // endpoints can represent them.
+    //
+    void PrincipalAxis(const BlockPoints& points, unsigned int iterations, float mean[4], float axis[4], float* residual = nullptr)
+    {
+        unsigned int n = points.Channels;
+        float count = 0.0f;
+        for (unsigned int c = 0; c < 4; c++)
+        {
+            mean[c] = axis[c] = 0.0f;
+        }
+
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            if (points.Mask & (1 << i))
+            {
+                count += 1.0f;
+                for (unsigned int c = 0; c < n; c++)
+                {
+                    mean[c] += points.Values[i][c];
+                }
+            }
+        }
+
+        if (count == 0.0f)
+        {
+            if (residual)
+            {
+                *residual = 0.0f;
+            }
+            return;
+        }
+
+        for (unsigned int c = 0; c < n; c++)
+        {
+            mean[c] /= count;
+        }
+
+        float covariance[4][4] = {};
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            if (points.Mask & (1 << i))
+            {
+                float d[4];
+                for (unsigned int c = 0; c < n; c++)
+                {
+                    d[c] = points.Values[i][c] - mean[c];
+                }
+
+                for (unsigned int a = 0; a < n; a++)
+                {
+                    for (unsigned int b = a; b < n; b++)
+                    {
+                        covariance[a][b] += d[a] * d[b];
+                    }
+                }
+            }
+        }
+
+        unsigned int widest = 0;
+        float trace = 0.0f;
+        for (unsigned int a = 0; a < n; a++)
+        {
+            trace += covariance[a][a];
+            if (covariance[a][a] > covariance[widest][widest])
+            {
+                widest = a;
+            }
+
+            for (unsigned int b = 0; b < a; b++)
+            {
+                covariance[a][b] = covariance[b][a];
+            }
+        }
+
+        // start from the widest channel's row, which cannot be orthogonal to the axis
+        for (unsigned int c = 0; c < n; c++)
+        {
+            axis[c] = covariance[widest][c];
+        }
+
+        for (unsigned int iteration = 0; iteration < iterations; iteration++)
+        {
+            float next[4] = {};
+            float scale = 0.0f;
+            for (unsigned int a = 0; a < n; a++)
+            {
+                for (unsigned int b = 0; b < n; b++)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                scale = std::max(scale, std::fabs(next[a]));
+            }
+
+            if (scale == 0.0f)
+            {
+                break;
+            }
+
+            for (unsigned int c = 0; c < n; c++)
+            {
+                axis[c] = next[c] / scale;
+            }
+        }
+
+        float length = 0.0f;
+        for (unsigned int c = 0; c < n; c++)
+        {
+            length += axis[c] * axis[c];
+        }
+
+        float variance = 0.0f;
+        if (length > 1e-12f)
+        {
+            length = 1.0f / std::sqrt(length);
+            for (unsigned int c = 0; c < n; c++)
+            {
+                axis[c] *= length;
+            }
+
+            for (unsigned int a = 0; a < n; a++)
+            {
+                for (unsigned int b = 0; b < n; b++)
+                {
+                    variance += axis[a] * covariance[a][b] * axis[b];
+                }
+            }
+        }
+        else
+        {
+            for (unsigned int c = 0; c < n; c++)
+            {
+                axis[c] = 0.0f;
+            }
+        }
+
+        if (residual)
+        {
+            *residual = std::max(trace - variance, 0.0f);
+        }
+    }
+
+    //
+    // the extreme projections of the points onto the axis
+    //
+    void AxisEndpoints(const BlockPoints& points, const float mean[4], const float axis[4], float e0[4], float e1[4])
+    {
+        float low = FLT_MAX;
+        float high = -FLT_MAX;
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            if (points.Mask & (1 << i))
+            {
+                float t = 0.0f;
+                for (unsigned int c = 0; c < points.Channels; c++)
+                {
+                    t += (points.Values[i][c] - mean[c]) * axis[c];
+                }
+                low = std::min(low, t);
+                high = std::max(high, t);
+            }
+        }
+
+        if (low > high)
+        {
+            low = high = 0.0f;
+        }
+
+        for (unsigned int c = 0; c < 4; c++)
+        {
+            e0[c] = c < points.Channels ? mean[c] + axis[c] * low : 0.0f;
+            e1[c] = c < points.Channels ? mean[c] + axis[c] * high : 0.0f;
+        }
+    }
+
+    //
+    // Least-squares endpoints for texels interpolated the given fractions of the way from
+    // e0 to e1; false when the fractions leave the system singular.
+    //
+    bool FitEndpoints(const BlockPoints& points, const float fractions[16], float e0[4], float e1[4])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            if (points.Mask & (1 << i))
+            {
+                float t = fractions[i];
+                float s = 1.0f - t;
+                aa += s * s;
+                ab += s * t;
+                bb += t * t;
+                for (unsigned int c = 0; c < points.Channels; c++)
+                {
+                    ax[c] += s * points.Values[i][c];
+                    bx[c] += t * points.Values[i][c];
+                }
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+
+        for (unsigned int c = 0; c < points.Channels; c++)
+        {
+            e0[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / determinant, 0.0f), 255.0f);
+            e1[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / determinant, 0.0f), 255.0f);
+        }
+
+        return true;
+    }
+
+    unsigned int Refinements(BCEncodeQuality quality)
+    {
+        return quality == BC_ENCODE_FAST ? 0 : quality == BC_ENCODE_NORMAL ? 1 : 3;
+    }
+
+    unsigned int AxisIterations(BCEncodeQuality quality)
+    {
+        return quality == BC_ENCODE_FAST ? 2 : 6;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // BC1 and BC3 colour
+    //
+    inline uint32_t Quantize565(const float color[4])
+    {
+        int r = Clamp(Round(color[0] * (31.0f / 255.0f)), 0, 31);
+        int g = Clamp(Round(color[1] * (63.0f / 255.0f)), 0, 63);
+        int b = Clamp(Round(color[2] * (31.0f / 255.0f)), 0, 31);
+        return (r << 11) | (g << 5) | b;
+    }
+
+    //
+    // the palette a decoder builds, with its rounding
+    //
+    void ColorPalette(uint32_t c0, uint32_t c1, bool fourColors, uint32_t palette[4])
+    {
+        uint32_t r0 = (c0 >> 11) & 0x1f, g0 = (c0 >> 5) & 0x3f, b0 = c0 & 0x1f;
+        uint32_t r1 = (c1 >> 11) & 0x1f, g1 = (c1 >> 5) & 0x3f, b1 = c1 & 0x1f;
+        r0 = (r0 << 3) | (r0 >> 2); g0 = (g0 << 2) | (g0 >> 4); b0 = (b0 << 3) | (b0 >> 2);
+        r1 = (r1 << 3) | (r1 >> 2); g1 = (g1 << 2) | (g1 >> 4); b1 = (b1 << 3) | (b1 >> 2);
+
+        palette[0] = Pack(r0, g0, b0, 255);
+        palette[1] = Pack(r1, g1, b1, 255);
+        if (fourColors)
+        {
+            palette[2] = Pack((2 * r0 + r1 + 1) / 3, (2 * g0 + g1 + 1) / 3, (2 * b0 + b1 + 1) / 3, 255);
+            palette[3] = Pack((r0 + 2 * r1 + 1) / 3, (g0 + 2 * g1 + 1) / 3, (b0 + 2 * b1 + 1) / 3, 255);
+        }
+        else
+        {
+            palette[2] = Pack((r0 + r1 + 1) / 2, (g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2, 255);
+            palette[3] = 0;
+        }
+    }
+
+    struct ColorCandidate
+    {
+        uint32_t Color0;
+        uint32_t Color1;
+        uint8_t Indices[16];
+        uint32_t Error;
+        bool FourColors;
+    };
+
+    //
+    // Orders the endpoints for the palette the block needs and picks its indices. BC1 has
+    // four colours when color0 > color1 and three plus transparent black otherwise; BC3
+    // always has four.
+    //
+    void EvaluateColor(const uint32_t texels[16], uint32_t opaque, bool threeColors, bool alwaysFour, uint32_t c0, uint32_t c1, ColorCandidate& candidate)
+    {
+        if (threeColors ? c0 > c1 : c0 < c1)
+        {
+            std::swap(c0, c1);
+        }
+
+        candidate.Color0 = c0;
+        candidate.Color1 = c1;
+        candidate.FourColors = alwaysFour || c0 > c1;
+
+        uint32_t palette[4];
+        ColorPalette(c0, c1, candidate.FourColors, palette);
+        candidate.Error = SelectIndices(texels, palette, candidate.FourColors ? 4 : 3, 0x00ffffff, opaque, candidate.Indices);
+
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            if (!(opaque & (1 << i)))
+            {
+                candidate.Indices[i] = 3;
+            }
+        }
+    }
+
+    void EncodeColor(const uint32_t texels[16], BCEncodeQuality quality, bool allowTransparent, uint8_t block[8])
+    {
+        uint32_t opaque = 0xffff;
+        if (allowTransparent)
+        {
+            opaque = 0;
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                if (Channel(texels[i], 3) >= 128)
+                {
+                    opaque |= 1 << i;
+                }
+            }
+        }
+
+        ColorCandidate best;
+        bool threeColors = opaque != 0xffff;
+        if (opaque == 0)
+        {
+            best.Color0 = best.Color1 = 0;
+            std::fill(best.Indices, best.Indices + 16, static_cast<uint8_t>(3));
+        }
+        else
+        {
+            BlockPoints points;
+            LoadPoints(texels, opaque, 0, 3, points);
+
+            float mean[4], axis[4], e0[4], e1[4];
+            PrincipalAxis(points, AxisIterations(quality), mean, axis);
+            AxisEndpoints(points, mean, axis, e0, e1);
+            EvaluateColor(texels, opaque, threeColors, !allowTransparent, Quantize565(e0), Quantize565(e1), best);
+
+            // refit the endpoints to the indices chosen, while that keeps helping
+            unsigned int refinements = Refinements(quality);
+            for (unsigned int r = 0; r < refinements && best.Error > 0; r++)
+            {
+                static const float fourFractions[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+                static const float threeFractions[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+                const float* table = best.FourColors ? fourFractions : threeFractions;
+
+                float fractions[16];
+                for (unsigned int i = 0; i < 16; i++)
+                {
+                    fractions[i] = table[best.Indices[i]];
+                }
+
+                ColorCandidate candidate;
+                if (!FitEndpoints(points, fractions, e0, e1))
+                {
+                    break;
+                }
+
+                EvaluateColor(texels, opaque, threeColors, !allowTransparent, Quantize565(e0), Quantize565(e1), candidate);
+                if (candidate.Error >= best.Error)
+                {
+                    break;
+                }
+                best = candidate;
+            }
+
+            // step each quantized endpoint channel by one while the error drops
+            if (quality == BC_ENCODE_HIGH)
+            {
+                static const uint32_t shifts[3] = { 11, 5, 0 };
+                static const uint32_t limits[3] = { 31, 63, 31 };
+
+                for (unsigned int pass = 0; pass < 8 && best.Error > 0; pass++)
+                {
+                    bool improved = false;
+                    for (unsigned int e = 0; e < 2; e++)
+                    {
+                        for (unsigned int c = 0; c < 3; c++)
+                        {
+                            for (int delta = -1; delta <= 1; delta += 2)
+                            {
+                                uint32_t color = e ? best.Color1 : best.Color0;
+                                int value = static_cast<int>((color >> shifts[c]) & limits[c]) + delta;
+                                if (value < 0 || value > static_cast<int>(limits[c]))
+                                {
+                                    continue;
+                                }
+
+                                color = (color & ~(limits[c] << shifts[c])) | (value << shifts[c]);
+                                ColorCandidate candidate;
+                                EvaluateColor(texels, opaque, threeColors, !allowTransparent,
+                                    e ? best.Color0 : color, e ? color : best.Color1, candidate);
+                                if (candidate.Error < best.Error)
+                                {
+                                    best = candidate;
+                                    improved = true;
+                                }
+                            }
+                        }
+                    }
+
+                    if (!improved)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        uint32_t indices = 0;
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            indices |= static_cast<uint32_t>(best.Indices[i]) << (2 * i);
+        }
+
+        block[0] = static_cast<uint8_t>(best.Color0);
+        block[1] = static_cast<uint8_t>(best.Color0 >> 8);
+        block[2] = static_cast<uint8_t>(best.Color1);
+        block[3] = static_cast<uint8_t>(best.Color1 >> 8);
+        memcpy(block + 4, &indices, 4);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // BC3 alpha, BC4 and BC5 channels
+    //
+    void ChannelPalette(int v0, int v1, int palette[8])
+    {
+        palette[0] = v0;
+        palette[1] = v1;
+        if (v0 > v1)
+        {
+            for (int i = 1; i < 7; i++)
+            {
+                palette[i + 1] = ((7 - i) * v0 + i * v1 + 3) / 7;
+            }
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+            {
+                palette[i + 1] = ((5 - i) * v0 + i * v1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    struct ChannelCandidate
+    {
+        int Value0;
+        int Value1;
+        uint8_t Indices[16];
+        uint32_t Error;
+    };
+
+    void EvaluateChannel(const int values[16], int v0, int v1, ChannelCandidate& candidate)
+    {
+        int palette[8];
+        ChannelPalette(v0, v1, palette);
+
+        candidate.Value0 = v0;
+        candidate.Value1 = v1;
+        candidate.Error = 0;
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            int best = INT32_MAX;
+            for (unsigned int p = 0; p < 8; p++)
+            {
+                int d = values[i] - palette[p];
+                if (d * d < best)
+                {
+                    best = d * d;
+                    candidate.Indices[i] = static_cast<uint8_t>(p);
+                }
+            }
+            candidate.Error += best;
+        }
+    }
+
+    void EncodeChannel(const uint32_t texels[16], unsigned int channel, BCEncodeQuality quality, uint8_t block[8])
+    {
+        int values[16];
+        int low = 255;
+        int high = 0;
+        int innerLow = 255;
+        int innerHigh = 0;
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            values[i] = Channel(texels[i], channel);
+            low = std::min(low, values[i]);
+            high = std::max(high, values[i]);
+            if (values[i] != 0 && values[i] != 255)
+            {
+                innerLow = std::min(innerLow, values[i]);
+                innerHigh = std::max(innerHigh, values[i]);
+            }
+        }
+
+        // eight interpolated values; equal endpoints give a constant block either way
+        ChannelCandidate best;
+        EvaluateChannel(values, high, low, best);
+
+        if (quality != BC_ENCODE_FAST && best.Error > 0)
+        {
+            // six values plus exact 0 and 255, for blocks that reach the extremes
+            ChannelCandidate candidate;
+            if ((low == 0 || high == 255) && innerLow <= innerHigh)
+            {
+                EvaluateChannel(values, innerLow, innerHigh, candidate);
+                if (candidate.Error < best.Error)
+                {
+                    best = candidate;
+                }
+            }
+
+            // refit the eight-value endpoints, whose index k > 1 lies (k - 1) / 7 along
+            if (best.Value0 > best.Value1)
+            {
+                BlockPoints points;
+                LoadPoints(texels, 0xffff, channel, 1, points);
+
+                float fractions[16];
+                for (unsigned int i = 0; i < 16; i++)
+                {
+                    uint8_t index = best.Indices[i];
+                    fractions[i] = index == 0 ? 0.0f : index == 1 ? 1.0f : (index - 1) / 7.0f;
+                }
+
+                float e0[4], e1[4];
+                if (FitEndpoints(points, fractions, e0, e1))
+                {
+                    int v0 = Round(e0[0]);
+                    int v1 = Round(e1[0]);
+                    if (v0 > v1)
+                    {
+                        EvaluateChannel(values, v0, v1, candidate);
+                        if (candidate.Error < best.Error)
+                        {
+                            best = candidate;
+                        }
+                    }
+                }
+            }
+        }
+
+        // a small window of endpoint pairs around the fit
+        if (quality == BC_ENCODE_HIGH && best.Error > 0)
+        {
+            int v0 = best.Value0;
+            int v1 = best.Value1;
+            for (int d0 = -2; d0 <= 2; d0++)
+            {
+                for (int d1 = -2; d1 <= 2; d1++)
+                {
+                    int c0 = v0 + d0;
+                    int c1 = v1 + d1;
+                    if ((d0 == 0 && d1 == 0) || c0 < 0 || c0 > 255 || c1 < 0 || c1 > 255)
+                    {
+                        continue;
+                    }
+
+                    ChannelCandidate candidate;
+                    EvaluateChannel(values, c0, c1, candidate);
+                    if (candidate.Error < best.Error)
+                    {
+                        best = candidate;
+                    }
+                }
+            }
+        }
+
+        uint64_t indices = 0;
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            indices |= static_cast<uint64_t>(best.Indices[i]) << (3 * i);
+        }
+
+        block[0] = static_cast<uint8_t>(best.Value0);
+        block[1] = static_cast<uint8_t>(best.Value1);
+        for (unsigned int i = 0; i < 6; i++)
+        {
+            block[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // BC7 in mode 6 (one subset, RGBA) and mode 1 (two subsets, RGB)
+    //
+    class BlockWriter
+    {
+    public:
+        BlockWriter() : m_low(0), m_high(0), m_position(0) {}
+
+        void Write(uint32_t value, unsigned int count)
+        {
+            uint64_t bits = value & ((1ull << count) - 1);
+            if (m_position < 64)
+            {
+                m_low |= bits << m_position;
+                if (m_position + count > 64)
+                {
+                    m_high |= bits >> (64 - m_position);
+                }
+            }
+            else
+            {
+                m_high |= bits << (m_position - 64);
+            }
+            m_position += count;
+        }
+
+        void Store(uint8_t* block) const
+        {
+            memcpy(block, &m_low, 8);
+            memcpy(block + 8, &m_high, 8);
+        }
+
+    private:
+        uint64_t m_low;
+        uint64_t m_high;
+        unsigned int m_position;
+    };
+
+    inline uint32_t Interpolate(uint32_t e0, uint32_t e1, uint32_t weight)
+    {
+        return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+    }
+
+    //
+    // colorBits-bit values plus a p-bit shared by the channels of both endpoints given;
+    // mode 6 passes one endpoint at a time
+    //
+    void QuantizeWithPBit(const float* const* endpoints, unsigned int endpointCount, unsigned int channels, unsigned int colorBits,
+        uint8_t quantized[2][4], uint8_t& pbit)
+    {
+        unsigned int bits = colorBits + 1;
+        int maximum = (1 << colorBits) - 1;
+        float scale = static_cast<float>((1 << bits) - 1) / 255.0f;
+
+        float bestError = FLT_MAX;
+        for (int p = 0; p < 2; p++)
+        {
+            float error = 0.0f;
+            uint8_t values[2][4] = {};
+            for (unsigned int e = 0; e < endpointCount; e++)
+            {
+                for (unsigned int c = 0; c < channels; c++)
+                {
+                    int value = Clamp(Round((endpoints[e][c] * scale - p) * 0.5f), 0, maximum);
+                    uint32_t full = (value << 1) | p;
+                    full = (full << (8 - bits)) | (full >> (2 * bits - 8));
+                    float d = endpoints[e][c] - full;
+                    error += d * d;
+                    values[e][c] = static_cast<uint8_t>(value);
+                }
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                pbit = static_cast<uint8_t>(p);
+                memcpy(quantized, values, sizeof(values));
+            }
+        }
+    }
+
+    inline uint32_t Unquantize(uint32_t value, uint32_t pbit, unsigned int colorBits)
+    {
+        unsigned int bits = colorBits + 1;
+        uint32_t full = (value << 1) | pbit;
+        return (full << (8 - bits)) | (full >> (2 * bits - 8));
+    }
+
+    struct BC7Candidate
+    {
+        unsigned int Mode;
+        unsigned int Partition;
+        uint8_t Endpoints[4][4];    // quantized, without their p-bits
+        uint8_t PBits[4];
+        uint8_t Indices[16];
+        uint32_t Error;
+    };
+
+    //
+    // mode 6: 7-bit RGBA endpoints with a p-bit each and 4-bit indices
+    //
+    void EvaluateMode6(const uint32_t texels[16], BC7Candidate& candidate)
+    {
+        uint32_t e0[4], e1[4];
+        for (unsigned int c = 0; c < 4; c++)
+        {
+            e0[c] = Unquantize(candidate.Endpoints[0][c], candidate.PBits[0], 7);
+            e1[c] = Unquantize(candidate.Endpoints[1][c], candidate.PBits[1], 7);
+        }
+
+        uint32_t palette[16];
+        for (unsigned int w = 0; w < 16; w++)
+        {
+            palette[w] = Pack(Interpolate(e0[0], e1[0], Weights4[w]), Interpolate(e0[1], e1[1], Weights4[w]),
+                Interpolate(e0[2], e1[2], Weights4[w]), Interpolate(e0[3], e1[3], Weights4[w]));
+        }
+
+        candidate.Mode = 6;
+        candidate.Partition = 0;
+        candidate.Error = SelectIndices(texels, palette, 16, 0xffffffff, 0xffff, candidate.Indices);
+
+        // texel 0 is stored with three bits, so its index must stay below 8
+        if (candidate.Indices[0] >= 8)
+        {
+            std::swap(candidate.Endpoints[0], candidate.Endpoints[1]);
+            std::swap(candidate.PBits[0], candidate.PBits[1]);
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                candidate.Indices[i] = static_cast<uint8_t>(15 - candidate.Indices[i]);
+            }
+        }
+    }
+
+    void QuantizeMode6(const float e0[4], const float e1[4], BC7Candidate& candidate)
+    {
+        uint8_t quantized[2][4];
+        const float* first[1] = { e0 };
+        QuantizeWithPBit(first, 1, 4, 7, quantized, candidate.PBits[0]);
+        memcpy(candidate.Endpoints[0], quantized[0], 4);
+
+        const float* second[1] = { e1 };
+        QuantizeWithPBit(second, 1, 4, 7, quantized, candidate.PBits[1]);
+        memcpy(candidate.Endpoints[1], quantized[0], 4);
+    }
+
+    void EncodeMode6(const uint32_t texels[16], BCEncodeQuality quality, BC7Candidate& best)
+    {
+        BlockPoints points;
+        LoadPoints(texels, 0xffff, 0, 4, points);
+
+        float mean[4], axis[4], e0[4], e1[4];
+        PrincipalAxis(points, AxisIterations(quality), mean, axis);
+        AxisEndpoints(points, mean, axis, e0, e1);
+        QuantizeMode6(e0, e1, best);
+        EvaluateMode6(texels, best);
+
+        unsigned int refinements = Refinements(quality);
+        for (unsigned int r = 0; r < refinements && best.Error > 0; r++)
+        {
+            float fractions[16];
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                fractions[i] = Weights4[best.Indices[i]] / 64.0f;
+            }
+
+            if (!FitEndpoints(points, fractions, e0, e1))
+            {
+                break;
+            }
+
+            BC7Candidate candidate;
+            QuantizeMode6(e0, e1, candidate);
+            EvaluateMode6(texels, candidate);
+            if (candidate.Error >= best.Error)
+            {
+                break;
+            }
+            best = candidate;
+        }
+
+        // step each quantized channel and flip each p-bit while the error drops
+        if (quality == BC_ENCODE_HIGH)
+        {
+            for (unsigned int pass = 0; pass < 4 && best.Error > 0; pass++)
+            {
+                bool improved = false;
+                for (unsigned int e = 0; e < 2; e++)
+                {
+                    for (unsigned int c = 0; c < 5; c++)
+                    {
+                        for (int delta = -1; delta <= 1; delta += 2)
+                        {
+                            BC7Candidate candidate = best;
+                            if (c == 4)
+                            {
+                                if (delta > 0)
+                                {
+                                    continue;
+                                }
+                                candidate.PBits[e] ^= 1;
+                            }
+                            else
+                            {
+                                int value = candidate.Endpoints[e][c] + delta;
+                                if (value < 0 || value > 127)
+                                {
+                                    continue;
+                                }
+                                candidate.Endpoints[e][c] = static_cast<uint8_t>(value);
+                            }
+
+                            EvaluateMode6(texels, candidate);
+                            if (candidate.Error < best.Error)
+                            {
+                                best = candidate;
+                                improved = true;
+                            }
+                        }
+                    }
+                }
+
+                if (!improved)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    //
+    // mode 1: two subsets of 6-bit RGB endpoints, a p-bit per subset and 3-bit indices
+    //
+    void EvaluateMode1(const uint32_t texels[16], BC7Candidate& candidate)
+    {
+        uint32_t subset1 = Partitions2[candidate.Partition];
+        uint32_t masks[2] = { ~subset1 & 0xffff, subset1 };
+        unsigned int anchors[2] = { 0, Anchors2[candidate.Partition] };
+
+        candidate.Mode = 1;
+        candidate.Error = 0;
+        for (unsigned int s = 0; s < 2; s++)
+        {
+            uint32_t e0[3], e1[3];
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                e0[c] = Unquantize(candidate.Endpoints[2 * s][c], candidate.PBits[s], 6);
+                e1[c] = Unquantize(candidate.Endpoints[2 * s + 1][c], candidate.PBits[s], 6);
+            }
+
+            uint32_t palette[8];
+            for (unsigned int w = 0; w < 8; w++)
+            {
+                palette[w] = Pack(Interpolate(e0[0], e1[0], Weights3[w]), Interpolate(e0[1], e1[1], Weights3[w]),
+                    Interpolate(e0[2], e1[2], Weights3[w]), 255);
+            }
+
+            uint8_t indices[16];
+            candidate.Error += SelectIndices(texels, palette, 8, 0x00ffffff, masks[s], indices);
+
+            bool flip = indices[anchors[s]] >= 4;
+            if (flip)
+            {
+                std::swap(candidate.Endpoints[2 * s], candidate.Endpoints[2 * s + 1]);
+            }
+
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                if (masks[s] & (1 << i))
+                {
+                    candidate.Indices[i] = static_cast<uint8_t>(flip ? 7 - indices[i] : indices[i]);
+                }
+            }
+        }
+    }
+
+    void QuantizeMode1(float endpoints[4][4], BC7Candidate& candidate)
+    {
+        for (unsigned int s = 0; s < 2; s++)
+        {
+            uint8_t quantized[2][4];
+            const float* pair[2] = { endpoints[2 * s], endpoints[2 * s + 1] };
+            QuantizeWithPBit(pair, 2, 3, 6, quantized, candidate.PBits[s]);
+            memcpy(candidate.Endpoints[2 * s], quantized[0], 4);
+            memcpy(candidate.Endpoints[2 * s + 1], quantized[1], 4);
+        }
+    }
+
+    void EncodeMode1(const uint32_t texels[16], BCEncodeQuality quality, BC7Candidate& best)
+    {
+        BlockPoints points;
+        LoadPoints(texels, 0xffff, 0, 3, points);
+
+        // rank the partitions by how far each subset lies from its own line
+        const unsigned int maximumTries = 4;
+        unsigned int tries = quality == BC_ENCODE_HIGH ? maximumTries : 1;
+        unsigned int ranked[maximumTries];
+        float rankedResidual[maximumTries];
+        for (unsigned int t = 0; t < tries; t++)
+        {
+            ranked[t] = 0;
+            rankedResidual[t] = FLT_MAX;
+        }
+
+        for (unsigned int partition = 0; partition < 64; partition++)
+        {
+            float total = 0.0f;
+            for (unsigned int s = 0; s < 2; s++)
+            {
+                points.Mask = s ? Partitions2[partition] : ~Partitions2[partition] & 0xffff;
+                float mean[4], axis[4], residual;
+                PrincipalAxis(points, 2, mean, axis, &residual);
+                total += residual;
+            }
+
+            for (unsigned int t = 0; t < tries; t++)
+            {
+                if (total < rankedResidual[t])
+                {
+                    for (unsigned int u = tries - 1; u > t; u--)
+                    {
+                        ranked[u] = ranked[u - 1];
+                        rankedResidual[u] = rankedResidual[u - 1];
+                    }
+                    ranked[t] = partition;
+                    rankedResidual[t] = total;
+                    break;
+                }
+            }
+        }
+
+        best.Error = UINT32_MAX;
+        for (unsigned int t = 0; t < tries; t++)
+        {
+            BC7Candidate candidate;
+            candidate.Partition = ranked[t];
+
+            float endpoints[4][4];
+            uint32_t masks[2] = { ~Partitions2[ranked[t]] & 0xffffu, Partitions2[ranked[t]] };
+            for (unsigned int s = 0; s < 2; s++)
+            {
+                points.Mask = masks[s];
+                float mean[4], axis[4];
+                PrincipalAxis(points, AxisIterations(quality), mean, axis);
+                AxisEndpoints(points, mean, axis, endpoints[2 * s], endpoints[2 * s + 1]);
+            }
+
+            QuantizeMode1(endpoints, candidate);
+            EvaluateMode1(texels, candidate);
+
+            unsigned int refinements = Refinements(quality);
+            for (unsigned int r = 0; r < refinements && candidate.Error > 0; r++)
+            {
+                float fractions[16];
+                for (unsigned int i = 0; i < 16; i++)
+                {
+                    fractions[i] = Weights3[candidate.Indices[i]] / 64.0f;
+                }
+
+                bool fitted = true;
+                for (unsigned int s = 0; s < 2 && fitted; s++)
+                {
+                    points.Mask = masks[s];
+                    fitted = FitEndpoints(points, fractions, endpoints[2 * s], endpoints[2 * s + 1]);
+                }
+
+                if (!fitted)
+                {
+                    break;
+                }
+
+                BC7Candidate refined;
+                refined.Partition = candidate.Partition;
+                QuantizeMode1(endpoints, refined);
+                EvaluateMode1(texels, refined);
+                if (refined.Error >= candidate.Error)
+                {
+                    break;
+                }
+                candidate = refined;
+            }
+
+            if (candidate.Error < best.Error)
+            {
+                best = candidate;
+            }
+        }
+    }
+
+    void WriteBC7(const BC7Candidate& candidate, uint8_t block[16])
+    {
+        BlockWriter writer;
+        if (candidate.Mode == 6)
+        {
+            writer.Write(1 << 6, 7);
+            for (unsigned int c = 0; c < 4; c++)
+            {
+                writer.Write(candidate.Endpoints[0][c], 7);
+                writer.Write(candidate.Endpoints[1][c], 7);
+            }
+
+            writer.Write(candidate.PBits[0], 1);
+            writer.Write(candidate.PBits[1], 1);
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                writer.Write(candidate.Indices[i], i == 0 ? 3 : 4);
+            }
+        }
+        else
+        {
+            writer.Write(1 << 1, 2);
+            writer.Write(candidate.Partition, 6);
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                for (unsigned int e = 0; e < 4; e++)
+                {
+                    writer.Write(candidate.Endpoints[e][c], 6);
+                }
+            }
+
+            writer.Write(candidate.PBits[0], 1);
+            writer.Write(candidate.PBits[1], 1);
+
+            unsigned int anchor = Anchors2[candidate.Partition];
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                writer.Write(candidate.Indices[i], (i == 0 || i == anchor) ? 2 : 3);
+            }
+        }
+
+        writer.Store(block);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Whole surfaces
+    //
+    typedef void (*BlockEncoder)(const uint32_t texels[16], BCEncodeQuality quality, uint8_t* block);
+
+    BlockEncoder FindEncoder(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return &EncodeBC1Block;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return &EncodeBC3Block;
+
+        case DXGI_FORMAT_BC4_UNORM:
+            return &EncodeBC4Block;
+
+        case DXGI_FORMAT_BC5_UNORM:
+            return &EncodeBC5Block;
+
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return &EncodeBC7Block;
+
+        default:
+            return nullptr;
+        }
+    }
+
+    struct EncodeRows
+    {
+        BlockEncoder Encoder;
+        BCEncodeQuality Quality;
+        const uint8_t* Source;
+        size_t SourceRowPitch;
+        uint32_t Width;
+        uint32_t Height;
+        uint8_t* Destination;
+        size_t DestinationRowPitch;
+        size_t BlockBytes;
+
+        void operator()(unsigned int begin, unsigned int end) const
+        {
+            uint32_t texels[16];
+            uint32_t blocksWide = (Width + 3) / 4;
+            for (unsigned int row = begin; row < end; row++)
+            {
+                uint8_t* block = Destination + row * DestinationRowPitch;
+                for (uint32_t blockX = 0; blockX < blocksWide; blockX++, block += BlockBytes)
+                {
+                    for (uint32_t y = 0; y < 4; y++)
+                    {
+                        const uint8_t* sourceRow = Source + std::min(row * 4 + y, Height - 1) * SourceRowPitch;
+                        for (uint32_t x = 0; x < 4; x++)
+                        {
+                            memcpy(&texels[4 * y + x], sourceRow + std::min(blockX * 4 + x, Width - 1) * 4, 4);
+                        }
+                    }
+
+                    Encoder(texels, Quality, block);
+                }
+            }
+        }
+    };
+
+    //
+    // soft gradients, hard edges and noise in colour, with alpha kept opaque enough for BC1
+    //
+    void MakeTestPattern(uint32_t size, std::vector<uint32_t>& texels)
+    {
+        texels.resize(static_cast<size_t>(size) * size);
+        uint32_t random = 0x2545f491;
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                random = random * 1664525 + 1013904223;
+                uint32_t noise = random >> 28;
+                uint32_t r = x * 255 / size;
+                uint32_t g = ((x / 16 + y / 16) & 1) ? 200 : 40;
+                uint32_t b = std::min<uint32_t>(y * 255 / size + noise, 255);
+                uint32_t a = 128 + ((x + y) * 127) / (2 * size);
+                texels[static_cast<size_t>(y) * size + x] = Pack(r, g, b, a);
+            }
+        }
+    }
+}
+
+void DirectX::EncodeBC1Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[8])
+{
+    EncodeColor(texels, quality, true, block);
+}
+
+void DirectX::EncodeBC3Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[16])
+{
+    EncodeChannel(texels, 3, quality, block);
+    EncodeColor(texels, quality, false, block + 8);
+}
+
+void DirectX::EncodeBC4Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[8])
+{
+    EncodeChannel(texels, 0, quality, block);
+}
+
+void DirectX::EncodeBC5Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[16])
+{
+    EncodeChannel(texels, 0, quality, block);
+    EncodeChannel(texels, 1, quality, block + 8);
+}
+
+void DirectX::EncodeBC7Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[16])
+{
+    BC7Candidate best;
+    EncodeMode6(texels, quality, best);
+
+    // opaque blocks may do better split in two
+    bool opaque = true;
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        opaque = opaque && Channel(texels[i], 3) == 255;
+    }
+
+    if (opaque && quality != BC_ENCODE_FAST && best.Error > 0)
+    {
+        BC7Candidate partitioned;
+        EncodeMode1(texels, quality, partitioned);
+        if (partitioned.Error < best.Error)
+        {
+            best = partitioned;
+        }
+    }
+
+    WriteBC7(best, block);
+}
+
+bool DirectX::CanEncodeBC(DXGI_FORMAT format)
+{
+    return FindEncoder(format) != nullptr;
+}
+
+bool DirectX::EncodeBC(DXGI_FORMAT format, const uint8_t* source, size_t sourceRowPitch, uint32_t width, uint32_t height,
+    uint8_t* destination, size_t destinationRowPitch, BCEncodeQuality quality, JobSystem* jobs)
+{
+    BlockEncoder encoder = FindEncoder(format);
+    if (!encoder || width == 0 || height == 0)
+    {
+        return encoder != nullptr;
+    }
+
+    EncodeRows rows;
+    rows.Encoder = encoder;
+    rows.Quality = quality;
+    rows.Source = source;
+    rows.SourceRowPitch = sourceRowPitch;
+    rows.Width = width;
+    rows.Height = height;
+    rows.Destination = destination;
+    rows.DestinationRowPitch = destinationRowPitch;
+    rows.BlockBytes = BitsPerPixel(format) * 2;
+
+    unsigned int rowCount = (height + 3) / 4;
+    if (jobs)
+    {
+        jobs->ParallelFor(0, rowCount, 1, rows);
+    }
+    else
+    {
+        rows(0, rowCount);
+    }
+
+    return true;
+}
+
+void DirectX::RunBCEncodeBenchmark(JobSystem* jobs, std::vector<BCEncodeBenchmarkResult>& results, uint32_t size)
+{
+    static const DXGI_FORMAT formats[] =
+    {
+        DXGI_FORMAT_BC1_UNORM,
+        DXGI_FORMAT_BC3_UNORM,
+        DXGI_FORMAT_BC4_UNORM,
+        DXGI_FORMAT_BC5_UNORM,
+        DXGI_FORMAT_BC7_UNORM,
+    };
+
+    results.clear();
+
+    std::vector<uint32_t> pattern;
+    MakeTestPattern(size, pattern);
+    const uint8_t* source = reinterpret_cast<const uint8_t*>(pattern.data());
+
+    std::vector<uint8_t> blocks;
+    std::vector<uint32_t> decoded(pattern.size());
+    double megapixels = static_cast<double>(size) * size * 1e-6;
+
+    for (DXGI_FORMAT format : formats)
+    {
+        DDSSubresource encoded;
+        GetSurfaceInfo(size, size, format, &encoded.SlicePitch, &encoded.RowPitch, &encoded.RowCount);
+        encoded.Width = size;
+        encoded.Height = size;
+        encoded.Depth = 1;
+        blocks.resize(encoded.SlicePitch);
+        encoded.Data = blocks.data();
+
+        // the channels each format stores
+        unsigned int channels = format == DXGI_FORMAT_BC4_UNORM ? 1 : format == DXGI_FORMAT_BC5_UNORM ? 2 : format == DXGI_FORMAT_BC1_UNORM ? 3 : 4;
+
+        for (int quality = BC_ENCODE_FAST; quality <= BC_ENCODE_HIGH; quality++)
+        {
+            BCEncodeBenchmarkResult result;
+            result.Format = format;
+            result.Quality = static_cast<BCEncodeQuality>(quality);
+
+            int64_t start = GameClock::Now();
+            EncodeBC(format, source, size * 4, size, size, blocks.data(), encoded.RowPitch, result.Quality, jobs);
+            result.MegapixelsPerSecond = megapixels / ((GameClock::Now() - start) * 1e-9);
+
+            DecodeBC(format, encoded, reinterpret_cast<uint8_t*>(decoded.data()), size * 4);
+
+            double squaredError = 0.0;
+            for (size_t i = 0; i < pattern.size(); i++)
+            {
+                for (unsigned int c = 0; c < channels; c++)
+                {
+                    double d = static_cast<double>(Channel(pattern[i], c)) - Channel(decoded[i], c);
+                    squaredError += d * d;
+                }
+            }
+
+            double meanSquaredError = squaredError / (pattern.size() * channels);
+            result.PeakSignalToNoise = meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : 99.0;
+            results.push_back(result);
+        }
+    }
+}
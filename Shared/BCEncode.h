@@ -0,0 +1,70 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "DDSTexture.h"
+
+class JobSystem;
+
+namespace DirectX
+{
+    //
+    // Fast fits endpoints to the principal axis of each block. Normal refines them by
+    // least squares and lets BC7 try partitioned blocks; high refines further and searches
+    // the quantized endpoints around the fit.
+    //
+    enum BCEncodeQuality
+    {
+        BC_ENCODE_FAST,
+        BC_ENCODE_NORMAL,
+        BC_ENCODE_HIGH,
+    };
+
+    //
+    // Block encoders. Each takes the 16 texels of one 4x4 block row by row, packed as
+    // R8G8B8A8 (red in the low byte) like the decoders write them. BC1 keeps texels with
+    // alpha below 128 transparent; BC4 encodes red and BC5 red and green.
+    //
+    void EncodeBC1Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[8]);
+    void EncodeBC3Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[16]);
+    void EncodeBC4Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[8]);
+    void EncodeBC5Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[16]);
+    void EncodeBC7Block(const uint32_t texels[16], BCEncodeQuality quality, uint8_t block[16]);
+
+    //
+    // BC1, BC3 and BC7 in UNORM or sRGB, BC4 and BC5 UNORM
+    //
+    bool CanEncodeBC(DXGI_FORMAT format);
+
+    //
+    // Encodes width x height R8G8B8A8 texels, rows sourceRowPitch bytes apart, into rows of
+    // blocks destinationRowPitch bytes apart. Blocks crossing the right or bottom edge
+    // repeat the last column and row. With jobs, rows of blocks are encoded in parallel.
+    // Returns false for formats CanEncodeBC rejects.
+    //
+    bool EncodeBC(DXGI_FORMAT format, const uint8_t* source, size_t sourceRowPitch, uint32_t width, uint32_t height,
+        uint8_t* destination, size_t destinationRowPitch, BCEncodeQuality quality, JobSystem* jobs = nullptr);
+
+    struct BCEncodeBenchmarkResult
+    {
+        DXGI_FORMAT Format;
+        BCEncodeQuality Quality;
+        double MegapixelsPerSecond;
+        double PeakSignalToNoise;       // in dB over the channels the format stores
+    };
+
+    //
+    // encodes a size x size test pattern of gradients, edges and noise in every format and
+    // quality, spreading the blocks over jobs when given, and measures the decoded error
+    //
+    void RunBCEncodeBenchmark(JobSystem* jobs, std::vector<BCEncodeBenchmarkResult>& results, uint32_t size = 256);
+}
@@ -0,0 +1,1182 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "BCDecode.h"
+#include "BPTCTables.h"
+
+using namespace DirectX;
+using namespace DirectX::BPTC;
+
+namespace DirectX
+{
+    namespace BPTC
+    {
+        const uint8_t Weights2[4] = { 0, 21, 43, 64 };
+        const uint8_t Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+        const uint8_t Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        const uint16_t Partitions2[64] =
+        {
+            0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+            0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+            0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+            0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+            0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+            0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+            0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+            0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+        };
+
+        const uint8_t Anchors2[64] =
+        {
+            15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+            15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+            15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+             6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+        };
+    }
+}
+
+//
+// BC6H and BC7 (BPTC) blocks: the generic decoders are driven by the mode tables of the
+// Direct3D 11 specification; the modes encoders favour have fast paths of their own.
+//
+namespace
+{
+    //
+    // reads fields LSB first from a 128-bit block
+    //
+    class BlockBits
+    {
+    public:
+        explicit BlockBits(const uint8_t* block) : m_position(0)
+        {
+            memcpy(&m_low, block, 8);
+            memcpy(&m_high, block + 8, 8);
+        }
+
+        uint32_t Read(unsigned int count)
+        {
+            uint64_t value;
+            if (m_position >= 64)
+            {
+                value = m_high >> (m_position - 64);
+            }
+            else if (m_position == 0)
+            {
+                value = m_low;
+            }
+            else
+            {
+                value = (m_low >> m_position) | (m_high << (64 - m_position));
+            }
+
+            m_position += count;
+            return static_cast<uint32_t>(value & ((1ull << count) - 1));
+        }
+
+        void Skip(unsigned int count) { m_position += count; }
+
+    private:
+        uint64_t m_low;
+        uint64_t m_high;
+        unsigned int m_position;
+    };
+
+    inline uint32_t Pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    const uint8_t* Weights(unsigned int indexBits)
+    {
+        return indexBits == 2 ? Weights2 : indexBits == 3 ? Weights3 : Weights4;
+    }
+
+    inline uint32_t Interpolate(uint32_t e0, uint32_t e1, uint32_t weight)
+    {
+        return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+    }
+
+    //
+    // subset of each texel for three subsets, two bits per texel
+    //
+    const uint32_t s_partitions3[64] =
+    {
+        0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+        0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+        0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+        0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+        0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+        0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+        0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+        0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+    };
+
+    //
+    // anchor texels, whose index drops its top bit: texel 0 for the first subset and these
+    // for the others
+    //
+    const uint8_t s_anchors3Second[64] =
+    {
+         3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+         3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+         8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+         3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+    };
+
+    const uint8_t s_anchors3Third[64] =
+    {
+        15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+        15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+        15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+        15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // BC7
+    //
+    struct BC7Mode
+    {
+        uint8_t Subsets;
+        uint8_t PartitionBits;
+        uint8_t RotationBits;
+        uint8_t IndexSelectionBits;
+        uint8_t ColorBits;
+        uint8_t AlphaBits;          // 0 when alpha is always opaque
+        uint8_t EndpointPBits;      // a p-bit per endpoint
+        uint8_t SharedPBits;        // a p-bit per subset
+        uint8_t IndexBits;
+        uint8_t SecondaryIndexBits;
+    };
+
+    const BC7Mode s_bc7Modes[8] =
+    {
+        { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+    };
+
+    inline uint32_t Expand(uint32_t value, unsigned int bits)
+    {
+        value <<= 8 - bits;
+        return value | (value >> bits);
+    }
+
+    //
+    // the mode with the lowest set bit; a zero first byte is no mode and decodes to
+    // transparent black
+    //
+    inline int BC7ModeOf(const uint8_t* block)
+    {
+        for (int mode = 0; mode < 8; mode++)
+        {
+            if (block[0] & (1 << mode))
+            {
+                return mode;
+            }
+        }
+
+        return -1;
+    }
+
+    void DecodeBC7Generic(const uint8_t* block, int modeIndex, uint32_t texels[16])
+    {
+        const BC7Mode& mode = s_bc7Modes[modeIndex];
+        BlockBits bits(block);
+        bits.Skip(modeIndex + 1);
+
+        uint32_t partition = bits.Read(mode.PartitionBits);
+        uint32_t rotation = bits.Read(mode.RotationBits);
+        uint32_t indexSelection = bits.Read(mode.IndexSelectionBits);
+
+        // endpoints in subset order, two per subset, RGBA
+        unsigned int endpointCount = mode.Subsets * 2;
+        uint32_t endpoints[6][4];
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            for (unsigned int e = 0; e < endpointCount; e++)
+            {
+                endpoints[e][c] = bits.Read(mode.ColorBits);
+            }
+        }
+
+        for (unsigned int e = 0; e < endpointCount; e++)
+        {
+            endpoints[e][3] = bits.Read(mode.AlphaBits);
+        }
+
+        unsigned int colorBits = mode.ColorBits;
+        unsigned int alphaBits = mode.AlphaBits;
+        if (mode.EndpointPBits || mode.SharedPBits)
+        {
+            uint32_t pbits[6];
+            if (mode.EndpointPBits)
+            {
+                for (unsigned int e = 0; e < endpointCount; e++)
+                {
+                    pbits[e] = bits.Read(1);
+                }
+            }
+            else
+            {
+                for (unsigned int s = 0; s < mode.Subsets; s++)
+                {
+                    pbits[2 * s] = pbits[2 * s + 1] = bits.Read(1);
+                }
+            }
+
+            for (unsigned int e = 0; e < endpointCount; e++)
+            {
+                for (unsigned int c = 0; c < 4; c++)
+                {
+                    endpoints[e][c] = (endpoints[e][c] << 1) | pbits[e];
+                }
+            }
+
+            colorBits++;
+            if (alphaBits)
+            {
+                alphaBits++;
+            }
+        }
+
+        for (unsigned int e = 0; e < endpointCount; e++)
+        {
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                endpoints[e][c] = Expand(endpoints[e][c], colorBits);
+            }
+
+            endpoints[e][3] = alphaBits ? Expand(endpoints[e][3], alphaBits) : 255;
+        }
+
+        // subset and anchor of every texel
+        uint32_t subsets;
+        unsigned int anchor2 = 0;
+        unsigned int anchor3 = 0;
+        if (mode.Subsets == 2)
+        {
+            subsets = 0;
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                subsets |= ((Partitions2[partition] >> i) & 1) << (2 * i);
+            }
+
+            anchor2 = Anchors2[partition];
+        }
+        else if (mode.Subsets == 3)
+        {
+            subsets = s_partitions3[partition];
+            anchor2 = s_anchors3Second[partition];
+            anchor3 = s_anchors3Third[partition];
+        }
+        else
+        {
+            subsets = 0;
+        }
+
+        uint8_t indices[16];
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            bool anchor = i == 0 || (mode.Subsets > 1 && i == anchor2) || (mode.Subsets > 2 && i == anchor3);
+            indices[i] = static_cast<uint8_t>(bits.Read(mode.IndexBits - (anchor ? 1 : 0)));
+        }
+
+        // the second index set, which one of colour or alpha takes
+        uint8_t secondary[16];
+        if (mode.SecondaryIndexBits)
+        {
+            for (unsigned int i = 0; i < 16; i++)
+            {
+                secondary[i] = static_cast<uint8_t>(bits.Read(mode.SecondaryIndexBits - (i == 0 ? 1 : 0)));
+            }
+        }
+
+        const uint8_t* colorWeights = Weights(mode.IndexBits);
+        const uint8_t* alphaWeights = colorWeights;
+        const uint8_t* colorIndices = indices;
+        const uint8_t* alphaIndices = indices;
+        if (mode.SecondaryIndexBits)
+        {
+            alphaWeights = Weights(mode.SecondaryIndexBits);
+            alphaIndices = secondary;
+            if (indexSelection)
+            {
+                std::swap(colorWeights, alphaWeights);
+                std::swap(colorIndices, alphaIndices);
+            }
+        }
+
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            const uint32_t* e0 = endpoints[2 * ((subsets >> (2 * i)) & 3)];
+            const uint32_t* e1 = e0 + 4;
+            uint32_t cw = colorWeights[colorIndices[i]];
+            uint32_t aw = alphaWeights[alphaIndices[i]];
+
+            uint32_t channels[4] =
+            {
+                Interpolate(e0[0], e1[0], cw),
+                Interpolate(e0[1], e1[1], cw),
+                Interpolate(e0[2], e1[2], cw),
+                Interpolate(e0[3], e1[3], aw),
+            };
+
+            // rotation swaps alpha with red, green or blue
+            if (rotation)
+            {
+                std::swap(channels[3], channels[rotation - 1]);
+            }
+
+            texels[i] = Pack(channels[0], channels[1], channels[2], channels[3]);
+        }
+    }
+
+    //
+    // mode 6: one subset, 7-bit RGBA endpoints with p-bits and 4-bit indices, the mode
+    // encoders pick for most smooth colour and alpha; every field sits at a fixed position
+    //
+    void DecodeBC7Mode6(const uint8_t* block, uint32_t texels[16])
+    {
+        uint64_t low;
+        uint64_t high;
+        memcpy(&low, block, 8);
+        memcpy(&high, block + 8, 8);
+
+        uint32_t p0 = static_cast<uint32_t>(low >> 63);
+        uint32_t p1 = static_cast<uint32_t>(high & 1);
+
+        uint32_t e0[4];
+        uint32_t e1[4];
+        for (unsigned int c = 0; c < 4; c++)
+        {
+            e0[c] = (static_cast<uint32_t>(low >> (7 + 14 * c)) & 0x7f) << 1 | p0;
+            e1[c] = (static_cast<uint32_t>(low >> (14 + 14 * c)) & 0x7f) << 1 | p1;
+        }
+
+        uint32_t palette[16];
+        for (unsigned int w = 0; w < 16; w++)
+        {
+            uint32_t weight = Weights4[w];
+            palette[w] = Pack(Interpolate(e0[0], e1[0], weight), Interpolate(e0[1], e1[1], weight),
+                Interpolate(e0[2], e1[2], weight), Interpolate(e0[3], e1[3], weight));
+        }
+
+        // texel 0 has three index bits, the rest four
+        uint64_t indices = high >> 1;
+        texels[0] = palette[indices & 7];
+        indices >>= 3;
+        for (unsigned int i = 1; i < 16; i++, indices >>= 4)
+        {
+            texels[i] = palette[indices & 15];
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // BC6H
+    //
+    enum BC6HField : uint8_t
+    {
+        // endpoint w, x, y, z times channel r, g, b, then the partition
+        RW, GW, BW, RX, GX, BX, RY, GY, BY, RZ, GZ, BZ, PD,
+    };
+
+    //
+    // a run of bits of one field, read from First towards Last; a few modes store the top
+    // bits of w in reverse
+    //
+    struct BC6HBits
+    {
+        BC6HField Field;
+        uint8_t First;
+        uint8_t Last;
+    };
+
+    struct BC6HMode
+    {
+        uint8_t Value;
+        bool Transformed;           // x, y and z are deltas from w
+        uint8_t EndpointBits;
+        uint8_t DeltaBits[3];
+        uint8_t Regions;
+        uint8_t BitsCount;
+        BC6HBits Bits[24];
+    };
+
+    const BC6HMode s_bc6hModes[14] =
+    {
+        { 0x00, true, 10, { 5, 5, 5 }, 2, 20,
+            { { GY, 4, 4 }, { BY, 4, 4 }, { BZ, 4, 4 }, { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 },
+              { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 },
+              { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 },
+              { BZ, 3, 3 }, { PD, 0, 4 } } },
+        { 0x01, true, 7, { 6, 6, 6 }, 2, 24,
+            { { GY, 5, 5 }, { GZ, 4, 4 }, { GZ, 5, 5 }, { RW, 0, 6 }, { BZ, 0, 0 }, { BZ, 1, 1 },
+              { BY, 4, 4 }, { GW, 0, 6 }, { BY, 5, 5 }, { BZ, 2, 2 }, { GY, 4, 4 }, { BW, 0, 6 },
+              { BZ, 3, 3 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 5 },
+              { GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 5 }, { RZ, 0, 5 }, { PD, 0, 4 } } },
+        { 0x02, true, 11, { 5, 4, 4 }, 2, 19,
+            { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 4 }, { RW, 10, 10 }, { GY, 0, 3 },
+              { GX, 0, 3 }, { GW, 10, 10 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 3 }, { BW, 10, 10 },
+              { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 },
+              { PD, 0, 4 } } },
+        { 0x06, true, 11, { 4, 5, 4 }, 2, 21,
+            { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 10, 10 }, { GZ, 4, 4 },
+              { GY, 0, 3 }, { GX, 0, 4 }, { GW, 10, 10 }, { GZ, 0, 3 }, { BX, 0, 3 }, { BW, 10, 10 },
+              { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 3 }, { BZ, 0, 0 }, { BZ, 2, 2 }, { RZ, 0, 3 },
+              { GY, 4, 4 }, { BZ, 3, 3 }, { PD, 0, 4 } } },
+        { 0x0a, true, 11, { 4, 4, 5 }, 2, 21,
+            { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 10, 10 }, { BY, 4, 4 },
+              { GY, 0, 3 }, { GX, 0, 3 }, { GW, 10, 10 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 },
+              { BW, 10, 10 }, { BY, 0, 3 }, { RY, 0, 3 }, { BZ, 1, 1 }, { BZ, 2, 2 }, { RZ, 0, 3 },
+              { BZ, 4, 4 }, { BZ, 3, 3 }, { PD, 0, 4 } } },
+        { 0x0e, true, 9, { 5, 5, 5 }, 2, 20,
+            { { RW, 0, 8 }, { BY, 4, 4 }, { GW, 0, 8 }, { GY, 4, 4 }, { BW, 0, 8 }, { BZ, 4, 4 },
+              { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 }, { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 },
+              { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 }, { BZ, 2, 2 }, { RZ, 0, 4 },
+              { BZ, 3, 3 }, { PD, 0, 4 } } },
+        { 0x12, true, 8, { 6, 5, 5 }, 2, 20,
+            { { RW, 0, 7 }, { GZ, 4, 4 }, { BY, 4, 4 }, { GW, 0, 7 }, { BZ, 2, 2 }, { GY, 4, 4 },
+              { BW, 0, 7 }, { BZ, 3, 3 }, { BZ, 4, 4 }, { RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 4 },
+              { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 5 },
+              { RZ, 0, 5 }, { PD, 0, 4 } } },
+        { 0x16, true, 8, { 5, 6, 5 }, 2, 22,
+            { { RW, 0, 7 }, { BZ, 0, 0 }, { BY, 4, 4 }, { GW, 0, 7 }, { GY, 5, 5 }, { GY, 4, 4 },
+              { BW, 0, 7 }, { GZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 },
+              { GX, 0, 5 }, { GZ, 0, 3 }, { BX, 0, 4 }, { BZ, 1, 1 }, { BY, 0, 3 }, { RY, 0, 4 },
+              { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { PD, 0, 4 } } },
+        { 0x1a, true, 8, { 5, 5, 6 }, 2, 22,
+            { { RW, 0, 7 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 0, 7 }, { BY, 5, 5 }, { GY, 4, 4 },
+              { BW, 0, 7 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 4 }, { GZ, 4, 4 }, { GY, 0, 3 },
+              { GX, 0, 4 }, { BZ, 0, 0 }, { GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 4 },
+              { BZ, 2, 2 }, { RZ, 0, 4 }, { BZ, 3, 3 }, { PD, 0, 4 } } },
+        { 0x1e, false, 6, { 6, 6, 6 }, 2, 24,
+            { { RW, 0, 5 }, { GZ, 4, 4 }, { BZ, 0, 0 }, { BZ, 1, 1 }, { BY, 4, 4 }, { GW, 0, 5 },
+              { GY, 5, 5 }, { BY, 5, 5 }, { BZ, 2, 2 }, { GY, 4, 4 }, { BW, 0, 5 }, { GZ, 5, 5 },
+              { BZ, 3, 3 }, { BZ, 5, 5 }, { BZ, 4, 4 }, { RX, 0, 5 }, { GY, 0, 3 }, { GX, 0, 5 },
+              { GZ, 0, 3 }, { BX, 0, 5 }, { BY, 0, 3 }, { RY, 0, 5 }, { RZ, 0, 5 }, { PD, 0, 4 } } },
+        { 0x03, false, 10, { 10, 10, 10 }, 1, 6,
+            { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 9 }, { GX, 0, 9 }, { BX, 0, 9 } } },
+        { 0x07, true, 11, { 9, 9, 9 }, 1, 9,
+            { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 8 }, { RW, 10, 10 }, { GX, 0, 8 },
+              { GW, 10, 10 }, { BX, 0, 8 }, { BW, 10, 10 } } },
+        { 0x0b, true, 12, { 8, 8, 8 }, 1, 9,
+            { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 7 }, { RW, 11, 10 }, { GX, 0, 7 },
+              { GW, 11, 10 }, { BX, 0, 7 }, { BW, 11, 10 } } },
+        { 0x0f, true, 16, { 4, 4, 4 }, 1, 9,
+            { { RW, 0, 9 }, { GW, 0, 9 }, { BW, 0, 9 }, { RX, 0, 3 }, { RW, 15, 10 }, { GX, 0, 3 },
+              { GW, 15, 10 }, { BX, 0, 3 }, { BW, 15, 10 } } },
+    };
+
+    //
+    // the table entry for each mode value: two bits below 2, five bits otherwise
+    //
+    const BC6HMode* BC6HModeOf(const uint8_t* block)
+    {
+        uint32_t value = block[0] & 3;
+        if (value > 1)
+        {
+            value = block[0] & 0x1f;
+        }
+
+        for (const BC6HMode& mode : s_bc6hModes)
+        {
+            if (mode.Value == value)
+            {
+                return &mode;
+            }
+        }
+
+        return nullptr;
+    }
+
+    inline int SignExtend(int value, unsigned int bits)
+    {
+        int sign = 1 << (bits - 1);
+        return (value & (sign - 1)) - (value & sign);
+    }
+
+    int Unquantize(int value, unsigned int bits, bool isSigned)
+    {
+        if (!isSigned)
+        {
+            if (bits >= 15 || value == 0)
+            {
+                return value;
+            }
+
+            return value == (1 << bits) - 1 ? 0xffff : ((value << 16) + 0x8000) >> bits;
+        }
+
+        if (bits >= 16)
+        {
+            return value;
+        }
+
+        bool negative = value < 0;
+        int magnitude = negative ? -value : value;
+        int result;
+        if (magnitude == 0)
+        {
+            result = 0;
+        }
+        else if (magnitude >= (1 << (bits - 1)) - 1)
+        {
+            result = 0x7fff;
+        }
+        else
+        {
+            result = ((magnitude << 15) + 0x4000) >> (bits - 1);
+        }
+
+        return negative ? -result : result;
+    }
+
+    //
+    // scales an interpolated value into the bit pattern of a half
+    //
+    inline uint16_t FinishUnquantize(int value, bool isSigned)
+    {
+        if (!isSigned)
+        {
+            return static_cast<uint16_t>((value * 31) >> 6);
+        }
+
+        if (value < 0)
+        {
+            return static_cast<uint16_t>(0x8000 | (((-value) * 31) >> 5));
+        }
+
+        return static_cast<uint16_t>((value * 31) >> 5);
+    }
+
+    const uint16_t HalfOne = 0x3c00;
+
+    //
+    // interpolates the unquantized endpoints of each region with the block's indices,
+    // which follow the header at the block's last 63 (one region) or 46 (two) bits
+    //
+    void InterpolateBC6H(const uint8_t* block, const int endpoints[4][3], unsigned int regions, uint32_t partition, bool isSigned, uint16_t texels[64])
+    {
+        BlockBits bits(block);
+        unsigned int indexBits = regions == 1 ? 4 : 3;
+        bits.Skip(regions == 1 ? 65 : 82);
+
+        uint32_t subsets = regions == 1 ? 0 : Partitions2[partition];
+        unsigned int anchor = regions == 1 ? 0 : Anchors2[partition];
+        const uint8_t* weights = Weights(indexBits);
+
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            bool isAnchor = i == 0 || (regions == 2 && i == anchor);
+            int weight = weights[bits.Read(indexBits - (isAnchor ? 1 : 0))];
+            const int* e0 = endpoints[2 * ((subsets >> i) & 1)];
+            const int* e1 = e0 + 3;
+
+            uint16_t* texel = texels + 4 * i;
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                texel[c] = FinishUnquantize((e0[c] * (64 - weight) + e1[c] * weight + 32) >> 6, isSigned);
+            }
+
+            texel[3] = HalfOne;
+        }
+    }
+
+    void DecodeBC6HGeneric(const uint8_t* block, const BC6HMode& mode, bool isSigned, uint16_t texels[64])
+    {
+        BlockBits bits(block);
+        bits.Skip(mode.Value < 2 ? 2 : 5);
+
+        int fields[13] = {};
+        for (unsigned int f = 0; f < mode.BitsCount; f++)
+        {
+            const BC6HBits& run = mode.Bits[f];
+            if (run.Last >= run.First)
+            {
+                fields[run.Field] |= bits.Read(run.Last - run.First + 1) << run.First;
+                continue;
+            }
+
+            for (int bit = run.First; bit >= run.Last; bit--)
+            {
+                fields[run.Field] |= bits.Read(1) << bit;
+            }
+        }
+
+        int endpoints[4][3];
+        unsigned int endpointCount = mode.Regions * 2;
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            int base = fields[c];
+            if (isSigned)
+            {
+                base = SignExtend(base, mode.EndpointBits);
+            }
+
+            endpoints[0][c] = base;
+            for (unsigned int e = 1; e < endpointCount; e++)
+            {
+                int value = fields[3 * e + c];
+                if (isSigned || mode.Transformed)
+                {
+                    value = SignExtend(value, mode.DeltaBits[c]);
+                }
+
+                if (mode.Transformed)
+                {
+                    value = (base + value) & ((1 << mode.EndpointBits) - 1);
+                    if (isSigned)
+                    {
+                        value = SignExtend(value, mode.EndpointBits);
+                    }
+                }
+
+                endpoints[e][c] = value;
+            }
+
+            for (unsigned int e = 0; e < endpointCount; e++)
+            {
+                endpoints[e][c] = Unquantize(endpoints[e][c], mode.EndpointBits, isSigned);
+            }
+        }
+
+        InterpolateBC6H(block, endpoints, mode.Regions, fields[PD], isSigned, texels);
+    }
+
+    //
+    // mode 0x03: one region of plain 10-bit endpoints, no deltas to resolve
+    //
+    void DecodeBC6HMode11(const uint8_t* block, bool isSigned, uint16_t texels[64])
+    {
+        uint64_t low;
+        uint64_t high;
+        memcpy(&low, block, 8);
+        memcpy(&high, block + 8, 8);
+
+        // rw gw bw rx gx bx from bit 5; bx crosses into the second half
+        int endpoints[4][3];
+        for (unsigned int e = 0; e < 2; e++)
+        {
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                unsigned int shift = 5 + 30 * e + 10 * c;
+                uint64_t field = shift + 10 > 64 ? (low >> shift) | (high << (64 - shift)) : low >> shift;
+                int value = static_cast<int>(field & 0x3ff);
+                if (isSigned)
+                {
+                    value = SignExtend(value, 10);
+                }
+
+                endpoints[e][c] = Unquantize(value, 10, isSigned);
+            }
+        }
+
+        InterpolateBC6H(block, endpoints, 1, 0, isSigned, texels);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // known-answer blocks covering every mode. The BC7 texels were decoded by Pillow's BCn
+    // decoder; the BC6H texels by a decoder written from the BC6H bit layouts in the D3D11
+    // functional specification and cross-checked against Pillow's 8-bit BC6H output
+    //
+    struct BC7ReferenceBlock
+    {
+        uint8_t Block[16];
+        uint32_t Texels[16];                // 0xAABBGGRR
+    };
+
+    struct BC6HReferenceBlock
+    {
+        bool IsSigned;
+        uint8_t Block[16];
+        uint16_t Texels[48];                // RGB halves
+    };
+
+    const BC7ReferenceBlock s_bc7ReferenceBlocks[] =
+    {
+        // mode 6 from endpoints (21, 41, 61, 255) and (200, 100, 0, 128), texel i taking index i
+        {
+            { 0x40, 0x05, 0x99, 0x22, 0xf3, 0x00, 0xfe, 0xc0, 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe },
+            {
+                0xff3d2915, 0xf7392d20, 0xed34312e, 0xe5313539, 0xdd2d3945, 0xd5293c50, 0xcb24415e, 0xc3204569,
+                0xbc1d4874, 0xb4194c7f, 0xaa14518d, 0xa2105498, 0x9a0c58a4, 0x92095caf, 0x880460bd, 0x800064c8
+            }
+        },
+        // mode 0
+        {
+            { 0x79, 0x2e, 0xba, 0x94, 0x4d, 0x33, 0xe3, 0xb9, 0x68, 0xc1, 0xb7, 0xc2, 0x43, 0x88, 0x3e, 0xa2 },
+            {
+                0xffebac46, 0xff4fa1a6, 0xff56a850, 0xffbd9c5a, 0xffce6b7b, 0xff58ab34, 0xff5aad18, 0xffa48966,
+                0xffdf915c, 0xff5aad18, 0xff4fa1a6, 0xff0818ad, 0xfff1b93b, 0xff56a850, 0xff51a38a, 0xff8a7771
+            }
+        },
+        // mode 1
+        {
+            { 0xd2, 0xbc, 0x7f, 0x5a, 0x6a, 0x86, 0xba, 0x9d, 0xf6, 0x37, 0x4f, 0x8b, 0xb4, 0x54, 0x84, 0x13 },
+            {
+                0xff718ef6, 0xff8bb177, 0xff52b864, 0xff7398f5, 0xff8bb177, 0xff8bb177, 0xff6c70fa, 0xff7398f5,
+                0xffc6aa8c, 0xff6d79f9, 0xff76abf3, 0xffe3a695, 0xff6f83f8, 0xff718ef6, 0xffc6aa8c, 0xffffa39f
+            }
+        },
+        // mode 2
+        {
+            { 0xbc, 0xc6, 0xff, 0xdd, 0x34, 0xb0, 0xc0, 0xba, 0x77, 0xec, 0xb5, 0xd4, 0xdf, 0xa7, 0x25, 0x88 },
+            {
+                0xff591e64, 0xff591e64, 0xffde5aff, 0xffde5aff, 0xff5a1efa, 0xff5a3cf4, 0xff9d3cb3, 0xff591e64,
+                0xff8bbd44, 0xff52bd31, 0xff5a1efa, 0xff180018, 0xff52bd31, 0xffc6bd58, 0xff5a00ff, 0xff9d3cb3
+            }
+        },
+        // mode 3
+        {
+            { 0x38, 0xde, 0x69, 0xfa, 0x0e, 0xc5, 0x59, 0xa0, 0x6a, 0x77, 0x1f, 0xb9, 0xbe, 0x23, 0xc3, 0x53 },
+            {
+                0xffa04ec2, 0xff779d69, 0xff753eb7, 0xffe5a93b, 0xffa04ec2, 0xffb428ee, 0xff753eb7, 0xffae7578,
+                0xff753eb7, 0xff3e0af4, 0xffb428ee, 0xff779d69, 0xffe5a93b, 0xff3e0af4, 0xffa04ec2, 0xffa04ec2
+            }
+        },
+        // mode 4
+        {
+            { 0x70, 0x54, 0x58, 0xcb, 0x33, 0x53, 0x6d, 0x6a, 0x51, 0x91, 0x36, 0xe7, 0xde, 0x68, 0x3a, 0x34 },
+            {
+                0xdf40b574, 0xdf50b574, 0xce45b510, 0xe740b5a5, 0xdf50b574, 0xdf4bb574, 0xce55b510, 0xd650b541,
+                0xe730b5a5, 0xd64bb541, 0xd635b541, 0xd64bb541, 0xe740b5a5, 0xd630b541, 0xe74bb5a5, 0xdf35b574
+            }
+        },
+        // mode 5
+        {
+            { 0x20, 0xbf, 0x39, 0xc3, 0x04, 0xf8, 0xdd, 0x42, 0xd8, 0x81, 0x51, 0xc5, 0xf5, 0x91, 0xcd, 0xb4 },
+            {
+                0xb700187e, 0x807e4ce7, 0x10553bc5, 0x107e4ce7, 0x8000187e, 0xb700187e, 0x8000187e, 0x477e4ce7,
+                0x8000187e, 0x10553bc5, 0xb7553bc5, 0x10553bc5, 0xb7553bc5, 0x8000187e, 0x10553bc5, 0x477e4ce7
+            }
+        },
+        // mode 6
+        {
+            { 0x40, 0x9d, 0x1c, 0x54, 0xd9, 0xa7, 0x9b, 0xc7, 0x3b, 0x3c, 0xfe, 0x76, 0x5d, 0x22, 0x33, 0x5e },
+            {
+                0x97eb3a9a, 0x99f03d8c, 0x91da2fce, 0x99f03d8c, 0x90d52cde, 0x8fd32be5, 0x96e838a3, 0x95e637aa,
+                0x91d82ed5, 0x97eb3a9a, 0x99f23e85, 0x99f23e85, 0x99f03d8c, 0x99f03d8c, 0x90d52cde, 0x97eb3a9a
+            }
+        },
+        // mode 7
+        {
+            { 0x80, 0x98, 0xd6, 0xa0, 0x24, 0x43, 0x63, 0x9f, 0x56, 0x55, 0xf0, 0xb5, 0xff, 0xb6, 0x77, 0xdc },
+            {
+                0x74d242d4, 0x049e34d7, 0xf2969e11, 0xd7558e2c, 0x3ab73bd6, 0x74d242d4, 0x049e34d7, 0xe475961f,
+                0x049e34d7, 0x74d242d4, 0x049e34d7, 0xf2969e11, 0xaaeb49d3, 0x049e34d7, 0x74d242d4, 0x049e34d7
+            }
+        },
+    };
+
+    const BC6HReferenceBlock s_bc6hReferenceBlocks[] =
+    {
+        // mode 0x03, every texel (65504, 0, 1.515)
+        {
+            false,
+            { 0xe3, 0x7f, 0x00, 0x00, 0xfc, 0x1f, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+            {
+                0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f,
+                0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f,
+                0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f,
+                0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f, 0x7bff, 0x0000, 0x3e0f
+            }
+        },
+        // unsigned mode 0x00
+        {
+            false,
+            { 0x28, 0xaf, 0xb2, 0xc4, 0xdc, 0x21, 0x54, 0xec, 0x34, 0x94, 0xaf, 0x10, 0x19, 0xf0, 0xd7, 0x2c },
+            {
+                0x2d75, 0x2b57, 0x4984, 0x2d8a, 0x2b53, 0x49a7, 0x2da0, 0x2b4e, 0x49ca, 0x2df7, 0x2ade, 0x4a19,
+                0x2db6, 0x2b4a, 0x49ed, 0x2d39, 0x2b30, 0x4924, 0x2db3, 0x2afc, 0x49c1, 0x2cfc, 0x2b4a, 0x48d6,
+                0x2cfc, 0x2b4a, 0x48d6, 0x2e71, 0x2aaa, 0x4ab6, 0x2eae, 0x2a90, 0x4b04, 0x2d75, 0x2b57, 0x4984,
+                0x2e34, 0x2ac4, 0x4a67, 0x2da0, 0x2b4e, 0x49ca, 0x2d75, 0x2b57, 0x4984, 0x2da0, 0x2b4e, 0x49ca
+            }
+        },
+        // unsigned mode 0x01
+        {
+            false,
+            { 0x01, 0xe6, 0x26, 0x70, 0xb4, 0x3c, 0x59, 0x3a, 0x14, 0x32, 0xcd, 0x48, 0x3d, 0xb1, 0x76, 0x9a },
+            {
+                0x37f9, 0x4ec1, 0x31d4, 0x3b4e, 0x501e, 0x3003, 0x337e, 0x583b, 0x4756, 0x2e51, 0x57d2, 0x4779,
+                0x34fa, 0x4d87, 0x3377, 0x1e36, 0x568d, 0x47e6, 0x13dc, 0x55bc, 0x482c, 0x2363, 0x56f5, 0x47c3,
+                0x38ac, 0x58a4, 0x4734, 0x2924, 0x576a, 0x479c, 0x1e36, 0x568d, 0x47e6, 0x1e36, 0x568d, 0x47e6,
+                0x2924, 0x576a, 0x479c, 0x2e51, 0x57d2, 0x4779, 0x2924, 0x576a, 0x479c, 0x2e51, 0x57d2, 0x4779
+            }
+        },
+        // unsigned mode 0x02
+        {
+            false,
+            { 0x42, 0x7b, 0x86, 0xe1, 0x6f, 0xa9, 0xf8, 0x6a, 0x33, 0xd7, 0x12, 0x4d, 0x4d, 0x47, 0x22, 0x90 },
+            {
+                0x79ba, 0x2f41, 0x7b0f, 0x79d7, 0x2f4c, 0x7b1a, 0x79f3, 0x2f57, 0x7b25, 0x7a10, 0x2f62, 0x7b30,
+                0x79f3, 0x2f57, 0x7b25, 0x7a4b, 0x2f79, 0x7b47, 0x79d7, 0x2f4c, 0x7b1a, 0x7a4b, 0x2f79, 0x7b47,
+                0x79d7, 0x2f5f, 0x7aae, 0x79ba, 0x2f41, 0x7b0f, 0x79d7, 0x2f4c, 0x7b1a, 0x79d7, 0x2f4c, 0x7b1a,
+                0x79a9, 0x2f69, 0x7ab5, 0x794e, 0x2f7f, 0x7ac2, 0x7a2f, 0x2f6e, 0x7b3c, 0x7a2f, 0x2f6e, 0x7b3c
+            }
+        },
+        // unsigned mode 0x06
+        {
+            false,
+            { 0xa6, 0xbb, 0x40, 0x86, 0x19, 0x7e, 0x37, 0xe4, 0x32, 0xc8, 0x63, 0x2d, 0x83, 0xd9, 0x39, 0x51 },
+            {
+                0x1ce9, 0x45d7, 0x0bd6, 0x1cda, 0x4625, 0x0bf2, 0x1c9b, 0x45e6, 0x0c28, 0x1cda, 0x4625, 0x0bf2,
+                0x1cf6, 0x45c1, 0x0bb3, 0x1d11, 0x4594, 0x0b6b, 0x1ce9, 0x45d7, 0x0bd6, 0x1cbb, 0x4606, 0x0c0c,
+                0x1c8c, 0x45d7, 0x0c35, 0x1cfd, 0x45b6, 0x0ba1, 0x1d17, 0x4589, 0x0b5a, 0x1d04, 0x45aa, 0x0b8e,
+                0x1caa, 0x45f5, 0x0c1b, 0x1c9b, 0x45e6, 0x0c28, 0x1cbb, 0x4606, 0x0c0c, 0x1cf6, 0x45c1, 0x0bb3
+            }
+        },
+        // unsigned mode 0x0a
+        {
+            false,
+            { 0x4a, 0xc0, 0xb3, 0xe4, 0xcc, 0x0b, 0x94, 0xe6, 0xee, 0xad, 0x8b, 0x60, 0xef, 0xbd, 0xb8, 0xf3 },
+            {
+                0x5d08, 0x15c4, 0x2627, 0x5d26, 0x15c4, 0x25ee, 0x5d17, 0x15c4, 0x260b, 0x5d26, 0x15c4, 0x25ee,
+                0x5d44, 0x15fe, 0x2563, 0x5cd9, 0x15e3, 0x2563, 0x5d0d, 0x15f0, 0x2563, 0x5cd9, 0x15e3, 0x2563,
+                0x5d5e, 0x1604, 0x2563, 0x5cd9, 0x15e3, 0x2563, 0x5d5e, 0x1604, 0x2563, 0x5d27, 0x15f7, 0x2563,
+                0x5cf9, 0x15c4, 0x2644, 0x5cba, 0x15c4, 0x26b8, 0x5ce8, 0x15c4, 0x2663, 0x5cba, 0x15c4, 0x26b8
+            }
+        },
+        // unsigned mode 0x0e
+        {
+            false,
+            { 0xae, 0x12, 0x1e, 0x3a, 0x0e, 0x84, 0x20, 0xf1, 0xd4, 0x35, 0xe8, 0xa2, 0x9d, 0xec, 0x16, 0xf2 },
+            {
+                0x2446, 0x0eec, 0x4547, 0x246a, 0x0f7c, 0x458f, 0x2461, 0x0f59, 0x457e, 0x26a1, 0x0f23, 0x46d7,
+                0x2461, 0x0f59, 0x457e, 0x2461, 0x0f59, 0x457e, 0x244f, 0x0f0f, 0x4559, 0x26b2, 0x0f45, 0x463a,
+                0x246a, 0x0f7c, 0x458f, 0x246a, 0x0f7c, 0x458f, 0x2461, 0x0f59, 0x457e, 0x26cd, 0x0f7c, 0x4545,
+                0x2435, 0x0ea7, 0x4525, 0x2446, 0x0eec, 0x4547, 0x246a, 0x0f7c, 0x458f, 0x26bb, 0x0f57, 0x45eb
+            }
+        },
+        // unsigned mode 0x12
+        {
+            false,
+            { 0x92, 0x2c, 0x3c, 0x7c, 0x95, 0xcc, 0xbb, 0x2a, 0x29, 0x16, 0x20, 0x9e, 0x1a, 0xcf, 0xf1, 0x98 },
+            {
+                0x30ae, 0x3a5e, 0x5c46, 0x3321, 0x3a18, 0x5ac6, 0x2f2a, 0x3912, 0x59a1, 0x26fe, 0x3602, 0x5486,
+                0x35b8, 0x39ce, 0x5931, 0x3321, 0x3a18, 0x5ac6, 0x3231, 0x3a35, 0x5b86, 0x2f2a, 0x3912, 0x59a1,
+                0x3966, 0x3966, 0x56f2, 0x35b8, 0x39ce, 0x5931, 0x3231, 0x3a35, 0x5b86, 0x2f2a, 0x3912, 0x59a1,
+                0x3966, 0x3966, 0x56f2, 0x30ae, 0x3a5e, 0x5c46, 0x3231, 0x3a35, 0x5b86, 0x34eb, 0x3b3a, 0x5d3a
+            }
+        },
+        // unsigned mode 0x16
+        {
+            false,
+            { 0x96, 0xcf, 0xfe, 0x9a, 0xa1, 0x07, 0x98, 0x1b, 0x8f, 0x2e, 0x8b, 0xb2, 0x50, 0x00, 0x1f, 0x47 },
+            {
+                0x3aab, 0x7aca, 0x6250, 0x3c4e, 0x7aca, 0x638a, 0x3820, 0x7aca, 0x6067, 0x38f1, 0x7aca, 0x6104,
+                0x3c36, 0x2454, 0x6325, 0x3c4e, 0x7aca, 0x638a, 0x3aab, 0x7aca, 0x6250, 0x3b7c, 0x7aca, 0x62ed,
+                0x3fb2, 0x6cbe, 0x5faa, 0x3c4e, 0x7aca, 0x638a, 0x38f1, 0x7aca, 0x6104, 0x367e, 0x7aca, 0x5f2e,
+                0x3f03, 0x5e93, 0x6058, 0x3b88, 0x1629, 0x63d3, 0x3b7c, 0x7aca, 0x62ed, 0x3aab, 0x7aca, 0x6250
+            }
+        },
+        // unsigned mode 0x1a
+        {
+            false,
+            { 0x1a, 0x2e, 0x0f, 0x1a, 0xa2, 0xdb, 0x9f, 0xac, 0x9e, 0xbb, 0x35, 0x94, 0x35, 0xa5, 0x30, 0x76 },
+            {
+                0x35ac, 0x0ea3, 0x083d, 0x340a, 0x0e5d, 0x0ba5, 0x367e, 0x0ec6, 0x068a, 0x3250, 0x0e13, 0x0f3e,
+                0x3321, 0x0e36, 0x0d8a, 0x3250, 0x0e13, 0x0f3e, 0x317f, 0x0df0, 0x10f2, 0x3321, 0x0e36, 0x0d8a,
+                0x3a7d, 0x1187, 0x284b, 0x3a7d, 0x1187, 0x284b, 0x3c1f, 0x134c, 0x18a0, 0x3709, 0x0dca, 0x495e,
+                0x3c1f, 0x134c, 0x18a0, 0x33c4, 0x0a3f, 0x68b3, 0x33c4, 0x0a3f, 0x68b3, 0x3c1f, 0x134c, 0x18a0
+            }
+        },
+        // unsigned mode 0x1e
+        {
+            false,
+            { 0x3e, 0x79, 0x50, 0x45, 0xbb, 0x74, 0xa2, 0x70, 0xd5, 0xb7, 0xce, 0xd2, 0x37, 0x66, 0x96, 0xdd },
+            {
+                0x1dd9, 0x3457, 0x4206, 0x2216, 0x3068, 0x41b9, 0x25e7, 0x2cdd, 0x4173, 0x2216, 0x3068, 0x41b9,
+                0x5aab, 0x295a, 0x58a4, 0x2d88, 0x25c8, 0x40e8, 0x29b7, 0x2952, 0x412d, 0x1268, 0x3ef8, 0x42d8,
+                0x566e, 0x2e70, 0x6634, 0x57f1, 0x2c9f, 0x615c, 0x1638, 0x3b6d, 0x4292, 0x1dd9, 0x3457, 0x4206,
+                0x53b4, 0x31b5, 0x6eec, 0x566e, 0x2e70, 0x6634, 0x5c08, 0x27b8, 0x5448, 0x29b7, 0x2952, 0x412d
+            }
+        },
+        // unsigned mode 0x03
+        {
+            false,
+            { 0x63, 0xdd, 0x6b, 0x98, 0xb3, 0x22, 0xe1, 0x35, 0x29, 0x4f, 0x65, 0x32, 0xc0, 0x2d, 0x5b, 0x74 },
+            {
+                0x4541, 0x2c2c, 0x3ce0, 0x4f42, 0x23aa, 0x3a78, 0x0a79, 0x5e26, 0x4b04, 0x4541, 0x2c2c, 0x3ce0,
+                0x4040, 0x306d, 0x3e14, 0x3a00, 0x35be, 0x3f95, 0x4f42, 0x23aa, 0x3a78, 0x4a42, 0x27eb, 0x3bac,
+                0x5a84, 0x1a18, 0x37c3, 0x1abb, 0x5053, 0x471b, 0x15bb, 0x5494, 0x484f, 0x4f42, 0x23aa, 0x3a78,
+                0x1fbc, 0x4c12, 0x45e7, 0x4040, 0x306d, 0x3e14, 0x4541, 0x2c2c, 0x3ce0, 0x34ff, 0x39ff, 0x40c9
+            }
+        },
+        // unsigned mode 0x07
+        {
+            false,
+            { 0xa7, 0x03, 0x1e, 0x55, 0xac, 0x00, 0xc5, 0x39, 0xc0, 0x81, 0x6b, 0xa8, 0xf9, 0x09, 0x36, 0x9b },
+            {
+                0x01c9, 0x60a9, 0x2192, 0x02cc, 0x6297, 0x271f, 0x01dd, 0x60d0, 0x2202, 0x0276, 0x61f3, 0x2545,
+                0x02b8, 0x6271, 0x26b0, 0x024d, 0x61a5, 0x2466, 0x0276, 0x61f3, 0x2545, 0x02a4, 0x624a, 0x2640,
+                0x028a, 0x6219, 0x25b5, 0x030e, 0x6315, 0x2889, 0x028a, 0x6219, 0x25b5, 0x01c9, 0x60a9, 0x2192,
+                0x024d, 0x61a5, 0x2466, 0x020b, 0x6127, 0x22fd, 0x02b8, 0x6271, 0x26b0, 0x028a, 0x6219, 0x25b5
+            }
+        },
+        // unsigned mode 0x0b
+        {
+            false,
+            { 0x6b, 0x8d, 0x7f, 0x8c, 0xce, 0x0c, 0x6e, 0x55, 0x02, 0x82, 0x57, 0x8d, 0xf9, 0xe6, 0xf0, 0xe0 },
+            {
+                0x410f, 0x64f2, 0x1938, 0x4141, 0x64bc, 0x1962, 0x40d0, 0x6536, 0x1904, 0x3f99, 0x6689, 0x1800,
+                0x3fcb, 0x6653, 0x1829, 0x403b, 0x65d8, 0x1887, 0x3e93, 0x67a6, 0x1725, 0x3f99, 0x6689, 0x1800,
+                0x3f67, 0x66bf, 0x17d6, 0x3e22, 0x6820, 0x16c7, 0x3ffd, 0x661c, 0x1853, 0x3e54, 0x67e9, 0x16f1,
+                0x4141, 0x64bc, 0x1962, 0x3e22, 0x6820, 0x16c7, 0x4141, 0x64bc, 0x1962, 0x3e54, 0x67e9, 0x16f1
+            }
+        },
+        // unsigned mode 0x0f
+        {
+            false,
+            { 0x4f, 0xaa, 0xbb, 0x28, 0x39, 0x9a, 0xf8, 0x1b, 0xd3, 0xcb, 0xd8, 0x6e, 0x11, 0xf5, 0xe1, 0x22 },
+            {
+                0x15f3, 0x1dc5, 0x5f37, 0x15f6, 0x1dc7, 0x5f3a, 0x15f6, 0x1dc7, 0x5f3a, 0x15f6, 0x1dc7, 0x5f3a,
+                0x15f5, 0x1dc6, 0x5f39, 0x15f6, 0x1dc7, 0x5f3a, 0x15f7, 0x1dc7, 0x5f3b, 0x15f5, 0x1dc6, 0x5f39,
+                0x15f3, 0x1dc5, 0x5f37, 0x15f3, 0x1dc5, 0x5f37, 0x15f4, 0x1dc6, 0x5f38, 0x15f7, 0x1dc7, 0x5f3b,
+                0x15f3, 0x1dc5, 0x5f37, 0x15f7, 0x1dc7, 0x5f3b, 0x15f4, 0x1dc6, 0x5f38, 0x15f4, 0x1dc6, 0x5f38
+            }
+        },
+        // signed mode 0x00
+        {
+            true,
+            { 0x2c, 0x06, 0xdc, 0x56, 0x4e, 0xf2, 0xea, 0x40, 0x7e, 0x29, 0x5c, 0xd5, 0x77, 0xed, 0x6f, 0xf1 },
+            {
+                0x0ce8, 0x69c3, 0xb39a, 0x0d8e, 0x691d, 0xb388, 0x0c99, 0x6a12, 0xb3a3, 0x097b, 0x6c78, 0xb3f6,
+                0x0ddc, 0x68cf, 0xb37f, 0x0e2b, 0x6881, 0xb377, 0x0ddc, 0x68cf, 0xb37f, 0x097b, 0x6c78, 0xb3f6,
+                0x0ddc, 0x68cf, 0xb37f, 0x0ddc, 0x68cf, 0xb37f, 0x0e2b, 0x6881, 0xb377, 0x0a6a, 0x6b08, 0xb542,
+                0x0ce8, 0x69c3, 0xb39a, 0x0c4b, 0x6a60, 0xb3ac, 0x0ddc, 0x68cf, 0xb37f, 0x0a6a, 0x6b08, 0xb542
+            }
+        },
+        // signed mode 0x01
+        {
+            true,
+            { 0x7d, 0x9d, 0x53, 0x28, 0x09, 0xc5, 0x1f, 0x1e, 0x5d, 0x6c, 0xa2, 0xf4, 0x2e, 0x81, 0xb4, 0x18 },
+            {
+                0xa9a8, 0x4c88, 0x27b8, 0xb519, 0x1bab, 0x09cf, 0xc0d0, 0x1709, 0x008b, 0xb519, 0x1bab, 0x09cf,
+                0xe5b8, 0x48a8, 0x1ff8, 0xd4d3, 0x49bf, 0x2226, 0xa962, 0x204d, 0x1312, 0xc0d0, 0x1709, 0x008b,
+                0xb21a, 0x4bfc, 0x26a1, 0xa9a8, 0x4c88, 0x27b8, 0xba8c, 0x4b71, 0x258a, 0xb519, 0x1bab, 0x09cf,
+                0xc2fe, 0x4ae5, 0x2473, 0xb21a, 0x4bfc, 0x26a1, 0xdd45, 0x4933, 0x210f, 0xa9a8, 0x4c88, 0x27b8
+            }
+        },
+        // signed mode 0x02
+        {
+            true,
+            { 0x02, 0xa8, 0x6f, 0xe4, 0x06, 0xcf, 0xe9, 0xe3, 0xf0, 0x45, 0x3b, 0x1e, 0x51, 0x8b, 0xde, 0x91 },
+            {
+                0xd54f, 0x1aff, 0x6b1a, 0xd54e, 0x1b66, 0x6b8f, 0xd647, 0x1be9, 0x6bb6, 0xd54f, 0x1ad2, 0x6bb6,
+                0xd54f, 0x1b07, 0x6afc, 0xd5a1, 0x1b92, 0x6b9c, 0xd4f2, 0x1b36, 0x6b81, 0xd54f, 0x1aff, 0x6b1a,
+                0xd54f, 0x1af6, 0x6b39, 0xd5f4, 0x1bbd, 0x6ba9, 0xd5a1, 0x1b92, 0x6b9c, 0xd54f, 0x1ad2, 0x6bb6,
+                0xd54f, 0x1ae3, 0x6b79, 0xd54e, 0x1b66, 0x6b8f, 0xd4f2, 0x1b36, 0x6b81, 0xd54f, 0x1aec, 0x6b5b
+            }
+        },
+        // signed mode 0x06
+        {
+            true,
+            { 0x26, 0x36, 0x91, 0x95, 0x1b, 0x6e, 0x1a, 0xf1, 0x99, 0xb4, 0xb2, 0x44, 0x6f, 0x8f, 0x28, 0xc3 },
+            {
+                0x347e, 0x612d, 0x3785, 0x34a6, 0x6083, 0x379f, 0x348c, 0x60f5, 0x378e, 0x348c, 0x60f5, 0x378e,
+                0x33e8, 0x61e3, 0x373a, 0x34db, 0x5f9a, 0x37c3, 0x34c1, 0x600b, 0x37b2, 0x34c1, 0x600b, 0x37b2,
+                0x33db, 0x61d2, 0x3725, 0x33f5, 0x61f5, 0x3751, 0x3498, 0x60bc, 0x3796, 0x34b4, 0x6045, 0x37a9,
+                0x33e8, 0x61e3, 0x373a, 0x33b3, 0x619b, 0x36e1, 0x3402, 0x6206, 0x3766, 0x34ce, 0x5fd3, 0x37ba
+            }
+        },
+        // signed mode 0x0a
+        {
+            true,
+            { 0x2a, 0xf0, 0x00, 0x83, 0x1f, 0x32, 0x60, 0x89, 0x92, 0x68, 0x72, 0x92, 0xc9, 0x2c, 0xd4, 0xa5 },
+            {
+                0x6cae, 0x3e2e, 0x746e, 0x6ccd, 0x3db2, 0x727e, 0x6bd5, 0x3d55, 0x74ea, 0x6bf8, 0x3d63, 0x7493,
+                0x6cbc, 0x3e33, 0x7431, 0x6cd6, 0x3e3c, 0x73b7, 0x6c1b, 0x3d6f, 0x743c, 0x6caa, 0x3da5, 0x72d5,
+                0x6ce4, 0x3e40, 0x7373, 0x6cf1, 0x3e44, 0x7336, 0x6cae, 0x3e2e, 0x746e, 0x6c1b, 0x3d6f, 0x743c,
+                0x6cf1, 0x3e44, 0x7336, 0x6cd6, 0x3e3c, 0x73b7, 0x6cbc, 0x3e33, 0x7431, 0x6cf1, 0x3e44, 0x7336
+            }
+        },
+        // signed mode 0x0e
+        {
+            true,
+            { 0xee, 0x3f, 0x8d, 0xeb, 0xc3, 0x4a, 0xe6, 0xd0, 0x46, 0x97, 0x5b, 0x73, 0xa3, 0x1c, 0x67, 0x65 },
+            {
+                0x81d1, 0xf18e, 0x856f, 0x8383, 0xf485, 0x8538, 0x840e, 0xf579, 0x8527, 0x044a, 0xee89, 0x0022,
+                0x825c, 0xf282, 0x855d, 0x0375, 0xf046, 0x809e, 0x044a, 0xee89, 0x0022, 0x02b5, 0xf1d7, 0x814d,
+                0x02b5, 0xf1d7, 0x814d, 0x0375, 0xf046, 0x809e, 0x044a, 0xee89, 0x0022, 0x825c, 0xf282, 0x855d,
+                0x05ca, 0xeb67, 0x017f, 0x81d1, 0xf18e, 0x856f, 0x8145, 0xf09a, 0x8580, 0x825c, 0xf282, 0x855d
+            }
+        },
+        // signed mode 0x12
+        {
+            true,
+            { 0xd2, 0x48, 0x51, 0x80, 0x85, 0x3a, 0x3c, 0xd2, 0xc7, 0xce, 0x5b, 0x3a, 0x6b, 0xc9, 0x77, 0x92 },
+            {
+                0x48a8, 0xdb46, 0xbd65, 0x5096, 0xd321, 0xc814, 0x2834, 0xcef4, 0xc06c, 0x5096, 0xd321, 0xc814,
+                0x4ad6, 0xdb23, 0xbcd9, 0x519e, 0xdab6, 0xbb27, 0x48a8, 0xdb46, 0xbd65, 0x3fe8, 0xd167, 0xc4ea,
+                0x301a, 0xcfc5, 0xc1eb, 0x467a, 0xdb69, 0xbdf0, 0x53cc, 0xda94, 0xba9c, 0x4ad6, 0xdb23, 0xbcd9,
+                0x6064, 0xd4c4, 0xcb14, 0x48af, 0xd250, 0xc695, 0x48af, 0xd250, 0xc695, 0x4d42, 0xdafc, 0xbc3e
+            }
+        },
+        // signed mode 0x16
+        {
+            true,
+            { 0x56, 0x49, 0xf5, 0xac, 0xaf, 0xec, 0x31, 0x77, 0xa5, 0x8a, 0x0d, 0x40, 0x61, 0xd3, 0xa6, 0x35 },
+            {
+                0x43ad, 0x8faa, 0xa373, 0x482c, 0x95cc, 0xa92c, 0x482c, 0x95cc, 0xa92c, 0x3a9c, 0xaefc, 0xae04,
+                0x452c, 0x91b5, 0xa55b, 0x3b04, 0xaefc, 0xaf3d, 0x3c4a, 0xaefc, 0xb30e, 0x3cb2, 0xaefc, 0xb448,
+                0x3b04, 0xaefc, 0xaf3d, 0x3cb2, 0xaefc, 0xb448, 0x3cb2, 0xaefc, 0xb448, 0x3b04, 0xaefc, 0xaf3d,
+                0x3cb2, 0xaefc, 0xb448, 0x3cb2, 0xaefc, 0xb448, 0x3d1b, 0xaefc, 0xb582, 0x3a9c, 0xaefc, 0xae04
+            }
+        },
+        // signed mode 0x1a
+        {
+            true,
+            { 0x5a, 0x69, 0x84, 0x22, 0xa7, 0x50, 0x48, 0xb0, 0x89, 0xce, 0xf1, 0x22, 0xc3, 0x17, 0x81, 0x38 },
+            {
+                0x482c, 0x083c, 0xec04, 0x3c8c, 0x0a2c, 0x6df4, 0x3fd1, 0x09a0, 0x30a6, 0x482c, 0x083c, 0xec04,
+                0x4b17, 0x101e, 0xf06b, 0x492f, 0x1064, 0xf36a, 0x4c0c, 0x0ffc, 0xeeec, 0x4544, 0x10f4, 0xf994,
+                0x492f, 0x1064, 0xf36a, 0x4b17, 0x101e, 0xf06b, 0x4a23, 0x1041, 0xf1eb, 0x4c0c, 0x0ffc, 0xeeec,
+                0x4820, 0x108b, 0xf515, 0x4c0c, 0x0ffc, 0xeeec, 0x4544, 0x10f4, 0xf994, 0x4c0c, 0x0ffc, 0xeeec
+            }
+        },
+        // signed mode 0x1e
+        {
+            true,
+            { 0x7e, 0x9b, 0x47, 0x4b, 0x3f, 0xa5, 0x84, 0x63, 0xbd, 0x48, 0xf4, 0x2f, 0xf6, 0xe4, 0xe9, 0xf7 },
+            {
+                0x4dae, 0x24a1, 0xd77d, 0x43d0, 0x3ff0, 0x9d10, 0x43d0, 0x3ff0, 0x9d10, 0x60ef, 0x446b, 0xbc6d,
+                0x4dae, 0x24a1, 0xd77d, 0x4ae5, 0x4107, 0xa4b1, 0x4ae5, 0x4107, 0xa4b1, 0x60ef, 0x446b, 0xbc6d,
+                0x30cd, 0x0d33, 0xc46b, 0x4ae5, 0x4107, 0xa4b1, 0x60ef, 0x446b, 0xbc6d, 0x6805, 0x4582, 0xc40e,
+                0xe2d0, 0xea90, 0x1d10, 0x43d0, 0x3ff0, 0x9d10, 0x4ae5, 0x4107, 0xa4b1, 0x60ef, 0x446b, 0xbc6d
+            }
+        },
+        // signed mode 0x03
+        {
+            true,
+            { 0x63, 0xce, 0x5d, 0xf7, 0x07, 0x98, 0xa5, 0x60, 0xb1, 0x10, 0xc1, 0xb9, 0xe7, 0x22, 0x19, 0x6c },
+            {
+                0xe045, 0xced5, 0x8155, 0xc731, 0x2081, 0xb92d, 0xe045, 0xced5, 0x8155, 0xde22, 0xc55b, 0x8615,
+                0xde22, 0xc55b, 0x8615, 0xc50e, 0x29fb, 0xbdee, 0xcbfe, 0x0b2f, 0xae7c, 0xc731, 0x2081, 0xb92d,
+                0xd043, 0x87c3, 0xa4fa, 0xc041, 0x3f4d, 0xc8a0, 0xdb77, 0xb983, 0x8c06, 0xdb77, 0xb983, 0x8c06,
+                0xcbfe, 0x0b2f, 0xae7c, 0xde22, 0xc55b, 0x8615, 0xc50e, 0x29fb, 0xbdee, 0xd265, 0x913d, 0xa039
+            }
+        },
+        // signed mode 0x07
+        {
+            true,
+            { 0x87, 0x52, 0x30, 0xff, 0xc4, 0xf4, 0xf4, 0x13, 0xc2, 0x94, 0x41, 0x08, 0xce, 0xa3, 0xc6, 0x42 },
+            {
+                0xaafd, 0xb31b, 0x4dbc, 0x9d78, 0xbb05, 0x5134, 0xa73f, 0xb54b, 0x4eb2, 0xa135, 0xb8d5, 0x503e,
+                0xaafd, 0xb31b, 0x4dbc, 0xa73f, 0xb54b, 0x4eb2, 0xa25c, 0xb829, 0x4ff2, 0xac23, 0xb26f, 0x4d70,
+                0x9ae2, 0xbc8a, 0x51dd, 0x9d78, 0xbb05, 0x5134, 0xa866, 0xb49f, 0x4e66, 0x9fc5, 0xb9ac, 0x509d,
+                0xa4a9, 0xb6d0, 0x4f5b, 0x9d78, 0xbb05, 0x5134, 0xa98c, 0xb3f3, 0x4e1b, 0xa73f, 0xb54b, 0x4eb2
+            }
+        },
+        // signed mode 0x0b
+        {
+            true,
+            { 0xab, 0xd9, 0x85, 0x30, 0xf1, 0xda, 0xcc, 0x6f, 0x2a, 0x31, 0xb6, 0x78, 0xd3, 0x44, 0x11, 0x76 },
+            {
+                0x90bf, 0x5039, 0x0894, 0x91d0, 0x4f11, 0x08f4, 0x9243, 0x4e95, 0x091b, 0x9175, 0x4f73, 0x08d4,
+                0x904e, 0x50b4, 0x086c, 0x8e6f, 0x52bb, 0x07c3, 0x8f98, 0x517a, 0x082c, 0x8ff3, 0x5117, 0x084c,
+                0x9175, 0x4f73, 0x08d4, 0x8db9, 0x5381, 0x0783, 0x911a, 0x4fd6, 0x08b4, 0x911a, 0x4fd6, 0x08b4,
+                0x9243, 0x4e95, 0x091b, 0x9243, 0x4e95, 0x091b, 0x904e, 0x50b4, 0x086c, 0x8ff3, 0x5117, 0x084c
+            }
+        },
+        // signed mode 0x0f
+        {
+            true,
+            { 0x0f, 0x19, 0x97, 0x44, 0x21, 0xbf, 0x62, 0xc8, 0xfa, 0x96, 0xd4, 0xa5, 0x19, 0x39, 0xc1, 0x95 },
+            {
+                0x78e2, 0xef39, 0xe423, 0x78e5, 0xef36, 0xe423, 0x78e3, 0xef39, 0xe423, 0x78e3, 0xef38, 0xe423,
+                0x78e2, 0xef3a, 0xe423, 0x78e4, 0xef37, 0xe423, 0x78e2, 0xef39, 0xe423, 0x78e4, 0xef38, 0xe423,
+                0x78e3, 0xef38, 0xe423, 0x78e1, 0xef3b, 0xe423, 0x78e3, 0xef38, 0xe423, 0x78e2, 0xef3a, 0xe423,
+                0x78e1, 0xef3b, 0xe423, 0x78e4, 0xef37, 0xe423, 0x78e2, 0xef39, 0xe423, 0x78e3, 0xef38, 0xe423
+            }
+        },
+    };
+}
+
+void DirectX::DecodeBC7Block(const uint8_t* block, uint32_t texels[16])
+{
+    int mode = BC7ModeOf(block);
+    if (mode == 6)
+    {
+        DecodeBC7Mode6(block, texels);
+    }
+    else if (mode >= 0)
+    {
+        DecodeBC7Generic(block, mode, texels);
+    }
+    else
+    {
+        std::fill(texels, texels + 16, 0u);
+    }
+}
+
+void DirectX::DecodeBC6HBlock(const uint8_t* block, bool isSigned, uint16_t texels[64])
+{
+    const BC6HMode* mode = BC6HModeOf(block);
+    if (!mode)
+    {
+        // reserved modes decode to opaque black
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            texels[4 * i] = texels[4 * i + 1] = texels[4 * i + 2] = 0;
+            texels[4 * i + 3] = HalfOne;
+        }
+    }
+    else if (mode->Value == 0x03)
+    {
+        DecodeBC6HMode11(block, isSigned, texels);
+    }
+    else
+    {
+        DecodeBC6HGeneric(block, *mode, isSigned, texels);
+    }
+}
+
+bool DirectX::CheckBPTCReferenceBlocks()
+{
+    for (const BC7ReferenceBlock& reference : s_bc7ReferenceBlocks)
+    {
+        uint32_t texels[16];
+        DecodeBC7Block(reference.Block, texels);
+        if (memcmp(texels, reference.Texels, sizeof(texels)) != 0)
+        {
+            return false;
+        }
+    }
+
+    for (const BC6HReferenceBlock& reference : s_bc6hReferenceBlocks)
+    {
+        uint16_t texels[64];
+        DecodeBC6HBlock(reference.Block, reference.IsSigned, texels);
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            if (texels[4 * i] != reference.Texels[3 * i] ||
+                texels[4 * i + 1] != reference.Texels[3 * i + 1] ||
+                texels[4 * i + 2] != reference.Texels[3 * i + 2] ||
+                texels[4 * i + 3] != HalfOne)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
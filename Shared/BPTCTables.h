@@ -0,0 +1,30 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <stdint.h>
+
+//
+// BC6H and BC7 tables the decoders and the encoder share, defined in BPTCDecode.cpp
+//
+namespace DirectX
+{
+    namespace BPTC
+    {
+        // interpolation weights out of 64, for 2, 3 and 4 bit indices
+        extern const uint8_t Weights2[4];
+        extern const uint8_t Weights3[8];
+        extern const uint8_t Weights4[16];
+
+        // subset of each texel for two subsets, one bit per texel
+        extern const uint16_t Partitions2[64];
+
+        // the anchor texel of the second of two subsets
+        extern const uint8_t Anchors2[64];
+    }
+}
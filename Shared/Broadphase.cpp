@@ -0,0 +1,652 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "Broadphase.h"
+
+using namespace DirectX;
+
+using namespace Physics;
+
+namespace
+{
+    const int CellCoordinateLimit = (1 << 20) - 1;
+
+    inline float Component(const XMFLOAT3& v, UINT axis)
+    {
+        return (&v.x)[axis];
+    }
+
+    inline BroadphasePair MakePair(UINT a, UINT b)
+    {
+        BroadphasePair pair;
+        pair.A = std::min(a, b);
+        pair.B = std::max(a, b);
+        return pair;
+    }
+
+    inline int CellCoordinate(float value, float inverseCellSize)
+    {
+        float cell = std::floor(value * inverseCellSize);
+        cell = std::max(cell, static_cast<float>(-CellCoordinateLimit));
+        cell = std::min(cell, static_cast<float>(CellCoordinateLimit));
+        return static_cast<int>(cell);
+    }
+}
+
+#pragma region SpatialHash
+
+void SpatialHash::Initialize(float cellSize)
+{
+    m_autoCellSize = cellSize <= 0.0f;
+    m_cellSize = m_autoCellSize ? 0.0f : cellSize;
+    m_inverseCellSize = m_autoCellSize ? 0.0f : 1.0f / cellSize;
+}
+
+SpatialHash::CellRange SpatialHash::Cells(const Aabb& box) const
+{
+    CellRange range;
+    range.MinX = CellCoordinate(box.Min.x, m_inverseCellSize);
+    range.MinY = CellCoordinate(box.Min.y, m_inverseCellSize);
+    range.MinZ = CellCoordinate(box.Min.z, m_inverseCellSize);
+    range.MaxX = CellCoordinate(box.Max.x, m_inverseCellSize);
+    range.MaxY = CellCoordinate(box.Max.y, m_inverseCellSize);
+    range.MaxZ = CellCoordinate(box.Max.z, m_inverseCellSize);
+    return range;
+}
+
+UINT64 SpatialHash::CellKey(int x, int y, int z) const
+{
+    // 21 bits per coordinate, offset to be non-negative
+    return (static_cast<UINT64>(x + CellCoordinateLimit + 1) << 42)
+        | (static_cast<UINT64>(y + CellCoordinateLimit + 1) << 21)
+        | static_cast<UINT64>(z + CellCoordinateLimit + 1);
+}
+
+UINT SpatialHash::Bucket(UINT64 cell) const
+{
+    UINT mask = static_cast<UINT>(m_bucketOffsets.size() - 2);
+    return static_cast<UINT>((cell * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+void SpatialHash::Build(const Aabb* boxes, UINT count)
+{
+    m_boxes.assign(boxes, boxes + count);
+    m_large.clear();
+    m_isLarge.assign(count, 0);
+
+    if (m_autoCellSize)
+    {
+        double extent = 0.0;
+        for (const Aabb& box : m_boxes)
+        {
+            extent += std::max(box.Max.x - box.Min.x, std::max(box.Max.y - box.Min.y, box.Max.z - box.Min.z));
+        }
+
+        m_cellSize = std::max(count > 0 ? static_cast<float>(2.0 * extent / count) : 1.0f, 1e-3f);
+        m_inverseCellSize = 1.0f / m_cellSize;
+    }
+
+    //
+    // size the table at twice the number of (box, cell) entries, rounded to a power of two
+    //
+    UINT entryCount = 0;
+    for (UINT i = 0; i < count; i++)
+    {
+        CellRange r = Cells(m_boxes[i]);
+        UINT64 cells = static_cast<UINT64>(r.MaxX - r.MinX + 1) * (r.MaxY - r.MinY + 1) * (r.MaxZ - r.MinZ + 1);
+        if (cells > MaxCellsPerBox)
+        {
+            m_large.push_back(i);
+            m_isLarge[i] = 1;
+        }
+        else
+        {
+            entryCount += static_cast<UINT>(cells);
+        }
+    }
+
+    UINT bucketCount = 16;
+    while (bucketCount < 2 * entryCount)
+    {
+        bucketCount *= 2;
+    }
+
+    m_bucketOffsets.assign(bucketCount + 1, 0);
+    m_entries.resize(entryCount);
+
+    //
+    // counting sort by bucket: count, prefix sum, scatter
+    //
+    for (UINT i = 0; i < count; i++)
+    {
+        if (m_isLarge[i])
+        {
+            continue;
+        }
+
+        CellRange r = Cells(m_boxes[i]);
+        for (int x = r.MinX; x <= r.MaxX; x++)
+            for (int y = r.MinY; y <= r.MaxY; y++)
+                for (int z = r.MinZ; z <= r.MaxZ; z++)
+                {
+                    m_bucketOffsets[Bucket(CellKey(x, y, z)) + 1]++;
+                }
+    }
+
+    for (UINT b = 1; b <= bucketCount; b++)
+    {
+        m_bucketOffsets[b] += m_bucketOffsets[b - 1];
+    }
+
+    for (UINT i = 0; i < count; i++)
+    {
+        if (m_isLarge[i])
+        {
+            continue;
+        }
+
+        CellRange r = Cells(m_boxes[i]);
+        for (int x = r.MinX; x <= r.MaxX; x++)
+            for (int y = r.MinY; y <= r.MaxY; y++)
+                for (int z = r.MinZ; z <= r.MaxZ; z++)
+                {
+                    Entry entry;
+                    entry.Cell = CellKey(x, y, z);
+                    entry.Id = i;
+                    m_entries[m_bucketOffsets[Bucket(entry.Cell)]++] = entry;
+                }
+    }
+
+    // scattering advanced every offset to the start of the next bucket; shift them back
+    for (UINT b = bucketCount - 1; b > 0; b--)
+    {
+        m_bucketOffsets[b] = m_bucketOffsets[b - 1];
+    }
+    m_bucketOffsets[0] = 0;
+}
+
+void SpatialHash::FindPairs(std::vector<BroadphasePair>& pairs) const
+{
+    pairs.clear();
+    if (m_bucketOffsets.empty())
+    {
+        return;
+    }
+
+    UINT bucketCount = static_cast<UINT>(m_bucketOffsets.size() - 1);
+    for (UINT b = 0; b < bucketCount; b++)
+    {
+        UINT end = m_bucketOffsets[b + 1];
+        for (UINT i = m_bucketOffsets[b]; i < end; i++)
+        {
+            const Entry& first = m_entries[i];
+            const Aabb& a = m_boxes[first.Id];
+
+            for (UINT j = i + 1; j < end; j++)
+            {
+                const Entry& second = m_entries[j];
+                if (second.Cell != first.Cell || second.Id == first.Id)
+                {
+                    continue;
+                }
+
+                const Aabb& c = m_boxes[second.Id];
+                if (!Overlaps(a, c))
+                {
+                    continue;
+                }
+
+                // both boxes share every cell of their intersection; report from one of them
+                UINT64 owner = CellKey(
+                    CellCoordinate(std::max(a.Min.x, c.Min.x), m_inverseCellSize),
+                    CellCoordinate(std::max(a.Min.y, c.Min.y), m_inverseCellSize),
+                    CellCoordinate(std::max(a.Min.z, c.Min.z), m_inverseCellSize));
+                if (owner == first.Cell)
+                {
+                    pairs.push_back(MakePair(first.Id, second.Id));
+                }
+            }
+        }
+    }
+
+    for (UINT large : m_large)
+    {
+        const Aabb& a = m_boxes[large];
+        for (UINT other = 0; other < static_cast<UINT>(m_boxes.size()); other++)
+        {
+            if (other == large || (m_isLarge[other] && other < large))
+            {
+                continue;
+            }
+
+            if (Overlaps(a, m_boxes[other]))
+            {
+                pairs.push_back(MakePair(large, other));
+            }
+        }
+    }
+}
+
+void SpatialHash::Query(const Aabb& box, std::vector<UINT>& results) const
+{
+    if (m_bucketOffsets.empty())
+    {
+        return;
+    }
+
+    CellRange r = Cells(box);
+    UINT64 cells = static_cast<UINT64>(r.MaxX - r.MinX + 1) * (r.MaxY - r.MinY + 1) * (r.MaxZ - r.MinZ + 1);
+    if (cells > MaxCellsPerBox)
+    {
+        for (UINT i = 0; i < static_cast<UINT>(m_boxes.size()); i++)
+        {
+            if (Overlaps(box, m_boxes[i]))
+            {
+                results.push_back(i);
+            }
+        }
+        return;
+    }
+
+    for (int x = r.MinX; x <= r.MaxX; x++)
+        for (int y = r.MinY; y <= r.MaxY; y++)
+            for (int z = r.MinZ; z <= r.MaxZ; z++)
+            {
+                UINT64 cell = CellKey(x, y, z);
+                UINT bucket = Bucket(cell);
+
+                for (UINT i = m_bucketOffsets[bucket]; i < m_bucketOffsets[bucket + 1]; i++)
+                {
+                    const Entry& entry = m_entries[i];
+                    if (entry.Cell != cell)
+                    {
+                        continue;
+                    }
+
+                    const Aabb& other = m_boxes[entry.Id];
+                    if (!Overlaps(box, other))
+                    {
+                        continue;
+                    }
+
+                    UINT64 owner = CellKey(
+                        CellCoordinate(std::max(box.Min.x, other.Min.x), m_inverseCellSize),
+                        CellCoordinate(std::max(box.Min.y, other.Min.y), m_inverseCellSize),
+                        CellCoordinate(std::max(box.Min.z, other.Min.z), m_inverseCellSize));
+                    if (owner == cell)
+                    {
+                        results.push_back(entry.Id);
+                    }
+                }
+            }
+
+    for (UINT large : m_large)
+    {
+        if (Overlaps(box, m_boxes[large]))
+        {
+            results.push_back(large);
+        }
+    }
+}
+
+#pragma endregion
+
+#pragma region SweepAndPrune
+
+UINT SweepAndPrune::AddProxy(const Aabb& box)
+{
+    UINT id;
+    if (!m_freeIds.empty())
+    {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+        m_boxes[id] = box;
+        m_alive[id] = 1;
+    }
+    else
+    {
+        id = static_cast<UINT>(m_boxes.size());
+        m_boxes.push_back(box);
+        m_alive.push_back(1);
+    }
+
+    SortKey key;
+    key.Min = Component(box.Min, m_axis);
+    key.Id = id;
+    key.Box = box;
+    m_order.push_back(key);
+
+    m_liveCount++;
+    m_pendingAdds++;
+    return id;
+}
+
+void SweepAndPrune::RemoveProxy(UINT id)
+{
+    if (id < m_alive.size() && m_alive[id])
+    {
+        m_alive[id] = 0;
+        m_releasedIds.push_back(id);
+        m_liveCount--;
+    }
+}
+
+void SweepAndPrune::UpdateProxy(UINT id, const Aabb& box)
+{
+    m_boxes[id] = box;
+}
+
+void SweepAndPrune::Clear()
+{
+    m_boxes.clear();
+    m_alive.clear();
+    m_freeIds.clear();
+    m_releasedIds.clear();
+    m_order.clear();
+    m_pairKeys.clear();
+    m_pairs.clear();
+    m_added.clear();
+    m_removed.clear();
+    m_liveCount = 0;
+    m_pendingAdds = 0;
+    m_updatesSinceAxisCheck = 0;
+}
+
+bool SweepAndPrune::ChooseAxis()
+{
+    if (m_liveCount < 2)
+    {
+        return false;
+    }
+
+    double sum[3] = { 0.0, 0.0, 0.0 };
+    double sumSquares[3] = { 0.0, 0.0, 0.0 };
+    for (const SortKey& key : m_order)
+    {
+        const Aabb& box = key.Box;
+        for (UINT axis = 0; axis < 3; axis++)
+        {
+            double center = 0.5 * (static_cast<double>(Component(box.Min, axis)) + Component(box.Max, axis));
+            sum[axis] += center;
+            sumSquares[axis] += center * center;
+        }
+    }
+
+    double variance[3];
+    for (UINT axis = 0; axis < 3; axis++)
+    {
+        double mean = sum[axis] / m_order.size();
+        variance[axis] = sumSquares[axis] / m_order.size() - mean * mean;
+    }
+
+    UINT best = m_axis;
+    for (UINT axis = 0; axis < 3; axis++)
+    {
+        if (variance[axis] > variance[best])
+        {
+            best = axis;
+        }
+    }
+
+    // hysteresis, so two similar axes do not trigger a full re-sort back and forth
+    if (best == m_axis || variance[best] < 1.5 * variance[m_axis])
+    {
+        return false;
+    }
+
+    m_axis = best;
+    return true;
+}
+
+void SweepAndPrune::Sort(bool full)
+{
+    for (SortKey& key : m_order)
+    {
+        key.Box = m_boxes[key.Id];
+        key.Min = Component(key.Box.Min, m_axis);
+    }
+
+    if (full)
+    {
+        std::sort(m_order.begin(), m_order.end(), [](const SortKey& a, const SortKey& b) { return a.Min < b.Min; });
+        return;
+    }
+
+    // coherent motion leaves the previous order nearly sorted
+    for (size_t i = 1; i < m_order.size(); i++)
+    {
+        SortKey key = m_order[i];
+        size_t j = i;
+        while (j > 0 && m_order[j - 1].Min > key.Min)
+        {
+            m_order[j] = m_order[j - 1];
+            j--;
+        }
+        m_order[j] = key;
+    }
+}
+
+void SweepAndPrune::UpdatePairs()
+{
+    if (!m_releasedIds.empty())
+    {
+        const std::vector<BYTE>& alive = m_alive;
+        m_order.erase(std::remove_if(m_order.begin(), m_order.end(), [&alive](const SortKey& key) { return !alive[key.Id]; }), m_order.end());
+        m_freeIds.insert(m_freeIds.end(), m_releasedIds.begin(), m_releasedIds.end());
+        m_releasedIds.clear();
+    }
+
+    bool bulkLoad = m_pendingAdds > m_order.size() / 8;
+    bool axisChanged = false;
+    if (bulkLoad || ++m_updatesSinceAxisCheck >= AxisCheckInterval)
+    {
+        m_updatesSinceAxisCheck = 0;
+        axisChanged = ChooseAxis();
+    }
+
+    Sort(bulkLoad || axisChanged);
+    m_pendingAdds = 0;
+
+    //
+    // sweep: every box only needs testing against those starting before it ends
+    //
+    m_newPairKeys.clear();
+    for (size_t i = 0; i < m_order.size(); i++)
+    {
+        const SortKey& key = m_order[i];
+        float end = Component(key.Box.Max, m_axis);
+
+        for (size_t j = i + 1; j < m_order.size() && m_order[j].Min <= end; j++)
+        {
+            if (Overlaps(key.Box, m_order[j].Box))
+            {
+                BroadphasePair pair = MakePair(key.Id, m_order[j].Id);
+                m_newPairKeys.push_back((static_cast<UINT64>(pair.A) << 32) | pair.B);
+            }
+        }
+    }
+
+    std::sort(m_newPairKeys.begin(), m_newPairKeys.end());
+
+    //
+    // merge against the previous pairs to find the ones that began or ended
+    //
+    m_added.clear();
+    m_removed.clear();
+    m_pairs.clear();
+
+    size_t previous = 0;
+    for (UINT64 key : m_newPairKeys)
+    {
+        while (previous < m_pairKeys.size() && m_pairKeys[previous] < key)
+        {
+            UINT64 ended = m_pairKeys[previous++];
+            m_removed.push_back(MakePair(static_cast<UINT>(ended >> 32), static_cast<UINT>(ended)));
+        }
+
+        BroadphasePair pair = MakePair(static_cast<UINT>(key >> 32), static_cast<UINT>(key));
+        if (previous < m_pairKeys.size() && m_pairKeys[previous] == key)
+        {
+            previous++;
+        }
+        else
+        {
+            m_added.push_back(pair);
+        }
+        m_pairs.push_back(pair);
+    }
+
+    while (previous < m_pairKeys.size())
+    {
+        UINT64 ended = m_pairKeys[previous++];
+        m_removed.push_back(MakePair(static_cast<UINT>(ended >> 32), static_cast<UINT>(ended)));
+    }
+
+    m_pairKeys.swap(m_newPairKeys);
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void Physics::RunBroadphaseBenchmark(std::vector<BroadphaseBenchmarkResult>& results, UINT bodies, UINT ticks)
+{
+    results.clear();
+
+    //
+    // unit boxes in a slab four times longer along x, about two neighbours per body
+    //
+    const float halfSize = 0.5f;
+    const float speed = 0.05f;
+    float side = std::cbrt(bodies * 8.0f / 2.0f);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<XMFLOAT3> positions(bodies);
+    std::vector<XMFLOAT3> velocities(bodies);
+    for (UINT i = 0; i < bodies; i++)
+    {
+        positions[i] = XMFLOAT3(4.0f * side * unit(random), 0.5f * side * unit(random), 0.5f * side * unit(random));
+        velocities[i] = XMFLOAT3(speed * (2.0f * unit(random) - 1.0f), speed * (2.0f * unit(random) - 1.0f), speed * (2.0f * unit(random) - 1.0f));
+    }
+
+    std::vector<Aabb> boxes(bodies);
+    auto place = [&](UINT tick)
+    {
+        for (UINT i = 0; i < bodies; i++)
+        {
+            XMFLOAT3 p(positions[i].x + velocities[i].x * tick, positions[i].y + velocities[i].y * tick, positions[i].z + velocities[i].z * tick);
+            boxes[i].Min = XMFLOAT3(p.x - halfSize, p.y - halfSize, p.z - halfSize);
+            boxes[i].Max = XMFLOAT3(p.x + halfSize, p.y + halfSize, p.z + halfSize);
+        }
+    };
+
+    auto record = [&](const wchar_t* name, double milliseconds, double pairs)
+    {
+        BroadphaseBenchmarkResult result;
+        result.Name = name;
+        result.Bodies = bodies;
+        result.Ticks = ticks;
+        result.MillisecondsPerTick = milliseconds / ticks;
+        result.PairsPerTick = pairs / ticks;
+        results.push_back(result);
+    };
+
+    //
+    // spatial hash, rebuilt every tick
+    //
+    {
+        SpatialHash hash;
+        hash.Initialize(4.0f * halfSize);
+        std::vector<BroadphasePair> pairs;
+        double elapsed = 0.0;
+        double pairCount = 0.0;
+
+        for (UINT tick = 0; tick < ticks; tick++)
+        {
+            place(tick);
+
+            auto start = std::chrono::steady_clock::now();
+            hash.Build(boxes.data(), bodies);
+            hash.FindPairs(pairs);
+            elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            pairCount += pairs.size();
+        }
+
+        record(L"Spatial hash", elapsed, pairCount);
+    }
+
+    //
+    // incremental sweep and prune; the initial load is not part of the measurement
+    //
+    {
+        SweepAndPrune sap;
+        place(0);
+        for (UINT i = 0; i < bodies; i++)
+        {
+            sap.AddProxy(boxes[i]);
+        }
+        sap.UpdatePairs();
+
+        double elapsed = 0.0;
+        double pairCount = 0.0;
+
+        for (UINT tick = 0; tick < ticks; tick++)
+        {
+            place(tick);
+
+            auto start = std::chrono::steady_clock::now();
+            for (UINT i = 0; i < bodies; i++)
+            {
+                sap.UpdateProxy(i, boxes[i]);
+            }
+            sap.UpdatePairs();
+            elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            pairCount += sap.Pairs().size();
+        }
+
+        record(L"Sweep and prune", elapsed, pairCount);
+    }
+
+    //
+    // all pairs reference
+    //
+    if (bodies <= 10000)
+    {
+        double elapsed = 0.0;
+        double pairCount = 0.0;
+
+        for (UINT tick = 0; tick < ticks; tick++)
+        {
+            place(tick);
+
+            auto start = std::chrono::steady_clock::now();
+            UINT found = 0;
+            for (UINT i = 0; i < bodies; i++)
+            {
+                for (UINT j = i + 1; j < bodies; j++)
+                {
+                    found += Overlaps(boxes[i], boxes[j]) ? 1 : 0;
+                }
+            }
+            elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            pairCount += found;
+        }
+
+        record(L"All pairs", elapsed, pairCount);
+    }
+}
+
+#pragma endregion
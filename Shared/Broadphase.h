@@ -0,0 +1,177 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+
+#include <DirectXMath.h>
+
+namespace Physics
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // World space box and the candidate pair of body ids produced from it; pairs always
+    // store the smaller id first.
+    //
+    struct Aabb
+    {
+        DirectX::XMFLOAT3 Min;
+        DirectX::XMFLOAT3 Max;
+    };
+
+    struct BroadphasePair
+    {
+        UINT A;
+        UINT B;
+    };
+
+    inline bool Overlaps(const Aabb& a, const Aabb& b)
+    {
+        return a.Min.x <= b.Max.x && b.Min.x <= a.Max.x
+            && a.Min.y <= b.Max.y && b.Min.y <= a.Max.y
+            && a.Min.z <= b.Max.z && b.Min.z <= a.Max.z;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // SpatialHash buckets boxes by the uniform grid cells they touch. It is rebuilt from
+    // scratch every tick, which costs two linear passes and suits many bodies of similar
+    // size; boxes spanning too many cells are kept aside and tested against everything.
+    //
+    class SpatialHash
+    {
+    public:
+        SpatialHash() : m_cellSize(0.0f), m_inverseCellSize(0.0f), m_autoCellSize(true) { }
+
+        //
+        // cellSize <= 0 picks twice the mean box extent on every Build
+        //
+        void Initialize(float cellSize = 0.0f);
+
+        void Build(const Aabb* boxes, UINT count);
+
+        //
+        // each overlapping pair is reported once, from the cell holding the minimum corner of
+        // the two boxes' intersection
+        //
+        void FindPairs(std::vector<BroadphasePair>& pairs) const;
+
+        //
+        // appends the ids of every built box overlapping box
+        //
+        void Query(const Aabb& box, std::vector<UINT>& results) const;
+
+        float CellSize() const { return m_cellSize; }
+
+    private:
+        static const UINT MaxCellsPerBox = 64;
+
+        struct Entry
+        {
+            UINT64 Cell;
+            UINT Id;
+        };
+
+        struct CellRange
+        {
+            int MinX, MinY, MinZ;
+            int MaxX, MaxY, MaxZ;
+        };
+
+        CellRange Cells(const Aabb& box) const;
+        UINT64 CellKey(int x, int y, int z) const;
+        UINT Bucket(UINT64 cell) const;
+
+        float m_cellSize;
+        float m_inverseCellSize;
+        bool m_autoCellSize;
+
+        std::vector<Aabb> m_boxes;
+        std::vector<Entry> m_entries;           // grouped by bucket
+        std::vector<UINT> m_bucketOffsets;      // bucket count + 1 entries
+        std::vector<UINT> m_large;              // ids of boxes wider than MaxCellsPerBox cells
+        std::vector<BYTE> m_isLarge;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // SweepAndPrune keeps live proxies sorted by their minimum on the axis along which the
+    // bodies are most spread out. Bodies move little between ticks, so the insertion sort that
+    // restores the order is close to linear. The overlapping pairs persist across updates and
+    // each update reports which pairs began and which ended.
+    //
+    class SweepAndPrune
+    {
+    public:
+        SweepAndPrune() : m_axis(0), m_liveCount(0), m_pendingAdds(0), m_updatesSinceAxisCheck(0) { }
+
+        //
+        // ids are stable until removed and are reused afterwards
+        //
+        UINT AddProxy(const Aabb& box);
+        void RemoveProxy(UINT id);
+        void UpdateProxy(UINT id, const Aabb& box);
+        void Clear();
+
+        void UpdatePairs();
+
+        const std::vector<BroadphasePair>& Pairs() const { return m_pairs; }
+        const std::vector<BroadphasePair>& AddedPairs() const { return m_added; }
+        const std::vector<BroadphasePair>& RemovedPairs() const { return m_removed; }
+
+        UINT Axis() const { return m_axis; }
+        UINT ProxyCount() const { return m_liveCount; }
+
+    private:
+        static const UINT AxisCheckInterval = 32;
+
+        // a copy of the box sits next to the key so the sweep reads memory in order
+        struct SortKey
+        {
+            float Min;
+            UINT Id;
+            Aabb Box;
+        };
+
+        bool ChooseAxis();
+        void Sort(bool full);
+
+        UINT m_axis;
+        UINT m_liveCount;
+        UINT m_pendingAdds;
+        UINT m_updatesSinceAxisCheck;
+
+        std::vector<Aabb> m_boxes;
+        std::vector<BYTE> m_alive;
+        std::vector<UINT> m_freeIds;
+        std::vector<UINT> m_releasedIds;        // removed since the last update, not yet reusable
+        std::vector<SortKey> m_order;
+
+        std::vector<UINT64> m_pairKeys;         // sorted, (A << 32) | B
+        std::vector<UINT64> m_newPairKeys;
+        std::vector<BroadphasePair> m_pairs;
+        std::vector<BroadphasePair> m_added;
+        std::vector<BroadphasePair> m_removed;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Moving random boxes at constant density, updated through each broadphase for a number
+    // of ticks. The all-pairs reference only runs while it stays affordable.
+    //
+    struct BroadphaseBenchmarkResult
+    {
+        const wchar_t* Name;
+        UINT Bodies;
+        UINT Ticks;
+        double MillisecondsPerTick;
+        double PairsPerTick;
+    };
+
+    void RunBroadphaseBenchmark(std::vector<BroadphaseBenchmarkResult>& results, UINT bodies = 100000, UINT ticks = 10);
+}
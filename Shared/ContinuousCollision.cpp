@@ -0,0 +1,769 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "ContinuousCollision.h"
+
+using namespace DirectX;
+
+using namespace VSD3DStarter;
+using namespace Physics;
+
+#pragma region Primitive tests
+
+namespace
+{
+    const UINT MaxAdvancementSteps = 32;
+
+    inline float Dot(FXMVECTOR a, FXMVECTOR b)
+    {
+        return XMVectorGetX(XMVector3Dot(a, b));
+    }
+
+    //
+    // smallest root of a*t^2 + b*t + c = 0 in [0, maxTime]
+    //
+    bool LowestRoot(float a, float b, float c, float maxTime, float& root)
+    {
+        if (std::fabs(a) < 1e-12f)
+        {
+            return false;
+        }
+
+        float determinant = b * b - 4.0f * a * c;
+        if (determinant < 0.0f)
+        {
+            return false;
+        }
+
+        float sqrtDeterminant = std::sqrt(determinant);
+        float r1 = (-b - sqrtDeterminant) / (2.0f * a);
+        float r2 = (-b + sqrtDeterminant) / (2.0f * a);
+        if (r1 > r2)
+        {
+            std::swap(r1, r2);
+        }
+
+        if (r1 >= 0.0f && r1 <= maxTime)
+        {
+            root = r1;
+            return true;
+        }
+        return false;
+    }
+
+    //
+    // closest point on triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5)
+    //
+    XMVECTOR XM_CALLCONV ClosestPointOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+    {
+        XMVECTOR ab = XMVectorSubtract(b, a);
+        XMVECTOR ac = XMVectorSubtract(c, a);
+        XMVECTOR ap = XMVectorSubtract(p, a);
+        float d1 = Dot(ab, ap);
+        float d2 = Dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f)
+        {
+            return a;
+        }
+
+        XMVECTOR bp = XMVectorSubtract(p, b);
+        float d3 = Dot(ab, bp);
+        float d4 = Dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3)
+        {
+            return b;
+        }
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        {
+            return XMVectorMultiplyAdd(ab, XMVectorReplicate(d1 / (d1 - d3)), a);
+        }
+
+        XMVECTOR cp = XMVectorSubtract(p, c);
+        float d5 = Dot(ab, cp);
+        float d6 = Dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6)
+        {
+            return c;
+        }
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        {
+            return XMVectorMultiplyAdd(ac, XMVectorReplicate(d2 / (d2 - d6)), a);
+        }
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        {
+            return XMVectorMultiplyAdd(XMVectorSubtract(c, b), XMVectorReplicate((d4 - d3) / ((d4 - d3) + (d5 - d6))), b);
+        }
+
+        float denominator = 1.0f / (va + vb + vc);
+        float v = vb * denominator;
+        float w = vc * denominator;
+        return XMVectorAdd(a, XMVectorAdd(XMVectorScale(ab, v), XMVectorScale(ac, w)));
+    }
+
+    //
+    // closest points between segments p1q1 and p2q2 (Ericson 5.1.9)
+    //
+    void XM_CALLCONV ClosestPointsSegmentSegment(FXMVECTOR p1, FXMVECTOR q1, FXMVECTOR p2, GXMVECTOR q2, XMVECTOR& c1, XMVECTOR& c2)
+    {
+        XMVECTOR d1 = XMVectorSubtract(q1, p1);
+        XMVECTOR d2 = XMVectorSubtract(q2, p2);
+        XMVECTOR r = XMVectorSubtract(p1, p2);
+        float a = Dot(d1, d1);
+        float e = Dot(d2, d2);
+        float f = Dot(d2, r);
+        float s, t;
+
+        if (a <= 1e-12f && e <= 1e-12f)
+        {
+            c1 = p1;
+            c2 = p2;
+            return;
+        }
+
+        if (a <= 1e-12f)
+        {
+            s = 0.0f;
+            t = std::min(std::max(f / e, 0.0f), 1.0f);
+        }
+        else
+        {
+            float c = Dot(d1, r);
+            if (e <= 1e-12f)
+            {
+                t = 0.0f;
+                s = std::min(std::max(-c / a, 0.0f), 1.0f);
+            }
+            else
+            {
+                float b = Dot(d1, d2);
+                float denominator = a * e - b * b;
+
+                s = (denominator > 0.0f) ? std::min(std::max((b * f - c * e) / denominator, 0.0f), 1.0f) : 0.0f;
+                t = (b * s + f) / e;
+
+                if (t < 0.0f)
+                {
+                    t = 0.0f;
+                    s = std::min(std::max(-c / a, 0.0f), 1.0f);
+                }
+                else if (t > 1.0f)
+                {
+                    t = 1.0f;
+                    s = std::min(std::max((b - c) / a, 0.0f), 1.0f);
+                }
+            }
+        }
+
+        c1 = XMVectorMultiplyAdd(d1, XMVectorReplicate(s), p1);
+        c2 = XMVectorMultiplyAdd(d2, XMVectorReplicate(t), p2);
+    }
+
+    //
+    // true if p (on the triangle's plane) lies inside abc; normal is the unnormalized ab x ac
+    //
+    bool XM_CALLCONV PointInTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c, HXMVECTOR normal)
+    {
+        return Dot(XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(p, a)), normal) >= 0.0f &&
+            Dot(XMVector3Cross(XMVectorSubtract(c, b), XMVectorSubtract(p, b)), normal) >= 0.0f &&
+            Dot(XMVector3Cross(XMVectorSubtract(a, c), XMVectorSubtract(p, c)), normal) >= 0.0f;
+    }
+
+    //
+    // distance between segment pq and triangle abc with the closest points on each
+    //
+    float XM_CALLCONV SegmentTriangleDistance(FXMVECTOR p, FXMVECTOR q, FXMVECTOR a, GXMVECTOR b, HXMVECTOR c, XMVECTOR& onSegment, XMVECTOR& onTriangle)
+    {
+        XMVECTOR normal = XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a));
+
+        //
+        // a segment crossing the triangle has distance zero
+        //
+        float dp = Dot(normal, XMVectorSubtract(p, a));
+        float dq = Dot(normal, XMVectorSubtract(q, a));
+        if ((dp <= 0.0f && dq >= 0.0f) || (dp >= 0.0f && dq <= 0.0f))
+        {
+            float denominator = dp - dq;
+            XMVECTOR crossing = (std::fabs(denominator) > 1e-12f) ? XMVectorLerp(p, q, dp / denominator) : p;
+            if (PointInTriangle(crossing, a, b, c, normal))
+            {
+                onSegment = crossing;
+                onTriangle = crossing;
+                return 0.0f;
+            }
+        }
+
+        //
+        // otherwise the closest pair involves a segment end point or a triangle edge
+        //
+        float best = FLT_MAX;
+        XMVECTOR candidateSegment, candidateTriangle;
+
+        auto consider = [&] (FXMVECTOR s, FXMVECTOR t)
+        {
+            float distanceSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(s, t)));
+            if (distanceSq < best)
+            {
+                best = distanceSq;
+                onSegment = s;
+                onTriangle = t;
+            }
+        };
+
+        consider(p, ClosestPointOnTriangle(p, a, b, c));
+        consider(q, ClosestPointOnTriangle(q, a, b, c));
+
+        ClosestPointsSegmentSegment(p, q, a, b, candidateSegment, candidateTriangle);
+        consider(candidateSegment, candidateTriangle);
+        ClosestPointsSegmentSegment(p, q, b, c, candidateSegment, candidateTriangle);
+        consider(candidateSegment, candidateTriangle);
+        ClosestPointsSegmentSegment(p, q, c, a, candidateSegment, candidateTriangle);
+        consider(candidateSegment, candidateTriangle);
+
+        return std::sqrt(best);
+    }
+
+    //
+    // entry time of the ray origin + t * motion into the box, or false if it misses before maxTime
+    //
+    bool XM_CALLCONV RayBoxEntry(FXMVECTOR origin, FXMVECTOR motion, FXMVECTOR boxMin, GXMVECTOR boxMax, float maxTime, float& entry)
+    {
+        float o[3] = { XMVectorGetX(origin), XMVectorGetY(origin), XMVectorGetZ(origin) };
+        float m[3] = { XMVectorGetX(motion), XMVectorGetY(motion), XMVectorGetZ(motion) };
+        float lo[3] = { XMVectorGetX(boxMin), XMVectorGetY(boxMin), XMVectorGetZ(boxMin) };
+        float hi[3] = { XMVectorGetX(boxMax), XMVectorGetY(boxMax), XMVectorGetZ(boxMax) };
+
+        float tMin = 0.0f;
+        float tMax = maxTime;
+        for (UINT i = 0; i < 3; i++)
+        {
+            if (std::fabs(m[i]) < 1e-12f)
+            {
+                if (o[i] < lo[i] || o[i] > hi[i])
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            float inverse = 1.0f / m[i];
+            float t0 = (lo[i] - o[i]) * inverse;
+            float t1 = (hi[i] - o[i]) * inverse;
+            if (t0 > t1)
+            {
+                std::swap(t0, t1);
+            }
+
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+            if (tMin > tMax)
+            {
+                return false;
+            }
+        }
+
+        entry = tMin;
+        return true;
+    }
+}
+
+bool XM_CALLCONV Physics::SweepSphereTriangle(FXMVECTOR start, FXMVECTOR end, float radius,
+    FXMVECTOR v0, GXMVECTOR v1, HXMVECTOR v2, float maxTime, SweepHit& hit)
+{
+    XMVECTOR motion = XMVectorSubtract(end, start);
+    XMVECTOR triangleNormal = XMVector3Cross(XMVectorSubtract(v1, v0), XMVectorSubtract(v2, v0));
+    float area = XMVectorGetX(XMVector3Length(triangleNormal));
+    if (area < 1e-12f)
+    {
+        return false;
+    }
+
+    //
+    // work on the side of the plane the sphere starts on, so the triangle is double sided
+    //
+    XMVECTOR normal = XMVectorScale(triangleNormal, 1.0f / area);
+    float startDistance = Dot(normal, XMVectorSubtract(start, v0));
+    if (startDistance < 0.0f)
+    {
+        normal = XMVectorNegate(normal);
+        startDistance = -startDistance;
+    }
+
+    if (startDistance <= radius)
+    {
+        //
+        // already touching the plane: report an overlap at t = 0 if the sphere reaches the triangle
+        //
+        XMVECTOR closest = ClosestPointOnTriangle(start, v0, v1, v2);
+        XMVECTOR offset = XMVectorSubtract(start, closest);
+        float distance = XMVectorGetX(XMVector3Length(offset));
+        if (distance <= radius)
+        {
+            hit.Time = 0.0f;
+            XMStoreFloat3(&hit.Point, closest);
+            XMStoreFloat3(&hit.Normal, (distance > 1e-6f) ? XMVectorScale(offset, 1.0f / distance) : normal);
+            return true;
+        }
+    }
+    else
+    {
+        //
+        // first contact with the plane; if it lands inside the triangle nothing can be earlier
+        //
+        float approach = -Dot(normal, motion);
+        if (approach <= 0.0f)
+        {
+            return false;
+        }
+
+        float t = (startDistance - radius) / approach;
+        if (t > maxTime)
+        {
+            return false;
+        }
+
+        XMVECTOR contact = XMVectorSubtract(XMVectorMultiplyAdd(motion, XMVectorReplicate(t), start), XMVectorScale(normal, radius));
+        if (PointInTriangle(contact, v0, v1, v2, triangleNormal))
+        {
+            hit.Time = t;
+            XMStoreFloat3(&hit.Point, contact);
+            XMStoreFloat3(&hit.Normal, normal);
+            return true;
+        }
+    }
+
+    //
+    // otherwise the sphere can only meet a vertex or an edge
+    //
+    float best = maxTime;
+    bool found = false;
+    XMVECTOR point = XMVectorZero();
+
+    float motionSq = Dot(motion, motion);
+    float radiusSq = radius * radius;
+    const XMVECTOR vertices[3] = { v0, v1, v2 };
+
+    for (UINT i = 0; i < 3; i++)
+    {
+        XMVECTOR base = XMVectorSubtract(start, vertices[i]);
+        float t;
+        if (LowestRoot(motionSq, 2.0f * Dot(motion, base), Dot(base, base) - radiusSq, best, t))
+        {
+            best = t;
+            point = vertices[i];
+            found = true;
+        }
+    }
+
+    for (UINT i = 0; i < 3; i++)
+    {
+        XMVECTOR p0 = vertices[i];
+        XMVECTOR edge = XMVectorSubtract(vertices[(i + 1) % 3], p0);
+        XMVECTOR base = XMVectorSubtract(p0, start);
+
+        float edgeSq = Dot(edge, edge);
+        float edgeDotMotion = Dot(edge, motion);
+        float edgeDotBase = Dot(edge, base);
+
+        float a = edgeSq * -motionSq + edgeDotMotion * edgeDotMotion;
+        float b = edgeSq * (2.0f * Dot(motion, base)) - 2.0f * edgeDotMotion * edgeDotBase;
+        float c = edgeSq * (radiusSq - Dot(base, base)) + edgeDotBase * edgeDotBase;
+
+        float t;
+        if (LowestRoot(a, b, c, best, t))
+        {
+            float f = (edgeDotMotion * t - edgeDotBase) / edgeSq;
+            if (f >= 0.0f && f <= 1.0f)
+            {
+                best = t;
+                point = XMVectorMultiplyAdd(edge, XMVectorReplicate(f), p0);
+                found = true;
+            }
+        }
+    }
+
+    if (found)
+    {
+        XMVECTOR center = XMVectorMultiplyAdd(motion, XMVectorReplicate(best), start);
+        hit.Time = best;
+        XMStoreFloat3(&hit.Point, point);
+        XMStoreFloat3(&hit.Normal, XMVector3Normalize(XMVectorSubtract(center, point)));
+    }
+    return found;
+}
+
+bool XM_CALLCONV Physics::SweepCapsuleTriangle(FXMVECTOR start, FXMVECTOR axis, FXMVECTOR motion, float radius,
+    GXMVECTOR v0, HXMVECTOR v1, HXMVECTOR v2, float maxTime, SweepHit& hit)
+{
+    //
+    // conservative advancement: the distance between a convex shape and a triangle is convex
+    // in the translation, so stepping to the root of its tangent never passes the contact
+    //
+    const float tolerance = std::max(radius * 1e-3f, 1e-5f);
+
+    float t = 0.0f;
+    for (UINT step = 0; step < MaxAdvancementSteps; step++)
+    {
+        XMVECTOR p = XMVectorMultiplyAdd(motion, XMVectorReplicate(t), start);
+        XMVECTOR q = XMVectorAdd(p, axis);
+
+        XMVECTOR onSegment, onTriangle;
+        float distance = SegmentTriangleDistance(p, q, v0, v1, v2, onSegment, onTriangle);
+        float gap = distance - radius;
+
+        XMVECTOR normal;
+        if (distance > 1e-6f)
+        {
+            normal = XMVectorScale(XMVectorSubtract(onSegment, onTriangle), 1.0f / distance);
+        }
+        else
+        {
+            normal = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(v1, v0), XMVectorSubtract(v2, v0)));
+            if (Dot(normal, XMVectorSubtract(XMVectorMultiplyAdd(axis, XMVectorReplicate(0.5f), start), v0)) < 0.0f)
+            {
+                normal = XMVectorNegate(normal);
+            }
+        }
+
+        if (gap <= tolerance)
+        {
+            hit.Time = t;
+            XMStoreFloat3(&hit.Point, onTriangle);
+            XMStoreFloat3(&hit.Normal, normal);
+            return true;
+        }
+
+        float approach = -Dot(motion, normal);
+        if (approach <= 0.0f)
+        {
+            return false;
+        }
+
+        t += gap / approach;
+        if (t > maxTime)
+        {
+            return false;
+        }
+    }
+
+    //
+    // grazing contacts converge slowly; report the conservative time reached so far
+    //
+    XMVECTOR p = XMVectorMultiplyAdd(motion, XMVectorReplicate(t), start);
+    XMVECTOR onSegment, onTriangle;
+    SegmentTriangleDistance(p, XMVectorAdd(p, axis), v0, v1, v2, onSegment, onTriangle);
+
+    hit.Time = t;
+    XMStoreFloat3(&hit.Point, onTriangle);
+    XMStoreFloat3(&hit.Normal, XMVector3Normalize(XMVectorSubtract(onSegment, onTriangle)));
+    return true;
+}
+
+bool XM_CALLCONV Physics::RaycastTriangle(FXMVECTOR start, FXMVECTOR motion,
+    FXMVECTOR v0, GXMVECTOR v1, HXMVECTOR v2, float maxTime, SweepHit& hit)
+{
+    //
+    // Moller-Trumbore: solve start + t * motion = v0 + u * edge1 + v * edge2
+    //
+    XMVECTOR edge1 = XMVectorSubtract(v1, v0);
+    XMVECTOR edge2 = XMVectorSubtract(v2, v0);
+    XMVECTOR p = XMVector3Cross(motion, edge2);
+    float determinant = Dot(edge1, p);
+    if (std::fabs(determinant) < 1e-12f)
+    {
+        return false;
+    }
+
+    float inverse = 1.0f / determinant;
+    XMVECTOR s = XMVectorSubtract(start, v0);
+    float u = Dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+    {
+        return false;
+    }
+
+    XMVECTOR q = XMVector3Cross(s, edge1);
+    float v = Dot(motion, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+    {
+        return false;
+    }
+
+    float t = Dot(edge2, q) * inverse;
+    if (t < 0.0f || t > maxTime)
+    {
+        return false;
+    }
+
+    XMVECTOR normal = XMVector3Normalize(XMVector3Cross(edge1, edge2));
+    if (determinant < 0.0f)
+    {
+        normal = XMVectorNegate(normal);
+    }
+
+    hit.Time = t;
+    XMStoreFloat3(&hit.Point, XMVectorMultiplyAdd(motion, XMVectorReplicate(t), start));
+    XMStoreFloat3(&hit.Normal, normal);
+    return true;
+}
+
+#pragma endregion
+
+#pragma region TriangleMeshCollider
+
+void TriangleMeshCollider::Initialize(const Mesh::TriangleCollection& triangles, CXMMATRIX world)
+{
+    m_vertices.clear();
+    m_vertices.reserve(triangles.size() * 3);
+
+    for (const Mesh::Triangle& triangle : triangles)
+    {
+        for (UINT i = 0; i < 3; i++)
+        {
+            XMFLOAT3 v;
+            XMStoreFloat3(&v, XMVector3TransformCoord(XMLoadFloat3(&triangle.points[i]), world));
+            m_vertices.push_back(v);
+        }
+    }
+
+    m_order.resize(TriangleCount());
+    for (UINT i = 0; i < TriangleCount(); i++)
+    {
+        m_order[i] = i;
+    }
+
+    m_nodes.clear();
+    if (TriangleCount() > 0)
+    {
+        m_nodes.reserve(2 * TriangleCount() / LeafSize + 1);
+        m_nodes.resize(1);
+        BuildNode(0, 0, TriangleCount(), 0);
+    }
+}
+
+void TriangleMeshCollider::Initialize(const std::vector<Mesh*>& meshes, CXMMATRIX world)
+{
+    Mesh::TriangleCollection triangles;
+    for (Mesh* mesh : meshes)
+    {
+        triangles.insert(triangles.end(), mesh->Triangles().begin(), mesh->Triangles().end());
+    }
+
+    Initialize(triangles, world);
+}
+
+void TriangleMeshCollider::BuildNode(UINT node, UINT first, UINT count, UINT depth)
+{
+    XMVECTOR boundsMin = g_XMFltMax;
+    XMVECTOR boundsMax = XMVectorNegate(g_XMFltMax);
+    XMVECTOR centroidMin = boundsMin;
+    XMVECTOR centroidMax = boundsMax;
+
+    for (UINT i = first; i < first + count; i++)
+    {
+        const XMFLOAT3* v = &m_vertices[m_order[i] * 3];
+        XMVECTOR a = XMLoadFloat3(&v[0]);
+        XMVECTOR b = XMLoadFloat3(&v[1]);
+        XMVECTOR c = XMLoadFloat3(&v[2]);
+
+        boundsMin = XMVectorMin(boundsMin, XMVectorMin(a, XMVectorMin(b, c)));
+        boundsMax = XMVectorMax(boundsMax, XMVectorMax(a, XMVectorMax(b, c)));
+
+        XMVECTOR centroid = XMVectorScale(XMVectorAdd(a, XMVectorAdd(b, c)), 1.0f / 3.0f);
+        centroidMin = XMVectorMin(centroidMin, centroid);
+        centroidMax = XMVectorMax(centroidMax, centroid);
+    }
+
+    XMStoreFloat3(&m_nodes[node].Min, boundsMin);
+    XMStoreFloat3(&m_nodes[node].Max, boundsMax);
+
+    if (count <= LeafSize || depth + 1 >= MaxDepth)
+    {
+        m_nodes[node].First = first;
+        m_nodes[node].Count = count;
+        return;
+    }
+
+    //
+    // median split along the longest axis of the centroid bounds
+    //
+    XMFLOAT3 extent;
+    XMStoreFloat3(&extent, XMVectorSubtract(centroidMax, centroidMin));
+    UINT axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+
+    auto centroid = [this, axis] (UINT triangle) -> float
+    {
+        const XMFLOAT3* v = &m_vertices[triangle * 3];
+        const float* a = &v[0].x;
+        const float* b = &v[1].x;
+        const float* c = &v[2].x;
+        return a[axis] + b[axis] + c[axis];
+    };
+
+    UINT half = count / 2;
+    std::nth_element(m_order.begin() + first, m_order.begin() + first + half, m_order.begin() + first + count,
+        [&centroid] (UINT a, UINT b) { return centroid(a) < centroid(b); });
+
+    UINT left = static_cast<UINT>(m_nodes.size());
+    m_nodes.resize(left + 2);
+    m_nodes[node].First = left;
+    m_nodes[node].Count = 0;
+
+    BuildNode(left, first, half, depth + 1);
+    BuildNode(left + 1, first + half, count - half, depth + 1);
+}
+
+template<typename TriangleSweep>
+bool XM_CALLCONV TriangleMeshCollider::Sweep(FXMVECTOR origin, FXMVECTOR motion, FXMVECTOR inflate, const TriangleSweep& sweep, SweepHit& hit) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    UINT stack[2 * MaxDepth];
+    UINT stackSize = 0;
+    stack[stackSize++] = 0;
+
+    bool found = false;
+    float best = 1.0f;
+    SweepHit candidate;
+
+    while (stackSize > 0)
+    {
+        const Node& node = m_nodes[stack[--stackSize]];
+
+        float entry;
+        XMVECTOR boundsMin = XMVectorSubtract(XMLoadFloat3(&node.Min), inflate);
+        XMVECTOR boundsMax = XMVectorAdd(XMLoadFloat3(&node.Max), inflate);
+        if (!RayBoxEntry(origin, motion, boundsMin, boundsMax, best, entry))
+        {
+            continue;
+        }
+
+        if (node.Count == 0)
+        {
+            stack[stackSize++] = node.First;
+            stack[stackSize++] = node.First + 1;
+            continue;
+        }
+
+        for (UINT i = node.First; i < node.First + node.Count; i++)
+        {
+            UINT triangle = m_order[i];
+            const XMFLOAT3* v = &m_vertices[triangle * 3];
+            if (sweep(XMLoadFloat3(&v[0]), XMLoadFloat3(&v[1]), XMLoadFloat3(&v[2]), best, candidate) &&
+                (!found || candidate.Time < best))
+            {
+                hit = candidate;
+                hit.Triangle = triangle;
+                best = candidate.Time;
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+bool XM_CALLCONV TriangleMeshCollider::SweepSphere(FXMVECTOR start, FXMVECTOR end, float radius, SweepHit& hit) const
+{
+    auto sweep = [start, end, radius] (FXMVECTOR v0, FXMVECTOR v1, FXMVECTOR v2, float maxTime, SweepHit& candidate)
+    {
+        return SweepSphereTriangle(start, end, radius, v0, v1, v2, maxTime, candidate);
+    };
+
+    return Sweep(start, XMVectorSubtract(end, start), XMVectorReplicate(radius), sweep, hit);
+}
+
+bool XM_CALLCONV TriangleMeshCollider::SweepCapsule(FXMVECTOR start, FXMVECTOR axis, FXMVECTOR motion, float radius, SweepHit& hit) const
+{
+    auto sweep = [start, axis, motion, radius] (FXMVECTOR v0, FXMVECTOR v1, FXMVECTOR v2, float maxTime, SweepHit& candidate)
+    {
+        return SweepCapsuleTriangle(start, axis, motion, radius, v0, v1, v2, maxTime, candidate);
+    };
+
+    //
+    // the tree is walked with the capsule's centre and its half extents added to the bounds
+    //
+    XMVECTOR halfAxis = XMVectorScale(axis, 0.5f);
+    XMVECTOR inflate = XMVectorAdd(XMVectorAbs(halfAxis), XMVectorReplicate(radius));
+    return Sweep(XMVectorAdd(start, halfAxis), motion, inflate, sweep, hit);
+}
+
+bool XM_CALLCONV TriangleMeshCollider::Raycast(FXMVECTOR start, FXMVECTOR motion, SweepHit& hit) const
+{
+    auto sweep = [start, motion] (FXMVECTOR v0, FXMVECTOR v1, FXMVECTOR v2, float maxTime, SweepHit& candidate)
+    {
+        return RaycastTriangle(start, motion, v0, v1, v2, maxTime, candidate);
+    };
+
+    return Sweep(start, motion, XMVectorZero(), sweep, hit);
+}
+
+void XM_CALLCONV TriangleMeshCollider::QueryTriangles(FXMVECTOR boxMin, FXMVECTOR boxMax, std::vector<UINT>& triangles) const
+{
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    UINT stack[2 * MaxDepth];
+    UINT stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node& node = m_nodes[stack[--stackSize]];
+        if (!XMVector3GreaterOrEqual(boxMax, XMLoadFloat3(&node.Min)) || !XMVector3LessOrEqual(boxMin, XMLoadFloat3(&node.Max)))
+        {
+            continue;
+        }
+
+        if (node.Count == 0)
+        {
+            stack[stackSize++] = node.First;
+            stack[stackSize++] = node.First + 1;
+            continue;
+        }
+
+        triangles.insert(triangles.end(), m_order.begin() + node.First, m_order.begin() + node.First + node.Count);
+    }
+}
+
+void TriangleMeshCollider::GetTriangle(UINT triangle, XMVECTOR& v0, XMVECTOR& v1, XMVECTOR& v2) const
+{
+    const XMFLOAT3* v = &m_vertices[triangle * 3];
+    v0 = XMLoadFloat3(&v[0]);
+    v1 = XMLoadFloat3(&v[1]);
+    v2 = XMLoadFloat3(&v[2]);
+}
+
+void TriangleMeshCollider::GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax) const
+{
+    if (m_nodes.empty())
+    {
+        boundsMin = boundsMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        return;
+    }
+
+    boundsMin = m_nodes[0].Min;
+    boundsMax = m_nodes[0].Max;
+}
+
+#pragma endregion
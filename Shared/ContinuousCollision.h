@@ -0,0 +1,104 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "VSD3DStarter.h"
+
+namespace Physics
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Result of a swept query. Time is the fraction of the sweep at first contact, Point the
+    // contact point on the triangle and Normal the triangle-to-shape separation direction.
+    //
+    struct SweepHit
+    {
+        float Time;
+        DirectX::XMFLOAT3 Point;
+        DirectX::XMFLOAT3 Normal;
+        UINT Triangle;
+    };
+
+    //
+    // time of impact of a sphere moving from start to end against one triangle
+    //
+    bool XM_CALLCONV SweepSphereTriangle(DirectX::FXMVECTOR start, DirectX::FXMVECTOR end, float radius,
+        DirectX::FXMVECTOR v0, DirectX::GXMVECTOR v1, DirectX::HXMVECTOR v2, float maxTime, SweepHit& hit);
+
+    //
+    // time of impact of a capsule (segment start..start+axis, radius) translated by motion
+    //
+    bool XM_CALLCONV SweepCapsuleTriangle(DirectX::FXMVECTOR start, DirectX::FXMVECTOR axis, DirectX::FXMVECTOR motion, float radius,
+        DirectX::GXMVECTOR v0, DirectX::HXMVECTOR v1, DirectX::HXMVECTOR v2, float maxTime, SweepHit& hit);
+
+    //
+    // first crossing of the segment start..start+motion with one triangle, from either side
+    //
+    bool XM_CALLCONV RaycastTriangle(DirectX::FXMVECTOR start, DirectX::FXMVECTOR motion,
+        DirectX::FXMVECTOR v0, DirectX::GXMVECTOR v1, DirectX::HXMVECTOR v2, float maxTime, SweepHit& hit);
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // TriangleMeshCollider keeps the world space triangles of a static mesh in an AABB tree
+    // so swept queries only test the triangles whose bounds overlap the swept volume.
+    //
+    class TriangleMeshCollider
+    {
+    public:
+        TriangleMeshCollider() { }
+
+        void Initialize(const VSD3DStarter::Mesh::TriangleCollection& triangles, DirectX::CXMMATRIX world);
+        void Initialize(const std::vector<VSD3DStarter::Mesh*>& meshes, DirectX::CXMMATRIX world);
+
+        bool XM_CALLCONV SweepSphere(DirectX::FXMVECTOR start, DirectX::FXMVECTOR end, float radius, SweepHit& hit) const;
+        bool XM_CALLCONV SweepCapsule(DirectX::FXMVECTOR start, DirectX::FXMVECTOR axis, DirectX::FXMVECTOR motion, float radius, SweepHit& hit) const;
+
+        //
+        // closest triangle crossed by the segment start..start+motion; the normal faces the ray
+        //
+        bool XM_CALLCONV Raycast(DirectX::FXMVECTOR start, DirectX::FXMVECTOR motion, SweepHit& hit) const;
+
+        //
+        // appends the triangles whose bounds overlap the box
+        //
+        void XM_CALLCONV QueryTriangles(DirectX::FXMVECTOR boxMin, DirectX::FXMVECTOR boxMax, std::vector<UINT>& triangles) const;
+
+        UINT TriangleCount() const { return static_cast<UINT>(m_vertices.size() / 3); }
+        void GetTriangle(UINT triangle, DirectX::XMVECTOR& v0, DirectX::XMVECTOR& v1, DirectX::XMVECTOR& v2) const;
+        void GetBounds(DirectX::XMFLOAT3& boundsMin, DirectX::XMFLOAT3& boundsMax) const;
+
+    private:
+        struct Node
+        {
+            DirectX::XMFLOAT3 Min;
+            DirectX::XMFLOAT3 Max;
+            UINT First;     // first child index, or first entry of m_order for a leaf
+            UINT Count;     // 0 for an inner node
+        };
+
+        static const UINT LeafSize = 4;
+        static const UINT MaxDepth = 64;
+
+        void BuildNode(UINT node, UINT first, UINT count, UINT depth);
+
+        //
+        // walks the nodes whose bounds, inflated by the shape's half extents, are crossed by the
+        // ray origin + t * motion before the best time of impact found so far
+        //
+        template<typename TriangleSweep>
+        bool XM_CALLCONV Sweep(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR motion, DirectX::FXMVECTOR inflate, const TriangleSweep& sweep, SweepHit& hit) const;
+
+        std::vector<DirectX::XMFLOAT3> m_vertices;     // three per triangle, world space
+        std::vector<UINT> m_order;                     // triangle indices referenced by the leaves
+        std::vector<Node> m_nodes;
+    };
+}
@@ -0,0 +1,453 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <set>
+
+#include "ConvexHull.h"
+
+using namespace DirectX;
+
+using namespace VSD3DStarter;
+using namespace Physics;
+
+#pragma region Quickhull
+
+namespace
+{
+    struct HullFace
+    {
+        UINT V[3];
+        XMFLOAT3 Normal;
+        float Offset;
+        std::vector<UINT> Outside;
+        UINT Farthest;              // outside point with the largest distance
+        float FarthestDistance;
+        bool Alive;
+    };
+
+    inline float Dot(FXMVECTOR a, FXMVECTOR b)
+    {
+        return XMVectorGetX(XMVector3Dot(a, b));
+    }
+
+    inline float Distance(const HullFace& face, FXMVECTOR p)
+    {
+        return Dot(XMLoadFloat3(&face.Normal), p) - face.Offset;
+    }
+
+    inline UINT64 EdgeKey(UINT a, UINT b)
+    {
+        return (static_cast<UINT64>(a) << 32) | b;
+    }
+
+    bool MakeFace(const std::vector<XMFLOAT3>& points, UINT a, UINT b, UINT c, HullFace& face)
+    {
+        XMVECTOR p0 = XMLoadFloat3(&points[a]);
+        XMVECTOR normal = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&points[b]), p0), XMVectorSubtract(XMLoadFloat3(&points[c]), p0));
+        float length = XMVectorGetX(XMVector3Length(normal));
+
+        face.V[0] = a;
+        face.V[1] = b;
+        face.V[2] = c;
+        face.Alive = true;
+        face.Outside.clear();
+        face.Farthest = UINT_MAX;
+        face.FarthestDistance = 0.0f;
+
+        if (length <= 0.0f)
+        {
+            face.Normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            face.Offset = 0.0f;
+            return false;
+        }
+
+        normal = XMVectorScale(normal, 1.0f / length);
+        XMStoreFloat3(&face.Normal, normal);
+        face.Offset = Dot(normal, p0);
+        return true;
+    }
+
+    //
+    // adds p to the outside set of the face it is farthest above
+    //
+    void AssignPoint(std::vector<HullFace>& faces, const std::vector<UINT>& candidates, FXMVECTOR p, UINT index, float epsilon)
+    {
+        float best = epsilon;
+        UINT bestFace = UINT_MAX;
+        for (UINT f : candidates)
+        {
+            float d = Distance(faces[f], p);
+            if (d > best)
+            {
+                best = d;
+                bestFace = f;
+            }
+        }
+
+        if (bestFace != UINT_MAX)
+        {
+            HullFace& face = faces[bestFace];
+            face.Outside.push_back(index);
+            if (best > face.FarthestDistance)
+            {
+                face.FarthestDistance = best;
+                face.Farthest = index;
+            }
+        }
+    }
+}
+
+bool ConvexHull::Initialize(const XMFLOAT3* points, UINT pointCount, UINT maxVertices)
+{
+    m_vertices.clear();
+    m_indices.clear();
+    m_adjacencyOffsets.clear();
+    m_adjacency.clear();
+    m_radius = 0.0f;
+
+    if (pointCount < 4)
+    {
+        return false;
+    }
+
+    std::vector<XMFLOAT3> p(points, points + pointCount);
+
+    //
+    // tolerance scaled to the size of the cloud
+    //
+    XMVECTOR boundsMin = XMLoadFloat3(&p[0]);
+    XMVECTOR boundsMax = boundsMin;
+    UINT extremes[6] = { 0, 0, 0, 0, 0, 0 };
+    for (UINT i = 1; i < pointCount; i++)
+    {
+        const float* c = &p[i].x;
+        for (UINT axis = 0; axis < 3; axis++)
+        {
+            if (c[axis] < (&p[extremes[axis * 2]].x)[axis])
+            {
+                extremes[axis * 2] = i;
+            }
+            if (c[axis] > (&p[extremes[axis * 2 + 1]].x)[axis])
+            {
+                extremes[axis * 2 + 1] = i;
+            }
+        }
+        boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&p[i]));
+        boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&p[i]));
+    }
+
+    XMVECTOR span = XMVectorSubtract(boundsMax, boundsMin);
+    const float epsilon = 1e-5f * (XMVectorGetX(span) + XMVectorGetY(span) + XMVectorGetZ(span));
+
+    //
+    // initial tetrahedron: the farthest pair of extreme points, the point farthest from their
+    // line and the point farthest from the plane of those three
+    //
+    UINT i0 = 0, i1 = 0;
+    float bestDistance = -1.0f;
+    for (UINT a = 0; a < 6; a++)
+    {
+        for (UINT b = a + 1; b < 6; b++)
+        {
+            float d = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&p[extremes[a]]), XMLoadFloat3(&p[extremes[b]]))));
+            if (d > bestDistance)
+            {
+                bestDistance = d;
+                i0 = extremes[a];
+                i1 = extremes[b];
+            }
+        }
+    }
+
+    XMVECTOR p0 = XMLoadFloat3(&p[i0]);
+    XMVECTOR lineDirection = XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&p[i1]), p0));
+
+    UINT i2 = 0;
+    bestDistance = -1.0f;
+    for (UINT i = 0; i < pointCount; i++)
+    {
+        XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&p[i]), p0);
+        float d = XMVectorGetX(XMVector3LengthSq(XMVector3Cross(offset, lineDirection)));
+        if (d > bestDistance)
+        {
+            bestDistance = d;
+            i2 = i;
+        }
+    }
+
+    XMVECTOR planeNormal = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&p[i1]), p0), XMVectorSubtract(XMLoadFloat3(&p[i2]), p0)));
+
+    UINT i3 = 0;
+    bestDistance = 0.0f;
+    for (UINT i = 0; i < pointCount; i++)
+    {
+        float d = std::fabs(Dot(planeNormal, XMVectorSubtract(XMLoadFloat3(&p[i]), p0)));
+        if (d > bestDistance)
+        {
+            bestDistance = d;
+            i3 = i;
+        }
+    }
+
+    if (i0 == i1 || bestDistance <= epsilon)
+    {
+        // the cloud is flat or degenerate
+        return false;
+    }
+
+    std::vector<HullFace> faces(4);
+    const UINT initial[4][3] = { { i0, i1, i2 }, { i0, i3, i1 }, { i0, i2, i3 }, { i1, i3, i2 } };
+    XMVECTOR centroid = XMVectorScale(XMVectorAdd(XMVectorAdd(XMLoadFloat3(&p[i0]), XMLoadFloat3(&p[i1])), XMVectorAdd(XMLoadFloat3(&p[i2]), XMLoadFloat3(&p[i3]))), 0.25f);
+
+    for (UINT f = 0; f < 4; f++)
+    {
+        MakeFace(p, initial[f][0], initial[f][1], initial[f][2], faces[f]);
+        if (Distance(faces[f], centroid) > 0.0f)
+        {
+            MakeFace(p, initial[f][0], initial[f][2], initial[f][1], faces[f]);
+        }
+    }
+
+    std::vector<UINT> candidates;
+    candidates.push_back(0);
+    candidates.push_back(1);
+    candidates.push_back(2);
+    candidates.push_back(3);
+
+    for (UINT i = 0; i < pointCount; i++)
+    {
+        if (i != i0 && i != i1 && i != i2 && i != i3)
+        {
+            AssignPoint(faces, candidates, XMLoadFloat3(&p[i]), i, epsilon);
+        }
+    }
+
+    //
+    // expand towards the globally farthest outside point until no face has one left
+    //
+    UINT hullVertexCount = 4;
+    std::set<UINT64> visibleEdges;
+    std::vector<UINT> visible;
+    std::vector<UINT> orphans;
+    std::vector<std::pair<UINT, UINT>> horizon;
+
+    for (;;)
+    {
+        if (maxVertices > 0 && hullVertexCount >= maxVertices)
+        {
+            break;
+        }
+
+        UINT source = UINT_MAX;
+        for (UINT f = 0; f < faces.size(); f++)
+        {
+            if (faces[f].Alive && !faces[f].Outside.empty() &&
+                (source == UINT_MAX || faces[f].FarthestDistance > faces[source].FarthestDistance))
+            {
+                source = f;
+            }
+        }
+
+        if (source == UINT_MAX)
+        {
+            break;
+        }
+
+        UINT eye = faces[source].Farthest;
+        XMVECTOR eyePoint = XMLoadFloat3(&p[eye]);
+
+        //
+        // every face the eye point sees is replaced; the border of that region is the horizon
+        //
+        visible.clear();
+        visibleEdges.clear();
+        for (UINT f = 0; f < faces.size(); f++)
+        {
+            if (faces[f].Alive && Distance(faces[f], eyePoint) > epsilon)
+            {
+                visible.push_back(f);
+                for (UINT e = 0; e < 3; e++)
+                {
+                    visibleEdges.insert(EdgeKey(faces[f].V[e], faces[f].V[(e + 1) % 3]));
+                }
+            }
+        }
+
+        horizon.clear();
+        orphans.clear();
+        for (UINT f : visible)
+        {
+            for (UINT e = 0; e < 3; e++)
+            {
+                UINT a = faces[f].V[e];
+                UINT b = faces[f].V[(e + 1) % 3];
+                if (visibleEdges.find(EdgeKey(b, a)) == visibleEdges.end())
+                {
+                    horizon.push_back(std::make_pair(a, b));
+                }
+            }
+
+            for (UINT i : faces[f].Outside)
+            {
+                if (i != eye)
+                {
+                    orphans.push_back(i);
+                }
+            }
+
+            faces[f].Alive = false;
+            std::vector<UINT>().swap(faces[f].Outside);
+        }
+
+        candidates.clear();
+        for (const std::pair<UINT, UINT>& edge : horizon)
+        {
+            HullFace face;
+            if (MakeFace(p, edge.first, edge.second, eye, face))
+            {
+                candidates.push_back(static_cast<UINT>(faces.size()));
+                faces.push_back(face);
+            }
+        }
+
+        for (UINT i : orphans)
+        {
+            AssignPoint(faces, candidates, XMLoadFloat3(&p[i]), i, epsilon);
+        }
+
+        hullVertexCount++;
+    }
+
+    //
+    // compact the surviving faces into an indexed triangle list
+    //
+    std::vector<UINT> remap(pointCount, UINT_MAX);
+    for (const HullFace& face : faces)
+    {
+        if (!face.Alive)
+        {
+            continue;
+        }
+
+        for (UINT e = 0; e < 3; e++)
+        {
+            UINT v = face.V[e];
+            if (remap[v] == UINT_MAX)
+            {
+                remap[v] = static_cast<UINT>(m_vertices.size());
+                m_vertices.push_back(p[v]);
+            }
+            m_indices.push_back(remap[v]);
+        }
+    }
+
+    boundsMin = XMLoadFloat3(&m_vertices[0]);
+    boundsMax = boundsMin;
+    for (const XMFLOAT3& v : m_vertices)
+    {
+        boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&v));
+        boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&v));
+        m_radius = std::max(m_radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&v))));
+    }
+    XMStoreFloat3(&m_boundsMin, boundsMin);
+    XMStoreFloat3(&m_boundsMax, boundsMax);
+
+    BuildAdjacency();
+    return true;
+}
+
+bool ConvexHull::Initialize(const std::vector<Mesh*>& meshes, UINT maxVertices)
+{
+    std::vector<XMFLOAT3> points;
+    for (Mesh* mesh : meshes)
+    {
+        for (const Mesh::Triangle& triangle : mesh->Triangles())
+        {
+            points.insert(points.end(), triangle.points, triangle.points + 3);
+        }
+    }
+
+    //
+    // neighbouring triangles repeat their shared corners exactly, so welding bit-identical
+    // positions leaves quickhull about a sixth of the points of a closed mesh
+    //
+    std::sort(points.begin(), points.end(), [](const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return (a.x != b.x) ? a.x < b.x : (a.y != b.y) ? a.y < b.y : a.z < b.z;
+    });
+    points.erase(std::unique(points.begin(), points.end(), [](const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }), points.end());
+
+    return points.empty() ? false : Initialize(&points[0], static_cast<UINT>(points.size()), maxVertices);
+}
+
+void ConvexHull::BuildAdjacency()
+{
+    std::vector<std::set<UINT>> neighbours(m_vertices.size());
+    for (size_t t = 0; t + 2 < m_indices.size(); t += 3)
+    {
+        for (UINT e = 0; e < 3; e++)
+        {
+            UINT a = m_indices[t + e];
+            UINT b = m_indices[t + (e + 1) % 3];
+            neighbours[a].insert(b);
+            neighbours[b].insert(a);
+        }
+    }
+
+    m_adjacencyOffsets.resize(m_vertices.size() + 1);
+    m_adjacency.clear();
+    for (size_t v = 0; v < m_vertices.size(); v++)
+    {
+        m_adjacencyOffsets[v] = static_cast<UINT>(m_adjacency.size());
+        m_adjacency.insert(m_adjacency.end(), neighbours[v].begin(), neighbours[v].end());
+    }
+    m_adjacencyOffsets[m_vertices.size()] = static_cast<UINT>(m_adjacency.size());
+}
+
+#pragma endregion
+
+#pragma region Support
+
+XMVECTOR XM_CALLCONV ConvexHull::Support(FXMVECTOR direction, UINT& hint) const
+{
+    UINT current = (hint < m_vertices.size()) ? hint : 0;
+    float best = Dot(XMLoadFloat3(&m_vertices[current]), direction);
+
+    //
+    // on a convex polytope a vertex with no better neighbour is the global maximum
+    //
+    bool improved = true;
+    while (improved)
+    {
+        improved = false;
+        for (UINT n = m_adjacencyOffsets[current]; n < m_adjacencyOffsets[current + 1]; n++)
+        {
+            UINT neighbour = m_adjacency[n];
+            float d = Dot(XMLoadFloat3(&m_vertices[neighbour]), direction);
+            if (d > best)
+            {
+                best = d;
+                current = neighbour;
+                improved = true;
+                break;
+            }
+        }
+    }
+
+    hint = current;
+    return XMLoadFloat3(&m_vertices[current]);
+}
+
+#pragma endregion
@@ -0,0 +1,60 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "VSD3DStarter.h"
+
+namespace Physics
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // ConvexHull is the quickhull hull of a point cloud, stored as a triangle list with
+    // outward winding plus per-vertex adjacency so support queries can hill climb from the
+    // previous answer instead of testing every vertex.
+    //
+    class ConvexHull
+    {
+    public:
+        ConvexHull() : m_boundsMin(0.0f, 0.0f, 0.0f), m_boundsMax(0.0f, 0.0f, 0.0f), m_radius(0.0f) { }
+
+        //
+        // maxVertices > 0 stops quickhull once that many hull vertices are found; quickhull adds
+        // the farthest points first, so the result is a close, slightly smaller approximation
+        //
+        bool Initialize(const DirectX::XMFLOAT3* points, UINT pointCount, UINT maxVertices = 0);
+        bool Initialize(const std::vector<VSD3DStarter::Mesh*>& meshes, UINT maxVertices = 0);
+
+        //
+        // farthest hull vertex along direction (model space); hint carries the starting vertex
+        // between calls and may be any value the first time
+        //
+        DirectX::XMVECTOR XM_CALLCONV Support(DirectX::FXMVECTOR direction, UINT& hint) const;
+
+        bool IsValid() const { return !m_indices.empty(); }
+        const std::vector<DirectX::XMFLOAT3>& Vertices() const { return m_vertices; }
+        const std::vector<UINT>& Indices() const { return m_indices; }
+        const DirectX::XMFLOAT3& BoundsMin() const { return m_boundsMin; }
+        const DirectX::XMFLOAT3& BoundsMax() const { return m_boundsMax; }
+        float Radius() const { return m_radius; }   // around the model space origin
+
+    private:
+        void BuildAdjacency();
+
+        std::vector<DirectX::XMFLOAT3> m_vertices;
+        std::vector<UINT> m_indices;
+        std::vector<UINT> m_adjacencyOffsets;       // m_vertices.size() + 1 entries
+        std::vector<UINT> m_adjacency;
+        DirectX::XMFLOAT3 m_boundsMin;
+        DirectX::XMFLOAT3 m_boundsMax;
+        float m_radius;
+    };
+}
@@ -0,0 +1,261 @@
+//--------------------------------------------------------------------------------------
+// File: DDSTexture.h
+//
+// Device-independent DDS parsing. A DDSTexture describes a DDS image held in memory and
+// exposes every subresource (mip level of an array slice, cube face or volume) as a view
+// over the original bytes, so textures can be inspected and processed on the CPU without
+// a Direct3D device. DDSTextureLoader creates its resources on top of it.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#ifdef _WIN32
+#include <dxgiformat.h>
+#else
+
+//
+// the formats a DDS file can name, with the values dxgiformat.h gives them
+//
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN = 0,
+    DXGI_FORMAT_R32G32B32A32_TYPELESS = 1,
+    DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+    DXGI_FORMAT_R32G32B32A32_UINT = 3,
+    DXGI_FORMAT_R32G32B32A32_SINT = 4,
+    DXGI_FORMAT_R32G32B32_TYPELESS = 5,
+    DXGI_FORMAT_R32G32B32_FLOAT = 6,
+    DXGI_FORMAT_R32G32B32_UINT = 7,
+    DXGI_FORMAT_R32G32B32_SINT = 8,
+    DXGI_FORMAT_R16G16B16A16_TYPELESS = 9,
+    DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+    DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+    DXGI_FORMAT_R16G16B16A16_UINT = 12,
+    DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+    DXGI_FORMAT_R16G16B16A16_SINT = 14,
+    DXGI_FORMAT_R32G32_TYPELESS = 15,
+    DXGI_FORMAT_R32G32_FLOAT = 16,
+    DXGI_FORMAT_R32G32_UINT = 17,
+    DXGI_FORMAT_R32G32_SINT = 18,
+    DXGI_FORMAT_R32G8X24_TYPELESS = 19,
+    DXGI_FORMAT_D32_FLOAT_S8X24_UINT = 20,
+    DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS = 21,
+    DXGI_FORMAT_X32_TYPELESS_G8X24_UINT = 22,
+    DXGI_FORMAT_R10G10B10A2_TYPELESS = 23,
+    DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+    DXGI_FORMAT_R10G10B10A2_UINT = 25,
+    DXGI_FORMAT_R11G11B10_FLOAT = 26,
+    DXGI_FORMAT_R8G8B8A8_TYPELESS = 27,
+    DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+    DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+    DXGI_FORMAT_R8G8B8A8_UINT = 30,
+    DXGI_FORMAT_R8G8B8A8_SNORM = 31,
+    DXGI_FORMAT_R8G8B8A8_SINT = 32,
+    DXGI_FORMAT_R16G16_TYPELESS = 33,
+    DXGI_FORMAT_R16G16_FLOAT = 34,
+    DXGI_FORMAT_R16G16_UNORM = 35,
+    DXGI_FORMAT_R16G16_UINT = 36,
+    DXGI_FORMAT_R16G16_SNORM = 37,
+    DXGI_FORMAT_R16G16_SINT = 38,
+    DXGI_FORMAT_R32_TYPELESS = 39,
+    DXGI_FORMAT_D32_FLOAT = 40,
+    DXGI_FORMAT_R32_FLOAT = 41,
+    DXGI_FORMAT_R32_UINT = 42,
+    DXGI_FORMAT_R32_SINT = 43,
+    DXGI_FORMAT_R24G8_TYPELESS = 44,
+    DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+    DXGI_FORMAT_R24_UNORM_X8_TYPELESS = 46,
+    DXGI_FORMAT_X24_TYPELESS_G8_UINT = 47,
+    DXGI_FORMAT_R8G8_TYPELESS = 48,
+    DXGI_FORMAT_R8G8_UNORM = 49,
+    DXGI_FORMAT_R8G8_UINT = 50,
+    DXGI_FORMAT_R8G8_SNORM = 51,
+    DXGI_FORMAT_R8G8_SINT = 52,
+    DXGI_FORMAT_R16_TYPELESS = 53,
+    DXGI_FORMAT_R16_FLOAT = 54,
+    DXGI_FORMAT_D16_UNORM = 55,
+    DXGI_FORMAT_R16_UNORM = 56,
+    DXGI_FORMAT_R16_UINT = 57,
+    DXGI_FORMAT_R16_SNORM = 58,
+    DXGI_FORMAT_R16_SINT = 59,
+    DXGI_FORMAT_R8_TYPELESS = 60,
+    DXGI_FORMAT_R8_UNORM = 61,
+    DXGI_FORMAT_R8_UINT = 62,
+    DXGI_FORMAT_R8_SNORM = 63,
+    DXGI_FORMAT_R8_SINT = 64,
+    DXGI_FORMAT_A8_UNORM = 65,
+    DXGI_FORMAT_R1_UNORM = 66,
+    DXGI_FORMAT_R9G9B9E5_SHAREDEXP = 67,
+    DXGI_FORMAT_R8G8_B8G8_UNORM = 68,
+    DXGI_FORMAT_G8R8_G8B8_UNORM = 69,
+    DXGI_FORMAT_BC1_TYPELESS = 70,
+    DXGI_FORMAT_BC1_UNORM = 71,
+    DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+    DXGI_FORMAT_BC2_TYPELESS = 73,
+    DXGI_FORMAT_BC2_UNORM = 74,
+    DXGI_FORMAT_BC2_UNORM_SRGB = 75,
+    DXGI_FORMAT_BC3_TYPELESS = 76,
+    DXGI_FORMAT_BC3_UNORM = 77,
+    DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+    DXGI_FORMAT_BC4_TYPELESS = 79,
+    DXGI_FORMAT_BC4_UNORM = 80,
+    DXGI_FORMAT_BC4_SNORM = 81,
+    DXGI_FORMAT_BC5_TYPELESS = 82,
+    DXGI_FORMAT_BC5_UNORM = 83,
+    DXGI_FORMAT_BC5_SNORM = 84,
+    DXGI_FORMAT_B5G6R5_UNORM = 85,
+    DXGI_FORMAT_B5G5R5A1_UNORM = 86,
+    DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+    DXGI_FORMAT_B8G8R8X8_UNORM = 88,
+    DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM = 89,
+    DXGI_FORMAT_B8G8R8A8_TYPELESS = 90,
+    DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+    DXGI_FORMAT_B8G8R8X8_TYPELESS = 92,
+    DXGI_FORMAT_B8G8R8X8_UNORM_SRGB = 93,
+    DXGI_FORMAT_BC6H_TYPELESS = 94,
+    DXGI_FORMAT_BC6H_UF16 = 95,
+    DXGI_FORMAT_BC6H_SF16 = 96,
+    DXGI_FORMAT_BC7_TYPELESS = 97,
+    DXGI_FORMAT_BC7_UNORM = 98,
+    DXGI_FORMAT_BC7_UNORM_SRGB = 99,
+    DXGI_FORMAT_B4G4R4A4_UNORM = 115,
+    DXGI_FORMAT_FORCE_UINT = 0xffffffff
+};
+
+#endif
+
+#if !defined(_WIN32) || (_WIN32_WINNT >= 0x0602 /*_WIN32_WINNT_WIN8*/)
+#ifndef DXGI_1_2_FORMATS
+#define DXGI_1_2_FORMATS
+#endif
+#endif
+
+namespace DirectX
+{
+    //
+    // same values as D3D11_RESOURCE_DIMENSION
+    //
+    enum DDSDimension
+    {
+        DDS_DIMENSION_UNKNOWN = 0,
+        DDS_DIMENSION_TEXTURE1D = 2,
+        DDS_DIMENSION_TEXTURE2D = 3,
+        DDS_DIMENSION_TEXTURE3D = 4,
+    };
+
+    enum DDSStatus
+    {
+        DDS_OK,
+        DDS_INVALID_DATA,       // not a DDS file, or its header contradicts itself
+        DDS_NOT_SUPPORTED,      // a format or size Direct3D 11 cannot hold
+        DDS_END_OF_DATA,        // the header names more data than the file carries
+    };
+
+    //
+    // one mip level of one array item: rows of RowPitch bytes, slices of SlicePitch bytes;
+    // slice z of a volume starts at Data + z * SlicePitch
+    //
+    struct DDSSubresource
+    {
+        const uint8_t* Data;
+        size_t Offset;          // of Data from the start of the file
+        size_t RowPitch;
+        size_t SlicePitch;
+        size_t RowCount;        // rows of blocks for block-compressed formats
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t Depth;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // DDSTexture holds no texel data of its own; the bytes it was parsed from must outlive
+    // it. Array items are numbered slice-major, with a cube's six faces as consecutive items
+    // in +X, -X, +Y, -Y, +Z, -Z order.
+    //
+    class DDSTexture
+    {
+    public:
+        DDSTexture();
+
+        DDSStatus Parse(const uint8_t* ddsData, size_t ddsDataSize);
+
+        //
+        // Lays out a file of fileSize bytes from its first bytes alone, for reading it in
+        // pieces. The subresources carry offsets and null Data. MaxHeaderSize bytes always
+        // cover the headers.
+        //
+        DDSStatus ParseHeader(const uint8_t* headerData, size_t headerDataSize, size_t fileSize);
+
+        static const size_t MaxHeaderSize = 148;
+
+        DXGI_FORMAT Format() const { return m_format; }
+        DDSDimension Dimension() const { return m_dimension; }
+        bool IsCubeMap() const { return m_isCubeMap; }
+
+        uint32_t Width() const { return m_width; }
+        uint32_t Height() const { return m_height; }
+        uint32_t Depth() const { return m_depth; }
+        uint32_t MipCount() const { return m_mipCount; }
+        uint32_t ArraySize() const { return m_arraySize; }          // six per cube
+
+        const DDSSubresource& Subresource(uint32_t mip, uint32_t item) const { return m_subresources[item * m_mipCount + mip]; }
+        const DDSSubresource* Subresources() const { return m_subresources.data(); }
+        size_t SubresourceCount() const { return m_subresources.size(); }
+
+        //
+        // the texel data following the headers, and its offset from the start of the file
+        //
+        const uint8_t* Bits() const { return m_bits; }
+        size_t BitsSize() const { return m_bitsSize; }
+        size_t BitsOffset() const { return m_bitsOffset; }
+
+    private:
+        DDSStatus ParseLayout(const uint8_t* ddsData, size_t headerDataSize, size_t ddsDataSize, bool hasBits);
+
+        DXGI_FORMAT m_format;
+        DDSDimension m_dimension;
+        bool m_isCubeMap;
+        uint32_t m_width;
+        uint32_t m_height;
+        uint32_t m_depth;
+        uint32_t m_mipCount;
+        uint32_t m_arraySize;
+        const uint8_t* m_bits;
+        size_t m_bitsSize;
+        size_t m_bitsOffset;
+        std::vector<DDSSubresource> m_subresources;
+    };
+
+    //
+    // format helpers shared with the loaders and texture tools
+    //
+    size_t BitsPerPixel(DXGI_FORMAT format);
+    bool IsCompressed(DXGI_FORMAT format);
+    DXGI_FORMAT MakeSRGB(DXGI_FORMAT format);
+    void GetSurfaceInfo(size_t width, size_t height, DXGI_FORMAT format, size_t* outNumBytes, size_t* outRowBytes, size_t* outNumRows);
+
+    //
+    // Appends the magic number and headers of a DDS file, always with the DX10 extension.
+    // The subresources follow in the order Parse lays them out: each array item's mips
+    // from the largest, every slice of a volume mip together. arraySize counts six per cube.
+    //
+    void WriteDDSHeader(DXGI_FORMAT format, DDSDimension dimension, uint32_t width, uint32_t height, uint32_t depth,
+        uint32_t mipCount, uint32_t arraySize, bool isCubeMap, std::vector<uint8_t>& ddsFile);
+
+    //
+    // average time to parse the file, in nanoseconds
+    //
+    double BenchmarkDDSParse(const uint8_t* ddsData, size_t ddsDataSize, unsigned int iterations = 10000);
+}
@@ -0,0 +1,387 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <malloc.h>
+#include <memory>
+#include <new>
+#include <string.h>
+
+#include "FileReader.h"
+#include "GameClock.h"
+
+namespace
+{
+    struct HandleCloser { void operator()(HANDLE h) { if (h) CloseHandle(h); } };
+
+    typedef std::unique_ptr<void, HandleCloser> ScopedHandle;
+
+    inline HANDLE SafeHandle(HANDLE h) { return (h == INVALID_HANDLE_VALUE) ? 0 : h; }
+
+    //
+    // pooled buffers are page aligned, and sized in steps coarse enough that files of
+    // similar sizes share them
+    //
+    const size_t BufferAlignment = 4096;
+    const size_t BufferGranularity = 64 * 1024;
+
+    //
+    // ReadFile takes a DWORD count
+    //
+    const size_t MaxReadChunk = 64 * 1024 * 1024;
+}
+
+#pragma region FileBuffer
+
+FileBuffer::FileBuffer() :
+    m_reader(nullptr),
+    m_data(nullptr),
+    m_size(0),
+    m_capacity(0),
+    m_fileSize(0)
+{
+}
+
+FileBuffer::FileBuffer(FileBuffer&& other) :
+    m_reader(other.m_reader),
+    m_data(other.m_data),
+    m_size(other.m_size),
+    m_capacity(other.m_capacity),
+    m_fileSize(other.m_fileSize)
+{
+    other.m_reader = nullptr;
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_capacity = 0;
+    other.m_fileSize = 0;
+}
+
+FileBuffer& FileBuffer::operator=(FileBuffer&& other)
+{
+    if (this != &other)
+    {
+        Reset();
+        std::swap(m_reader, other.m_reader);
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_fileSize, other.m_fileSize);
+    }
+
+    return *this;
+}
+
+FileBuffer::~FileBuffer()
+{
+    Reset();
+}
+
+void FileBuffer::Reset()
+{
+    if (m_reader != nullptr)
+    {
+        m_reader->Release(*this);
+    }
+
+    m_reader = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_capacity = 0;
+    m_fileSize = 0;
+}
+
+#pragma endregion
+
+#pragma region FileCursor
+
+size_t FileCursor::Read(void* destination, size_t elementSize, size_t count)
+{
+    if (elementSize == 0)
+    {
+        return 0;
+    }
+
+    count = std::min(count, Remaining() / elementSize);
+    memcpy(destination, m_data + m_position, count * elementSize);
+    m_position += count * elementSize;
+    return count;
+}
+
+#pragma endregion
+
+#pragma region FileReader
+
+FileReader::FileReader() :
+    m_pooledBytes(0)
+{
+    memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+FileReader::~FileReader()
+{
+    Trim();
+}
+
+void FileReader::Initialize(const FileReadSettings& settings)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_settings = settings;
+}
+
+bool FileReader::Read(const std::wstring& fileName, FileBuffer& buffer, FileAccessHint hint)
+{
+    return ReadInto(fileName, 0, 0, true, buffer, hint);
+}
+
+bool FileReader::ReadRange(const std::wstring& fileName, std::uint64_t offset, size_t size, FileBuffer& buffer, FileAccessHint hint)
+{
+    return ReadInto(fileName, offset, size, false, buffer, hint);
+}
+
+bool FileReader::ReadInto(const std::wstring& fileName, std::uint64_t offset, size_t size, bool wholeFile, FileBuffer& buffer, FileAccessHint hint)
+{
+    buffer.Reset();
+    std::int64_t start = GameClock::Now();
+
+    CREATEFILE2_EXTENDED_PARAMETERS parameters;
+    memset(&parameters, 0, sizeof(parameters));
+    parameters.dwSize = sizeof(parameters);
+    parameters.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    parameters.dwFileFlags = (hint == FILE_ACCESS_SEQUENTIAL) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+
+    ScopedHandle file(SafeHandle(CreateFile2(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &parameters)));
+    if (!file)
+    {
+        Record(fileName, 0, GameClock::Now() - start, false, false);
+        return false;
+    }
+
+    FILE_STANDARD_INFO fileInfo;
+    if (!GetFileInformationByHandleEx(file.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+    {
+        Record(fileName, 0, GameClock::Now() - start, false, false);
+        return false;
+    }
+
+    std::uint64_t fileSize = static_cast<std::uint64_t>(fileInfo.EndOfFile.QuadPart);
+    offset = wholeFile ? 0 : std::min(offset, fileSize);
+    std::uint64_t available = fileSize - offset;
+    if (wholeFile && available > SIZE_MAX)
+    {
+        Record(fileName, 0, GameClock::Now() - start, false, false);
+        return false;
+    }
+
+    size = wholeFile ? static_cast<size_t>(available) : static_cast<size_t>(std::min<std::uint64_t>(size, available));
+    buffer.m_fileSize = fileSize;
+    if (size == 0)
+    {
+        Record(fileName, 0, GameClock::Now() - start, false, true);
+        return true;
+    }
+
+    size_t mapThreshold;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        mapThreshold = m_settings.MapThreshold;
+    }
+
+    //
+    // large files are mapped, so their pages come straight from the file cache without a
+    // copy; a failed mapping falls back to reading
+    //
+    if (wholeFile && mapThreshold != 0 && size >= mapThreshold)
+    {
+        ScopedHandle mapping(CreateFileMappingFromApp(file.get(), nullptr, PAGE_READONLY, 0, nullptr));
+        void* view = mapping ? MapViewOfFileFromApp(mapping.get(), FILE_MAP_READ, 0, 0) : nullptr;
+        if (view != nullptr)
+        {
+            buffer.m_reader = this;
+            buffer.m_data = static_cast<std::uint8_t*>(view);
+            buffer.m_size = size;
+            buffer.m_capacity = 0;
+
+            Record(fileName, size, GameClock::Now() - start, true, true);
+            return true;
+        }
+    }
+
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(offset);
+    if (offset != 0 && !SetFilePointerEx(file.get(), position, nullptr, FILE_BEGIN))
+    {
+        buffer.m_fileSize = 0;
+        Record(fileName, 0, GameClock::Now() - start, false, false);
+        return false;
+    }
+
+    Acquire(size, buffer);
+
+    size_t done = 0;
+    while (done < size)
+    {
+        DWORD chunk = static_cast<DWORD>(std::min(size - done, MaxReadChunk));
+        DWORD bytesRead = 0;
+        if (!::ReadFile(file.get(), buffer.m_data + done, chunk, &bytesRead, nullptr) || bytesRead == 0)
+        {
+            break;
+        }
+
+        done += bytesRead;
+    }
+
+    if (done != size)
+    {
+        buffer.Reset();
+        Record(fileName, done, GameClock::Now() - start, false, false);
+        return false;
+    }
+
+    Record(fileName, size, GameClock::Now() - start, false, true);
+    return true;
+}
+
+void FileReader::Acquire(size_t size, FileBuffer& buffer)
+{
+    size_t capacity = (size + BufferGranularity - 1) / BufferGranularity * BufferGranularity;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        //
+        // the smallest pooled buffer that holds size, if it is no more than twice as large
+        //
+        auto best = m_pool.end();
+        for (auto iter = m_pool.begin(); iter != m_pool.end(); ++iter)
+        {
+            if (iter->Capacity >= capacity && iter->Capacity <= 2 * capacity && (best == m_pool.end() || iter->Capacity < best->Capacity))
+            {
+                best = iter;
+            }
+        }
+
+        if (best != m_pool.end())
+        {
+            buffer.m_reader = this;
+            buffer.m_data = best->Data;
+            buffer.m_size = size;
+            buffer.m_capacity = best->Capacity;
+            m_pooledBytes -= best->Capacity;
+            m_pool.erase(best);
+            m_statistics.PoolHits++;
+            return;
+        }
+
+        m_statistics.PoolMisses++;
+    }
+
+    std::uint8_t* data = static_cast<std::uint8_t*>(_aligned_malloc(capacity, BufferAlignment));
+    if (data == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    buffer.m_reader = this;
+    buffer.m_data = data;
+    buffer.m_size = size;
+    buffer.m_capacity = capacity;
+}
+
+void FileReader::Release(FileBuffer& buffer)
+{
+    if (buffer.m_capacity == 0)
+    {
+        if (buffer.m_data != nullptr)
+        {
+            UnmapViewOfFile(buffer.m_data);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_pooledBytes + buffer.m_capacity <= m_settings.MaxPooledBytes)
+        {
+            PooledBuffer pooled;
+            pooled.Data = buffer.m_data;
+            pooled.Capacity = buffer.m_capacity;
+            m_pool.push_back(pooled);
+            m_pooledBytes += pooled.Capacity;
+            return;
+        }
+    }
+
+    _aligned_free(buffer.m_data);
+}
+
+void FileReader::Trim()
+{
+    std::vector<PooledBuffer> pool;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        pool.swap(m_pool);
+        m_pooledBytes = 0;
+    }
+
+    for (const PooledBuffer& pooled : pool)
+    {
+        _aligned_free(pooled.Data);
+    }
+}
+
+void FileReader::Record(const std::wstring& fileName, std::uint64_t bytes, std::int64_t nanoseconds, bool mapped, bool succeeded)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (!succeeded)
+    {
+        m_statistics.Failures++;
+        return;
+    }
+
+    m_statistics.Files++;
+    m_statistics.Bytes += bytes;
+    m_statistics.Nanoseconds += nanoseconds;
+    m_statistics.MappedFiles += mapped ? 1 : 0;
+
+    if (m_settings.TimingHistory == 0)
+    {
+        return;
+    }
+
+    if (m_timings.size() >= m_settings.TimingHistory)
+    {
+        m_timings.pop_front();
+    }
+
+    FileReadTiming timing;
+    timing.FileName = fileName;
+    timing.Bytes = bytes;
+    timing.Nanoseconds = nanoseconds;
+    timing.Mapped = mapped;
+    m_timings.push_back(timing);
+}
+
+FileReadStatistics FileReader::Statistics() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    FileReadStatistics statistics = m_statistics;
+    statistics.PooledBytes = m_pooledBytes;
+    return statistics;
+}
+
+std::vector<FileReadTiming> FileReader::Timings() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return std::vector<FileReadTiming>(m_timings.begin(), m_timings.end());
+}
+
+#pragma endregion
@@ -0,0 +1,173 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class FileReader;
+
+//
+// tells the file cache how a file will be read, so it can read ahead or not
+//
+enum FileAccessHint
+{
+    FILE_ACCESS_SEQUENTIAL,
+    FILE_ACCESS_RANDOM,
+};
+
+struct FileReadSettings
+{
+    FileReadSettings() :
+        MapThreshold(4 << 20),
+        MaxPooledBytes(32 << 20),
+        TimingHistory(256)
+    {
+    }
+
+    size_t MapThreshold;            // whole files at least this large are mapped instead of read; 0 never maps
+    size_t MaxPooledBytes;          // released buffers kept for reuse
+    size_t TimingHistory;           // reads whose timings are kept
+};
+
+struct FileReadTiming
+{
+    std::wstring FileName;
+    std::uint64_t Bytes;
+    std::int64_t Nanoseconds;       // opening to the last byte read, or to the view mapped
+    bool Mapped;
+};
+
+struct FileReadStatistics
+{
+    std::uint64_t Files;
+    std::uint64_t Failures;
+    std::uint64_t Bytes;
+    std::int64_t Nanoseconds;
+    std::uint64_t MappedFiles;
+    std::uint64_t PoolHits;         // reads that reused a released buffer
+    std::uint64_t PoolMisses;       // reads that allocated one
+    size_t PooledBytes;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// FileBuffer holds the bytes of one read, either in a pooled buffer that is never zeroed
+// or in a mapped view of the file. It goes back to its reader when reset or destroyed, so
+// it must not outlive the reader.
+//
+class FileBuffer
+{
+public:
+    FileBuffer();
+    FileBuffer(FileBuffer&& other);
+    FileBuffer& operator=(FileBuffer&& other);
+    ~FileBuffer();
+
+    const std::uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+
+    //
+    // of the whole file the bytes came from
+    //
+    std::uint64_t FileSize() const { return m_fileSize; }
+
+    void Reset();
+
+private:
+    friend class FileReader;
+
+    FileBuffer(const FileBuffer&);
+    FileBuffer& operator=(const FileBuffer&);
+
+    FileReader* m_reader;
+    std::uint8_t* m_data;
+    size_t m_size;
+    size_t m_capacity;              // of the pooled buffer; 0 for a mapped view
+    std::uint64_t m_fileSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// FileCursor reads a buffer front to back the way fread reads a file: whole elements only,
+// returning how many were copied.
+//
+class FileCursor
+{
+public:
+    FileCursor(const std::uint8_t* data, size_t size) : m_data(data), m_size(size), m_position(0) {}
+
+    size_t Read(void* destination, size_t elementSize, size_t count);
+
+    size_t Position() const { return m_position; }
+    size_t Remaining() const { return m_size - m_position; }
+
+private:
+    const std::uint8_t* m_data;
+    size_t m_size;
+    size_t m_position;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// FileReader reads whole files, or byte ranges of them, with one call each into buffers
+// it pools and hands out again, and maps large files instead of copying them. It times
+// every read. Safe to use from several threads at once.
+//
+class FileReader
+{
+public:
+    FileReader();
+    ~FileReader();
+
+    void Initialize(const FileReadSettings& settings = FileReadSettings());
+
+    //
+    // false, with buffer empty, when the file cannot be opened or read. A range is cut short
+    // where the file ends, so check the size read when it matters.
+    //
+    bool Read(const std::wstring& fileName, FileBuffer& buffer, FileAccessHint hint = FILE_ACCESS_SEQUENTIAL);
+    bool ReadRange(const std::wstring& fileName, std::uint64_t offset, size_t size, FileBuffer& buffer,
+        FileAccessHint hint = FILE_ACCESS_RANDOM);
+
+    //
+    // frees the pooled buffers
+    //
+    void Trim();
+
+    FileReadStatistics Statistics() const;
+    std::vector<FileReadTiming> Timings() const;
+
+private:
+    friend class FileBuffer;
+
+    struct PooledBuffer
+    {
+        std::uint8_t* Data;
+        size_t Capacity;
+    };
+
+    FileReader(const FileReader&);
+    FileReader& operator=(const FileReader&);
+
+    bool ReadInto(const std::wstring& fileName, std::uint64_t offset, size_t size, bool wholeFile, FileBuffer& buffer, FileAccessHint hint);
+    void Acquire(size_t size, FileBuffer& buffer);
+    void Release(FileBuffer& buffer);
+    void Record(const std::wstring& fileName, std::uint64_t bytes, std::int64_t nanoseconds, bool mapped, bool succeeded);
+
+    mutable std::mutex m_lock;
+    FileReadSettings m_settings;
+    std::vector<PooledBuffer> m_pool;
+    size_t m_pooledBytes;
+    std::deque<FileReadTiming> m_timings;
+    FileReadStatistics m_statistics;
+};
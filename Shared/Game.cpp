@@ -11,6 +11,7 @@
 #include <DirectXMath.h>
 #include <DirectXColors.h>
 #include <algorithm>
+#include <cmath>
 
 using namespace DirectX;
 using namespace Microsoft::WRL;
@@ -20,23 +21,64 @@ using namespace Windows::Graphics::Display;
 using namespace Windows::UI::Core;
 using namespace VSD3DStarter;
 
-const float ROTATION_POWER = 0.01f;
-const float MOOVE_POWER = 0.5f;
-const float ANIMATION_DURATION = 0.2f;
-const float GRAVITATION_ANIMATION_DURATION = 1.0f;
+const float ROTATION_POWER = 0.6f;		// rad/s added per key press
+const float MOOVE_POWER = 0.5f;			// velocity change per key press
 const float MOON_GA = 1.6f;
+const float GRAVITY_SCALE = 0.006f;		// scene units per metre
+const float CONTACT_SKIN = 0.001f;
+const UINT SHIP_HULL_VERTICES = 64;
+const UINT MAX_CONTACT_SUBSTEPS = 16;
+
+const UINT PARTICLE_CAPACITY = 1 << 17;
+const UINT TERRAIN_HEIGHTFIELD_RESOLUTION = 256;
+const uint64_t TEXTURE_BUDGET_BYTES = 256ull << 20;
+const UINT EXHAUST_PARTICLES = 400;		// per thrust key press
+const float DUST_MIN_SPEED = 0.05f;		// impact speed raising any dust
+const float DUST_PARTICLES_PER_SPEED = 4000.0f;
+const UINT DUST_MAX_PARTICLES = 3000;
+
+const double SIMULATION_STEP = 1.0 / 60.0;
+const UINT MAX_SIMULATION_STEPS_PER_FRAME = 8;
+const size_t MAX_PENDING_BURSTS = 256;	// while the render thread is not picking up snapshots
+const float MAX_PARTICLE_TIME_DELTA = 0.1f;
+
+// entities reported by scene ray queries
+enum PickEntities
+{
+	PICK_STARSHIP,
+	PICK_MOON,
+	PICK_LANDING_POINT,
+};
 
 const float START_CAM_POS_X = 0.0f;
 const float START_CAM_POS_Y = 2.5f;
 const float START_CAM_POS_Z = -4.5f;
 
-Game::Game()
+Game::Game() :
+	m_isGameStarted(false),
+	m_isPause(false),
+	m_isMultiplayer(false),
+	m_isGameFinished(false),
+	m_isAnimationRunning(false),
+	m_shipRadius(0.0f),
+	m_shipInstance(0),
+	m_droppedInputs(0),
+	m_inputLatency(0.0f),
+	m_publishedSequence(0),
+	m_acknowledgedSequence(0),
+	m_appliedSequence(0),
+	m_exhaustEmitter(0),
+	m_dustEmitter(0)
 {
+	m_jobs.Initialize();
 	RestartGame();
 }
 
 Game::~Game()
 {
+	// the simulation thread reads the animations freed below
+	StopSimulation();
+
 	for (Mesh* m : m_backModel)
 	{
 		delete m;
@@ -60,6 +102,12 @@ Game::~Game()
 		delete m;
 	}
 	m_starShipModel.clear();
+
+	for (AnimationSet* a : m_animationSets)
+	{
+		delete a;
+	}
+	m_animationSets.clear();
 }
 
 void Game::CreateWindowSizeDependentResources()
@@ -111,10 +159,181 @@ void Game::CreateWindowSizeDependentResources()
 
 void Game::Initialize()
 {
-	Mesh::LoadFromFile(m_graphics, L"StarShip.cmo", L"", L"", m_starShipModel);
-	Mesh::LoadFromFile(m_graphics, L"TheMoon.cmo", L"", L"", m_moonModel);
-	Mesh::LoadFromFile(m_graphics, L"LandingPoint.cmo", L"", L"", m_landingPointModel);
-	Mesh::LoadFromFile(m_graphics, L"Back.cmo", L"", L"", m_backModel);
+	// also runs after a device loss, while the simulation thread is stepping; everything is
+	// built into locals first and only swapped in under m_simulationLock at the end, so steps
+	// wait for the swap instead of the whole load
+
+	// textures loaded with the meshes build any missing mips on the job system, and textures
+	// that already have mips stream their finer levels in as the camera gets close, within a
+	// budget that evicts whatever has gone undrawn longest
+	m_graphics.SetJobSystem(&m_jobs);
+	m_graphics.SetTextureStreaming(true);
+	m_graphics.SetTextureBudget(TEXTURE_BUDGET_BYTES);
+
+	std::vector<Mesh*> starShipModel;
+	std::vector<Mesh*> moonModel;
+	std::vector<Mesh*> landingPointModel;
+	std::vector<Mesh*> backModel;
+	Mesh::LoadFromFile(m_graphics, L"StarShip.cmo", L"", L"", starShipModel);
+	Mesh::LoadFromFile(m_graphics, L"TheMoon.cmo", L"", L"", moonModel);
+	Mesh::LoadFromFile(m_graphics, L"LandingPoint.cmo", L"", L"", landingPointModel);
+	Mesh::LoadFromFile(m_graphics, L"Back.cmo", L"", L"", backModel);
+
+	// small textures the meshes sample without wrapping share atlases, saving rebinds
+	std::vector<Mesh*> meshes;
+	meshes.insert(meshes.end(), starShipModel.begin(), starShipModel.end());
+	meshes.insert(meshes.end(), moonModel.begin(), moonModel.end());
+	meshes.insert(meshes.end(), landingPointModel.begin(), landingPointModel.end());
+	meshes.insert(meshes.end(), backModel.begin(), backModel.end());
+	Mesh::PackTextures(m_graphics, meshes);
+
+	// only RestartGame moves the landing point, and it runs on this thread
+	XMMATRIX landingPointWorld = XMMatrixTranslation(m_landingX, m_landingY, m_landingZ);
+
+	// collision geometry and the ship hull are independent, so build them side by side; the
+	// particle heightfield is sampled from the moon collider as soon as that is done
+	Physics::TriangleMeshCollider moonCollider;
+	Physics::TriangleMeshCollider landingPointCollider;
+	Physics::ConvexHull shipHull;
+	Physics::TriangleMeshCollider shipPickShape;
+	ParticleHeightfield terrainHeightfield;
+	bool hullValid = false;
+	m_jobs.ParallelFor(0, 4, 1, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; i++)
+		{
+			switch (i)
+			{
+			case 0:
+				moonCollider.Initialize(moonModel, XMMatrixTranslation(0.0f, -250.0f, 0.0f));
+				terrainHeightfield.Initialize(moonCollider, TERRAIN_HEIGHTFIELD_RESOLUTION);
+				break;
+			case 1:
+				landingPointCollider.Initialize(landingPointModel, landingPointWorld);
+				break;
+			case 2:
+				hullValid = shipHull.Initialize(starShipModel, SHIP_HULL_VERTICES);
+				break;
+			case 3:
+				shipPickShape.Initialize(starShipModel, XMMatrixIdentity());
+				break;
+			}
+		}
+	});
+
+	float shipRadius = 0.0f;
+	for (Mesh* m : starShipModel)
+	{
+		shipRadius = std::max(shipRadius, m->Extents().Radius);
+	}
+
+	// the swept sphere must enclose the hull, which is measured around the model origin
+	if (hullValid)
+	{
+		shipRadius = std::max(shipRadius, shipHull.Radius());
+	}
+
+	// build the runtime animation data for every ship mesh that carries clips
+	std::vector<AnimationSet*> animationSets;
+	std::vector<AnimationPlayer> animationPlayers;
+	AnimationCompressionSettings compressionSettings;
+
+	for (Mesh* m : starShipModel)
+	{
+		if (!m->AnimationClips().empty())
+		{
+			AnimationSet* animationSet = new AnimationSet();
+			animationSet->Initialize(*m, &compressionSettings);
+			animationSets.push_back(animationSet);
+
+			// the compressed clips replace the 4x4 keyframes loaded with the mesh
+			for (auto& clip : m->AnimationClips())
+			{
+				Mesh::KeyframeArray().swap(clip.second.Keyframes);
+			}
+
+			AnimationPlayer player;
+			player.Initialize(animationSet);
+			player.Play(m->AnimationClips().begin()->first);
+			animationPlayers.push_back(player);
+		}
+	}
+
+	// particle effects; dust settles on the heightfield sampled from the moon collider
+	m_terrainHeightfield = std::move(terrainHeightfield);
+	m_particles.Initialize(m_graphics, PARTICLE_CAPACITY);
+	m_particles.SetJobSystem(&m_jobs);
+	m_particles.SetGravity(XMFLOAT3(0.0f, -MOON_GA * GRAVITY_SCALE, 0.0f));
+	m_particles.SetHeightfield(&m_terrainHeightfield);
+
+	ParticleEmitterDesc exhaust;
+	exhaust.Spread = 0.25f;
+	exhaust.SpeedMin = 1.0f;
+	exhaust.SpeedMax = 2.0f;
+	exhaust.LifeMin = 0.3f;
+	exhaust.LifeMax = 0.6f;
+	exhaust.SizeStart = 0.03f;
+	exhaust.SizeEnd = 0.12f;
+	exhaust.ColorStart = XMFLOAT4(1.0f, 0.7f, 0.3f, 1.0f);
+	exhaust.ColorEnd = XMFLOAT4(0.6f, 0.2f, 0.1f, 0.0f);
+	exhaust.Drag = 2.0f;
+	exhaust.Additive = true;
+	UINT exhaustEmitter = m_particles.AddEmitter(exhaust);
+
+	ParticleEmitterDesc dust;
+	dust.Spread = 1.3f;
+	dust.SpeedMin = 0.2f;
+	dust.SpeedMax = 0.6f;
+	dust.LifeMin = 1.0f;
+	dust.LifeMax = 2.5f;
+	dust.SizeStart = 0.05f;
+	dust.SizeEnd = 0.25f;
+	dust.ColorStart = XMFLOAT4(0.6f, 0.6f, 0.6f, 0.6f);
+	dust.ColorEnd = XMFLOAT4(0.6f, 0.6f, 0.6f, 0.0f);
+	dust.Drag = 1.5f;
+	dust.Restitution = 0.2f;
+	UINT dustEmitter = m_particles.AddEmitter(dust);
+
+	// swap in what the steps read; the previous meshes and animations end up in the locals
+	// and are freed once the lock is released
+	{
+		std::lock_guard<std::mutex> lock(m_simulationLock);
+
+		std::swap(m_moonCollider, moonCollider);
+		std::swap(m_landingPointCollider, landingPointCollider);
+		std::swap(m_shipHull, shipHull);
+		m_shipRadius = shipRadius;
+		m_animationSets.swap(animationSets);
+		m_animationPlayers.swap(animationPlayers);
+		m_exhaustEmitter = exhaustEmitter;
+		m_dustEmitter = dustEmitter;
+	}
+
+	// the meshes, pick shape and scene belong to this thread alone
+	m_starShipModel.swap(starShipModel);
+	m_moonModel.swap(moonModel);
+	m_landingPointModel.swap(landingPointModel);
+	m_backModel.swap(backModel);
+	std::swap(m_shipPickShape, shipPickShape);
+
+	m_scene.Clear();
+	m_shipInstance = m_scene.AddInstance(&m_shipPickShape, PICK_STARSHIP, XMMatrixIdentity());
+	m_scene.AddInstance(&m_moonCollider, PICK_MOON, XMMatrixIdentity());
+	m_scene.AddInstance(&m_landingPointCollider, PICK_LANDING_POINT, XMMatrixIdentity());
+	m_scene.Update();
+
+	for (std::vector<Mesh*>* model : { &starShipModel, &moonModel, &landingPointModel, &backModel })
+	{
+		for (Mesh* m : *model)
+		{
+			delete m;
+		}
+	}
+
+	for (AnimationSet* a : animationSets)
+	{
+		delete a;
+	}
 }
 
 void Game::Clear()
@@ -141,6 +360,22 @@ void Game::Clear()
 
 String^ Game::OnHitObject(int x, int y)
 {
+	Physics::SceneHit hit;
+	if (x < 0 || y < 0 || !m_scene.Pick(m_graphics.GetCamera(), x, y, hit))
+	{
+		return "";
+	}
+
+	switch (hit.Entity)
+	{
+	case PICK_STARSHIP:
+		return "StarShip";
+	case PICK_MOON:
+		return "Moon";
+	case PICK_LANDING_POINT:
+		return "LandingPoint";
+	}
+
 	return "";
 }
 
@@ -149,18 +384,129 @@ void Game::Update(float timeTotal, float timeDelta)
 	if (!Pause())
 	{
 		m_animationTime += timeDelta;
-		m_animationGravTime += timeDelta;
 		m_totalTime = timeTotal;
 
-		UseRotation();
-		UseGravitation();
-		UseTranslation();
+		IntegrateShip(timeDelta);
+		UpdateAnimations(timeDelta);
 
 		//UpdateCameraPosition();
 
-		UpdateObjectTarget();
 		FinishGame();
 	}
+	else
+	{
+		// nothing moves while paused, so there is nothing to interpolate towards
+		m_previousShipState = m_shipState;
+	}
+}
+
+void Game::StartSimulation()
+{
+	// give the render thread a consistent snapshot before the first step completes
+	{
+		std::lock_guard<std::mutex> lock(m_simulationLock);
+		PublishSnapshot(static_cast<float>(SIMULATION_STEP));
+	}
+
+	m_simulation.Start(
+		[this](double timeTotal, float timeDelta, INT64 stepTime) { SimulationStep(static_cast<float>(timeTotal), timeDelta, stepTime); },
+		SIMULATION_STEP,
+		MAX_SIMULATION_STEPS_PER_FRAME);
+}
+
+void Game::StopSimulation()
+{
+	m_simulation.Stop();
+}
+
+void Game::SimulationStep(float timeTotal, float timeDelta, INT64 stepTime)
+{
+	std::lock_guard<std::mutex> lock(m_simulationLock);
+
+	ApplyInput(stepTime);
+	Update(timeTotal, timeDelta);
+	PublishSnapshot(timeDelta);
+}
+
+void Game::ApplyInput(INT64 stepTime)
+{
+	// input newer than this step waits for the catch-up step that covers it
+	for (const InputEvent* e = m_input.Peek(); e != nullptr && e->Timestamp <= stepTime; e = m_input.Peek())
+	{
+		switch (e->Type)
+		{
+		case INPUT_ROTATE:
+			ApplyRotation(e->Action);
+			break;
+		case INPUT_MOOVE:
+			ApplyMoove(e->Action);
+			break;
+		}
+
+		m_inputLatency = static_cast<float>((GameClock::Now() - e->Timestamp) * 1e-9);
+		m_input.Pop();
+	}
+}
+
+void Game::PublishSnapshot(float timeDelta)
+{
+	// bursts in a snapshot the render thread has read are already spawned
+	UINT64 acknowledged = m_acknowledgedSequence.load(std::memory_order_acquire);
+	m_pendingBursts.erase(
+		std::remove_if(m_pendingBursts.begin(), m_pendingBursts.end(), [acknowledged](const ParticleBurst& b) { return b.Sequence <= acknowledged; }),
+		m_pendingBursts.end());
+
+	GameSnapshot& snapshot = m_snapshots.Back();
+	snapshot.Sequence = ++m_publishedSequence;
+	snapshot.PublishedAt = GameClock::Now();
+	snapshot.StepSeconds = timeDelta;
+	snapshot.Paused = Pause();
+	snapshot.InputLatency = m_inputLatency;
+	snapshot.PreviousShip = m_previousShipState;
+	snapshot.Ship = m_shipState;
+	snapshot.LandingPoint = XMFLOAT3(m_landingX, m_landingY, m_landingZ);
+	snapshot.Bursts.assign(m_pendingBursts.begin(), m_pendingBursts.end());
+
+	m_snapshots.Publish();
+}
+
+void XM_CALLCONV Game::QueueParticles(UINT emitter, UINT count, FXMVECTOR position, FXMVECTOR direction)
+{
+	if (m_pendingBursts.size() >= MAX_PENDING_BURSTS)
+	{
+		m_pendingBursts.erase(m_pendingBursts.begin());
+	}
+
+	ParticleBurst burst;
+	burst.Sequence = m_publishedSequence + 1;
+	burst.Emitter = emitter;
+	burst.Count = count;
+	XMStoreFloat3(&burst.Position, position);
+	XMStoreFloat3(&burst.Direction, direction);
+	m_pendingBursts.push_back(burst);
+}
+
+void Game::ApplySnapshotParticles(const GameSnapshot& snapshot)
+{
+	if (snapshot.Sequence <= m_appliedSequence)
+	{
+		return;
+	}
+
+	// a skipped snapshot's bursts are carried by the next one, so spawn each only once
+	for (const ParticleBurst& burst : snapshot.Bursts)
+	{
+		if (burst.Sequence > m_appliedSequence)
+		{
+			ParticleEmitterDesc& emitter = m_particles.Emitter(burst.Emitter);
+			emitter.Position = burst.Position;
+			emitter.Direction = burst.Direction;
+			m_particles.Emit(burst.Emitter, burst.Count);
+		}
+	}
+
+	m_appliedSequence = snapshot.Sequence;
+	m_acknowledgedSequence.store(m_appliedSequence, std::memory_order_release);
 }
 
 void Game::Render()
@@ -168,16 +514,37 @@ void Game::Render()
 	GameBase::Render();
 	Clear();
 
-	// render ship
-	XMMATRIX transform = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&m_currentRotation));
-	transform *= XMMatrixTranslationFromVector(m_currentTranslation_v_x);	
-	transform *= XMMatrixTranslationFromVector(m_currentTranslation_v_y);
-	transform *= XMMatrixTranslation(0.0f, -m_targetGT * 0.1f, 0.0f);
+	// swap in texture levels read since the last frame and queue the ones last frame asked for
+	m_graphics.UpdateTextureStreaming();
+
+	// pick up the latest simulation step
+	m_snapshots.Acquire();
+	const GameSnapshot& snapshot = m_snapshots.Front();
+	ApplySnapshotParticles(snapshot);
+
+	m_renderClock.Tick();
+	if (!snapshot.Paused)
+	{
+		m_particles.Update(std::min(static_cast<float>(m_renderClock.DeltaSeconds()), MAX_PARTICLE_TIME_DELTA));
+	}
+
+	// render ship between the last two steps, as far as real time has moved past the latest
+	float alpha = static_cast<float>((GameClock::Now() - snapshot.PublishedAt) * 1e-9 / snapshot.StepSeconds);
+	alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+
+	XMVECTOR orientation = XMQuaternionSlerp(XMLoadFloat4(&snapshot.PreviousShip.Orientation), XMLoadFloat4(&snapshot.Ship.Orientation), alpha);
+	XMVECTOR position = XMVectorLerp(XMLoadFloat3(&snapshot.PreviousShip.Position), XMLoadFloat3(&snapshot.Ship.Position), alpha);
+	XMMATRIX transform = XMMatrixRotationQuaternion(orientation);
+	transform *= XMMatrixTranslationFromVector(position);
 	for (UINT i = 0; i < m_starShipModel.size(); i++)
 	{
 		m_starShipModel[i]->Render(m_graphics, transform);
 	}
 
+	// picking sees the ship where it was drawn
+	m_scene.SetTransform(m_shipInstance, transform);
+	m_scene.Update();
+
 	// render Moon
 	transform = XMMatrixTranslation(0.0f, -250.0f, 0.0f);
 	for (UINT i = 0; i < m_moonModel.size(); i++)
@@ -186,19 +553,22 @@ void Game::Render()
 	}
 
 	// render Landing point
-	transform = XMMatrixTranslation(m_landingX, m_landingY, m_landingZ);
+	transform = XMMatrixTranslation(snapshot.LandingPoint.x, snapshot.LandingPoint.y, snapshot.LandingPoint.z);
 	for (UINT i = 0; i < m_landingPointModel.size(); i++)
 	{
 		m_landingPointModel[i]->Render(m_graphics, transform);
 	}
 
 	// render Back model
-	transform = XMMatrixTranslation(0.0f, -250.0f, XMVectorGetZ(m_currentTranslation_v_x));
+	transform = XMMatrixTranslation(0.0f, -250.0f, XMVectorGetZ(position));
 	for (UINT i = 0; i < m_backModel.size(); i++)
 	{
 		m_backModel[i]->Render(m_graphics, transform);
 	}
 
+	// particles last, blended over the opaque scene
+	m_particles.Render(m_graphics);
+
 	// only enable MSAA if the device has enough power
 	if (m_d3dFeatureLevel >= D3D_FEATURE_LEVEL_10_0)
 	{
@@ -209,142 +579,227 @@ void Game::Render()
 }
 
 void Game::RotateObject(int rotationType)
+{
+	InputEvent e = { GameClock::Now(), INPUT_ROTATE, rotationType };
+	if (!m_input.Push(e))
+	{
+		m_droppedInputs++;
+	}
+}
+
+void Game::MooveObject(int mooveType)
+{
+	InputEvent e = { GameClock::Now(), INPUT_MOOVE, mooveType };
+	if (!m_input.Push(e))
+	{
+		m_droppedInputs++;
+	}
+}
+
+void Game::ApplyRotation(int rotationType)
 {
 	if (!Pause())
 	{
 		switch (rotationType)
 		{
 		case ROTATE_UP:
-			m_rotationSpeedX -= ROTATION_POWER;
+			m_shipState.AngularVelocity.x -= ROTATION_POWER;
 			break;
 		case ROTATE_DOWN:
-			m_rotationSpeedX += ROTATION_POWER;
+			m_shipState.AngularVelocity.x += ROTATION_POWER;
 			break;
 		case ROTATE_RIGHT:
-			m_rotationSpeedY -= ROTATION_POWER;
+			m_shipState.AngularVelocity.y -= ROTATION_POWER;
 			break;
 		case ROTATE_LEFT:
-			m_rotationSpeedY += ROTATION_POWER;
+			m_shipState.AngularVelocity.y += ROTATION_POWER;
 			break;
 		}
 	}
 }
 
-void Game::MooveObject(int mooveType)
+void Game::ApplyMoove(int mooveType)
 {
 	if (!Pause())
 	{
-		float sinX = XMScalarSin(m_currentRotation.x),
-			cosX = XMScalarCos(m_currentRotation.x);
-
-		float sinY = XMScalarSin(m_currentRotation.y),
-			cosY = XMScalarCos(m_currentRotation.y);
-
-		float sinZ = XMScalarSin(m_currentRotation.z),
-			cosZ = XMScalarCos(m_currentRotation.z);
+		// impulse along the ship's nose; the attitude quaternion rotates it into world space
+		XMVECTOR forward = XMVectorSet(0.0f, 0.0f, (mooveType == MOOVE_BACKWARD) ? -MOOVE_POWER : MOOVE_POWER, 0.0f);
+		XMVECTOR impulse = XMVector3Rotate(forward, XMLoadFloat4(&m_shipState.Orientation));
 
-		XMVECTOR v1 = XMVectorSet(XMVectorGetX(m_initialTranslation_v_x),
-			XMVectorGetY(m_initialTranslation_v_x) * cosX - XMVectorGetZ(m_initialTranslation_v_x) * sinX,
-			XMVectorGetY(m_initialTranslation_v_x) * sinX + XMVectorGetZ(m_initialTranslation_v_x) * cosX,
-			0.0f);
+		XMStoreFloat3(&m_shipState.Velocity, XMVectorAdd(XMLoadFloat3(&m_shipState.Velocity), impulse));
 
-		XMVECTOR v2 = XMVectorSet(XMVectorGetX(m_initialTranslation_v_y) * cosY + XMVectorGetZ(m_initialTranslation_v_y) * sinY,
-			XMVectorGetY(m_initialTranslation_v_y),
-			XMVectorGetZ(m_initialTranslation_v_y) * cosY + XMVectorGetX(m_initialTranslation_v_y) * sinY,
-			0.0f);
-
-		XMVECTOR v3 = XMVectorSet(XMVectorGetX(m_initialTranslation_v_z) * cosZ - XMVectorGetY(m_initialTranslation_v_z) * sinZ,
-			XMVectorGetX(m_initialTranslation_v_z) * sinZ + XMVectorGetY(m_initialTranslation_v_z) * cosZ,
-			XMVectorGetZ(m_initialTranslation_v_z),
-			0.0f);
-
-		m_basicTranslation_x = XMVectorAdd(m_basicTranslation_x, v1);
-		m_basicTranslation_y = XMVectorAdd(m_basicTranslation_y, v2);
+		// exhaust leaves the opposite side of the ship
+		XMVECTOR direction = XMVector3Normalize(-impulse);
+		QueueParticles(m_exhaustEmitter, EXHAUST_PARTICLES, XMLoadFloat3(&m_shipState.Position) + direction * m_shipRadius, direction);
 	}
 }
 
-void Game::UpdateObjectTarget()
+void Game::IntegrateShip(float timeDelta)
 {
-	CountRotation();
-	CountTranslation();
-	CountGravitation();
+	m_previousShipState = m_shipState;
+	XMFLOAT3 startPosition = m_shipState.Position;
 
-	m_animationTime = 0.0f;
-	m_animationGravTime = 0.0f;
-	m_isAnimationRunning = true;
+	m_shipIntegrator.Step(m_shipState, m_shipForces, timeDelta);
+	ResolveShipContacts(startPosition);
 }
 
-void Game::CountTranslation()
+void Game::ResolveShipContacts(const XMFLOAT3& startPosition)
 {
-	m_targetTranslation_v_x += XMVector3Normalize(m_basicTranslation_x) * 0.01f;
-	m_targetTranslation_v_y += XMVector3Normalize(m_basicTranslation_y) * 0.01f;
-}
+	if (m_shipRadius <= 0.0f)
+	{
+		return;
+	}
 
-void Game::CountRotation()
-{
-	m_targetRotation = XMFLOAT3(
-		m_targetRotation.x + m_rotationSpeedX,
-		m_targetRotation.y + m_rotationSpeedY,
-		m_targetRotation.z + m_rotationSpeedZ
-		);
-	m_initialRotation = m_currentRotation;
+	// sweep the whole step so a fast descent cannot pass through thin terrain between updates
+	XMVECTOR start = XMLoadFloat3(&startPosition);
+	XMVECTOR end = XMLoadFloat3(&m_shipState.Position);
+
+	Physics::SweepHit hit;
+	Physics::SweepHit padHit;
+	bool contact = m_moonCollider.SweepSphere(start, end, m_shipRadius, hit);
+	bool padContact = false;
+	if (m_landingPointCollider.SweepSphere(start, end, m_shipRadius, padHit) && (!contact || padHit.Time < hit.Time))
+	{
+		hit = padHit;
+		contact = true;
+		padContact = true;
+	}
+
+	if (!contact)
+	{
+		return;
+	}
+
+	if (m_shipHull.IsValid() && ResolveHullContacts(start, end, hit))
+	{
+		return;
+	}
+
+	// stop at the time of impact and keep only the velocity along the surface
+	XMVECTOR normal = XMLoadFloat3(&hit.Normal);
+	XMVECTOR position = XMVectorLerp(start, end, hit.Time) + normal * CONTACT_SKIN;
+	XMStoreFloat3(&m_shipState.Position, position);
+
+	EmitDust(position - normal * m_shipRadius, normal);
+	RemoveInwardVelocity(normal);
+	m_shipOnLandingPoint = padContact;
 }
 
-void Game::CountGravitation()
+bool XM_CALLCONV Game::ResolveHullContacts(FXMVECTOR start, FXMVECTOR end, const Physics::SweepHit& hit)
 {
-	m_targetGT += MOON_GA *(m_totalTime / 1000.0f);
-	m_initialGT = m_currentGT;
+	// the sphere only bounds the ship; walk the rest of the step testing the hull itself
+	float remaining = XMVectorGetX(XMVector3Length(end - start)) * (1.0f - hit.Time);
+	UINT substeps = static_cast<UINT>(std::ceil(remaining / (0.5f * m_shipRadius)));
+	substeps = std::min(std::max(substeps, 1u), MAX_CONTACT_SUBSTEPS);
+
+	Physics::HullInstance hull = { &m_shipHull, m_shipState.Orientation, m_shipState.Position, 0 };
+	for (UINT i = 0; i <= substeps; i++)
+	{
+		float t = hit.Time + (1.0f - hit.Time) * i / substeps;
+		XMVECTOR position = XMVectorLerp(start, end, t);
+		XMStoreFloat3(&hull.Position, position);
+
+		m_contacts.clear();
+		UINT moonContacts = Physics::CollideHullMesh(hull, m_moonCollider, m_contactCandidates, m_contacts);
+		Physics::CollideHullMesh(hull, m_landingPointCollider, m_contactCandidates, m_contacts);
+		if (m_contacts.empty())
+		{
+			continue;
+		}
+
+		// push out along the deepest contact, then drop the velocity into every touched surface
+		size_t deepest = 0;
+		for (size_t c = 1; c < m_contacts.size(); c++)
+		{
+			if (m_contacts[c].Depth > m_contacts[deepest].Depth)
+			{
+				deepest = c;
+			}
+		}
+
+		const Physics::ContactPoint& contact = m_contacts[deepest];
+		position += XMLoadFloat3(&contact.Normal) * (contact.Depth + CONTACT_SKIN);
+		XMStoreFloat3(&m_shipState.Position, position);
+
+		EmitDust(XMLoadFloat3(&contact.PointOnTriangle), XMLoadFloat3(&contact.Normal));
+		for (const Physics::ContactPoint& c : m_contacts)
+		{
+			RemoveInwardVelocity(XMLoadFloat3(&c.Normal));
+		}
+
+		m_shipOnLandingPoint = m_contacts.size() > moonContacts;
+		return true;
+	}
+
+	// the walk can step over terrain thinner than a substep; the hull missing everything only
+	// means a graze while the ship's centre stays in front of the surface the sphere hit
+	XMVECTOR behind = XMVector3Dot(end - XMLoadFloat3(&hit.Point), XMLoadFloat3(&hit.Normal));
+	return XMVectorGetX(behind) >= 0.0f;
 }
 
-void Game::UseRotation()
+void XM_CALLCONV Game::EmitDust(FXMVECTOR point, FXMVECTOR normal)
 {
-	float rotateAnimationProgress = std::min<float>(m_animationTime / ANIMATION_DURATION, 0.4f);
+	// dust in proportion to how hard the ship hits the surface
+	float impactSpeed = -XMVectorGetX(XMVector3Dot(XMLoadFloat3(&m_shipState.Velocity), normal));
+	if (impactSpeed < DUST_MIN_SPEED)
+	{
+		return;
+	}
 
-	XMVECTOR initial = XMLoadFloat3(&m_initialRotation);
-	XMVECTOR target = XMLoadFloat3(&m_targetRotation);
-	XMVECTOR current = initial + rotateAnimationProgress * (target - initial);
-	XMStoreFloat3(&m_currentRotation, current);
+	QueueParticles(m_dustEmitter, std::min(static_cast<UINT>(impactSpeed * DUST_PARTICLES_PER_SPEED), DUST_MAX_PARTICLES), point, normal);
 }
 
-void Game::UseTranslation()
+void XM_CALLCONV Game::RemoveInwardVelocity(FXMVECTOR normal)
 {
-	m_currentTranslation_v_x = m_targetTranslation_v_x;
-	m_currentTranslation_v_y = m_targetTranslation_v_y;
+	XMVECTOR velocity = XMLoadFloat3(&m_shipState.Velocity);
+	float normalSpeed = XMVectorGetX(XMVector3Dot(velocity, normal));
+	if (normalSpeed < 0.0f)
+	{
+		XMStoreFloat3(&m_shipState.Velocity, velocity - normal * normalSpeed);
+	}
 }
 
-void Game::UseGravitation()
+void Game::UpdateAnimations(float timeDelta)
 {
-	float fallAnimationProgress = std::min<float>(m_animationGravTime / GRAVITATION_ANIMATION_DURATION, 1.0f);
-
-	float initial = m_initialGT;
-	float target = m_targetGT;
-	float current = initial + fallAnimationProgress * (target - initial);
-	m_currentGT = current;
+	m_jobs.ParallelFor(0, static_cast<UINT>(m_animationPlayers.size()), 1, [this, timeDelta](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; i++)
+		{
+			m_animationPlayers[i].Update(timeDelta);
+		}
+	});
 }
 
 void Game::UpdateCameraPosition()
 {
-	float x1 = XMVectorGetX(m_currentTranslation_v_x),
-		y1 = XMVectorGetY(m_currentTranslation_v_x),
-		z1 = XMVectorGetZ(m_currentTranslation_v_x);
-
-	float x2 = XMVectorGetX(m_currentTranslation_v_y),
-		y2 = XMVectorGetY(m_currentTranslation_v_y),
-		z2 = XMVectorGetZ(m_currentTranslation_v_y);
+	const XMFLOAT3& p = m_shipState.Position;
 
 	m_graphics.GetCamera().SetPosition(XMFLOAT3(
-		START_CAM_POS_X + x1 + x2,
-		START_CAM_POS_Y + y1 + y2,
-		START_CAM_POS_Z + z1 + z2));
-	m_graphics.GetCamera().SetLookAt(XMFLOAT3(x1 + x2, y1 + y2, z1 + z2));
+		START_CAM_POS_X + p.x,
+		START_CAM_POS_Y + p.y,
+		START_CAM_POS_Z + p.z));
+	m_graphics.GetCamera().SetLookAt(p);
 
 }
 
 void Game::FinishGame()
 {
+	if (m_shipOnLandingPoint)
+	{
+		Pause(true);
+		GameFinished(true);
+		return;
+	}
+
+	// without a hull or pad geometry fall back to the area around the landing point
+	if (m_shipHull.IsValid() && m_landingPointCollider.TriangleCount() > 0)
+	{
+		return;
+	}
+
 	if (		 
-		(XMVectorGetZ(m_currentTranslation_v_x) <= m_landingZ + 5 && XMVectorGetZ(m_currentTranslation_v_x) >= m_landingZ - 5)
-		&& (XMVectorGetX(m_currentTranslation_v_y) <= m_landingX + 5 && XMVectorGetX(m_currentTranslation_v_y) >= m_landingX - 5)
+		(m_shipState.Position.z <= m_landingZ + 5 && m_shipState.Position.z >= m_landingZ - 5)
+		&& (m_shipState.Position.x <= m_landingX + 5 && m_shipState.Position.x >= m_landingX - 5)
 		)
 	{
 		Pause(true);
@@ -355,41 +810,25 @@ void Game::FinishGame()
 
 void Game::RestartGame()
 {
+	std::lock_guard<std::mutex> lock(m_simulationLock);
+
 	GameFinished(true);
-	m_rotationSpeedX = 0.0f;
-	m_rotationSpeedY = 0.0f;
-	m_rotationSpeedZ = 0.0f;
 	m_translationSpeed = 0.0f;
 
 	m_landingX = 5.0f;
 	m_landingY = -10.0f;
 	m_landingZ = 20.0f;
 
-	m_basicVector = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-	m_initialTranslation_v_x = m_basicVector;
-	m_initialTranslation_v_y = m_basicVector;
-	m_targetTranslation_v_x = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-	m_targetTranslation_v_y = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-	m_currentTranslation_v_x = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-	m_currentTranslation_v_y = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-
-	m_initialRotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
-	m_currentRotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
-	m_targetRotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_shipState = Physics::RigidBodyState();
+	m_shipForces = Physics::ForceModel();
+	m_shipForces.UniformGravity = XMFLOAT3(0.0f, -MOON_GA * GRAVITY_SCALE, 0.0f);
+	m_shipIntegrator.Initialize(Physics::INTEGRATOR_VELOCITY_VERLET);
+	m_previousShipState = m_shipState;
+	m_shipOnLandingPoint = false;
+	m_pendingBursts.clear();
+	m_particles.Clear();
 
 	m_animationTime = 0.0f;
 	m_generalAnimationProgress = 0.0f;
 	m_totalTime = 0.0f;
-
-	m_basicTranslation_y = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-	m_basicTranslation_z = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-	m_basicTranslation_x = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-	m_basicVector = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-
-	m_initialGT = 0.0f;
-	m_currentGT = 0.0f;
-	m_targetGT = 0.0f;
-	m_gravitationTranslation = 0.0f;
-
-	m_gravitationTime = 0.0f;
 }
@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <wrl.h>
@@ -15,10 +17,51 @@
 
 #include "VSD3DStarter.h"
 #include "GameBase.h"
+#include "Animation.h"
+#include "Integrators.h"
+#include "ContinuousCollision.h"
+#include "NarrowPhase.h"
+#include "ParticleSystem.h"
+#include "SceneQuery.h"
+#include "GameClock.h"
+#include "JobSystem.h"
+#include "InputQueue.h"
+#include "SimulationThread.h"
+#include "TripleBuffer.h"
 
 #include "StarShipMoovementTypes.h"
 #include "PhysicVariables.h"
 
+//
+// particles requested by the simulation, spawned by the render thread once it sees them
+//
+struct ParticleBurst
+{
+	UINT64 Sequence;				// snapshot that first carries the burst
+	UINT Emitter;
+	UINT Count;
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT3 Direction;
+};
+
+//
+// everything the render thread needs from one simulation step
+//
+struct GameSnapshot
+{
+	GameSnapshot() : Sequence(0), PublishedAt(0), StepSeconds(1.0f / 60.0f), Paused(true), InputLatency(0.0f), LandingPoint(0.0f, 0.0f, 0.0f) { }
+
+	UINT64 Sequence;
+	INT64 PublishedAt;				// GameClock::Now() when the step finished
+	float StepSeconds;
+	bool Paused;
+	float InputLatency;				// seconds from the last applied key press to its step
+	Physics::RigidBodyState PreviousShip;
+	Physics::RigidBodyState Ship;
+	DirectX::XMFLOAT3 LandingPoint;
+	std::vector<ParticleBurst> Bursts;
+};
+
 ref class Game sealed : public GameBase
 {
 public:
@@ -34,20 +77,35 @@ public:
 	virtual void Render() override;
 	virtual void Clear();
 
+	// runs Update at a fixed rate on its own thread until stopped or the game is destroyed
+	void StartSimulation();
+	void StopSimulation();
+	void ResetSimulationClock() { m_simulation.ResetClock(); }
+
 	Platform::String^ OnHitObject(int x, int y);
 
+	// queue player input for the simulation thread; safe to call from the UI thread
 	void RotateObject(int rotationType);
 	void MooveObject(int mooveType);
-	void UpdateObjectTarget();
-
-	void UseRotation();
-	void UseGravitation();
-	void UseTranslation();
-
-	void CountTranslation();
-	void CountRotation();
-	void CountGravitation();
-
+	float LastInputLatency() { return m_snapshots.Front().InputLatency; }
+	// key presses lost because the input queue was full; read on the UI thread
+	UINT DroppedInputs() { return m_droppedInputs; }
+
+	void SimulationStep(float timeTotal, float timeDelta, INT64 stepTime);
+	void ApplyInput(INT64 stepTime);
+	void ApplyRotation(int rotationType);
+	void ApplyMoove(int mooveType);
+	void PublishSnapshot(float timeDelta);
+	void XM_CALLCONV QueueParticles(UINT emitter, UINT count, DirectX::FXMVECTOR position, DirectX::FXMVECTOR direction);
+	void ApplySnapshotParticles(const GameSnapshot& snapshot);
+
+	void IntegrateShip(float timeDelta);
+	void ResolveShipContacts(const DirectX::XMFLOAT3& startPosition);
+	// false when the hull walk may have stepped over what the sphere hit
+	bool XM_CALLCONV ResolveHullContacts(DirectX::FXMVECTOR start, DirectX::FXMVECTOR end, const Physics::SweepHit& hit);
+	void XM_CALLCONV RemoveInwardVelocity(DirectX::FXMVECTOR normal);
+	void XM_CALLCONV EmitDust(DirectX::FXMVECTOR point, DirectX::FXMVECTOR normal);
+	void UpdateAnimations(float timeDelta);
 	void UpdateCameraPosition();
 	void FinishGame();
 	void RestartGame();
@@ -64,57 +122,81 @@ public:
 	void AnimationRunning(bool val) { m_isAnimationRunning = val; }
 private:
 
+	// shared by loading, animation and particles; the UI thread owns its first deque
+	JobSystem m_jobs;
+
 	std::vector<VSD3DStarter::Mesh*> m_moonModel;
 	std::vector<VSD3DStarter::Mesh*> m_landingPointModel;
 	std::vector<VSD3DStarter::Mesh*> m_starShipModel;
 	std::vector<VSD3DStarter::Mesh*> m_backModel;
 
-	bool m_isGameStarted;
-	bool m_isPause;
-	bool m_isMultiplayer;
-	bool m_isGameFinished;	
-	bool m_isAnimationRunning;
+	std::vector<VSD3DStarter::AnimationSet*> m_animationSets;
+	std::vector<VSD3DStarter::AnimationPlayer> m_animationPlayers;
+
+	// set from both the UI and the simulation thread
+	std::atomic<bool> m_isGameStarted;
+	std::atomic<bool> m_isPause;
+	std::atomic<bool> m_isMultiplayer;
+	std::atomic<bool> m_isGameFinished;
+	std::atomic<bool> m_isAnimationRunning;
 	float m_animationTime;
 	float m_generalAnimationProgress;
 	float m_totalTime;
 
-	float m_animationGravTime;
-
-	DirectX::XMFLOAT3 m_initialRotation;
-	DirectX::XMFLOAT3 m_currentRotation;
-	DirectX::XMFLOAT3 m_targetRotation;
-
-	DirectX::XMVECTOR m_basicTranslation_y;
-	DirectX::XMVECTOR m_basicTranslation_z;
-	DirectX::XMVECTOR m_basicTranslation_x;
-	DirectX::XMVECTOR m_basicVector;
-
-	DirectX::XMVECTOR m_initialTranslation_v_x;
-	DirectX::XMVECTOR m_currentTranslation_v_x;
-	DirectX::XMVECTOR m_targetTranslation_v_x;	
-
-	DirectX::XMVECTOR m_initialTranslation_v_y;
-	DirectX::XMVECTOR m_currentTranslation_v_y;
-	DirectX::XMVECTOR m_targetTranslation_v_y;
-
-	DirectX::XMVECTOR m_initialTranslation_v_z;
-	DirectX::XMVECTOR m_currentTranslation_v_z;
-	DirectX::XMVECTOR m_targetTranslation_v_z;
-
-	float m_initialGT;
-	float m_currentGT;
-	float m_targetGT;
-	float m_gravitationTranslation;
-
-	float m_gravitationTime;
-
-	float m_rotationSpeedX;
-	float m_rotationSpeedY;
-	float m_rotationSpeedZ;
+	// ship position, velocity, attitude quaternion and ship-space angular velocity (rad/s)
+	Physics::RigidBodyState m_shipState;
+	Physics::RigidBodyState m_previousShipState;
+	Physics::ForceModel m_shipForces;
+	Physics::Integrator m_shipIntegrator;
+	float m_shipRadius;
+
+	// static collision geometry in world space, swept against the ship every update
+	Physics::TriangleMeshCollider m_moonCollider;
+	Physics::TriangleMeshCollider m_landingPointCollider;
+
+	// ship hull for resolving the sphere sweep into exact contacts, and reused query scratch
+	Physics::ConvexHull m_shipHull;
+	std::vector<UINT> m_contactCandidates;
+	std::vector<Physics::ContactPoint> m_contacts;
+	bool m_shipOnLandingPoint;
+
+	// ray queries for picking; the ship collider is in model space and moved with the
+	// rendered ship, the static colliders are already in world space
+	Physics::TriangleMeshCollider m_shipPickShape;
+	Physics::SceneQuery m_scene;
+	UINT m_shipInstance;
+
+	// the simulation steps on its own thread, holding m_simulationLock for each step; the UI
+	// thread sends input through m_input, takes the lock only to restart or reload, and
+	// reads only published snapshots
+	InputQueue m_input;
+	UINT m_droppedInputs;			// UI thread only
+	float m_inputLatency;
+	std::mutex m_simulationLock;
+	TripleBuffer<GameSnapshot> m_snapshots;
+	UINT64 m_publishedSequence;
+
+	// bursts stay queued until the render thread acknowledges a snapshot carrying them
+	std::vector<ParticleBurst> m_pendingBursts;
+	std::atomic<UINT64> m_acknowledgedSequence;
+	UINT64 m_appliedSequence;
+
+	// engine exhaust and touchdown dust, colliding with a heightfield of the moon surface;
+	// owned by the render thread and advanced by its own clock
+	VSD3DStarter::ParticleSystem m_particles;
+	VSD3DStarter::ParticleHeightfield m_terrainHeightfield;
+	UINT m_exhaustEmitter;
+	UINT m_dustEmitter;
+	GameClock m_renderClock;
 
 	float m_translationSpeed;
 
 	float m_landingX;
 	float m_landingY;
 	float m_landingZ;
+
+	// the step function captures a raw this, which holds only because ~Game stops the thread
+	// before freeing anything and, declared last, this is destroyed first, joining the thread
+	// before any member a step touches; keep it last and keep Start and Stop on the UI thread
+	SimulationThread m_simulation;
 };
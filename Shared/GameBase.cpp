@@ -9,6 +9,7 @@
 
 #include "DirectXCollision.h"
 #include "GameBase.h"
+#include "RayBatch.h"
 
 using namespace DirectX;
 using namespace Microsoft::WRL;
@@ -179,50 +180,21 @@ void GameBase::Render()
 bool GameBase::LineSphereHitTest(Mesh* mesh, const XMFLOAT3* p0, const XMFLOAT3* dir, float& outT)
 {
     XMFLOAT3 center(mesh->Extents().CenterX, mesh->Extents().CenterY, mesh->Extents().CenterZ);
-    BoundingSphere* sphere = new BoundingSphere(center, mesh->Extents().Radius);
-    return sphere->Intersects(XMLoadFloat3(p0), XMLoadFloat3(dir), outT);
+    BoundingSphere sphere(center, mesh->Extents().Radius);
+    return sphere.Intersects(XMLoadFloat3(p0), XMVector3Normalize(XMLoadFloat3(dir)), outT);
 }
 
 bool GameBase::LineHitTest(Mesh* mesh, const XMFLOAT3* p0, const XMFLOAT3* dir, const XMFLOAT4X4* objectWorldTransform, float* outT)
 {
-    XMMATRIX objInvMatrix = XMLoadFloat4x4(objectWorldTransform);
-
-    XMVECTOR det;
-    objInvMatrix = XMMatrixInverse(&det, objInvMatrix);
-
-    XMVECTOR p0Vec = XMVector3TransformCoord(XMLoadFloat3(p0), objInvMatrix);
-    XMVECTOR dirVec = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(dir), objInvMatrix));
-
-    XMFLOAT3 p0InObj;
-    XMFLOAT3 dirInObj;
-
-    XMStoreFloat3(&p0InObj, p0Vec);
-    XMStoreFloat3(&dirInObj, dirVec);
-
-    bool hit = false;
-    float closestT = FLT_MAX;
-    float t = 0;
-    if (this->LineSphereHitTest(mesh, &p0InObj, &dirInObj, t))
-    {
-        for (Mesh::Triangle& triangle : mesh->Triangles())
-        {
-            XMVECTOR triangleV0 = XMLoadFloat3(&triangle.points[0]);
-            XMVECTOR triangleV1 = XMLoadFloat3(&triangle.points[1]);
-            XMVECTOR triangleV2 = XMLoadFloat3(&triangle.points[2]);
-
-            if (TriangleTests::Intersects(p0Vec, dirVec, triangleV0, triangleV1, triangleV2, t))
-            {
-                if (t >= 0 && t < closestT)
-                {
-                    closestT = t;
-                    hit = true;
-                }
-            }
-        }
-    }
-
-    *outT = closestT;
-    return hit;
+    // a batch of one; callers with many rays should use Physics::RaycastMeshes directly so
+    // the transform is inverted once for all of them
+    Physics::BatchRay ray = { *p0, *dir, FLT_MAX };
+    Physics::LocalRay scratch;
+    Physics::BatchRayHit hit;
+
+    bool result = Physics::RaycastMeshes(&ray, 1, &mesh, objectWorldTransform, 1, &scratch, &hit) > 0;
+    *outT = hit.Distance;
+    return result;
 }
 
 #pragma endregion
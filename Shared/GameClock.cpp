@@ -0,0 +1,93 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+
+#include "GameClock.h"
+
+#pragma region GameClock
+
+GameClock::GameClock()
+{
+    Reset();
+}
+
+void GameClock::Reset()
+{
+    m_start = Clock::now();
+    m_last = m_start;
+    m_totalNanoseconds = 0;
+    m_deltaNanoseconds = 0;
+    m_frameCount = 0;
+}
+
+void GameClock::Tick()
+{
+    Clock::time_point now = Clock::now();
+
+    m_totalNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count();
+    if (m_frameCount == 0)
+    {
+        m_deltaNanoseconds = std::int64_t(1000000000) / 60;
+    }
+    else
+    {
+        m_deltaNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last).count();
+    }
+
+    m_last = now;
+    m_frameCount++;
+}
+
+std::int64_t GameClock::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+#pragma endregion
+
+#pragma region FixedStepAccumulator
+
+FixedStepAccumulator::FixedStepAccumulator()
+{
+    Initialize();
+}
+
+void FixedStepAccumulator::Initialize(double stepSeconds, unsigned int maxStepsPerFrame)
+{
+    m_stepNanoseconds = std::max(static_cast<std::int64_t>(stepSeconds * 1e9 + 0.5), std::int64_t(1));
+    m_maxStepsPerFrame = std::max(maxStepsPerFrame, 1u);
+    Reset();
+}
+
+void FixedStepAccumulator::Reset()
+{
+    m_accumulated = 0;
+    m_stepCount = 0;
+    m_droppedSteps = 0;
+}
+
+unsigned int FixedStepAccumulator::Advance(std::int64_t elapsedNanoseconds)
+{
+    m_accumulated += std::max(elapsedNanoseconds, std::int64_t(0));
+
+    std::int64_t steps = m_accumulated / m_stepNanoseconds;
+    m_accumulated -= steps * m_stepNanoseconds;
+
+    if (steps > m_maxStepsPerFrame)
+    {
+        m_droppedSteps += steps - m_maxStepsPerFrame;
+        steps = m_maxStepsPerFrame;
+    }
+
+    m_stepCount += steps;
+    return static_cast<unsigned int>(steps);
+}
+
+#pragma endregion
@@ -0,0 +1,86 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// GameClock samples the monotonic steady clock once per frame. Totals are kept as integer
+// nanoseconds so they do not lose precision however long the game runs.
+//
+class GameClock
+{
+public:
+    GameClock();
+
+    void Reset();
+
+    //
+    // samples the clock; the first tick after Reset reports a 60Hz frame
+    //
+    void Tick();
+
+    std::int64_t TotalNanoseconds() const { return m_totalNanoseconds; }
+    std::int64_t DeltaNanoseconds() const { return m_deltaNanoseconds; }
+    double TotalSeconds() const { return m_totalNanoseconds * 1e-9; }
+    double DeltaSeconds() const { return m_deltaNanoseconds * 1e-9; }
+    std::uint64_t FrameCount() const { return m_frameCount; }
+
+    static std::int64_t Now();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point m_start;
+    Clock::time_point m_last;
+    std::int64_t m_totalNanoseconds;
+    std::int64_t m_deltaNanoseconds;
+    std::uint64_t m_frameCount;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// FixedStepAccumulator turns variable frame times into a whole number of fixed simulation
+// steps. The remainder carries over to the next frame and tells how long until the next step
+// is due. After a long stall only MaxStepsPerFrame steps run and the rest of the backlog is
+// dropped, so one slow frame cannot start a spiral of ever longer catch-up frames.
+//
+class FixedStepAccumulator
+{
+public:
+    FixedStepAccumulator();
+
+    void Initialize(double stepSeconds = 1.0 / 60.0, unsigned int maxStepsPerFrame = 8);
+    void Reset();
+
+    //
+    // adds the elapsed time and returns how many steps to simulate now
+    //
+    unsigned int Advance(std::int64_t elapsedNanoseconds);
+
+    float StepSeconds() const { return static_cast<float>(m_stepNanoseconds * 1e-9); }
+    std::int64_t StepNanoseconds() const { return m_stepNanoseconds; }
+
+    //
+    // time accumulated but not yet simulated, less than one step
+    //
+    std::int64_t AccumulatedNanoseconds() const { return m_accumulated; }
+
+    std::uint64_t StepCount() const { return m_stepCount; }
+    double SimulatedSeconds() const { return m_stepCount * (m_stepNanoseconds * 1e-9); }
+    std::uint64_t DroppedSteps() const { return m_droppedSteps; }
+
+private:
+    std::int64_t m_stepNanoseconds;
+    std::int64_t m_accumulated;
+    unsigned int m_maxStepsPerFrame;
+    std::uint64_t m_stepCount;
+    std::uint64_t m_droppedSteps;
+};
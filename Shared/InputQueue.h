@@ -0,0 +1,88 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// SpscQueue is a bounded ring buffer for exactly one producer thread and one consumer
+// thread. Each side only writes its own index, so neither ever blocks; a full queue rejects
+// the push instead. Capacity must be a power of two.
+//
+template <typename T, unsigned int Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_tail(0) { }
+
+    //
+    // producer side; returns false and drops the item when the queue is full
+    //
+    bool Push(const T& item)
+    {
+        unsigned int head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+
+        m_items[head & (Capacity - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //
+    // consumer side; Peek returns the oldest item, or nullptr when the queue is empty, and
+    // stays valid until Pop
+    //
+    const T* Peek() const
+    {
+        unsigned int tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        return &m_items[tail & (Capacity - 1)];
+    }
+
+    void Pop()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    SpscQueue(const SpscQueue&);
+    SpscQueue& operator=(const SpscQueue&);
+
+    T m_items[Capacity];
+    std::atomic<unsigned int> m_head;       // written by the producer
+    std::atomic<unsigned int> m_tail;       // written by the consumer
+};
+
+enum InputEventTypes
+{
+    INPUT_ROTATE = 0,
+    INPUT_MOOVE = 1
+};
+
+//
+// one player action, stamped with GameClock::Now() when the UI thread received it
+//
+struct InputEvent
+{
+    std::int64_t Timestamp;
+    int Type;                               // InputEventTypes
+    int Action;                             // StarShipMoovementTypes for that type
+};
+
+typedef SpscQueue<InputEvent, 256> InputQueue;
@@ -0,0 +1,354 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "Integrators.h"
+
+using namespace DirectX;
+
+using namespace Physics;
+
+#pragma region State arithmetic
+
+namespace
+{
+    const UINT MaxAdaptiveSubsteps = 64;
+
+    //
+    // working form of RigidBodyState; also used for derivatives
+    //
+    struct StateVectors
+    {
+        XMVECTOR Position;
+        XMVECTOR Velocity;
+        XMVECTOR Orientation;
+        XMVECTOR AngularVelocity;
+    };
+
+    inline StateVectors Load(const RigidBodyState& state)
+    {
+        StateVectors s;
+        s.Position = XMLoadFloat3(&state.Position);
+        s.Velocity = XMLoadFloat3(&state.Velocity);
+        s.Orientation = XMLoadFloat4(&state.Orientation);
+        s.AngularVelocity = XMLoadFloat3(&state.AngularVelocity);
+        return s;
+    }
+
+    inline void Store(const StateVectors& s, RigidBodyState& state)
+    {
+        XMStoreFloat3(&state.Position, s.Position);
+        XMStoreFloat3(&state.Velocity, s.Velocity);
+        XMStoreFloat4(&state.Orientation, XMQuaternionNormalize(s.Orientation));
+        XMStoreFloat3(&state.AngularVelocity, s.AngularVelocity);
+    }
+
+    //
+    // dq/dt = 0.5 * q * w; XMQuaternionMultiply(a, b) computes b * a
+    //
+    inline XMVECTOR OrientationRate(FXMVECTOR orientation, FXMVECTOR angularVelocity)
+    {
+        return XMVectorScale(XMQuaternionMultiply(angularVelocity, orientation), 0.5f);
+    }
+
+    inline StateVectors Evaluate(const StateVectors& s, const ForceModel& forces, FXMVECTOR angularAcceleration)
+    {
+        StateVectors d;
+        d.Position = s.Velocity;
+        d.Velocity = forces.LinearAcceleration(s.Position);
+        d.Orientation = OrientationRate(s.Orientation, s.AngularVelocity);
+        d.AngularVelocity = angularAcceleration;
+        return d;
+    }
+
+    //
+    // base + h * sum(coefficients[i] * k[i])
+    //
+    inline StateVectors Combine(const StateVectors& base, const StateVectors* k, const float* coefficients, UINT count, float h)
+    {
+        StateVectors s = base;
+        for (UINT i = 0; i < count; i++)
+        {
+            if (coefficients[i] == 0.0f)
+            {
+                continue;
+            }
+
+            XMVECTOR c = XMVectorReplicate(coefficients[i] * h);
+            s.Position = XMVectorMultiplyAdd(k[i].Position, c, s.Position);
+            s.Velocity = XMVectorMultiplyAdd(k[i].Velocity, c, s.Velocity);
+            s.Orientation = XMVectorMultiplyAdd(k[i].Orientation, c, s.Orientation);
+            s.AngularVelocity = XMVectorMultiplyAdd(k[i].AngularVelocity, c, s.AngularVelocity);
+        }
+        return s;
+    }
+
+    //
+    // Dormand-Prince 5(4) tableau; the seventh stage reuses the fifth order solution (FSAL)
+    //
+    const float DP_A2[] = { 1.0f / 5.0f };
+    const float DP_A3[] = { 3.0f / 40.0f, 9.0f / 40.0f };
+    const float DP_A4[] = { 44.0f / 45.0f, -56.0f / 15.0f, 32.0f / 9.0f };
+    const float DP_A5[] = { 19372.0f / 6561.0f, -25360.0f / 2187.0f, 64448.0f / 6561.0f, -212.0f / 729.0f };
+    const float DP_A6[] = { 9017.0f / 3168.0f, -355.0f / 33.0f, 46732.0f / 5247.0f, 49.0f / 176.0f, -5103.0f / 18656.0f };
+    const float DP_B[] = { 35.0f / 384.0f, 0.0f, 500.0f / 1113.0f, 125.0f / 192.0f, -2187.0f / 6784.0f, 11.0f / 84.0f };
+    const float DP_E[] = { 71.0f / 57600.0f, 0.0f, -71.0f / 16695.0f, 71.0f / 1920.0f, -17253.0f / 339200.0f, 22.0f / 525.0f, -1.0f / 40.0f };
+}
+
+#pragma endregion
+
+#pragma region Integrator
+
+XMVECTOR XM_CALLCONV ForceModel::LinearAcceleration(FXMVECTOR position) const
+{
+    XMVECTOR gravity;
+    if (GravityParameter > 0.0f)
+    {
+        XMVECTOR toCenter = XMVectorSubtract(XMLoadFloat3(&GravityCenter), position);
+        XMVECTOR distanceSq = XMVectorMax(XMVector3LengthSq(toCenter), XMVectorReplicate(1e-12f));
+        XMVECTOR inverseDistance = XMVectorReciprocalSqrt(distanceSq);
+
+        // GM / r^2 along toCenter / r
+        gravity = XMVectorScale(XMVectorMultiply(toCenter, XMVectorMultiply(inverseDistance, XMVectorMultiply(inverseDistance, inverseDistance))), GravityParameter);
+    }
+    else
+    {
+        gravity = XMLoadFloat3(&UniformGravity);
+    }
+
+    return XMVectorAdd(gravity, XMLoadFloat3(&Thrust));
+}
+
+const wchar_t* Physics::IntegratorName(IntegratorType type)
+{
+    switch (type)
+    {
+    case INTEGRATOR_SEMI_IMPLICIT_EULER:
+        return L"Semi-implicit Euler";
+    case INTEGRATOR_VELOCITY_VERLET:
+        return L"Velocity Verlet";
+    case INTEGRATOR_RK4:
+        return L"RK4";
+    case INTEGRATOR_RK45:
+        return L"RK45 (Dormand-Prince)";
+    default:
+        return L"Unknown";
+    }
+}
+
+void Integrator::Initialize(IntegratorType type, float tolerance)
+{
+    m_type = type;
+    m_tolerance = std::max(tolerance, 1e-9f);
+    m_adaptiveStep = 0.0f;
+    m_evaluations = 0;
+    m_forcedSubsteps = 0;
+}
+
+void Integrator::Step(RigidBodyState& state, const ForceModel& forces, float timeDelta)
+{
+    m_evaluations = 0;
+    m_forcedSubsteps = 0;
+    if (timeDelta <= 0.0f)
+    {
+        return;
+    }
+
+    StateVectors s = Load(state);
+    XMVECTOR angularAcceleration = XMLoadFloat3(&forces.AngularAcceleration);
+    float h = timeDelta;
+
+    switch (m_type)
+    {
+    case INTEGRATOR_SEMI_IMPLICIT_EULER:
+        {
+            s.Velocity = XMVectorMultiplyAdd(forces.LinearAcceleration(s.Position), XMVectorReplicate(h), s.Velocity);
+            s.Position = XMVectorMultiplyAdd(s.Velocity, XMVectorReplicate(h), s.Position);
+            s.AngularVelocity = XMVectorMultiplyAdd(angularAcceleration, XMVectorReplicate(h), s.AngularVelocity);
+            s.Orientation = XMVectorMultiplyAdd(OrientationRate(s.Orientation, s.AngularVelocity), XMVectorReplicate(h), s.Orientation);
+            m_evaluations = 1;
+        }
+        break;
+
+    case INTEGRATOR_VELOCITY_VERLET:
+        {
+            XMVECTOR a0 = forces.LinearAcceleration(s.Position);
+            s.Position = XMVectorAdd(s.Position, XMVectorAdd(XMVectorScale(s.Velocity, h), XMVectorScale(a0, 0.5f * h * h)));
+            XMVECTOR a1 = forces.LinearAcceleration(s.Position);
+            s.Velocity = XMVectorMultiplyAdd(XMVectorAdd(a0, a1), XMVectorReplicate(0.5f * h), s.Velocity);
+
+            // rotation uses the same half-step velocity form
+            XMVECTOR halfAngularVelocity = XMVectorMultiplyAdd(angularAcceleration, XMVectorReplicate(0.5f * h), s.AngularVelocity);
+            s.Orientation = XMVectorMultiplyAdd(OrientationRate(s.Orientation, halfAngularVelocity), XMVectorReplicate(h), s.Orientation);
+            s.AngularVelocity = XMVectorMultiplyAdd(angularAcceleration, XMVectorReplicate(h), s.AngularVelocity);
+            m_evaluations = 2;
+        }
+        break;
+
+    case INTEGRATOR_RK4:
+        {
+            const float half[] = { 0.5f };
+            const float full[] = { 0.0f, 0.0f, 1.0f };
+            const float weights[] = { 1.0f / 6.0f, 1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 6.0f };
+
+            StateVectors k[4];
+            k[0] = Evaluate(s, forces, angularAcceleration);
+            k[1] = Evaluate(Combine(s, &k[0], half, 1, h), forces, angularAcceleration);
+            k[2] = Evaluate(Combine(s, &k[1], half, 1, h), forces, angularAcceleration);
+            k[3] = Evaluate(Combine(s, k, full, 3, h), forces, angularAcceleration);
+            s = Combine(s, k, weights, 4, h);
+            m_evaluations = 4;
+        }
+        break;
+
+    case INTEGRATOR_RK45:
+        {
+            float remaining = timeDelta;
+            h = (m_adaptiveStep > 0.0f) ? m_adaptiveStep : timeDelta;
+
+            StateVectors k[7];
+            k[0] = Evaluate(s, forces, angularAcceleration);
+            m_evaluations = 1;
+
+            for (UINT substep = 0; remaining > 0.0f; substep++)
+            {
+                h = std::min(h, remaining);
+
+                k[1] = Evaluate(Combine(s, k, DP_A2, 1, h), forces, angularAcceleration);
+                k[2] = Evaluate(Combine(s, k, DP_A3, 2, h), forces, angularAcceleration);
+                k[3] = Evaluate(Combine(s, k, DP_A4, 3, h), forces, angularAcceleration);
+                k[4] = Evaluate(Combine(s, k, DP_A5, 4, h), forces, angularAcceleration);
+                k[5] = Evaluate(Combine(s, k, DP_A6, 5, h), forces, angularAcceleration);
+                StateVectors next = Combine(s, k, DP_B, 6, h);
+                k[6] = Evaluate(next, forces, angularAcceleration);
+                m_evaluations += 6;
+
+                //
+                // embedded fourth order error estimate over position and velocity
+                //
+                StateVectors error = Combine(StateVectors(), k, DP_E, 7, h);
+                XMVECTOR errorMax = XMVectorMax(XMVectorAbs(error.Position), XMVectorAbs(error.Velocity));
+                float errorNorm = std::max(std::max(XMVectorGetX(errorMax), XMVectorGetY(errorMax)), XMVectorGetZ(errorMax)) / m_tolerance;
+
+                bool accept = (errorNorm <= 1.0f) || (substep >= MaxAdaptiveSubsteps);
+                if (accept)
+                {
+                    if (errorNorm > 1.0f)
+                    {
+                        m_forcedSubsteps++;
+                    }
+
+                    s = next;
+                    s.Orientation = XMQuaternionNormalize(s.Orientation);
+                    k[0] = k[6];
+                    remaining = (h < remaining) ? remaining - h : 0.0f;
+                }
+
+                float scale = (errorNorm > 0.0f) ? 0.9f * std::pow(errorNorm, -0.2f) : 5.0f;
+                h *= std::min(std::max(scale, 0.2f), 5.0f);
+            }
+
+            m_adaptiveStep = h;
+        }
+        break;
+
+    default:
+        return;
+    }
+
+    Store(s, state);
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void Physics::RunIntegratorBenchmark(std::vector<IntegratorBenchmarkResult>& results, UINT steps, float timeStep)
+{
+    results.clear();
+
+    const float spinRate = 1.0f;
+
+    ForceModel forces;
+    forces.GravityParameter = 1.0f;
+
+    for (UINT type = 0; type < INTEGRATOR_COUNT; type++)
+    {
+        RigidBodyState initialState;
+        initialState.Position = XMFLOAT3(1.0f, 0.0f, 0.0f);
+        initialState.Velocity = XMFLOAT3(0.0f, 1.0f, 0.0f);
+        initialState.AngularVelocity = XMFLOAT3(0.0f, spinRate, 0.0f);
+
+        //
+        // throughput pass, timed as a whole so the clock is not part of the measurement
+        //
+        Integrator integrator;
+        integrator.Initialize(static_cast<IntegratorType>(type));
+
+        RigidBodyState state = initialState;
+        double evaluations = 0.0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (UINT i = 0; i < steps; i++)
+        {
+            integrator.Step(state, forces, timeStep);
+            evaluations += integrator.Evaluations();
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        //
+        // accuracy pass
+        //
+        integrator.Initialize(static_cast<IntegratorType>(type));
+        state = initialState;
+
+        const double initialEnergy = -0.5;
+        double maxEnergyError = 0.0;
+        UINT forcedSubsteps = 0;
+
+        for (UINT i = 0; i < steps; i++)
+        {
+            integrator.Step(state, forces, timeStep);
+            forcedSubsteps += integrator.ForcedSubsteps();
+
+            const XMFLOAT3& p = state.Position;
+            const XMFLOAT3& v = state.Velocity;
+            double radius = std::sqrt(static_cast<double>(p.x) * p.x + static_cast<double>(p.y) * p.y + static_cast<double>(p.z) * p.z);
+            double energy = 0.5 * (static_cast<double>(v.x) * v.x + static_cast<double>(v.y) * v.y + static_cast<double>(v.z) * v.z) - 1.0 / radius;
+            maxEnergyError = std::max(maxEnergyError, std::fabs((energy - initialEnergy) / initialEnergy));
+        }
+
+        //
+        // analytic solution: unit circle with period 2 pi, constant spin about +y
+        //
+        double totalTime = static_cast<double>(steps) * timeStep;
+        double dx = state.Position.x - std::cos(totalTime);
+        double dy = state.Position.y - std::sin(totalTime);
+        double dz = state.Position.z;
+
+        XMVECTOR expected = XMQuaternionRotationAxis(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), static_cast<float>(std::fmod(spinRate * totalTime, XM_2PI)));
+        float dot = std::fabs(XMVectorGetX(XMQuaternionDot(expected, XMLoadFloat4(&state.Orientation))));
+
+        IntegratorBenchmarkResult result;
+        result.Type = static_cast<IntegratorType>(type);
+        result.Steps = steps;
+        result.NanosecondsPerStep = (steps > 0) ? elapsed / steps : 0.0;
+        result.EvaluationsPerStep = (steps > 0) ? evaluations / steps : 0.0;
+        result.ForcedSubsteps = forcedSubsteps;
+        result.MaxEnergyError = maxEnergyError;
+        result.FinalPositionError = std::sqrt(dx * dx + dy * dy + dz * dz);
+        result.FinalOrientationError = 2.0 * std::acos(std::min(dot, 1.0f));
+        results.push_back(result);
+    }
+}
+
+#pragma endregion
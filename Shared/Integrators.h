@@ -0,0 +1,127 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+
+#include <DirectXMath.h>
+
+namespace Physics
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Translational and rotational state of a rigid body. The angular velocity is expressed
+    // in body space, so the orientation evolves as dq/dt = 0.5 * q * w.
+    //
+    struct RigidBodyState
+    {
+        RigidBodyState() :
+            Position(0.0f, 0.0f, 0.0f),
+            Velocity(0.0f, 0.0f, 0.0f),
+            Orientation(0.0f, 0.0f, 0.0f, 1.0f),
+            AngularVelocity(0.0f, 0.0f, 0.0f)
+        {
+        }
+
+        DirectX::XMFLOAT3 Position;
+        DirectX::XMFLOAT3 Velocity;
+        DirectX::XMFLOAT4 Orientation;
+        DirectX::XMFLOAT3 AngularVelocity;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Accelerations acting on a body. With a zero GravityParameter gravity is the uniform
+    // UniformGravity vector, otherwise it points at GravityCenter with magnitude GM / r^2.
+    //
+    struct ForceModel
+    {
+        ForceModel() :
+            UniformGravity(0.0f, 0.0f, 0.0f),
+            GravityCenter(0.0f, 0.0f, 0.0f),
+            GravityParameter(0.0f),
+            Thrust(0.0f, 0.0f, 0.0f),
+            AngularAcceleration(0.0f, 0.0f, 0.0f)
+        {
+        }
+
+        DirectX::XMVECTOR XM_CALLCONV LinearAcceleration(DirectX::FXMVECTOR position) const;
+
+        DirectX::XMFLOAT3 UniformGravity;
+        DirectX::XMFLOAT3 GravityCenter;
+        float GravityParameter;                 // GM
+        DirectX::XMFLOAT3 Thrust;               // world space acceleration
+        DirectX::XMFLOAT3 AngularAcceleration;  // body space
+    };
+
+    enum IntegratorType
+    {
+        INTEGRATOR_SEMI_IMPLICIT_EULER = 0,
+        INTEGRATOR_VELOCITY_VERLET = 1,
+        INTEGRATOR_RK4 = 2,
+        INTEGRATOR_RK45 = 3,
+
+        INTEGRATOR_COUNT = 4
+    };
+
+    const wchar_t* IntegratorName(IntegratorType type);
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Integrator advances a RigidBodyState by one time step with the selected scheme.
+    // INTEGRATOR_RK45 (Dormand-Prince) sub-steps internally to keep the estimated local
+    // position/velocity error below the tolerance and carries its step size between calls.
+    //
+    class Integrator
+    {
+    public:
+        Integrator() : m_type(INTEGRATOR_SEMI_IMPLICIT_EULER), m_tolerance(1e-5f), m_adaptiveStep(0.0f), m_evaluations(0), m_forcedSubsteps(0) { }
+
+        void Initialize(IntegratorType type, float tolerance = 1e-5f);
+        void Step(RigidBodyState& state, const ForceModel& forces, float timeDelta);
+
+        IntegratorType Type() const { return m_type; }
+
+        //
+        // force model evaluations spent by the last Step
+        //
+        UINT Evaluations() const { return m_evaluations; }
+
+        //
+        // RK45 substeps the last Step accepted over the tolerance because it ran out of
+        // substeps; nonzero means the tolerance is too tight for the step size
+        //
+        UINT ForcedSubsteps() const { return m_forcedSubsteps; }
+
+    private:
+        IntegratorType m_type;
+        float m_tolerance;
+        float m_adaptiveStep;
+        UINT m_evaluations;
+        UINT m_forcedSubsteps;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Benchmark: a body on a circular orbit (GM = 1, r = 1) spinning at a constant rate is
+    // integrated with every scheme and compared against the analytic solution.
+    //
+    struct IntegratorBenchmarkResult
+    {
+        IntegratorType Type;
+        UINT Steps;
+        double NanosecondsPerStep;
+        double EvaluationsPerStep;
+        UINT ForcedSubsteps;            // RK45 substeps accepted over the tolerance in the accuracy pass
+        double MaxEnergyError;          // relative to the initial orbital energy
+        double FinalPositionError;      // orbit radii
+        double FinalOrientationError;   // radians
+    };
+
+    void RunIntegratorBenchmark(std::vector<IntegratorBenchmarkResult>& results, UINT steps = 100000, float timeStep = 1.0f / 60.0f);
+}
@@ -0,0 +1,703 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "JobSystem.h"
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define JOB_THREAD_LOCAL thread_local
+#endif
+
+namespace
+{
+    const unsigned int SpinsBeforeSleep = 64;
+    const unsigned int PiecesPerThread = 4;
+
+    // the system and slot the current thread works for
+    JOB_THREAD_LOCAL JobSystem* t_system = nullptr;
+    JOB_THREAD_LOCAL int t_slot = -1;
+}
+
+#pragma region WorkStealingDeque
+
+WorkStealingDeque::WorkStealingDeque() :
+    m_top(0),
+    m_bottom(0),
+    m_jobs(new std::atomic<Job*>[Capacity])
+{
+}
+
+bool WorkStealingDeque::Push(Job* job)
+{
+    std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    std::int64_t top = m_top.load(std::memory_order_acquire);
+    if (bottom - top >= Capacity)
+    {
+        return false;
+    }
+
+    m_jobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+Job* WorkStealingDeque::Pop()
+{
+    std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = m_jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // last job; race thieves for it
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+Job* WorkStealingDeque::Steal()
+{
+    std::int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+    {
+        return nullptr;
+    }
+
+    Job* job = m_jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    return job;
+}
+
+#pragma endregion
+
+#pragma region JobSystem
+
+JobSystem::JobSystem() :
+    m_running(false),
+    m_sharedPoolNext(0),
+    m_sharedHead(0),
+    m_sharedCount(0),
+    m_sharedExecuted(0),
+    m_sleeping(0),
+    m_submitted(0)
+{
+}
+
+JobSystem::~JobSystem()
+{
+    Shutdown();
+}
+
+void JobSystem::Initialize(unsigned int workerCount)
+{
+    Shutdown();
+
+    if (workerCount == 0)
+    {
+        workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    m_workers.clear();
+    for (unsigned int i = 0; i <= workerCount; i++)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->Pool.reset(new Job[JobPoolSize]);
+        worker->PoolAllocated.reset(new std::atomic<bool>[JobPoolSize]);
+        for (unsigned int j = 0; j < JobPoolSize; j++)
+        {
+            worker->PoolAllocated[j].store(false);
+        }
+        worker->Random = 0x9e3779b9u * (i + 1);
+        m_workers.push_back(std::move(worker));
+    }
+
+    m_sharedPool.reset(new Job[JobPoolSize]);
+    m_sharedPoolAllocated.reset(new std::atomic<bool>[JobPoolSize]);
+    for (unsigned int j = 0; j < JobPoolSize; j++)
+    {
+        m_sharedPoolAllocated[j].store(false);
+    }
+    m_sharedPoolNext.store(0);
+    m_sharedQueue.assign(JobPoolSize, nullptr);
+    m_sharedHead = 0;
+    m_sharedCount = 0;
+    m_sharedExecuted.store(0);
+
+    t_system = this;
+    t_slot = 0;
+
+    m_running.store(true);
+    for (unsigned int i = 1; i <= workerCount; i++)
+    {
+        m_threads.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+    }
+}
+
+void JobSystem::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepLock);
+        m_running.store(false);
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+
+    // with the workers gone nothing else touches the deques; jobs released as these
+    // complete are queued again and found on the next pass
+    int slot = CurrentSlot();
+    for (Job* job = FindJob(slot); job != nullptr; job = FindJob(slot))
+    {
+        Execute(job, slot);
+    }
+
+    if (t_system == this)
+    {
+        t_system = nullptr;
+        t_slot = -1;
+    }
+}
+
+void JobSystem::Run(JobFunction function, void* data, JobCounter* counter, JobCounter* dependency)
+{
+    ParallelFor(0, 1, 1, function, data, counter, dependency);
+}
+
+void JobSystem::ParallelFor(unsigned int begin, unsigned int end, unsigned int grain, JobFunction function, void* data, JobCounter* counter, JobCounter* dependency)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    if (grain == 0)
+    {
+        unsigned int pieces = static_cast<unsigned int>(m_workers.size()) * PiecesPerThread;
+        grain = std::max((end - begin + pieces - 1) / std::max(pieces, 1u), 1u);
+    }
+
+    // before Initialize, run it here
+    int slot = CurrentSlot();
+    if (m_workers.empty())
+    {
+        if (dependency != nullptr)
+        {
+            Wait(*dependency);
+        }
+        function(data, begin, end);
+        return;
+    }
+
+    // with the pool full, the range runs here, after its dependency
+    Job local;
+    local.Allocated = nullptr;
+    Job* job = Allocate(slot);
+    bool runHere = (job == nullptr);
+    if (runHere)
+    {
+        job = &local;
+    }
+
+    job->Function = function;
+    job->Data = data;
+    job->Begin = begin;
+    job->End = end;
+    job->Grain = grain;
+    job->Counter = counter;
+    job->Next = nullptr;
+
+    if (counter != nullptr)
+    {
+        counter->m_pending.fetch_add(1);
+    }
+
+    if (runHere)
+    {
+        if (dependency != nullptr)
+        {
+            Wait(*dependency);
+        }
+        if (slot >= 0)
+        {
+            m_workers[slot]->RunInline.fetch_add(1, std::memory_order_relaxed);
+        }
+        Execute(job, slot);
+    }
+    else if (dependency != nullptr)
+    {
+        SubmitAfter(job, dependency, slot);
+    }
+    else
+    {
+        Submit(job, slot);
+    }
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    int slot = CurrentSlot();
+    while (!counter.IsDone())
+    {
+        Job* job = FindJob(slot);
+        if (job != nullptr)
+        {
+            Execute(job, slot);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+JobSystemStatistics JobSystem::Statistics() const
+{
+    JobSystemStatistics statistics = { m_sharedExecuted.load(std::memory_order_relaxed), 0, 0 };
+    for (const std::unique_ptr<Worker>& worker : m_workers)
+    {
+        statistics.Executed += worker->Executed.load(std::memory_order_relaxed);
+        statistics.Stolen += worker->Stolen.load(std::memory_order_relaxed);
+        statistics.RunInline += worker->RunInline.load(std::memory_order_relaxed);
+    }
+    return statistics;
+}
+
+int JobSystem::CurrentSlot() const
+{
+    return (t_system == this) ? t_slot : -1;
+}
+
+Job* JobSystem::Allocate(int slot)
+{
+    // an entry is free once its last job has started, which copies it out first
+    if (slot >= 0)
+    {
+        Worker& worker = *m_workers[slot];
+        for (unsigned int i = 0; i < JobPoolSize; i++)
+        {
+            unsigned int index = worker.PoolNext++ & (JobPoolSize - 1);
+            if (!worker.PoolAllocated[index].load(std::memory_order_acquire))
+            {
+                worker.PoolAllocated[index].store(true, std::memory_order_relaxed);
+                worker.Pool[index].Allocated = &worker.PoolAllocated[index];
+                return &worker.Pool[index];
+            }
+        }
+
+        return nullptr;
+    }
+
+    for (unsigned int i = 0; i < JobPoolSize; i++)
+    {
+        unsigned int index = m_sharedPoolNext.fetch_add(1, std::memory_order_relaxed) & (JobPoolSize - 1);
+        bool allocated = false;
+        if (m_sharedPoolAllocated[index].compare_exchange_strong(allocated, true, std::memory_order_acquire))
+        {
+            m_sharedPool[index].Allocated = &m_sharedPoolAllocated[index];
+            return &m_sharedPool[index];
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::Submit(Job* job, int slot)
+{
+    bool queued;
+    if (slot >= 0)
+    {
+        queued = m_workers[slot]->Deque.Push(job);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_sharedLock);
+        queued = m_sharedCount < JobPoolSize;
+        if (queued)
+        {
+            m_sharedQueue[(m_sharedHead + m_sharedCount++) & (JobPoolSize - 1)] = job;
+        }
+    }
+
+    if (!queued)
+    {
+        // everyone is busy enough already
+        if (slot >= 0)
+        {
+            m_workers[slot]->RunInline.fetch_add(1, std::memory_order_relaxed);
+        }
+        Execute(job, slot);
+        return;
+    }
+
+    // a worker checks the count under the sleep lock before it waits, so either it sees
+    // this job or it is already waiting when the notification comes
+    m_submitted.fetch_add(1);
+    if (m_sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_sleepLock);
+        m_wake.notify_one();
+    }
+}
+
+void JobSystem::SubmitAfter(Job* job, JobCounter* dependency, int slot)
+{
+    // push onto the dependency's list; whoever then sees it done takes the whole list
+    Job* head = dependency->m_dependents.load();
+    do
+    {
+        job->Next = head;
+    }
+    while (!dependency->m_dependents.compare_exchange_weak(head, job));
+
+    if (dependency->m_pending.load() == 0)
+    {
+        for (Job* ready = dependency->m_dependents.exchange(nullptr); ready != nullptr; )
+        {
+            Job* next = ready->Next;
+            Submit(ready, slot);
+            ready = next;
+        }
+    }
+}
+
+Job* JobSystem::FindJob(int slot)
+{
+    if (slot >= 0)
+    {
+        Job* job = m_workers[slot]->Deque.Pop();
+        if (job != nullptr)
+        {
+            return job;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_sharedLock, std::try_to_lock);
+        if (lock.owns_lock() && m_sharedCount > 0)
+        {
+            Job* job = m_sharedQueue[m_sharedHead++ & (JobPoolSize - 1)];
+            m_sharedCount--;
+            return job;
+        }
+    }
+
+    // steal from a random victim onwards
+    std::uint32_t random = (slot >= 0) ? m_workers[slot]->Random : static_cast<std::uint32_t>(m_sharedPoolNext.load(std::memory_order_relaxed));
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    if (slot >= 0)
+    {
+        m_workers[slot]->Random = random;
+    }
+
+    size_t count = m_workers.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t victim = (random + i) % count;
+        if (static_cast<int>(victim) == slot)
+        {
+            continue;
+        }
+
+        Job* job = m_workers[victim]->Deque.Steal();
+        if (job != nullptr)
+        {
+            if (slot >= 0)
+            {
+                m_workers[slot]->Stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::Execute(Job* job, int slot)
+{
+    // work on a copy, so the pool entry can go back to its owner at once
+    Job work = *job;
+    work.Allocated = nullptr;
+    if (job->Allocated != nullptr)
+    {
+        job->Allocated->store(false, std::memory_order_release);
+    }
+
+    // split off the upper half until the rest is one piece, leaving the halves to thieves
+    while (work.End - work.Begin > work.Grain)
+    {
+        Job* upper = Allocate(slot);
+        if (upper == nullptr)
+        {
+            break;
+        }
+
+        unsigned int middle = work.Begin + (work.End - work.Begin) / 2;
+
+        std::atomic<bool>* allocated = upper->Allocated;
+        *upper = work;
+        upper->Begin = middle;
+        upper->Next = nullptr;
+        upper->Allocated = allocated;
+        work.End = middle;
+
+        if (work.Counter != nullptr)
+        {
+            work.Counter->m_pending.fetch_add(1);
+        }
+        Submit(upper, slot);
+    }
+
+    // with the pool full, the rest runs here piece by piece
+    if (work.End - work.Begin > work.Grain && slot >= 0)
+    {
+        m_workers[slot]->RunInline.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    for (unsigned int begin = work.Begin; begin < work.End; )
+    {
+        unsigned int end = begin + std::min(work.Grain, work.End - begin);
+        work.Function(work.Data, begin, end);
+        begin = end;
+    }
+
+    if (slot >= 0)
+    {
+        m_workers[slot]->Executed.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        m_sharedExecuted.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Complete(work.Counter, slot);
+}
+
+void JobSystem::Complete(JobCounter* counter, int slot)
+{
+    if (counter == nullptr)
+    {
+        return;
+    }
+
+    // a waiter may free the counter once both reach zero, so m_completing is touched last
+    counter->m_completing.fetch_add(1);
+    if (counter->m_pending.fetch_sub(1) == 1)
+    {
+        for (Job* ready = counter->m_dependents.exchange(nullptr); ready != nullptr; )
+        {
+            Job* next = ready->Next;
+            Submit(ready, slot);
+            ready = next;
+        }
+    }
+    counter->m_completing.fetch_sub(1);
+}
+
+void JobSystem::WorkerMain(unsigned int slot)
+{
+    t_system = this;
+    t_slot = static_cast<int>(slot);
+
+    unsigned int idle = 0;
+    while (m_running.load())
+    {
+        // read before looking, so a job submitted after an empty search moves it on
+        std::uint64_t submitted = m_submitted.load();
+
+        Job* job = FindJob(t_slot);
+        if (job != nullptr)
+        {
+            Execute(job, t_slot);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < SpinsBeforeSleep)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepLock);
+        m_sleeping.fetch_add(1);
+        m_wake.wait(lock, [&]() { return !m_running.load() || m_submitted.load() != submitted; });
+        m_sleeping.fetch_sub(1);
+        idle = 0;
+    }
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+namespace
+{
+    //
+    // no work besides counting the items it was given
+    //
+    void EmptyJob(void* data, unsigned int begin, unsigned int end)
+    {
+        static_cast<std::atomic<unsigned int>*>(data)->fetch_add(end - begin, std::memory_order_relaxed);
+    }
+
+    //
+    // adds up the indices, to check a range splits into pieces that each run exactly once
+    //
+    void SumJob(void* data, unsigned int begin, unsigned int end)
+    {
+        std::uint64_t sum = 0;
+        for (unsigned int i = begin; i < end; i++)
+        {
+            sum += i;
+        }
+        static_cast<std::atomic<std::uint64_t>*>(data)->fetch_add(sum, std::memory_order_relaxed);
+    }
+
+    //
+    // a little floating point work per item, written back so it cannot be optimized away
+    //
+    void WorkJob(void* data, unsigned int begin, unsigned int end)
+    {
+        float* values = static_cast<float*>(data);
+        for (unsigned int i = begin; i < end; i++)
+        {
+            float x = values[i];
+            for (int k = 0; k < 64; k++)
+            {
+                x = std::sqrt(x * x + 1.0f) * 0.5f;
+            }
+            values[i] = x;
+        }
+    }
+}
+
+void RunJobSystemBenchmark(JobSystem& jobs, std::vector<JobSystemBenchmarkResult>& results, unsigned int jobCount)
+{
+    results.clear();
+
+    auto record = [&](const wchar_t* name, unsigned int count, double nanoseconds, double speedup, std::uint64_t stolen, bool correct)
+    {
+        JobSystemBenchmarkResult result;
+        result.Name = name;
+        result.Jobs = count;
+        result.NanosecondsPerJob = nanoseconds / count;
+        result.Speedup = speedup;
+        result.Stolen = stolen;
+        result.Correct = correct;
+        results.push_back(result);
+    };
+
+    auto elapsed = [](std::chrono::steady_clock::time_point start)
+    {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    };
+
+    //
+    // separate empty jobs submitted one by one, mostly stolen by the workers
+    //
+    {
+        std::atomic<unsigned int> items(0);
+        std::uint64_t stolen = jobs.Statistics().Stolen;
+        unsigned int batch = JobSystem::JobPoolSize / 2;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int submitted = 0; submitted < jobCount; submitted += batch)
+        {
+            JobCounter counter;
+            for (unsigned int i = 0; i < batch && submitted + i < jobCount; i++)
+            {
+                jobs.Run(&EmptyJob, &items, &counter);
+            }
+            jobs.Wait(counter);
+        }
+        record(L"spawn + wait", jobCount, elapsed(start), 0.0, jobs.Statistics().Stolen - stolen, items.load() == jobCount);
+    }
+
+    //
+    // one range split down to single items, so every piece is a split, a push and a pop or steal;
+    // far more pieces than a pool holds, so some run where the pool fills
+    //
+    {
+        std::atomic<unsigned int> items(0);
+        std::uint64_t stolen = jobs.Statistics().Stolen;
+        auto start = std::chrono::steady_clock::now();
+        JobCounter counter;
+        jobs.ParallelFor(0, jobCount, 1, &EmptyJob, &items, &counter);
+        jobs.Wait(counter);
+        record(L"parallel for, grain 1", jobCount, elapsed(start), 0.0, jobs.Statistics().Stolen - stolen, items.load() == jobCount);
+    }
+
+    //
+    // a wide range in small pieces, whose sum only comes out right if every piece runs once
+    //
+    {
+        unsigned int count = std::max(jobCount, 1000000u);
+        std::atomic<std::uint64_t> sum(0);
+        std::uint64_t stolen = jobs.Statistics().Stolen;
+        auto start = std::chrono::steady_clock::now();
+        JobCounter counter;
+        jobs.ParallelFor(0, count, 3, &SumJob, &sum, &counter);
+        jobs.Wait(counter);
+        std::uint64_t expected = static_cast<std::uint64_t>(count) * (count - 1) / 2;
+        record(L"parallel for sum, grain 3", (count + 2) / 3, elapsed(start), 0.0, jobs.Statistics().Stolen - stolen, sum.load() == expected);
+    }
+
+    //
+    // the same range with real work, against running it on this thread alone
+    //
+    {
+        std::vector<float> serialValues(jobCount, 1.0f);
+        std::vector<float> values(jobCount, 1.0f);
+
+        auto start = std::chrono::steady_clock::now();
+        WorkJob(serialValues.data(), 0, jobCount);
+        double serial = elapsed(start);
+
+        std::uint64_t stolen = jobs.Statistics().Stolen;
+        start = std::chrono::steady_clock::now();
+        JobCounter counter;
+        jobs.ParallelFor(0, jobCount, 0, &WorkJob, values.data(), &counter);
+        jobs.Wait(counter);
+        double parallel = elapsed(start);
+
+        record(L"parallel for, automatic grain", jobCount, parallel, serial / std::max(parallel, 1.0), jobs.Statistics().Stolen - stolen,
+            values == serialValues);
+    }
+}
+
+#pragma endregion
@@ -0,0 +1,228 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+//
+// a job runs its function over [begin, end); ranges wider than the grain are split in halves
+// so idle workers can steal the untouched half
+//
+typedef void (*JobFunction)(void* data, unsigned int begin, unsigned int end);
+
+struct Job
+{
+    JobFunction Function;
+    void* Data;
+    unsigned int Begin;
+    unsigned int End;
+    unsigned int Grain;
+    JobCounter* Counter;
+    Job* Next;                              // in the dependents of the counter it waits for
+    std::atomic<bool>* Allocated;           // the pool entry's flag, cleared once the job starts; null off the pools
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// JobCounter counts unfinished jobs. Waiting on it helps run jobs until it reaches zero, and
+// jobs can be held back until another counter reaches zero. A counter must outlive its jobs,
+// which Wait guarantees before it returns.
+//
+class JobCounter
+{
+public:
+    JobCounter() : m_pending(0), m_completing(0), m_dependents(nullptr) { }
+
+    bool IsDone() const
+    {
+        return m_pending.load() == 0 && m_completing.load() == 0;
+    }
+
+private:
+    friend class JobSystem;
+
+    JobCounter(const JobCounter&);
+    JobCounter& operator=(const JobCounter&);
+
+    std::atomic<int> m_pending;
+    std::atomic<int> m_completing;          // completions still touching the counter
+    std::atomic<Job*> m_dependents;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// Chase-Lev deque of a fixed capacity. The owning thread pushes and pops at the bottom
+// without contention; any other thread may steal from the top.
+//
+class WorkStealingDeque
+{
+public:
+    static const std::int64_t Capacity = 4096;
+
+    WorkStealingDeque();
+
+    bool Push(Job* job);                    // owner only; false when full
+    Job* Pop();                             // owner only
+    Job* Steal();                           // any thread
+
+private:
+    std::atomic<std::int64_t> m_top;
+    std::atomic<std::int64_t> m_bottom;
+    std::unique_ptr<std::atomic<Job*>[]> m_jobs;
+};
+
+struct JobSystemStatistics
+{
+    std::uint64_t Executed;
+    std::uint64_t Stolen;
+    std::uint64_t RunInline;                // queue was full, so the submitting thread ran it
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// JobSystem runs jobs on one worker thread per remaining core. Each worker owns a deque and
+// steals from the others when it runs dry. The thread that calls Initialize owns a deque too
+// and runs jobs while it waits; other threads submit through a shared queue and also help
+// while waiting. Jobs live in per-thread pools of JobPoolSize entries, each free again once
+// its job starts; when a thread's pool is full, what it would queue runs on it instead.
+//
+class JobSystem
+{
+public:
+    static const unsigned int JobPoolSize = 4096;
+
+    JobSystem();
+    ~JobSystem();
+
+    //
+    // 0 workers picks one per core besides the calling thread
+    //
+    void Initialize(unsigned int workerCount = 0);
+
+    //
+    // stops the workers, then runs whatever they left queued on the calling thread, so every
+    // counter still reaches zero
+    //
+    void Shutdown();
+
+    unsigned int WorkerCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+    //
+    // queues function(data, 0, 1); when dependency is given it is held back until that
+    // counter is done
+    //
+    void Run(JobFunction function, void* data, JobCounter* counter, JobCounter* dependency = nullptr);
+
+    //
+    // queues function over [begin, end) in pieces of at most grain items; grain 0 picks one
+    // that gives each thread a few pieces to balance with
+    //
+    void ParallelFor(unsigned int begin, unsigned int end, unsigned int grain, JobFunction function, void* data, JobCounter* counter, JobCounter* dependency = nullptr);
+
+    //
+    // runs body(begin, end) over the range and returns when all of it is done
+    //
+    template <typename Body>
+    void ParallelFor(unsigned int begin, unsigned int end, unsigned int grain, const Body& body)
+    {
+        struct Thunk
+        {
+            static void Run(void* data, unsigned int b, unsigned int e) { (*static_cast<const Body*>(data))(b, e); }
+        };
+
+        if (begin < end && end - begin <= grain)
+        {
+            body(begin, end);
+            return;
+        }
+
+        JobCounter counter;
+        ParallelFor(begin, end, grain, &Thunk::Run, const_cast<Body*>(&body), &counter);
+        Wait(counter);
+    }
+
+    //
+    // runs queued jobs on the calling thread until counter is done
+    //
+    void Wait(const JobCounter& counter);
+
+    JobSystemStatistics Statistics() const;
+
+private:
+    struct Worker
+    {
+        Worker() : PoolNext(0), Random(0), Executed(0), Stolen(0), RunInline(0) { }
+
+        WorkStealingDeque Deque;
+        std::unique_ptr<Job[]> Pool;
+        std::unique_ptr<std::atomic<bool>[]> PoolAllocated;
+        unsigned int PoolNext;
+        std::uint32_t Random;
+        std::atomic<std::uint64_t> Executed;
+        std::atomic<std::uint64_t> Stolen;
+        std::atomic<std::uint64_t> RunInline;
+    };
+
+    JobSystem(const JobSystem&);
+    JobSystem& operator=(const JobSystem&);
+
+    int CurrentSlot() const;
+    Job* Allocate(int slot);                // null when every entry still holds a job not yet started
+    void Submit(Job* job, int slot);
+    void SubmitAfter(Job* job, JobCounter* dependency, int slot);
+    Job* FindJob(int slot);
+    void Execute(Job* job, int slot);
+    void Complete(JobCounter* counter, int slot);
+    void WorkerMain(unsigned int slot);
+
+    // slot 0 belongs to the initializing thread, the rest to the worker threads
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_running;
+
+    // jobs from threads without a slot
+    std::unique_ptr<Job[]> m_sharedPool;
+    std::unique_ptr<std::atomic<bool>[]> m_sharedPoolAllocated;
+    std::atomic<unsigned int> m_sharedPoolNext;
+    std::mutex m_sharedLock;
+    std::vector<Job*> m_sharedQueue;        // ring of JobPoolSize entries
+    unsigned int m_sharedHead;
+    unsigned int m_sharedCount;
+    std::atomic<std::uint64_t> m_sharedExecuted;
+
+    // idle workers sleep here until the submission count moves past what they last saw
+    std::mutex m_sleepLock;
+    std::condition_variable m_wake;
+    std::atomic<int> m_sleeping;
+    std::atomic<std::uint64_t> m_submitted;
+};
+
+struct JobSystemBenchmarkResult
+{
+    const wchar_t* Name;
+    unsigned int Jobs;
+    double NanosecondsPerJob;
+    double Speedup;                         // over the same work run serially, where measured
+    std::uint64_t Stolen;
+    bool Correct;                           // every item ran exactly once
+};
+
+//
+// measures spawn, steal and completion overhead with empty jobs, and the speedup on a loop
+// with real work, checking each ran every item once; must be called from the thread that
+// initialized jobs
+//
+void RunJobSystemBenchmark(JobSystem& jobs, std::vector<JobSystemBenchmarkResult>& results, unsigned int jobCount = 100000);
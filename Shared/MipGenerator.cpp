@@ -0,0 +1,490 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+#include <vector>
+
+#include "JobSystem.h"
+#include "MipGenerator.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define MIP_GENERATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    const float Pi = 3.14159265358979f;
+    const float KaiserAlpha = 4.0f;
+    const float KaiserWidth = 3.0f;         // destination texels either side of the centre
+
+    //
+    // Byte to float conversions, and the linear values halfway between neighbouring sRGB
+    // codes. Searching the midpoints rounds linear values back to codes exactly as the
+    // encode curve would.
+    //
+    struct ChannelTables
+    {
+        ChannelTables()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                UnormToFloat[i] = i / 255.0f;
+                SRGBToLinear[i] = Decode(i / 255.0f);
+            }
+
+            for (int i = 0; i < 255; i++)
+            {
+                SRGBMidpoints[i] = Decode((i + 0.5f) / 255.0f);
+            }
+        }
+
+        static float Decode(float value)
+        {
+            return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float UnormToFloat[256];
+        float SRGBToLinear[256];
+        float SRGBMidpoints[255];
+    };
+
+    const ChannelTables s_tables;
+
+    inline uint8_t LinearToSRGB(float value)
+    {
+        unsigned int low = 0;
+        unsigned int high = 255;
+        while (low < high)
+        {
+            unsigned int middle = (low + high) / 2;
+            if (s_tables.SRGBMidpoints[middle] <= value)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        return static_cast<uint8_t>(low);
+    }
+
+    inline uint8_t FloatToUnorm(float value)
+    {
+        return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    template <typename Body>
+    void ForRows(JobSystem* jobs, uint32_t rowCount, const Body& body)
+    {
+        if (jobs)
+        {
+            jobs->ParallelFor(0, rowCount, 0, body);
+        }
+        else
+        {
+            body(0, rowCount);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Filter taps along one axis: destination texel d reads Indices and Weights from
+    // First[d] up to First[d + 1]. The weights of every texel add up to one.
+    //
+    struct FilterTaps
+    {
+        std::vector<uint32_t> First;
+        std::vector<uint32_t> Indices;
+        std::vector<float> Weights;
+    };
+
+    float BesselI0(float x)
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        float half = 0.5f * x;
+        for (int k = 1; k < 32 && term > 1e-7f * sum; k++)
+        {
+            term *= (half / k) * (half / k);
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    float KaiserSinc(float t)
+    {
+        float x = t / KaiserWidth;
+        if (std::fabs(x) >= 1.0f)
+        {
+            return 0.0f;
+        }
+
+        float sinc = (t == 0.0f) ? 1.0f : std::sin(Pi * t) / (Pi * t);
+        return sinc * BesselI0(KaiserAlpha * std::sqrt(1.0f - x * x)) / BesselI0(KaiserAlpha);
+    }
+
+    uint32_t EdgeIndex(int index, uint32_t size, bool wrap)
+    {
+        int n = static_cast<int>(size);
+        if (wrap)
+        {
+            return static_cast<uint32_t>(((index % n) + n) % n);
+        }
+
+        return static_cast<uint32_t>(std::min(std::max(index, 0), n - 1));
+    }
+
+    void BuildTaps(MipFilter filter, uint32_t sourceSize, uint32_t destinationSize, bool wrap, FilterTaps& taps)
+    {
+        taps.First.clear();
+        taps.Indices.clear();
+        taps.Weights.clear();
+
+        float scale = static_cast<float>(sourceSize) / destinationSize;
+        float radius = (filter == MIP_FILTER_BOX) ? 0.5f * scale : KaiserWidth * scale;
+
+        for (uint32_t d = 0; d < destinationSize; d++)
+        {
+            size_t start = taps.Weights.size();
+            taps.First.push_back(static_cast<uint32_t>(start));
+
+            float center = (d + 0.5f) * scale;
+            int first = static_cast<int>(std::floor(center - radius));
+            int last = static_cast<int>(std::ceil(center + radius));
+
+            float total = 0.0f;
+            for (int i = first; i < last; i++)
+            {
+                float weight;
+                if (filter == MIP_FILTER_BOX)
+                {
+                    weight = std::min(i + 1.0f, center + radius) - std::max(static_cast<float>(i), center - radius);
+                }
+                else
+                {
+                    weight = KaiserSinc((i + 0.5f - center) / scale);
+                }
+
+                if (weight == 0.0f)
+                {
+                    continue;
+                }
+
+                taps.Indices.push_back(EdgeIndex(i, sourceSize, wrap));
+                taps.Weights.push_back(weight);
+                total += weight;
+            }
+
+            for (size_t k = start; k < taps.Weights.size(); k++)
+            {
+                taps.Weights[k] /= total;
+            }
+        }
+
+        taps.First.push_back(static_cast<uint32_t>(taps.Weights.size()));
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Filter kernels over rows of float RGBA texels
+    //
+#ifdef MIP_GENERATOR_SSE2
+    void FilterRow(const float* source, const FilterTaps& taps, uint32_t count, float* destination)
+    {
+        for (uint32_t d = 0; d < count; d++)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t k = taps.First[d]; k < taps.First[d + 1]; k++)
+            {
+                __m128 texel = _mm_loadu_ps(source + 4 * taps.Indices[k]);
+                sum = _mm_add_ps(sum, _mm_mul_ps(texel, _mm_set1_ps(taps.Weights[k])));
+            }
+
+            _mm_storeu_ps(destination + 4 * d, sum);
+        }
+    }
+
+    void AccumulateRow(const float* source, float weight, uint32_t count, float* destination)
+    {
+        __m128 w = _mm_set1_ps(weight);
+        for (uint32_t i = 0; i < 4 * count; i += 4)
+        {
+            __m128 sum = _mm_add_ps(_mm_loadu_ps(destination + i), _mm_mul_ps(_mm_loadu_ps(source + i), w));
+            _mm_storeu_ps(destination + i, sum);
+        }
+    }
+
+    void QuantizeUnormRow(const float* source, float alphaScale, uint32_t count, uint8_t* destination)
+    {
+        const __m128 scale = _mm_set_ps(255.0f * alphaScale, 255.0f, 255.0f, 255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 maximum = _mm_set1_ps(255.0f);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            __m128 value = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source + 4 * i), scale), half);
+            value = _mm_min_ps(_mm_max_ps(value, zero), maximum);
+            __m128i packed = _mm_cvttps_epi32(value);
+            packed = _mm_packus_epi16(_mm_packs_epi32(packed, packed), packed);
+            int texel = _mm_cvtsi128_si32(packed);
+            memcpy(destination + 4 * i, &texel, 4);
+        }
+    }
+#else
+    void FilterRow(const float* source, const FilterTaps& taps, uint32_t count, float* destination)
+    {
+        for (uint32_t d = 0; d < count; d++)
+        {
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (uint32_t k = taps.First[d]; k < taps.First[d + 1]; k++)
+            {
+                const float* texel = source + 4 * taps.Indices[k];
+                for (int c = 0; c < 4; c++)
+                {
+                    sum[c] += texel[c] * taps.Weights[k];
+                }
+            }
+
+            for (int c = 0; c < 4; c++)
+            {
+                destination[4 * d + c] = sum[c];
+            }
+        }
+    }
+
+    void AccumulateRow(const float* source, float weight, uint32_t count, float* destination)
+    {
+        for (uint32_t i = 0; i < 4 * count; i++)
+        {
+            destination[i] += source[i] * weight;
+        }
+    }
+
+    void QuantizeUnormRow(const float* source, float alphaScale, uint32_t count, uint8_t* destination)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            destination[4 * i + 0] = FloatToUnorm(source[4 * i + 0]);
+            destination[4 * i + 1] = FloatToUnorm(source[4 * i + 1]);
+            destination[4 * i + 2] = FloatToUnorm(source[4 * i + 2]);
+            destination[4 * i + 3] = FloatToUnorm(source[4 * i + 3] * alphaScale);
+        }
+    }
+#endif
+
+    void QuantizeSRGBRow(const float* source, float alphaScale, uint32_t count, uint8_t* destination)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            destination[4 * i + 0] = LinearToSRGB(source[4 * i + 0]);
+            destination[4 * i + 1] = LinearToSRGB(source[4 * i + 1]);
+            destination[4 * i + 2] = LinearToSRGB(source[4 * i + 2]);
+            destination[4 * i + 3] = FloatToUnorm(source[4 * i + 3] * alphaScale);
+        }
+    }
+
+    void ExpandRow(const uint8_t* source, bool isSRGB, uint32_t count, float* destination)
+    {
+        const float* color = isSRGB ? s_tables.SRGBToLinear : s_tables.UnormToFloat;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            destination[4 * i + 0] = color[source[4 * i + 0]];
+            destination[4 * i + 1] = color[source[4 * i + 1]];
+            destination[4 * i + 2] = color[source[4 * i + 2]];
+            destination[4 * i + 3] = s_tables.UnormToFloat[source[4 * i + 3]];
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Alpha coverage: the share of texels whose stored alpha passes the reference test, and
+    // the alpha scale that brings a filtered level closest to the share of the top level.
+    // Coverage only changes in steps, so the scales either side of the target are compared.
+    //
+    float Coverage(const float* texels, size_t count, float alphaScale, float reference)
+    {
+        size_t passed = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (s_tables.UnormToFloat[FloatToUnorm(texels[4 * i + 3] * alphaScale)] > reference)
+            {
+                passed++;
+            }
+        }
+
+        return static_cast<float>(passed) / count;
+    }
+
+    float CoverageScale(const float* texels, size_t count, float reference, float target)
+    {
+        float unscaled = Coverage(texels, count, 1.0f, reference);
+        if (target <= 0.0f || unscaled == target)
+        {
+            return 1.0f;
+        }
+
+        // smallest scale reaching the target; coverage grows with the scale
+        float low = 0.0f;
+        float high = 1.0f / reference;
+        for (int i = 0; i < 20; i++)
+        {
+            float middle = 0.5f * (low + high);
+            if (Coverage(texels, count, middle, reference) >= target)
+            {
+                high = middle;
+            }
+            else
+            {
+                low = middle;
+            }
+        }
+
+        float below = Coverage(texels, count, low, reference);
+        float above = Coverage(texels, count, high, reference);
+        return (target - below < above - target) ? low : high;
+    }
+}
+
+uint32_t DirectX::FullMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+        count++;
+    }
+
+    return count;
+}
+
+size_t DirectX::MipChainSize(uint32_t width, uint32_t height, uint32_t mipCount)
+{
+    size_t bytes = 0;
+    for (uint32_t mip = 1; mip < mipCount; mip++)
+    {
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+        bytes += 4 * static_cast<size_t>(width) * height;
+    }
+
+    return bytes;
+}
+
+void DirectX::GenerateMips(const uint8_t* source, size_t sourceRowPitch, uint32_t width, uint32_t height, uint32_t mipCount,
+    bool isSRGB, const MipGenerationSettings& settings, uint8_t* destination, JobSystem* jobs)
+{
+    bool keepCoverage = settings.AlphaCoverageReference > 0.0f;
+    float targetCoverage = 0.0f;
+    if (keepCoverage)
+    {
+        size_t passed = 0;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* row = source + y * sourceRowPitch;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                if (s_tables.UnormToFloat[row[4 * x + 3]] > settings.AlphaCoverageReference)
+                {
+                    passed++;
+                }
+            }
+        }
+
+        targetCoverage = static_cast<float>(passed) / (static_cast<size_t>(width) * height);
+    }
+
+    // the level above stays in float after the first pass; the top level is expanded a row at a time
+    std::vector<float> above;
+    std::vector<float> filtered;
+    std::vector<float> level;
+    FilterTaps columns;
+    FilterTaps rows;
+    uint32_t aboveWidth = width;
+    uint32_t aboveHeight = height;
+
+    for (uint32_t mip = 1; mip < mipCount; mip++)
+    {
+        uint32_t levelWidth = std::max(aboveWidth / 2, 1u);
+        uint32_t levelHeight = std::max(aboveHeight / 2, 1u);
+        BuildTaps(settings.Filter, aboveWidth, levelWidth, settings.WrapEdges, columns);
+        BuildTaps(settings.Filter, aboveHeight, levelHeight, settings.WrapEdges, rows);
+
+        filtered.resize(4 * static_cast<size_t>(levelWidth) * aboveHeight);
+        ForRows(jobs, aboveHeight, [&](unsigned int begin, unsigned int end)
+        {
+            std::vector<float> expanded;
+            for (unsigned int y = begin; y < end; y++)
+            {
+                const float* row;
+                if (mip == 1)
+                {
+                    expanded.resize(4 * static_cast<size_t>(aboveWidth));
+                    ExpandRow(source + y * sourceRowPitch, isSRGB, aboveWidth, expanded.data());
+                    row = expanded.data();
+                }
+                else
+                {
+                    row = above.data() + 4 * static_cast<size_t>(y) * aboveWidth;
+                }
+
+                FilterRow(row, columns, levelWidth, filtered.data() + 4 * static_cast<size_t>(y) * levelWidth);
+            }
+        });
+
+        level.assign(4 * static_cast<size_t>(levelWidth) * levelHeight, 0.0f);
+        ForRows(jobs, levelHeight, [&](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int y = begin; y < end; y++)
+            {
+                float* row = level.data() + 4 * static_cast<size_t>(y) * levelWidth;
+                for (uint32_t k = rows.First[y]; k < rows.First[y + 1]; k++)
+                {
+                    AccumulateRow(filtered.data() + 4 * static_cast<size_t>(rows.Indices[k]) * levelWidth, rows.Weights[k], levelWidth, row);
+                }
+            }
+        });
+
+        float alphaScale = 1.0f;
+        if (keepCoverage)
+        {
+            alphaScale = CoverageScale(level.data(), level.size() / 4, settings.AlphaCoverageReference, targetCoverage);
+        }
+
+        ForRows(jobs, levelHeight, [&](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int y = begin; y < end; y++)
+            {
+                const float* row = level.data() + 4 * static_cast<size_t>(y) * levelWidth;
+                uint8_t* bytes = destination + 4 * static_cast<size_t>(y) * levelWidth;
+                if (isSRGB)
+                {
+                    QuantizeSRGBRow(row, alphaScale, levelWidth, bytes);
+                }
+                else
+                {
+                    QuantizeUnormRow(row, alphaScale, levelWidth, bytes);
+                }
+            }
+        });
+
+        destination += 4 * static_cast<size_t>(levelWidth) * levelHeight;
+        above.swap(level);
+        aboveWidth = levelWidth;
+        aboveHeight = levelHeight;
+    }
+}
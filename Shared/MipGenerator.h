@@ -0,0 +1,61 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class JobSystem;
+
+namespace DirectX
+{
+    //
+    // Box averages the source texels each destination texel covers. Kaiser is a windowed
+    // sinc three destination texels wide, sharper on minified surfaces at a few more taps.
+    //
+    enum MipFilter
+    {
+        MIP_FILTER_BOX,
+        MIP_FILTER_KAISER,
+    };
+
+    struct MipGenerationSettings
+    {
+        MipGenerationSettings() :
+            Filter(MIP_FILTER_BOX),
+            WrapEdges(false),
+            AlphaCoverageReference(0.0f)
+        {
+        }
+
+        MipFilter Filter;
+        bool WrapEdges;                 // filter across opposite edges, for wrap addressing
+        float AlphaCoverageReference;   // above 0, every level keeps the share of texels whose alpha passes this test
+    };
+
+    //
+    // levels down to 1x1
+    //
+    uint32_t FullMipCount(uint32_t width, uint32_t height);
+
+    //
+    // bytes GenerateMips writes for levels 1 to mipCount - 1
+    //
+    size_t MipChainSize(uint32_t width, uint32_t height, uint32_t mipCount);
+
+    //
+    // Builds levels 1 to mipCount - 1 from a width x height image of four 8-bit channels
+    // with alpha last, rows sourceRowPitch bytes apart. Levels are written one after the
+    // other with tightly packed rows, the way a DDS file stores them. Each level is
+    // filtered from the one above in linear light when isSRGB is set, keeping the filtered
+    // levels in float so rounding does not pile up down the chain. With jobs, rows are
+    // filtered in parallel.
+    //
+    void GenerateMips(const uint8_t* source, size_t sourceRowPitch, uint32_t width, uint32_t height, uint32_t mipCount,
+        bool isSRGB, const MipGenerationSettings& settings, uint8_t* destination, JobSystem* jobs = nullptr);
+}
@@ -0,0 +1,512 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "NarrowPhase.h"
+
+using namespace DirectX;
+
+using namespace Physics;
+
+#pragma region GJK
+
+namespace
+{
+    const UINT MaxGjkIterations = 64;
+    const UINT MaxEpaIterations = 64;
+    const UINT MaxEpaVertices = MaxEpaIterations + 4;
+    const UINT MaxEpaFaces = 2 * MaxEpaVertices;
+    const UINT MaxEpaEdges = 3 * MaxEpaFaces;
+    const float EpaTolerance = 1e-4f;
+
+    inline float Dot(FXMVECTOR a, FXMVECTOR b)
+    {
+        return XMVectorGetX(XMVector3Dot(a, b));
+    }
+
+    //
+    // point of the Minkowski difference hull - triangle, with the two points it came from
+    //
+    struct SupportPoint
+    {
+        XMVECTOR P;
+        XMVECTOR A;
+        XMVECTOR B;
+    };
+
+    struct MinkowskiPair
+    {
+        const HullInstance* Hull;
+        XMVECTOR Orientation;
+        XMVECTOR Position;
+        XMVECTOR Triangle[3];
+
+        SupportPoint XM_CALLCONV Support(FXMVECTOR direction) const
+        {
+            SupportPoint s;
+            XMVECTOR local = XMVector3InverseRotate(direction, Orientation);
+            s.A = XMVectorAdd(XMVector3Rotate(Hull->Hull->Support(local, Hull->Hint), Orientation), Position);
+
+            float d0 = Dot(Triangle[0], direction);
+            float d1 = Dot(Triangle[1], direction);
+            float d2 = Dot(Triangle[2], direction);
+            s.B = (d0 <= d1 && d0 <= d2) ? Triangle[0] : ((d1 <= d2) ? Triangle[1] : Triangle[2]);
+
+            s.P = XMVectorSubtract(s.A, s.B);
+            return s;
+        }
+    };
+
+    struct Simplex
+    {
+        SupportPoint Points[4];     // newest last
+        UINT Count;
+    };
+
+    inline XMVECTOR XM_CALLCONV TripleCross(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c)
+    {
+        return XMVector3Cross(XMVector3Cross(a, b), c);
+    }
+
+    void Line(Simplex& simplex, XMVECTOR& direction)
+    {
+        const SupportPoint a = simplex.Points[1];
+        const SupportPoint b = simplex.Points[0];
+        XMVECTOR ab = XMVectorSubtract(b.P, a.P);
+        XMVECTOR ao = XMVectorNegate(a.P);
+
+        if (Dot(ab, ao) > 0.0f)
+        {
+            direction = TripleCross(ab, ao, ab);
+        }
+        else
+        {
+            simplex.Points[0] = a;
+            simplex.Count = 1;
+            direction = ao;
+        }
+    }
+
+    void TriangleCase(Simplex& simplex, XMVECTOR& direction)
+    {
+        const SupportPoint a = simplex.Points[2];
+        const SupportPoint b = simplex.Points[1];
+        const SupportPoint c = simplex.Points[0];
+        XMVECTOR ab = XMVectorSubtract(b.P, a.P);
+        XMVECTOR ac = XMVectorSubtract(c.P, a.P);
+        XMVECTOR ao = XMVectorNegate(a.P);
+        XMVECTOR abc = XMVector3Cross(ab, ac);
+
+        if (Dot(XMVector3Cross(abc, ac), ao) > 0.0f)
+        {
+            if (Dot(ac, ao) > 0.0f)
+            {
+                simplex.Points[0] = c;
+                simplex.Points[1] = a;
+                simplex.Count = 2;
+                direction = TripleCross(ac, ao, ac);
+                return;
+            }
+
+            simplex.Points[0] = b;
+            simplex.Points[1] = a;
+            simplex.Count = 2;
+            Line(simplex, direction);
+            return;
+        }
+
+        if (Dot(XMVector3Cross(ab, abc), ao) > 0.0f)
+        {
+            simplex.Points[0] = b;
+            simplex.Points[1] = a;
+            simplex.Count = 2;
+            Line(simplex, direction);
+            return;
+        }
+
+        if (Dot(abc, ao) > 0.0f)
+        {
+            direction = abc;
+        }
+        else
+        {
+            simplex.Points[0] = b;
+            simplex.Points[1] = c;
+            direction = XMVectorNegate(abc);
+        }
+    }
+
+    //
+    // reduces the simplex to the feature closest to the origin; true once it encloses it
+    //
+    bool Tetrahedron(Simplex& simplex, XMVECTOR& direction)
+    {
+        const SupportPoint a = simplex.Points[3];
+        const SupportPoint b = simplex.Points[2];
+        const SupportPoint c = simplex.Points[1];
+        const SupportPoint d = simplex.Points[0];
+        XMVECTOR ao = XMVectorNegate(a.P);
+
+        XMVECTOR ab = XMVectorSubtract(b.P, a.P);
+        XMVECTOR ac = XMVectorSubtract(c.P, a.P);
+        XMVECTOR ad = XMVectorSubtract(d.P, a.P);
+
+        XMVECTOR abc = XMVector3Cross(ab, ac);
+        XMVECTOR acd = XMVector3Cross(ac, ad);
+        XMVECTOR adb = XMVector3Cross(ad, ab);
+
+        // face normals point away from the opposite vertex
+        if (Dot(abc, ad) > 0.0f) abc = XMVectorNegate(abc);
+        if (Dot(acd, ab) > 0.0f) acd = XMVectorNegate(acd);
+        if (Dot(adb, ac) > 0.0f) adb = XMVectorNegate(adb);
+
+        if (Dot(abc, ao) > 0.0f)
+        {
+            simplex.Points[0] = c;
+            simplex.Points[1] = b;
+            simplex.Points[2] = a;
+        }
+        else if (Dot(acd, ao) > 0.0f)
+        {
+            simplex.Points[0] = d;
+            simplex.Points[1] = c;
+            simplex.Points[2] = a;
+        }
+        else if (Dot(adb, ao) > 0.0f)
+        {
+            simplex.Points[0] = b;
+            simplex.Points[1] = d;
+            simplex.Points[2] = a;
+        }
+        else
+        {
+            return true;
+        }
+
+        simplex.Count = 3;
+        TriangleCase(simplex, direction);
+        return false;
+    }
+
+    bool Gjk(const MinkowskiPair& pair, Simplex& simplex)
+    {
+        XMVECTOR direction = XMVectorSubtract(pair.Position, XMVectorScale(XMVectorAdd(pair.Triangle[0], XMVectorAdd(pair.Triangle[1], pair.Triangle[2])), 1.0f / 3.0f));
+        if (XMVectorGetX(XMVector3LengthSq(direction)) < 1e-12f)
+        {
+            direction = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+        }
+
+        simplex.Points[0] = pair.Support(direction);
+        simplex.Count = 1;
+        direction = XMVectorNegate(simplex.Points[0].P);
+
+        for (UINT iteration = 0; iteration < MaxGjkIterations; iteration++)
+        {
+            if (XMVectorGetX(XMVector3LengthSq(direction)) < 1e-14f)
+            {
+                // the origin lies on the current simplex: touching, not penetrating
+                return false;
+            }
+
+            SupportPoint s = pair.Support(direction);
+            if (Dot(s.P, direction) < 0.0f)
+            {
+                return false;
+            }
+
+            simplex.Points[simplex.Count++] = s;
+
+            switch (simplex.Count)
+            {
+            case 2:
+                Line(simplex, direction);
+                break;
+            case 3:
+                TriangleCase(simplex, direction);
+                break;
+            case 4:
+                if (Tetrahedron(simplex, direction))
+                {
+                    return true;
+                }
+                break;
+            }
+        }
+
+        return false;
+    }
+}
+
+#pragma endregion
+
+#pragma region EPA
+
+namespace
+{
+    struct EpaFace
+    {
+        UINT V[3];
+        XMVECTOR Normal;
+        float Distance;
+    };
+
+    bool MakeEpaFace(const SupportPoint* vertices, UINT a, UINT b, UINT c, EpaFace& face)
+    {
+        XMVECTOR normal = XMVector3Cross(XMVectorSubtract(vertices[b].P, vertices[a].P), XMVectorSubtract(vertices[c].P, vertices[a].P));
+        float length = XMVectorGetX(XMVector3Length(normal));
+        if (length < 1e-12f)
+        {
+            return false;
+        }
+
+        face.V[0] = a;
+        face.V[1] = b;
+        face.V[2] = c;
+        face.Normal = XMVectorScale(normal, 1.0f / length);
+        face.Distance = Dot(face.Normal, vertices[a].P);
+        return true;
+    }
+
+    //
+    // expands the enclosing tetrahedron towards the Minkowski boundary face nearest the origin
+    //
+    bool Epa(const MinkowskiPair& pair, const Simplex& simplex, ContactPoint& contact)
+    {
+        SupportPoint vertices[MaxEpaVertices];
+        EpaFace faces[MaxEpaFaces];
+        UINT edges[MaxEpaEdges][2];
+        UINT vertexCount = 4;
+        UINT faceCount = 0;
+
+        for (UINT i = 0; i < 4; i++)
+        {
+            vertices[i] = simplex.Points[i];
+        }
+
+        XMVECTOR centroid = XMVectorScale(XMVectorAdd(XMVectorAdd(vertices[0].P, vertices[1].P), XMVectorAdd(vertices[2].P, vertices[3].P)), 0.25f);
+        const UINT initial[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+        for (UINT f = 0; f < 4; f++)
+        {
+            EpaFace& face = faces[faceCount];
+            if (!MakeEpaFace(vertices, initial[f][0], initial[f][1], initial[f][2], face))
+            {
+                return false;
+            }
+
+            if (Dot(face.Normal, XMVectorSubtract(vertices[face.V[0]].P, centroid)) < 0.0f)
+            {
+                MakeEpaFace(vertices, initial[f][0], initial[f][2], initial[f][1], face);
+            }
+            faceCount++;
+        }
+
+        UINT closest = 0;
+        for (UINT iteration = 0; ; iteration++)
+        {
+            closest = 0;
+            for (UINT f = 1; f < faceCount; f++)
+            {
+                if (faces[f].Distance < faces[closest].Distance)
+                {
+                    closest = f;
+                }
+            }
+
+            if (iteration >= MaxEpaIterations || vertexCount >= MaxEpaVertices)
+            {
+                break;
+            }
+
+            SupportPoint s = pair.Support(faces[closest].Normal);
+            if (Dot(s.P, faces[closest].Normal) - faces[closest].Distance < EpaTolerance)
+            {
+                break;
+            }
+
+            //
+            // remove every face the new point sees and stitch the horizon to it
+            //
+            UINT edgeCount = 0;
+            for (UINT f = 0; f < faceCount; )
+            {
+                if (Dot(faces[f].Normal, XMVectorSubtract(s.P, vertices[faces[f].V[0]].P)) <= 0.0f)
+                {
+                    f++;
+                    continue;
+                }
+
+                for (UINT e = 0; e < 3; e++)
+                {
+                    UINT a = faces[f].V[e];
+                    UINT b = faces[f].V[(e + 1) % 3];
+
+                    // an edge shared by two removed faces is interior; drop its twin
+                    bool shared = false;
+                    for (UINT k = 0; k < edgeCount; k++)
+                    {
+                        if (edges[k][0] == b && edges[k][1] == a)
+                        {
+                            edges[k][0] = edges[edgeCount - 1][0];
+                            edges[k][1] = edges[edgeCount - 1][1];
+                            edgeCount--;
+                            shared = true;
+                            break;
+                        }
+                    }
+
+                    if (!shared && edgeCount < MaxEpaEdges)
+                    {
+                        edges[edgeCount][0] = a;
+                        edges[edgeCount][1] = b;
+                        edgeCount++;
+                    }
+                }
+
+                faces[f] = faces[--faceCount];
+            }
+
+            UINT added = vertexCount++;
+            vertices[added] = s;
+            for (UINT e = 0; e < edgeCount && faceCount < MaxEpaFaces; e++)
+            {
+                if (MakeEpaFace(vertices, edges[e][0], edges[e][1], added, faces[faceCount]))
+                {
+                    faceCount++;
+                }
+            }
+
+            if (faceCount == 0)
+            {
+                return false;
+            }
+        }
+
+        //
+        // contact from the barycentric coordinates of the origin's projection on the face
+        //
+        const EpaFace& face = faces[closest];
+        const SupportPoint& a = vertices[face.V[0]];
+        const SupportPoint& b = vertices[face.V[1]];
+        const SupportPoint& c = vertices[face.V[2]];
+
+        XMVECTOR projection = XMVectorScale(face.Normal, face.Distance);
+        XMVECTOR v0 = XMVectorSubtract(b.P, a.P);
+        XMVECTOR v1 = XMVectorSubtract(c.P, a.P);
+        XMVECTOR v2 = XMVectorSubtract(projection, a.P);
+        float d00 = Dot(v0, v0);
+        float d01 = Dot(v0, v1);
+        float d11 = Dot(v1, v1);
+        float d20 = Dot(v2, v0);
+        float d21 = Dot(v2, v1);
+        float denominator = d00 * d11 - d01 * d01;
+
+        float v = 0.0f, w = 0.0f;
+        if (std::fabs(denominator) > 1e-12f)
+        {
+            v = (d11 * d20 - d01 * d21) / denominator;
+            w = (d00 * d21 - d01 * d20) / denominator;
+        }
+        float u = 1.0f - v - w;
+
+        XMVECTOR onHull = XMVectorAdd(XMVectorScale(a.A, u), XMVectorAdd(XMVectorScale(b.A, v), XMVectorScale(c.A, w)));
+        XMVECTOR onTriangle = XMVectorAdd(XMVectorScale(a.B, u), XMVectorAdd(XMVectorScale(b.B, v), XMVectorScale(c.B, w)));
+
+        // the face normal points out of hull - triangle; the hull escapes along its negation
+        XMStoreFloat3(&contact.Normal, XMVectorNegate(face.Normal));
+        contact.Depth = std::max(face.Distance, 0.0f);
+        XMStoreFloat3(&contact.PointOnHull, onHull);
+        XMStoreFloat3(&contact.PointOnTriangle, onTriangle);
+        return true;
+    }
+}
+
+#pragma endregion
+
+#pragma region Queries
+
+bool XM_CALLCONV Physics::IntersectHullTriangle(const HullInstance& hull, FXMVECTOR v0, FXMVECTOR v1, FXMVECTOR v2, ContactPoint& contact)
+{
+    if (hull.Hull == nullptr || !hull.Hull->IsValid())
+    {
+        return false;
+    }
+
+    MinkowskiPair pair;
+    pair.Hull = &hull;
+    pair.Orientation = XMLoadFloat4(&hull.Orientation);
+    pair.Position = XMLoadFloat3(&hull.Position);
+    pair.Triangle[0] = v0;
+    pair.Triangle[1] = v1;
+    pair.Triangle[2] = v2;
+
+    Simplex simplex;
+    if (!Gjk(pair, simplex))
+    {
+        return false;
+    }
+
+    return Epa(pair, simplex, contact);
+}
+
+void Physics::GetHullWorldBounds(const HullInstance& hull, XMFLOAT3& boundsMin, XMFLOAT3& boundsMax)
+{
+    XMVECTOR localMin = XMLoadFloat3(&hull.Hull->BoundsMin());
+    XMVECTOR localMax = XMLoadFloat3(&hull.Hull->BoundsMax());
+    XMVECTOR center = XMVectorScale(XMVectorAdd(localMin, localMax), 0.5f);
+    XMVECTOR extents = XMVectorScale(XMVectorSubtract(localMax, localMin), 0.5f);
+
+    //
+    // the world extents of a rotated box are its local extents times |R|
+    //
+    XMMATRIX rotation = XMMatrixRotationQuaternion(XMLoadFloat4(&hull.Orientation));
+    XMVECTOR worldExtents = XMVectorAdd(XMVectorAdd(
+        XMVectorScale(XMVectorAbs(rotation.r[0]), XMVectorGetX(extents)),
+        XMVectorScale(XMVectorAbs(rotation.r[1]), XMVectorGetY(extents))),
+        XMVectorScale(XMVectorAbs(rotation.r[2]), XMVectorGetZ(extents)));
+    XMVECTOR worldCenter = XMVectorAdd(XMVector3Rotate(center, XMLoadFloat4(&hull.Orientation)), XMLoadFloat3(&hull.Position));
+
+    XMStoreFloat3(&boundsMin, XMVectorSubtract(worldCenter, worldExtents));
+    XMStoreFloat3(&boundsMax, XMVectorAdd(worldCenter, worldExtents));
+}
+
+UINT Physics::CollideHullMesh(const HullInstance& hull, const TriangleMeshCollider& mesh, std::vector<UINT>& candidates, std::vector<ContactPoint>& contacts)
+{
+    if (hull.Hull == nullptr || !hull.Hull->IsValid())
+    {
+        return 0;
+    }
+
+    XMFLOAT3 boundsMin, boundsMax;
+    GetHullWorldBounds(hull, boundsMin, boundsMax);
+
+    candidates.clear();
+    mesh.QueryTriangles(XMLoadFloat3(&boundsMin), XMLoadFloat3(&boundsMax), candidates);
+
+    UINT found = 0;
+    for (UINT triangle : candidates)
+    {
+        XMVECTOR v0, v1, v2;
+        mesh.GetTriangle(triangle, v0, v1, v2);
+
+        ContactPoint contact;
+        if (IntersectHullTriangle(hull, v0, v1, v2, contact))
+        {
+            contact.Triangle = triangle;
+            contacts.push_back(contact);
+            found++;
+        }
+    }
+
+    return found;
+}
+
+#pragma endregion
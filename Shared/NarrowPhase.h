@@ -0,0 +1,56 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "ConvexHull.h"
+#include "ContinuousCollision.h"
+
+namespace Physics
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Penetrating contact between a hull and a triangle. Normal points from the triangle
+    // towards the hull; moving the hull by Normal * Depth separates the two.
+    //
+    struct ContactPoint
+    {
+        DirectX::XMFLOAT3 Normal;
+        float Depth;
+        DirectX::XMFLOAT3 PointOnHull;
+        DirectX::XMFLOAT3 PointOnTriangle;
+        UINT Triangle;
+    };
+
+    //
+    // placement of a hull in the world; Hint caches the last support vertex for hill climbing
+    //
+    struct HullInstance
+    {
+        const ConvexHull* Hull;
+        DirectX::XMFLOAT4 Orientation;
+        DirectX::XMFLOAT3 Position;
+        mutable UINT Hint;
+    };
+
+    //
+    // GJK overlap test followed by EPA for the penetration depth and direction
+    //
+    bool XM_CALLCONV IntersectHullTriangle(const HullInstance& hull, DirectX::FXMVECTOR v0, DirectX::FXMVECTOR v1, DirectX::FXMVECTOR v2, ContactPoint& contact);
+
+    //
+    // tests the hull against every mesh triangle overlapping its world bounds and appends the
+    // contacts; candidates is caller-owned scratch so repeated queries do not allocate
+    //
+    UINT CollideHullMesh(const HullInstance& hull, const TriangleMeshCollider& mesh, std::vector<UINT>& candidates, std::vector<ContactPoint>& contacts);
+
+    void GetHullWorldBounds(const HullInstance& hull, DirectX::XMFLOAT3& boundsMin, DirectX::XMFLOAT3& boundsMax);
+}
@@ -0,0 +1,24 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+//
+// Round soft sprite. The colour arrives premultiplied, so blending with ONE / INV_SRC_ALPHA
+// treats alpha 0 particles as additive and the rest as ordinary transparency.
+//
+
+struct V2P
+{
+    float4 pos : SV_POSITION;
+    float4 color : COLOR0;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(V2P input) : SV_TARGET
+{
+    float falloff = saturate(1.0f - dot(input.uv, input.uv));
+    return input.color * (falloff * falloff);
+}
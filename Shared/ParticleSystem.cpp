@@ -0,0 +1,528 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "ParticleSystem.h"
+#include "DirectXHelper.h"
+
+#include "ParticleVS.h"
+#include "ParticlePS.h"
+
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+using namespace VSD3DStarter;
+
+namespace
+{
+    const float CollisionFriction = 0.5f;
+
+    //
+    // shader constants; XMFLOAT storage keeps the layout free of alignment padding
+    //
+    struct ParticleConstants
+    {
+        XMFLOAT4X4 WorldToProjected4x4;
+        XMFLOAT4 CameraRight;
+        XMFLOAT4 CameraUp;
+    };
+
+    inline XMVECTOR Load4(const float* source)
+    {
+        return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(source));
+    }
+
+    inline void Store4(float* destination, FXMVECTOR value)
+    {
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(destination), value);
+    }
+
+    inline UINT PackColor(float r, float g, float b, float a)
+    {
+        UINT ur = static_cast<UINT>(std::min(std::max(r, 0.0f), 1.0f) * 255.0f + 0.5f);
+        UINT ug = static_cast<UINT>(std::min(std::max(g, 0.0f), 1.0f) * 255.0f + 0.5f);
+        UINT ub = static_cast<UINT>(std::min(std::max(b, 0.0f), 1.0f) * 255.0f + 0.5f);
+        UINT ua = static_cast<UINT>(std::min(std::max(a, 0.0f), 1.0f) * 255.0f + 0.5f);
+        return ur | (ug << 8) | (ub << 16) | (ua << 24);
+    }
+}
+
+#pragma region ParticleHeightfield
+
+void ParticleHeightfield::Initialize(const Physics::TriangleMeshCollider& collider, UINT resolution)
+{
+    m_heights.clear();
+    if (collider.TriangleCount() == 0 || resolution < 2)
+    {
+        return;
+    }
+
+    XMFLOAT3 boundsMin, boundsMax;
+    collider.GetBounds(boundsMin, boundsMax);
+
+    float extent = std::max(boundsMax.x - boundsMin.x, boundsMax.z - boundsMin.z);
+    float cellSize = std::max(extent / (resolution - 1), 1e-4f);
+
+    m_originX = boundsMin.x;
+    m_originZ = boundsMin.z;
+    m_inverseCellSize = 1.0f / cellSize;
+    m_columns = static_cast<UINT>((boundsMax.x - boundsMin.x) * m_inverseCellSize) + 2;
+    m_rows = static_cast<UINT>((boundsMax.z - boundsMin.z) * m_inverseCellSize) + 2;
+    m_heights.assign(m_columns * m_rows, -FLT_MAX);
+
+    //
+    // rasterize every triangle into the grid from above, keeping the highest surface
+    //
+    for (UINT t = 0; t < collider.TriangleCount(); t++)
+    {
+        XMVECTOR v0, v1, v2;
+        collider.GetTriangle(t, v0, v1, v2);
+
+        XMFLOAT3 a, b, c;
+        XMStoreFloat3(&a, v0);
+        XMStoreFloat3(&b, v1);
+        XMStoreFloat3(&c, v2);
+
+        float area = (b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z);
+        if (std::fabs(area) < 1e-12f)
+        {
+            continue;   // vertical faces have no top surface
+        }
+
+        int minColumn = std::max(static_cast<int>(std::ceil((std::min(a.x, std::min(b.x, c.x)) - m_originX) * m_inverseCellSize)), 0);
+        int maxColumn = std::min(static_cast<int>(std::floor((std::max(a.x, std::max(b.x, c.x)) - m_originX) * m_inverseCellSize)), static_cast<int>(m_columns) - 1);
+        int minRow = std::max(static_cast<int>(std::ceil((std::min(a.z, std::min(b.z, c.z)) - m_originZ) * m_inverseCellSize)), 0);
+        int maxRow = std::min(static_cast<int>(std::floor((std::max(a.z, std::max(b.z, c.z)) - m_originZ) * m_inverseCellSize)), static_cast<int>(m_rows) - 1);
+
+        for (int row = minRow; row <= maxRow; row++)
+        {
+            float z = m_originZ + row * cellSize;
+            for (int column = minColumn; column <= maxColumn; column++)
+            {
+                float x = m_originX + column * cellSize;
+
+                float u = ((b.x - x) * (c.z - z) - (c.x - x) * (b.z - z)) / area;
+                float v = ((c.x - x) * (a.z - z) - (a.x - x) * (c.z - z)) / area;
+                float w = 1.0f - u - v;
+                if (u < -1e-5f || v < -1e-5f || w < -1e-5f)
+                {
+                    continue;
+                }
+
+                float& height = m_heights[row * m_columns + column];
+                height = std::max(height, u * a.y + v * b.y + w * c.y);
+            }
+        }
+    }
+}
+
+float ParticleHeightfield::Height(float x, float z) const
+{
+    if (m_heights.empty())
+    {
+        return -FLT_MAX;
+    }
+
+    float gx = (x - m_originX) * m_inverseCellSize;
+    float gz = (z - m_originZ) * m_inverseCellSize;
+    if (gx < 0.0f || gz < 0.0f || gx >= m_columns - 1 || gz >= m_rows - 1)
+    {
+        return -FLT_MAX;
+    }
+
+    UINT column = static_cast<UINT>(gx);
+    UINT row = static_cast<UINT>(gz);
+    float fx = gx - column;
+    float fz = gz - row;
+
+    const float* h = &m_heights[row * m_columns + column];
+    float h00 = h[0];
+    float h10 = h[1];
+    float h01 = h[m_columns];
+    float h11 = h[m_columns + 1];
+
+    // at the terrain edge fall back to the highest known corner
+    if (h00 == -FLT_MAX || h10 == -FLT_MAX || h01 == -FLT_MAX || h11 == -FLT_MAX)
+    {
+        return std::max(std::max(h00, h10), std::max(h01, h11));
+    }
+
+    return (h00 * (1.0f - fx) + h10 * fx) * (1.0f - fz) + (h01 * (1.0f - fx) + h11 * fx) * fz;
+}
+
+#pragma endregion
+
+#pragma region ParticleSystem
+
+ParticleSystem::ParticleSystem() :
+    m_capacity(0),
+    m_count(0),
+    m_random(0x12345678u),
+    m_gravity(0.0f, 0.0f, 0.0f),
+    m_heightfield(nullptr),
+    m_jobs(nullptr)
+{
+}
+
+void ParticleSystem::Initialize(const Graphics& graphics, UINT capacity)
+{
+    m_capacity = capacity;
+    m_count = 0;
+
+    // padding lanes are integrated with the rest but never drawn or killed
+    UINT padded = (capacity + 3) & ~3u;
+    m_positionX.assign(padded, 0.0f);
+    m_positionY.assign(padded, 0.0f);
+    m_positionZ.assign(padded, 0.0f);
+    m_velocityX.assign(padded, 0.0f);
+    m_velocityY.assign(padded, 0.0f);
+    m_velocityZ.assign(padded, 0.0f);
+    m_age.assign(padded, 0.0f);
+    m_inverseLife.assign(padded, 0.0f);
+    m_drag.assign(padded, 0.0f);
+    m_emitter.assign(padded, 0);
+
+    m_quadVertices = nullptr;
+    m_quadIndices = nullptr;
+    m_instances = nullptr;
+
+    //
+    // instanced drawing needs feature level 9.3; below that the particles only simulate
+    //
+    if (graphics.GetDeviceFeatureLevel() < D3D_FEATURE_LEVEL_9_3 || capacity == 0)
+    {
+        return;
+    }
+
+    ID3D11Device* device = graphics.GetDevice();
+
+    const XMFLOAT2 corners[4] =
+    {
+        XMFLOAT2(-1.0f, -1.0f), XMFLOAT2(-1.0f, 1.0f), XMFLOAT2(1.0f, 1.0f), XMFLOAT2(1.0f, -1.0f)
+    };
+    const USHORT indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+    D3D11_BUFFER_DESC bufferDesc = { 0 };
+    D3D11_SUBRESOURCE_DATA initData = { 0 };
+
+    bufferDesc.ByteWidth = sizeof(corners);
+    bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    initData.pSysMem = corners;
+    DX::ThrowIfFailed(device->CreateBuffer(&bufferDesc, &initData, &m_quadVertices));
+
+    bufferDesc.ByteWidth = sizeof(indices);
+    bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    initData.pSysMem = indices;
+    DX::ThrowIfFailed(device->CreateBuffer(&bufferDesc, &initData, &m_quadIndices));
+
+    bufferDesc.ByteWidth = sizeof(ParticleInstance) * capacity;
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    DX::ThrowIfFailed(device->CreateBuffer(&bufferDesc, nullptr, &m_instances));
+
+    bufferDesc.ByteWidth = sizeof(ParticleConstants);
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    bufferDesc.CPUAccessFlags = 0;
+    DX::ThrowIfFailed(device->CreateBuffer(&bufferDesc, nullptr, &m_constants));
+
+    DX::ThrowIfFailed(device->CreateVertexShader(ParticleVS, sizeof(ParticleVS), nullptr, &m_vertexShader));
+    DX::ThrowIfFailed(device->CreatePixelShader(ParticlePS, sizeof(ParticlePS), nullptr, &m_pixelShader));
+
+    const D3D11_INPUT_ELEMENT_DESC layout[] =
+    {
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "TEXCOORD", 1, DXGI_FORMAT_R32_FLOAT, 1, 12, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    };
+    DX::ThrowIfFailed(device->CreateInputLayout(layout, ARRAYSIZE(layout), ParticleVS, sizeof(ParticleVS), &m_inputLayout));
+
+    //
+    // premultiplied blending, depth tested against the scene but not written
+    //
+    D3D11_BLEND_DESC blendDesc = { 0 };
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    DX::ThrowIfFailed(device->CreateBlendState(&blendDesc, &m_blendState));
+
+    D3D11_DEPTH_STENCIL_DESC depthDesc = { 0 };
+    depthDesc.DepthEnable = TRUE;
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+    DX::ThrowIfFailed(device->CreateDepthStencilState(&depthDesc, &m_depthState));
+}
+
+UINT ParticleSystem::AddEmitter(const ParticleEmitterDesc& desc)
+{
+    m_emitters.push_back(desc);
+    m_emitDebt.push_back(0.0f);
+    return static_cast<UINT>(m_emitters.size() - 1);
+}
+
+void ParticleSystem::Emit(UINT emitter, UINT count)
+{
+    Spawn(emitter, count);
+}
+
+float ParticleSystem::Random()
+{
+    // xorshift32, uniform in [0, 1)
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return (m_random >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::Spawn(UINT emitter, UINT count)
+{
+    count = std::min(count, m_capacity - m_count);
+    if (count == 0)
+    {
+        return;
+    }
+
+    const ParticleEmitterDesc& desc = m_emitters[emitter];
+
+    //
+    // orthonormal basis around the emission axis for sampling the cone
+    //
+    XMVECTOR axis = XMVector3Normalize(XMLoadFloat3(&desc.Direction));
+    XMVECTOR helper = std::fabs(XMVectorGetY(axis)) < 0.99f ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+    XMVECTOR tangent = XMVector3Normalize(XMVector3Cross(helper, axis));
+    XMVECTOR bitangent = XMVector3Cross(axis, tangent);
+    float cosSpread = std::cos(desc.Spread);
+
+    for (UINT n = 0; n < count; n++)
+    {
+        UINT i = m_count++;
+
+        float cosTheta = 1.0f - Random() * (1.0f - cosSpread);
+        float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+        float phi = XM_2PI * Random();
+        float speed = desc.SpeedMin + (desc.SpeedMax - desc.SpeedMin) * Random();
+        float life = desc.LifeMin + (desc.LifeMax - desc.LifeMin) * Random();
+
+        XMVECTOR direction = axis * cosTheta + tangent * (sinTheta * std::cos(phi)) + bitangent * (sinTheta * std::sin(phi));
+        XMFLOAT3 velocity;
+        XMStoreFloat3(&velocity, direction * speed);
+
+        m_positionX[i] = desc.Position.x;
+        m_positionY[i] = desc.Position.y;
+        m_positionZ[i] = desc.Position.z;
+        m_velocityX[i] = velocity.x;
+        m_velocityY[i] = velocity.y;
+        m_velocityZ[i] = velocity.z;
+        m_age[i] = 0.0f;
+        m_inverseLife[i] = 1.0f / std::max(life, 1e-3f);
+        m_drag[i] = desc.Drag;
+        m_emitter[i] = static_cast<USHORT>(emitter);
+    }
+}
+
+void ParticleSystem::Integrate(UINT begin, UINT end, float timeDelta)
+{
+    const XMVECTOR dt = XMVectorReplicate(timeDelta);
+    const XMVECTOR one = XMVectorReplicate(1.0f);
+    const XMVECTOR gravityX = XMVectorReplicate(m_gravity.x * timeDelta);
+    const XMVECTOR gravityY = XMVectorReplicate(m_gravity.y * timeDelta);
+    const XMVECTOR gravityZ = XMVectorReplicate(m_gravity.z * timeDelta);
+
+    for (UINT i = begin; i < end; i += 4)
+    {
+        XMVECTOR damping = XMVectorMax(XMVectorZero(), XMVectorSubtract(one, XMVectorMultiply(Load4(&m_drag[i]), dt)));
+
+        XMVECTOR vx = XMVectorMultiply(XMVectorAdd(Load4(&m_velocityX[i]), gravityX), damping);
+        XMVECTOR vy = XMVectorMultiply(XMVectorAdd(Load4(&m_velocityY[i]), gravityY), damping);
+        XMVECTOR vz = XMVectorMultiply(XMVectorAdd(Load4(&m_velocityZ[i]), gravityZ), damping);
+
+        Store4(&m_velocityX[i], vx);
+        Store4(&m_velocityY[i], vy);
+        Store4(&m_velocityZ[i], vz);
+        Store4(&m_positionX[i], XMVectorMultiplyAdd(vx, dt, Load4(&m_positionX[i])));
+        Store4(&m_positionY[i], XMVectorMultiplyAdd(vy, dt, Load4(&m_positionY[i])));
+        Store4(&m_positionZ[i], XMVectorMultiplyAdd(vz, dt, Load4(&m_positionZ[i])));
+        Store4(&m_age[i], XMVectorAdd(Load4(&m_age[i]), dt));
+    }
+}
+
+void ParticleSystem::Collide(UINT begin, UINT end)
+{
+    for (UINT i = begin; i < end; i++)
+    {
+        float height = m_heightfield->Height(m_positionX[i], m_positionZ[i]);
+        if (m_positionY[i] >= height)
+        {
+            continue;
+        }
+
+        m_positionY[i] = height;
+        if (m_velocityY[i] < 0.0f)
+        {
+            m_velocityY[i] = -m_velocityY[i] * m_emitters[m_emitter[i]].Restitution;
+        }
+        m_velocityX[i] *= CollisionFriction;
+        m_velocityZ[i] *= CollisionFriction;
+    }
+}
+
+void ParticleSystem::Compact()
+{
+    UINT i = 0;
+    while (i < m_count)
+    {
+        if (m_age[i] * m_inverseLife[i] < 1.0f)
+        {
+            i++;
+            continue;
+        }
+
+        // move the last live particle into the hole and test it next
+        UINT last = --m_count;
+        m_positionX[i] = m_positionX[last];
+        m_positionY[i] = m_positionY[last];
+        m_positionZ[i] = m_positionZ[last];
+        m_velocityX[i] = m_velocityX[last];
+        m_velocityY[i] = m_velocityY[last];
+        m_velocityZ[i] = m_velocityZ[last];
+        m_age[i] = m_age[last];
+        m_inverseLife[i] = m_inverseLife[last];
+        m_drag[i] = m_drag[last];
+        m_emitter[i] = m_emitter[last];
+    }
+}
+
+void ParticleSystem::Update(float timeDelta)
+{
+    if (timeDelta <= 0.0f || m_capacity == 0)
+    {
+        return;
+    }
+
+    for (UINT e = 0; e < m_emitters.size(); e++)
+    {
+        m_emitDebt[e] += m_emitters[e].Rate * timeDelta;
+        UINT count = static_cast<UINT>(m_emitDebt[e]);
+        m_emitDebt[e] -= count;
+        Spawn(e, count);
+    }
+
+    UINT padded = (m_count + 3) & ~3u;
+    const bool collide = m_heightfield != nullptr && m_heightfield->IsValid();
+
+    if (m_jobs != nullptr && m_count >= 2 * ParallelBatchSize)
+    {
+        UINT batches = (padded + ParallelBatchSize - 1) / ParallelBatchSize;
+        m_jobs->ParallelFor(0, batches, 1, [this, padded, collide, timeDelta](UINT firstBatch, UINT lastBatch)
+        {
+            UINT begin = firstBatch * ParallelBatchSize;
+            UINT end = std::min(lastBatch * ParallelBatchSize, padded);
+
+            Integrate(begin, end, timeDelta);
+            if (collide)
+            {
+                Collide(begin, std::min(end, m_count));
+            }
+        });
+    }
+    else
+    {
+        Integrate(0, padded, timeDelta);
+        if (collide)
+        {
+            Collide(0, m_count);
+        }
+    }
+
+    Compact();
+}
+
+void ParticleSystem::Render(const Graphics& graphics)
+{
+    if (m_count == 0 || m_instances == nullptr)
+    {
+        return;
+    }
+
+    ID3D11DeviceContext* deviceContext = graphics.GetDeviceContext();
+
+    //
+    // write the instance data straight into the discarded buffer
+    //
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(deviceContext->Map(m_instances.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+    {
+        return;
+    }
+
+    ParticleInstance* instances = static_cast<ParticleInstance*>(mapped.pData);
+    for (UINT i = 0; i < m_count; i++)
+    {
+        const ParticleEmitterDesc& desc = m_emitters[m_emitter[i]];
+        float t = std::min(m_age[i] * m_inverseLife[i], 1.0f);
+
+        float a = desc.ColorStart.w + (desc.ColorEnd.w - desc.ColorStart.w) * t;
+        float r = (desc.ColorStart.x + (desc.ColorEnd.x - desc.ColorStart.x) * t) * a;
+        float g = (desc.ColorStart.y + (desc.ColorEnd.y - desc.ColorStart.y) * t) * a;
+        float b = (desc.ColorStart.z + (desc.ColorEnd.z - desc.ColorStart.z) * t) * a;
+
+        ParticleInstance& instance = instances[i];
+        instance.Position = XMFLOAT3(m_positionX[i], m_positionY[i], m_positionZ[i]);
+        instance.Size = desc.SizeStart + (desc.SizeEnd - desc.SizeStart) * t;
+        instance.Color = PackColor(r, g, b, desc.Additive ? 0.0f : a);
+    }
+
+    deviceContext->Unmap(m_instances.Get(), 0);
+
+    //
+    // camera constants; the view matrix columns are the camera axes in world space
+    //
+    const Camera& camera = graphics.GetCamera();
+    XMFLOAT4X4 view;
+    XMStoreFloat4x4(&view, camera.GetView());
+
+    ParticleConstants constants;
+    XMStoreFloat4x4(&constants.WorldToProjected4x4, XMMatrixTranspose(camera.GetViewProjection()));
+    constants.CameraRight = XMFLOAT4(view._11, view._21, view._31, 0.0f);
+    constants.CameraUp = XMFLOAT4(view._12, view._22, view._32, 0.0f);
+    deviceContext->UpdateSubresource(m_constants.Get(), 0, nullptr, &constants, 0, 0);
+
+    ID3D11Buffer* vertexBuffers[2] = { m_quadVertices.Get(), m_instances.Get() };
+    UINT strides[2] = { sizeof(XMFLOAT2), sizeof(ParticleInstance) };
+    UINT offsets[2] = { 0, 0 };
+    deviceContext->IASetVertexBuffers(0, 2, vertexBuffers, strides, offsets);
+    deviceContext->IASetIndexBuffer(m_quadIndices.Get(), DXGI_FORMAT_R16_UINT, 0);
+    deviceContext->IASetInputLayout(m_inputLayout.Get());
+    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    ID3D11Buffer* constantBuffer = m_constants.Get();
+    deviceContext->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+    deviceContext->VSSetConstantBuffers(0, 1, &constantBuffer);
+    deviceContext->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+    deviceContext->OMSetBlendState(m_blendState.Get(), nullptr, 0xffffffff);
+    deviceContext->OMSetDepthStencilState(m_depthState.Get(), 0);
+
+    deviceContext->DrawIndexedInstanced(6, m_count, 0, 0, 0);
+
+    deviceContext->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+    deviceContext->OMSetDepthStencilState(nullptr, 0);
+}
+
+#pragma endregion
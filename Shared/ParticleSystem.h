@@ -0,0 +1,179 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+
+#include <wrl.h>
+#include <d3d11.h>
+#include <DirectXMath.h>
+
+#include "VSD3DStarter.h"
+#include "ContinuousCollision.h"
+#include "JobSystem.h"
+
+namespace VSD3DStarter
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Emission parameters. Particles leave Position inside a cone of half angle Spread around
+    // Direction, and their size and colour are interpolated over their life. Additive emitters
+    // add light (exhaust), the others are alpha blended (dust).
+    //
+    struct ParticleEmitterDesc
+    {
+        ParticleEmitterDesc() :
+            Position(0.0f, 0.0f, 0.0f),
+            Direction(0.0f, 1.0f, 0.0f),
+            Spread(0.3f),
+            SpeedMin(0.5f),
+            SpeedMax(1.0f),
+            LifeMin(0.5f),
+            LifeMax(1.0f),
+            Rate(0.0f),
+            SizeStart(0.05f),
+            SizeEnd(0.1f),
+            ColorStart(1.0f, 1.0f, 1.0f, 1.0f),
+            ColorEnd(1.0f, 1.0f, 1.0f, 0.0f),
+            Drag(0.0f),
+            Restitution(0.3f),
+            Additive(false)
+        {
+        }
+
+        DirectX::XMFLOAT3 Position;
+        DirectX::XMFLOAT3 Direction;
+        float Spread;                   // radians
+        float SpeedMin;
+        float SpeedMax;
+        float LifeMin;                  // seconds
+        float LifeMax;
+        float Rate;                     // particles per second, 0 for bursts only
+        float SizeStart;
+        float SizeEnd;
+        DirectX::XMFLOAT4 ColorStart;
+        DirectX::XMFLOAT4 ColorEnd;
+        float Drag;                     // fraction of velocity lost per second
+        float Restitution;              // vertical bounce kept on hitting the terrain
+        bool Additive;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // ParticleHeightfield samples the top surface of a collider on a regular x/z grid so
+    // particles can collide with terrain at the cost of one bilinear lookup.
+    //
+    class ParticleHeightfield
+    {
+    public:
+        ParticleHeightfield() : m_originX(0.0f), m_originZ(0.0f), m_inverseCellSize(0.0f), m_columns(0), m_rows(0) { }
+
+        void Initialize(const Physics::TriangleMeshCollider& collider, UINT resolution);
+
+        //
+        // terrain height below (x, z), or -FLT_MAX where the grid holds no terrain
+        //
+        float Height(float x, float z) const;
+
+        bool IsValid() const { return !m_heights.empty(); }
+
+    private:
+        std::vector<float> m_heights;   // row major, m_columns * m_rows
+        float m_originX;
+        float m_originZ;
+        float m_inverseCellSize;
+        UINT m_columns;
+        UINT m_rows;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // ParticleSystem keeps a fixed pool of particles as separate arrays per attribute, so the
+    // update runs four particles per SIMD instruction. Dead particles are replaced by the last
+    // live one, keeping the live range packed for the integrator and for the instance buffer
+    // each camera-facing quad is drawn from.
+    //
+    class ParticleSystem
+    {
+    public:
+        ParticleSystem();
+
+        void Initialize(const Graphics& graphics, UINT capacity);
+
+        UINT AddEmitter(const ParticleEmitterDesc& desc);
+        ParticleEmitterDesc& Emitter(UINT emitter) { return m_emitters[emitter]; }
+
+        //
+        // spawns count particles at once; particles beyond the pool capacity are dropped
+        //
+        void Emit(UINT emitter, UINT count);
+
+        void SetGravity(const DirectX::XMFLOAT3& gravity) { m_gravity = gravity; }
+        void SetHeightfield(const ParticleHeightfield* heightfield) { m_heightfield = heightfield; }
+
+        //
+        // splits large updates across the workers of jobs; null updates on the calling thread
+        //
+        void SetJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+
+        void Update(float timeDelta);
+        void Render(const Graphics& graphics);
+        void Clear() { m_count = 0; }
+
+        UINT Count() const { return m_count; }
+        UINT Capacity() const { return m_capacity; }
+
+    private:
+        static const UINT ParallelBatchSize = 16384;
+
+        struct ParticleInstance
+        {
+            DirectX::XMFLOAT3 Position;
+            float Size;
+            UINT Color;                 // premultiplied R8G8B8A8, alpha 0 for additive
+        };
+
+        void Spawn(UINT emitter, UINT count);
+        void Integrate(UINT begin, UINT end, float timeDelta);
+        void Collide(UINT begin, UINT end);
+        void Compact();
+        float Random();
+
+        UINT m_capacity;
+        UINT m_count;
+        UINT m_random;
+        DirectX::XMFLOAT3 m_gravity;
+        const ParticleHeightfield* m_heightfield;
+        JobSystem* m_jobs;
+
+        // one entry per particle, padded to a multiple of four
+        std::vector<float> m_positionX;
+        std::vector<float> m_positionY;
+        std::vector<float> m_positionZ;
+        std::vector<float> m_velocityX;
+        std::vector<float> m_velocityY;
+        std::vector<float> m_velocityZ;
+        std::vector<float> m_age;
+        std::vector<float> m_inverseLife;
+        std::vector<float> m_drag;
+        std::vector<USHORT> m_emitter;
+
+        std::vector<ParticleEmitterDesc> m_emitters;
+        std::vector<float> m_emitDebt;  // fractional particles carried between updates
+
+        Microsoft::WRL::ComPtr<ID3D11Buffer> m_quadVertices;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> m_quadIndices;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> m_instances;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> m_constants;
+        Microsoft::WRL::ComPtr<ID3D11InputLayout> m_inputLayout;
+        Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vertexShader;
+        Microsoft::WRL::ComPtr<ID3D11PixelShader> m_pixelShader;
+        Microsoft::WRL::ComPtr<ID3D11BlendState> m_blendState;
+        Microsoft::WRL::ComPtr<ID3D11DepthStencilState> m_depthState;
+    };
+}
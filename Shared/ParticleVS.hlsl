@@ -0,0 +1,45 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+//
+// Expands one instanced quad corner per particle into a camera-facing sprite.
+//
+
+cbuffer ParticleVars : register(b0)
+{
+    float4x4 WorldToProjected4x4;
+    float4 CameraRight;
+    float4 CameraUp;
+};
+
+struct A2V
+{
+    float2 corner : TEXCOORD0;      // per vertex, -1..1
+    float3 position : POSITION0;    // per instance
+    float size : TEXCOORD1;
+    float4 color : COLOR0;
+};
+
+struct V2P
+{
+    float4 pos : SV_POSITION;
+    float4 color : COLOR0;
+    float2 uv : TEXCOORD0;
+};
+
+V2P main(A2V input)
+{
+    V2P result;
+
+    float3 wp = input.position + (CameraRight.xyz * input.corner.x + CameraUp.xyz * input.corner.y) * input.size;
+
+    result.pos = mul(float4(wp, 1.0f), WorldToProjected4x4);
+    result.color = input.color;
+    result.uv = input.corner;
+
+    return result;
+}
@@ -0,0 +1,121 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ContinuousCollision.h"
+#include "RayBatch.h"
+
+using namespace DirectX;
+
+using namespace VSD3DStarter;
+using namespace Physics;
+
+UINT Physics::RaycastMeshes(const BatchRay* rays, UINT rayCount,
+    Mesh* const* meshes, const XMFLOAT4X4* worldTransforms, UINT objectCount,
+    LocalRay* scratch, BatchRayHit* hits)
+{
+    for (UINT r = 0; r < rayCount; r++)
+    {
+        hits[r].Distance = rays[r].MaxDistance;
+        hits[r].Object = RayBatchNoHit;
+        hits[r].Triangle = 0;
+    }
+
+    for (UINT o = 0; o < objectCount; o++)
+    {
+        XMMATRIX world = XMLoadFloat4x4(&worldTransforms[o]);
+        XMVECTOR determinant;
+        XMMATRIX inverse = XMMatrixInverse(&determinant, world);
+        if (std::fabs(XMVectorGetX(determinant)) < 1e-20f)
+        {
+            continue;
+        }
+
+        //
+        // bounding sphere in world space; the radius grows with the largest axis scale
+        //
+        Mesh::MeshExtents& extents = meshes[o]->Extents();
+        XMVECTOR center = XMVector3TransformCoord(XMVectorSet(extents.CenterX, extents.CenterY, extents.CenterZ, 1.0f), world);
+        XMVECTOR scale = XMVectorMax(XMVector3LengthSq(world.r[0]), XMVectorMax(XMVector3LengthSq(world.r[1]), XMVector3LengthSq(world.r[2])));
+        float radius = extents.Radius * std::sqrt(XMVectorGetX(scale));
+
+        // rays reaching the sphere within their current closest hit, moved into model space
+        UINT active = 0;
+        for (UINT r = 0; r < rayCount; r++)
+        {
+            XMVECTOR origin = XMLoadFloat3(&rays[r].Origin);
+            XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&rays[r].Direction));
+            float length = hits[r].Distance;
+
+            // segment-sphere test, and the segment need not reach past the sphere
+            float projection = XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, origin), direction));
+            float along = std::min(std::max(projection, 0.0f), length);
+            XMVECTOR closest = XMVectorMultiplyAdd(direction, XMVectorReplicate(along), origin);
+            if (XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(center, closest))) > radius * radius)
+            {
+                continue;
+            }
+
+            length = std::min(length, projection + radius);
+            if (length <= 0.0f)
+            {
+                continue;
+            }
+
+            LocalRay& local = scratch[active++];
+            XMStoreFloat3(&local.Origin, XMVector3TransformCoord(origin, inverse));
+            XMStoreFloat3(&local.Motion, XMVector3TransformNormal(XMVectorScale(direction, length), inverse));
+            local.Length = length;
+            local.Ray = r;
+        }
+
+        if (active == 0)
+        {
+            continue;
+        }
+
+        //
+        // each triangle is loaded once and tested against every ray that is left
+        //
+        const Mesh::TriangleCollection& triangles = meshes[o]->Triangles();
+        for (UINT t = 0; t < triangles.size(); t++)
+        {
+            XMVECTOR v0 = XMLoadFloat3(&triangles[t].points[0]);
+            XMVECTOR v1 = XMLoadFloat3(&triangles[t].points[1]);
+            XMVECTOR v2 = XMLoadFloat3(&triangles[t].points[2]);
+
+            for (UINT i = 0; i < active; i++)
+            {
+                const LocalRay& local = scratch[i];
+                BatchRayHit& best = hits[local.Ray];
+
+                SweepHit hit;
+                if (RaycastTriangle(XMLoadFloat3(&local.Origin), XMLoadFloat3(&local.Motion), v0, v1, v2, std::min(best.Distance / local.Length, 1.0f), hit))
+                {
+                    best.Distance = hit.Time * local.Length;
+                    best.Object = o;
+                    best.Triangle = t;
+                }
+            }
+        }
+    }
+
+    UINT hitCount = 0;
+    for (UINT r = 0; r < rayCount; r++)
+    {
+        if (hits[r].Object != RayBatchNoHit)
+        {
+            hitCount++;
+        }
+    }
+
+    return hitCount;
+}
@@ -0,0 +1,60 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <DirectXMath.h>
+
+#include "VSD3DStarter.h"
+
+namespace Physics
+{
+    //
+    // a world-space ray; Direction need not be normalized, distances are measured along it
+    // as if it were
+    //
+    struct BatchRay
+    {
+        DirectX::XMFLOAT3 Origin;
+        DirectX::XMFLOAT3 Direction;
+        float MaxDistance;
+    };
+
+    //
+    // closest hit of one ray; Object is RayBatchNoHit when nothing was hit
+    //
+    struct BatchRayHit
+    {
+        float Distance;
+        UINT Object;
+        UINT Triangle;
+    };
+
+    static const UINT RayBatchNoHit = 0xffffffff;
+
+    //
+    // a ray moved into one object's model space: the segment Origin..Origin+Motion covers
+    // Length world units of the ray, so hit fractions scale straight back to world distances
+    //
+    struct LocalRay
+    {
+        DirectX::XMFLOAT3 Origin;
+        DirectX::XMFLOAT3 Motion;
+        float Length;
+        UINT Ray;
+    };
+
+    //
+    // Casts every ray against every mesh placed by its world transform and keeps the closest
+    // hit per ray in hits. Each transform is inverted once for the whole batch, and rays
+    // that miss an object's bounding sphere never see its triangles. scratch must hold
+    // rayCount entries; nothing is allocated. Returns the number of rays that hit.
+    //
+    UINT RaycastMeshes(const BatchRay* rays, UINT rayCount,
+        VSD3DStarter::Mesh* const* meshes, const DirectX::XMFLOAT4X4* worldTransforms, UINT objectCount,
+        LocalRay* scratch, BatchRayHit* hits);
+}
@@ -0,0 +1,247 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <wrl/client.h>
+
+namespace VSD3DStarter
+{
+    //
+    // 64-bit FNV-1a of a resource name; registries key on this instead of the string
+    //
+    inline std::uint64_t HashResourceName(const std::wstring& name)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (wchar_t c : name)
+        {
+            hash ^= static_cast<std::uint64_t>(c);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    //
+    // A slot in a registry plus the generation it had when the handle was made. The slot
+    // index stays the same for as long as the resource lives, so it can go into sort keys;
+    // once the resource is freed the slot's generation moves on and old handles resolve to
+    // null rather than to whatever reuses the slot.
+    //
+    struct ResourceHandle
+    {
+        ResourceHandle() : Index(0), Generation(0) {}
+        ResourceHandle(std::uint32_t index, std::uint32_t generation) : Index(index), Generation(generation) {}
+
+        bool IsNull() const { return Generation == 0; }
+        bool operator==(const ResourceHandle& other) const { return Index == other.Index && Generation == other.Generation; }
+        bool operator!=(const ResourceHandle& other) const { return !(*this == other); }
+
+        std::uint32_t Index;
+        std::uint32_t Generation;       // 0 for no resource
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // ResourceRegistry keeps COM resources in slots looked up by name hash. Each resource is
+    // freed when its last counted reference goes; one nothing has referenced yet stays until
+    // Clear. Not thread safe; use it from the rendering thread.
+    //
+    template <class T>
+    class ResourceRegistry
+    {
+    public:
+        ResourceRegistry() {}
+
+        ResourceHandle Find(std::uint64_t nameHash) const
+        {
+            auto iter = m_names.find(nameHash);
+            return (iter != m_names.end()) ? ResourceHandle(iter->second, m_slots[iter->second].Generation) : ResourceHandle();
+        }
+
+        //
+        // registers resource under nameHash, taking a COM reference to it
+        //
+        ResourceHandle Add(std::uint64_t nameHash, T* resource)
+        {
+            std::uint32_t index;
+            if (!m_free.empty())
+            {
+                index = m_free.back();
+                m_free.pop_back();
+            }
+            else
+            {
+                index = static_cast<std::uint32_t>(m_slots.size());
+                m_slots.push_back(Slot());
+            }
+
+            Slot& slot = m_slots[index];
+            slot.Resource = resource;
+            slot.NameHash = nameHash;
+            slot.References = 0;
+            slot.Live = true;
+            m_names[nameHash] = index;
+
+            return ResourceHandle(index, slot.Generation);
+        }
+
+        bool IsValid(ResourceHandle handle) const
+        {
+            return handle.Index < m_slots.size() && m_slots[handle.Index].Live && m_slots[handle.Index].Generation == handle.Generation;
+        }
+
+        T* Get(ResourceHandle handle) const
+        {
+            return IsValid(handle) ? m_slots[handle.Index].Resource.Get() : nullptr;
+        }
+
+        void AddRef(ResourceHandle handle)
+        {
+            if (IsValid(handle))
+            {
+                m_slots[handle.Index].References++;
+            }
+        }
+
+        void Release(ResourceHandle handle)
+        {
+            if (IsValid(handle) && --m_slots[handle.Index].References == 0)
+            {
+                Free(handle.Index);
+            }
+        }
+
+        std::uint32_t Count() const { return static_cast<std::uint32_t>(m_slots.size() - m_free.size()); }
+
+        //
+        // frees every resource; handles still held resolve to null from here on
+        //
+        void Clear()
+        {
+            for (std::uint32_t index = 0; index < m_slots.size(); index++)
+            {
+                if (m_slots[index].Live)
+                {
+                    Free(index);
+                }
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            Slot() : NameHash(0), Generation(1), References(0), Live(false) {}
+
+            Microsoft::WRL::ComPtr<T> Resource;
+            std::uint64_t NameHash;
+            std::uint32_t Generation;
+            std::uint32_t References;
+            bool Live;
+        };
+
+        ResourceRegistry(const ResourceRegistry&);
+        ResourceRegistry& operator=(const ResourceRegistry&);
+
+        void Free(std::uint32_t index)
+        {
+            Slot& slot = m_slots[index];
+
+            auto iter = m_names.find(slot.NameHash);
+            if (iter != m_names.end() && iter->second == index)
+            {
+                m_names.erase(iter);
+            }
+
+            slot.Resource = nullptr;
+            slot.Live = false;
+            slot.References = 0;
+            slot.Generation = (slot.Generation == UINT32_MAX) ? 1 : slot.Generation + 1;
+            m_free.push_back(index);
+        }
+
+        std::vector<Slot> m_slots;
+        std::vector<std::uint32_t> m_free;
+        std::unordered_map<std::uint64_t, std::uint32_t> m_names;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // ResourceReference is a counted handle into a registry, copied and compared as integers
+    // and resolved with Get much as a ComPtr would be. A default constructed one is null.
+    //
+    template <class T>
+    class ResourceReference
+    {
+    public:
+        ResourceReference() : m_registry(nullptr) {}
+
+        ResourceReference(ResourceRegistry<T>* registry, ResourceHandle handle) :
+            m_registry(registry),
+            m_handle(handle)
+        {
+            if (m_registry != nullptr)
+            {
+                m_registry->AddRef(m_handle);
+            }
+        }
+
+        ResourceReference(const ResourceReference& other) :
+            m_registry(other.m_registry),
+            m_handle(other.m_handle)
+        {
+            if (m_registry != nullptr)
+            {
+                m_registry->AddRef(m_handle);
+            }
+        }
+
+        ~ResourceReference()
+        {
+            Reset();
+        }
+
+        ResourceReference& operator=(const ResourceReference& other)
+        {
+            if (m_registry != other.m_registry || m_handle != other.m_handle)
+            {
+                ResourceReference copy(other);
+                std::swap(m_registry, copy.m_registry);
+                std::swap(m_handle, copy.m_handle);
+            }
+
+            return *this;
+        }
+
+        void Reset()
+        {
+            if (m_registry != nullptr)
+            {
+                m_registry->Release(m_handle);
+            }
+
+            m_registry = nullptr;
+            m_handle = ResourceHandle();
+        }
+
+        T* Get() const { return (m_registry != nullptr) ? m_registry->Get(m_handle) : nullptr; }
+        ResourceHandle Handle() const { return m_handle; }
+
+        bool operator==(const ResourceReference& other) const { return m_registry == other.m_registry && m_handle == other.m_handle; }
+        bool operator!=(const ResourceReference& other) const { return !(*this == other); }
+
+    private:
+        ResourceRegistry<T>* m_registry;
+        ResourceHandle m_handle;
+    };
+}
@@ -0,0 +1,312 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "SceneQuery.h"
+
+using namespace DirectX;
+
+using namespace VSD3DStarter;
+using namespace Physics;
+
+namespace
+{
+    inline Aabb EmptyBounds()
+    {
+        Aabb bounds;
+        bounds.Min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+        bounds.Max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        return bounds;
+    }
+
+    inline void Merge(Aabb& bounds, const Aabb& other)
+    {
+        XMStoreFloat3(&bounds.Min, XMVectorMin(XMLoadFloat3(&bounds.Min), XMLoadFloat3(&other.Min)));
+        XMStoreFloat3(&bounds.Max, XMVectorMax(XMLoadFloat3(&bounds.Max), XMLoadFloat3(&other.Max)));
+    }
+
+    //
+    // bounds of a local box after an affine transform: the centre moves with the transform and
+    // the half extents are spread by the absolute values of the rotation and scale
+    //
+    Aabb XM_CALLCONV TransformBounds(const Aabb& local, FXMMATRIX world)
+    {
+        XMVECTOR localMin = XMLoadFloat3(&local.Min);
+        XMVECTOR localMax = XMLoadFloat3(&local.Max);
+        XMVECTOR center = XMVector3TransformCoord(XMVectorScale(XMVectorAdd(localMin, localMax), 0.5f), world);
+        XMVECTOR half = XMVectorScale(XMVectorSubtract(localMax, localMin), 0.5f);
+
+        XMVECTOR extent = XMVectorMultiply(XMVectorSplatX(half), XMVectorAbs(world.r[0]));
+        extent = XMVectorMultiplyAdd(XMVectorSplatY(half), XMVectorAbs(world.r[1]), extent);
+        extent = XMVectorMultiplyAdd(XMVectorSplatZ(half), XMVectorAbs(world.r[2]), extent);
+
+        Aabb bounds;
+        XMStoreFloat3(&bounds.Min, XMVectorSubtract(center, extent));
+        XMStoreFloat3(&bounds.Max, XMVectorAdd(center, extent));
+        return bounds;
+    }
+
+    //
+    // slab test against a ray with precomputed reciprocal direction; entry distance on a hit
+    //
+    inline bool RayBox(const float origin[3], const float inverseDirection[3], const Aabb& box, float maxDistance, float& entry)
+    {
+        const float* lo = &box.Min.x;
+        const float* hi = &box.Max.x;
+
+        float tMin = 0.0f;
+        float tMax = maxDistance;
+        for (UINT i = 0; i < 3; i++)
+        {
+            float t0 = (lo[i] - origin[i]) * inverseDirection[i];
+            float t1 = (hi[i] - origin[i]) * inverseDirection[i];
+            tMin = std::max(tMin, std::min(t0, t1));
+            tMax = std::min(tMax, std::max(t0, t1));
+        }
+
+        entry = tMin;
+        return tMin <= tMax;
+    }
+}
+
+void SceneQuery::Clear()
+{
+    m_instances.clear();
+    m_order.clear();
+    m_nodes.clear();
+    m_needsBuild = false;
+    m_needsRefit = false;
+}
+
+UINT SceneQuery::AddInstance(const TriangleMeshCollider* shape, UINT entity, CXMMATRIX world)
+{
+    Instance instance;
+    instance.Shape = shape;
+    instance.Entity = entity;
+    instance.Enabled = true;
+    shape->GetBounds(instance.LocalBounds.Min, instance.LocalBounds.Max);
+    m_instances.push_back(instance);
+
+    UINT index = static_cast<UINT>(m_instances.size() - 1);
+    SetTransform(index, world);
+    m_needsBuild = true;
+    return index;
+}
+
+void XM_CALLCONV SceneQuery::SetTransform(UINT instance, FXMMATRIX world)
+{
+    Instance& target = m_instances[instance];
+    XMStoreFloat4x4(&target.InverseWorld, XMMatrixInverse(nullptr, world));
+    target.WorldBounds = TransformBounds(target.LocalBounds, world);
+    m_needsRefit = true;
+}
+
+void SceneQuery::Update()
+{
+    if (m_needsBuild)
+    {
+        m_order.resize(m_instances.size());
+        for (UINT i = 0; i < m_order.size(); i++)
+        {
+            m_order[i] = i;
+        }
+
+        m_nodes.clear();
+        if (!m_instances.empty())
+        {
+            m_nodes.reserve(2 * m_instances.size());
+            m_nodes.resize(1);
+            BuildNode(0, 0, static_cast<UINT>(m_instances.size()), 0);
+        }
+    }
+    else if (m_needsRefit)
+    {
+        Refit();
+    }
+
+    m_needsBuild = false;
+    m_needsRefit = false;
+}
+
+void SceneQuery::BuildNode(UINT node, UINT first, UINT count, UINT depth)
+{
+    Aabb bounds = EmptyBounds();
+    Aabb centers = EmptyBounds();
+    for (UINT i = first; i < first + count; i++)
+    {
+        const Aabb& instance = m_instances[m_order[i]].WorldBounds;
+        Merge(bounds, instance);
+
+        Aabb center;
+        XMStoreFloat3(&center.Min, XMVectorScale(XMVectorAdd(XMLoadFloat3(&instance.Min), XMLoadFloat3(&instance.Max)), 0.5f));
+        center.Max = center.Min;
+        Merge(centers, center);
+    }
+
+    m_nodes[node].Bounds = bounds;
+    if (count <= LeafSize || depth + 1 >= MaxDepth)
+    {
+        m_nodes[node].First = first;
+        m_nodes[node].Count = count;
+        return;
+    }
+
+    //
+    // median split along the longest axis of the instance centres
+    //
+    XMFLOAT3 extent;
+    XMStoreFloat3(&extent, XMVectorSubtract(XMLoadFloat3(&centers.Max), XMLoadFloat3(&centers.Min)));
+    UINT axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+
+    auto center = [this, axis] (UINT instance) -> float
+    {
+        const Aabb& bounds = m_instances[instance].WorldBounds;
+        return (&bounds.Min.x)[axis] + (&bounds.Max.x)[axis];
+    };
+
+    UINT half = count / 2;
+    std::nth_element(m_order.begin() + first, m_order.begin() + first + half, m_order.begin() + first + count,
+        [&center] (UINT a, UINT b) { return center(a) < center(b); });
+
+    UINT left = static_cast<UINT>(m_nodes.size());
+    m_nodes.resize(left + 2);
+    m_nodes[node].First = left;
+    m_nodes[node].Count = 0;
+
+    BuildNode(left, first, half, depth + 1);
+    BuildNode(left + 1, first + half, count - half, depth + 1);
+}
+
+void SceneQuery::Refit()
+{
+    // children follow their parents, so a backwards pass sees them first
+    for (size_t i = m_nodes.size(); i-- > 0; )
+    {
+        Node& node = m_nodes[i];
+        node.Bounds = EmptyBounds();
+        if (node.Count == 0)
+        {
+            Merge(node.Bounds, m_nodes[node.First].Bounds);
+            Merge(node.Bounds, m_nodes[node.First + 1].Bounds);
+        }
+        else
+        {
+            for (UINT j = node.First; j < node.First + node.Count; j++)
+            {
+                Merge(node.Bounds, m_instances[m_order[j]].WorldBounds);
+            }
+        }
+    }
+}
+
+bool XM_CALLCONV SceneQuery::Raycast(FXMVECTOR origin, FXMVECTOR direction, float maxDistance, SceneHit& hit) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    XMVECTOR unitDirection = XMVector3Normalize(direction);
+
+    float o[3] = { XMVectorGetX(origin), XMVectorGetY(origin), XMVectorGetZ(origin) };
+    float d[3] = { XMVectorGetX(unitDirection), XMVectorGetY(unitDirection), XMVectorGetZ(unitDirection) };
+    float inverseDirection[3];
+    for (UINT i = 0; i < 3; i++)
+    {
+        // a huge reciprocal keeps the slab test valid for axis-parallel rays
+        inverseDirection[i] = 1.0f / ((std::fabs(d[i]) < 1e-20f) ? 1e-20f : d[i]);
+    }
+
+    UINT stack[2 * MaxDepth];
+    UINT stackSize = 0;
+    stack[stackSize++] = 0;
+
+    bool found = false;
+    float best = maxDistance;
+
+    while (stackSize > 0)
+    {
+        const Node& node = m_nodes[stack[--stackSize]];
+
+        float entry;
+        if (!RayBox(o, inverseDirection, node.Bounds, best, entry))
+        {
+            continue;
+        }
+
+        if (node.Count == 0)
+        {
+            // push the farther child first so the nearer one is searched first
+            float leftEntry = FLT_MAX;
+            float rightEntry = FLT_MAX;
+            bool left = RayBox(o, inverseDirection, m_nodes[node.First].Bounds, best, leftEntry);
+            bool right = RayBox(o, inverseDirection, m_nodes[node.First + 1].Bounds, best, rightEntry);
+            UINT nearChild = (leftEntry <= rightEntry) ? node.First : node.First + 1;
+            UINT farChild = (leftEntry <= rightEntry) ? node.First + 1 : node.First;
+
+            if ((nearChild == node.First) ? right : left)
+            {
+                stack[stackSize++] = farChild;
+            }
+            if ((nearChild == node.First) ? left : right)
+            {
+                stack[stackSize++] = nearChild;
+            }
+            continue;
+        }
+
+        for (UINT i = node.First; i < node.First + node.Count; i++)
+        {
+            const Instance& instance = m_instances[m_order[i]];
+            if (!instance.Enabled)
+            {
+                continue;
+            }
+
+            //
+            // the hit fraction along the segment is the same in local and world space
+            //
+            XMMATRIX inverseWorld = XMLoadFloat4x4(&instance.InverseWorld);
+            XMVECTOR motion = XMVectorScale(unitDirection, best);
+            XMVECTOR localStart = XMVector3TransformCoord(origin, inverseWorld);
+            XMVECTOR localMotion = XMVector3TransformNormal(motion, inverseWorld);
+
+            SweepHit candidate;
+            if (instance.Shape->Raycast(localStart, localMotion, candidate))
+            {
+                float distance = candidate.Time * best;
+
+                hit.Instance = m_order[i];
+                hit.Entity = instance.Entity;
+                hit.Triangle = candidate.Triangle;
+                hit.Distance = distance;
+                XMStoreFloat3(&hit.Point, XMVectorMultiplyAdd(unitDirection, XMVectorReplicate(distance), origin));
+                XMStoreFloat3(&hit.Normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&candidate.Normal), XMMatrixTranspose(inverseWorld))));
+
+                best = distance;
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+bool SceneQuery::Pick(const Camera& camera, UINT pixelX, UINT pixelY, SceneHit& hit) const
+{
+    XMFLOAT3 point;
+    XMFLOAT3 line;
+    camera.GetWorldLine(pixelX, pixelY, &point, &line);
+
+    XMVECTOR direction = XMLoadFloat3(&line);
+    return Raycast(XMLoadFloat3(&point), direction, XMVectorGetX(XMVector3Length(direction)), hit);
+}
@@ -0,0 +1,102 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "VSD3DStarter.h"
+#include "ContinuousCollision.h"
+#include "Broadphase.h"
+
+namespace Physics
+{
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // Closest hit of a scene ray query. Distance is measured along the normalized ray
+    // direction; Point and Normal are in world space.
+    //
+    struct SceneHit
+    {
+        UINT Instance;
+        UINT Entity;
+        UINT Triangle;
+        float Distance;
+        DirectX::XMFLOAT3 Point;
+        DirectX::XMFLOAT3 Normal;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // SceneQuery answers ray queries against every mesh instance in the scene. A small AABB
+    // tree over the instances' world bounds picks the instances a ray can reach, nearest
+    // first, and only those are asked to walk their own triangle tree, with the ray moved
+    // into the instance's local space. Moving instances only refit the tree's bounds.
+    //
+    class SceneQuery
+    {
+    public:
+        SceneQuery() : m_needsBuild(false), m_needsRefit(false) { }
+
+        void Clear();
+
+        //
+        // shape is kept by pointer and must outlive the query; entity is returned with hits
+        //
+        UINT AddInstance(const TriangleMeshCollider* shape, UINT entity, DirectX::CXMMATRIX world);
+        void XM_CALLCONV SetTransform(UINT instance, DirectX::FXMMATRIX world);
+        void SetEnabled(UINT instance, bool enabled) { m_instances[instance].Enabled = enabled; }
+
+        //
+        // rebuilds the tree after instances were added, or refits it after transforms changed;
+        // call before querying
+        //
+        void Update();
+
+        bool XM_CALLCONV Raycast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, SceneHit& hit) const;
+
+        //
+        // casts the ray through a pixel of the camera's viewport
+        //
+        bool Pick(const VSD3DStarter::Camera& camera, UINT pixelX, UINT pixelY, SceneHit& hit) const;
+
+        UINT InstanceCount() const { return static_cast<UINT>(m_instances.size()); }
+        const Aabb& WorldBounds(UINT instance) const { return m_instances[instance].WorldBounds; }
+
+    private:
+        struct Instance
+        {
+            const TriangleMeshCollider* Shape;
+            UINT Entity;
+            bool Enabled;
+            DirectX::XMFLOAT4X4 InverseWorld;
+            Aabb LocalBounds;
+            Aabb WorldBounds;
+        };
+
+        struct Node
+        {
+            Aabb Bounds;
+            UINT First;     // first child index, or first entry of m_order for a leaf
+            UINT Count;     // 0 for an inner node
+        };
+
+        static const UINT LeafSize = 2;
+        static const UINT MaxDepth = 32;
+
+        void BuildNode(UINT node, UINT first, UINT count, UINT depth);
+        void Refit();
+
+        std::vector<Instance> m_instances;
+        std::vector<UINT> m_order;                     // instance indices referenced by the leaves
+        std::vector<Node> m_nodes;                     // children always follow their parent
+        bool m_needsBuild;
+        bool m_needsRefit;
+    };
+}
@@ -0,0 +1,78 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <chrono>
+
+#include "SimulationThread.h"
+
+SimulationThread::SimulationThread() :
+    m_running(false),
+    m_resetRequested(false),
+    m_droppedSteps(0)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+    Stop();
+}
+
+void SimulationThread::Start(const StepFunction& step, double stepSeconds, unsigned int maxStepsPerFrame)
+{
+    Stop();
+
+    m_step = step;
+    m_stepper.Initialize(stepSeconds, maxStepsPerFrame);
+    m_clock.Reset();
+    m_resetRequested.store(false);
+    m_droppedSteps.store(0);
+
+    m_running.store(true);
+    m_thread = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop()
+{
+    m_running.store(false);
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    m_step = nullptr;
+}
+
+void SimulationThread::Run()
+{
+    while (m_running.load())
+    {
+        if (m_resetRequested.exchange(false))
+        {
+            m_clock.Reset();
+            m_stepper.Reset();
+        }
+
+        m_clock.Tick();
+        std::int64_t now = GameClock::Now();
+        unsigned int steps = m_stepper.Advance(m_clock.DeltaNanoseconds());
+
+        // the unsimulated remainder is the newest time, so the last step ends just before it
+        std::int64_t stepTime = now - m_stepper.AccumulatedNanoseconds() - (static_cast<std::int64_t>(steps) - 1) * m_stepper.StepNanoseconds();
+        for (unsigned int i = 0; i < steps && m_running.load(); i++)
+        {
+            m_step(m_stepper.SimulatedSeconds(), m_stepper.StepSeconds(), stepTime);
+            stepTime += m_stepper.StepNanoseconds();
+        }
+        m_droppedSteps.store(m_stepper.DroppedSteps(), std::memory_order_relaxed);
+
+        // sleep out the rest of the step; oversleeping only delays the next catch-up
+        std::int64_t wait = m_stepper.StepNanoseconds() - m_stepper.AccumulatedNanoseconds();
+        std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+    }
+}
@@ -0,0 +1,64 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "GameClock.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// SimulationThread calls a step function at a fixed rate on its own thread, independent of
+// how long frames take to render. Between steps it sleeps until the next one is due; after a
+// stall it catches up with at most MaxStepsPerFrame steps, like FixedStepAccumulator on the
+// render thread would. Each step is also given the GameClock::Now() time it stands for, so
+// catch-up steps can tell which input events happened before them.
+//
+class SimulationThread
+{
+public:
+    typedef std::function<void(double timeTotal, float timeDelta, std::int64_t stepTime)> StepFunction;
+
+    SimulationThread();
+    ~SimulationThread();
+
+    void Start(const StepFunction& step, double stepSeconds = 1.0 / 60.0, unsigned int maxStepsPerFrame = 8);
+
+    //
+    // waits for the step in progress and releases the step function
+    //
+    void Stop();
+
+    bool IsRunning() const { return m_running.load(); }
+
+    //
+    // restarts simulated time from zero before the next step
+    //
+    void ResetClock() { m_resetRequested.store(true); }
+
+    std::uint64_t DroppedSteps() const { return m_droppedSteps.load(std::memory_order_relaxed); }
+
+private:
+    SimulationThread(const SimulationThread&);
+    SimulationThread& operator=(const SimulationThread&);
+
+    void Run();
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_resetRequested;
+    std::atomic<std::uint64_t> m_droppedSteps;
+
+    // owned by the simulation thread while it runs
+    StepFunction m_step;
+    GameClock m_clock;
+    FixedStepAccumulator m_stepper;
+};
@@ -0,0 +1,348 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <numeric>
+#include <string.h>
+
+#include "TextureAtlas.h"
+
+using namespace DirectX;
+
+namespace
+{
+    //
+    // texels a block spans on each side, and its bytes; false for formats whose texels do
+    // not tile as blocks, which rect copies cannot move
+    //
+    bool BlockLayout(DXGI_FORMAT format, uint32_t& blockSize, size_t& blockBytes)
+    {
+        if (IsCompressed(format))
+        {
+            blockSize = 4;
+            blockBytes = BitsPerPixel(format) * 2;
+            return true;
+        }
+
+        switch (format)
+        {
+        case DXGI_FORMAT_R1_UNORM:
+        case DXGI_FORMAT_R8G8_B8G8_UNORM:
+        case DXGI_FORMAT_G8R8_G8B8_UNORM:
+            return false;
+
+        default:
+            break;
+        }
+
+        //
+        // the video formats, 100 to 114, are packed or planar
+        //
+        if (format >= 100 && format <= 114)
+        {
+            return false;
+        }
+
+        size_t bits = BitsPerPixel(format);
+        if (bits == 0 || bits % 8 != 0)
+        {
+            return false;
+        }
+
+        blockSize = 1;
+        blockBytes = bits / 8;
+        return true;
+    }
+
+    //
+    // parses 2D single-item sources sharing a format
+    //
+    DDSStatus ParseSources(const uint8_t* const* ddsData, const size_t* ddsDataSize, size_t count, std::vector<DDSTexture>& sources)
+    {
+        if (count == 0)
+        {
+            return DDS_INVALID_DATA;
+        }
+
+        sources.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            DDSStatus status = sources[i].Parse(ddsData[i], ddsDataSize[i]);
+            if (status != DDS_OK)
+            {
+                return status;
+            }
+
+            const DDSTexture& source = sources[i];
+            if (source.Dimension() != DDS_DIMENSION_TEXTURE2D || source.IsCubeMap() || source.ArraySize() != 1 ||
+                source.Format() != sources[0].Format())
+            {
+                return DDS_NOT_SUPPORTED;
+            }
+        }
+
+        return DDS_OK;
+    }
+
+    uint32_t MultipleOf(uint32_t value)
+    {
+        return value & (~value + 1);
+    }
+}
+
+uint32_t DirectX::AtlasAlignment(const DDSTexture& source)
+{
+    uint32_t blockSize;
+    size_t blockBytes;
+    if (source.Dimension() != DDS_DIMENSION_TEXTURE2D || source.IsCubeMap() || source.ArraySize() != 1 ||
+        !BlockLayout(source.Format(), blockSize, blockBytes))
+    {
+        return 0;
+    }
+
+    uint32_t alignment = std::min(MultipleOf(source.Width()), MultipleOf(source.Height()));
+    if (alignment < blockSize)
+    {
+        return 0;
+    }
+
+    uint32_t levels = source.MipCount() - 1;
+    return std::min(alignment, blockSize << std::min(levels, 16u));
+}
+
+bool DirectX::PackRectangles(uint32_t width, uint32_t height, uint32_t alignment, std::vector<AtlasRect>& rects)
+{
+    if (alignment == 0 || width % alignment != 0 || height % alignment != 0)
+    {
+        return false;
+    }
+
+    std::vector<size_t> order(rects.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&rects](size_t a, size_t b)
+    {
+        return (rects[a].Height != rects[b].Height) ? rects[a].Height > rects[b].Height : rects[a].Width > rects[b].Width;
+    });
+
+    //
+    // the height filled in each column of the grid, in cells
+    //
+    uint32_t columns = width / alignment;
+    uint32_t rows = height / alignment;
+    std::vector<uint32_t> skyline(columns, 0);
+
+    for (size_t index : order)
+    {
+        AtlasRect& rect = rects[index];
+        if (rect.Width == 0 || rect.Height == 0 || rect.Width % alignment != 0 || rect.Height % alignment != 0 || rect.Width > width)
+        {
+            return false;
+        }
+
+        uint32_t span = rect.Width / alignment;
+        uint32_t cells = rect.Height / alignment;
+        uint32_t bestX = 0;
+        uint32_t bestY = UINT32_MAX;
+        for (uint32_t x = 0; x + span <= columns; x++)
+        {
+            uint32_t y = *std::max_element(skyline.begin() + x, skyline.begin() + x + span);
+            if (y < bestY)
+            {
+                bestX = x;
+                bestY = y;
+            }
+        }
+
+        if (bestY + cells > rows)
+        {
+            return false;
+        }
+
+        rect.X = bestX * alignment;
+        rect.Y = bestY * alignment;
+        std::fill(skyline.begin() + bestX, skyline.begin() + bestX + span, bestY + cells);
+    }
+
+    return true;
+}
+
+bool DirectX::PackAtlas(uint32_t alignment, uint32_t maxSize, std::vector<AtlasRect>& rects, uint32_t& width, uint32_t& height)
+{
+    if (alignment == 0 || rects.empty())
+    {
+        return false;
+    }
+
+    uint64_t area = 0;
+    uint32_t side = alignment;
+    for (const AtlasRect& rect : rects)
+    {
+        area += static_cast<uint64_t>(rect.Width) * rect.Height;
+        while (side < rect.Width || side < rect.Height)
+        {
+            side *= 2;
+        }
+    }
+
+    width = side;
+    height = side;
+    while (width <= maxSize && height <= maxSize)
+    {
+        if (static_cast<uint64_t>(width) * height >= area && PackRectangles(width, height, alignment, rects))
+        {
+            return true;
+        }
+
+        if (width == height)
+        {
+            width *= 2;
+        }
+        else
+        {
+            height = width;
+        }
+    }
+
+    return false;
+}
+
+DDSStatus DirectX::BakeDDSAtlas(const uint8_t* const* ddsData, const size_t* ddsDataSize, const AtlasRect* rects, size_t count,
+    uint32_t width, uint32_t height, std::vector<uint8_t>& ddsFile)
+{
+    ddsFile.clear();
+
+    std::vector<DDSTexture> sources;
+    DDSStatus status = ParseSources(ddsData, ddsDataSize, count, sources);
+    if (status != DDS_OK)
+    {
+        return status;
+    }
+
+    DXGI_FORMAT format = sources[0].Format();
+    uint32_t blockSize;
+    size_t blockBytes;
+    if (!BlockLayout(format, blockSize, blockBytes) || width % blockSize != 0 || height % blockSize != 0)
+    {
+        return DDS_NOT_SUPPORTED;
+    }
+
+    //
+    // a level is kept while every source has it and every rect still covers whole blocks
+    //
+    uint32_t mipCount = 0;
+    for (bool keep = true; keep && mipCount < 16; )
+    {
+        uint32_t grid = blockSize << mipCount;
+        keep = width % grid == 0 && height % grid == 0;
+        for (size_t i = 0; keep && i < count; i++)
+        {
+            const AtlasRect& rect = rects[i];
+            keep = mipCount < sources[i].MipCount() && rect.Width == sources[i].Width() && rect.Height == sources[i].Height() &&
+                rect.X % grid == 0 && rect.Y % grid == 0 && rect.Width % grid == 0 && rect.Height % grid == 0;
+            keep = keep && rect.X + rect.Width <= width && rect.Y + rect.Height <= height;
+        }
+
+        if (keep)
+        {
+            mipCount++;
+        }
+    }
+
+    if (mipCount == 0)
+    {
+        return DDS_NOT_SUPPORTED;
+    }
+
+    WriteDDSHeader(format, DDS_DIMENSION_TEXTURE2D, width, height, 1, mipCount, 1, false, ddsFile);
+    size_t headerSize = ddsFile.size();
+
+    for (uint32_t mip = 0; mip < mipCount; mip++)
+    {
+        size_t levelBytes;
+        GetSurfaceInfo(std::max(width >> mip, 1u), std::max(height >> mip, 1u), format, &levelBytes, nullptr, nullptr);
+        ddsFile.resize(ddsFile.size() + levelBytes, 0);
+    }
+
+    DDSTexture atlas;
+    status = atlas.Parse(ddsFile.data(), ddsFile.size());
+    if (status != DDS_OK || ddsFile.size() - headerSize != atlas.BitsSize())
+    {
+        ddsFile.clear();
+        return DDS_INVALID_DATA;
+    }
+
+    //
+    // each source level goes in row by row of blocks
+    //
+    for (uint32_t mip = 0; mip < mipCount; mip++)
+    {
+        const DDSSubresource& target = atlas.Subresource(mip, 0);
+        uint8_t* targetBits = ddsFile.data() + target.Offset;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const DDSSubresource& source = sources[i].Subresource(mip, 0);
+            size_t column = (rects[i].X >> mip) / blockSize;
+            size_t row = (rects[i].Y >> mip) / blockSize;
+            size_t rowBytes = (source.Width / blockSize) * blockBytes;
+
+            for (size_t y = 0; y < source.RowCount; y++)
+            {
+                memcpy(targetBits + (row + y) * target.RowPitch + column * blockBytes, source.Data + y * source.RowPitch, rowBytes);
+            }
+        }
+    }
+
+    return DDS_OK;
+}
+
+DDSStatus DirectX::BakeDDSArray(const uint8_t* const* ddsData, const size_t* ddsDataSize, size_t count, std::vector<uint8_t>& ddsFile)
+{
+    ddsFile.clear();
+
+    std::vector<DDSTexture> sources;
+    DDSStatus status = ParseSources(ddsData, ddsDataSize, count, sources);
+    if (status != DDS_OK)
+    {
+        return status;
+    }
+
+    //
+    // D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION
+    //
+    if (count > 2048)
+    {
+        return DDS_NOT_SUPPORTED;
+    }
+
+    uint32_t mipCount = sources[0].MipCount();
+    for (const DDSTexture& source : sources)
+    {
+        if (source.Width() != sources[0].Width() || source.Height() != sources[0].Height())
+        {
+            return DDS_NOT_SUPPORTED;
+        }
+
+        mipCount = std::min(mipCount, source.MipCount());
+    }
+
+    WriteDDSHeader(sources[0].Format(), DDS_DIMENSION_TEXTURE2D, sources[0].Width(), sources[0].Height(), 1, mipCount,
+        static_cast<uint32_t>(count), false, ddsFile);
+
+    for (const DDSTexture& source : sources)
+    {
+        for (uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            const DDSSubresource& subresource = source.Subresource(mip, 0);
+            ddsFile.insert(ddsFile.end(), subresource.Data, subresource.Data + subresource.SlicePitch);
+        }
+    }
+
+    return DDS_OK;
+}
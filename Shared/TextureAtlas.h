@@ -0,0 +1,63 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "DDSTexture.h"
+
+namespace DirectX
+{
+    struct AtlasRect
+    {
+        uint32_t X;
+        uint32_t Y;
+        uint32_t Width;
+        uint32_t Height;
+    };
+
+    //
+    // The grid a 2D DDS texture can sit on in an atlas with every one of its levels still
+    // starting and ending on a block boundary: the largest power of two dividing both sides,
+    // capped where its smallest level reaches a single block. 0 for textures that cannot go
+    // in an atlas: arrays, cubes, volumes, packed and planar formats, and sides that are not
+    // whole blocks.
+    //
+    uint32_t AtlasAlignment(const DDSTexture& source);
+
+    //
+    // Places rects, whose Width and Height are set, in a width x height area without
+    // overlap, filling in X and Y. Every side and position is a multiple of alignment.
+    // Tallest first, each goes on the skyline as low as it can, then as far left. False
+    // when they do not all fit.
+    //
+    bool PackRectangles(uint32_t width, uint32_t height, uint32_t alignment, std::vector<AtlasRect>& rects);
+
+    //
+    // PackRectangles into the smallest power-of-two atlas, square or twice as wide as it is
+    // tall, no side above maxSize
+    //
+    bool PackAtlas(uint32_t alignment, uint32_t maxSize, std::vector<AtlasRect>& rects, uint32_t& width, uint32_t& height);
+
+    //
+    // Copies count 2D DDS files of one format into a width x height atlas at rects, as
+    // placed by PackAtlas. The atlas keeps as many levels as every source has and the rects
+    // stay block aligned for; space no rect covers is zero.
+    //
+    DDSStatus BakeDDSAtlas(const uint8_t* const* ddsData, const size_t* ddsDataSize, const AtlasRect* rects, size_t count,
+        uint32_t width, uint32_t height, std::vector<uint8_t>& ddsFile);
+
+    //
+    // Stacks count 2D DDS files of one format and size into a texture array, item i from
+    // source i, keeping the levels every source has. Nothing bleeds between items, but the
+    // shaders sampling it have to take the item index.
+    //
+    DDSStatus BakeDDSArray(const uint8_t* const* ddsData, const size_t* ddsDataSize, size_t count, std::vector<uint8_t>& ddsFile);
+}
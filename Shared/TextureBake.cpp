@@ -0,0 +1,285 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "BCDecode.h"
+#include "TextureBake.h"
+
+using namespace DirectX;
+
+namespace
+{
+    bool IsSRGB(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    //
+    // one slice of a subresource as tightly packed R8G8B8A8 texels
+    //
+    bool LoadRGBA(DXGI_FORMAT format, const DDSSubresource& subresource, uint32_t slice, std::vector<uint32_t>& texels)
+    {
+        size_t width = subresource.Width;
+        size_t height = subresource.Height;
+        texels.resize(width * height);
+        uint8_t* destination = reinterpret_cast<uint8_t*>(texels.data());
+        const uint8_t* source = subresource.Data + slice * subresource.SlicePitch;
+
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            for (size_t y = 0; y < height; y++)
+            {
+                memcpy(destination + y * width * 4, source + y * subresource.RowPitch, width * 4);
+            }
+            return true;
+
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            {
+                uint32_t opaque = (format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB) ? 0xff000000 : 0;
+                for (size_t y = 0; y < height; y++)
+                {
+                    const uint8_t* row = source + y * subresource.RowPitch;
+                    for (size_t x = 0; x < width; x++)
+                    {
+                        const uint8_t* bgra = row + x * 4;
+                        texels[y * width + x] = (bgra[2] | (bgra[1] << 8) | (bgra[0] << 16) | (static_cast<uint32_t>(bgra[3]) << 24)) | opaque;
+                    }
+                }
+            }
+            return true;
+
+        default:
+            if (BCDecodedFormat(format) != DXGI_FORMAT_R8G8B8A8_UNORM)
+            {
+                return false;
+            }
+
+            {
+                DDSSubresource single = subresource;
+                single.Data = source;
+                single.Depth = 1;
+                return DecodeBC(format, single, destination, width * 4);
+            }
+        }
+    }
+
+    bool IsFourChannel8(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    size_t TextureBytes(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount, uint32_t arraySize)
+    {
+        size_t bytes = 0;
+        for (uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            size_t slicePitch = 0;
+            GetSurfaceInfo(std::max(width >> mip, 1u), std::max(height >> mip, 1u), format, &slicePitch, nullptr, nullptr);
+            bytes += slicePitch * std::max(depth >> mip, 1u);
+        }
+
+        return bytes * arraySize;
+    }
+
+    //
+    // generates levels 1 to mipCount - 1 from the R8G8B8A8 top level in texels and encodes
+    // them one after the other at offset
+    //
+    void EncodeMipChain(DXGI_FORMAT format, const std::vector<uint32_t>& texels, uint32_t width, uint32_t height, uint32_t mipCount,
+        const MipGenerationSettings& settings, BCEncodeQuality quality, JobSystem* jobs, std::vector<uint8_t>& ddsFile, size_t& offset)
+    {
+        std::vector<uint8_t> chain(MipChainSize(width, height, mipCount));
+        GenerateMips(reinterpret_cast<const uint8_t*>(texels.data()), width * 4, width, height, mipCount,
+            IsSRGB(format), settings, chain.data(), jobs);
+
+        const uint8_t* level = chain.data();
+        for (uint32_t mip = 1; mip < mipCount; mip++)
+        {
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+
+            size_t slicePitch = 0;
+            size_t rowPitch = 0;
+            GetSurfaceInfo(width, height, format, &slicePitch, &rowPitch, nullptr);
+            EncodeBC(format, level, width * 4, width, height, &ddsFile[offset], rowPitch, quality, jobs);
+
+            level += 4 * static_cast<size_t>(width) * height;
+            offset += slicePitch;
+        }
+    }
+}
+
+DDSStatus DirectX::BakeDDS(const uint8_t* ddsData, size_t ddsDataSize, DXGI_FORMAT format, BCEncodeQuality quality,
+    const MipGenerationSettings* missingMips, JobSystem* jobs, std::vector<uint8_t>& ddsFile)
+{
+    ddsFile.clear();
+    if (!CanEncodeBC(format))
+    {
+        return DDS_NOT_SUPPORTED;
+    }
+
+    DDSTexture source;
+    DDSStatus status = source.Parse(ddsData, ddsDataSize);
+    if (status != DDS_OK)
+    {
+        return status;
+    }
+
+    if (source.Dimension() == DDS_DIMENSION_TEXTURE1D)
+    {
+        return DDS_NOT_SUPPORTED;
+    }
+
+    DXGI_FORMAT target = IsSRGB(source.Format()) ? MakeSRGB(format) : format;
+    bool generateMips = missingMips != nullptr && source.MipCount() == 1 && source.Dimension() == DDS_DIMENSION_TEXTURE2D;
+    uint32_t mipCount = generateMips ? FullMipCount(source.Width(), source.Height()) : source.MipCount();
+
+    // the whole output is sized up front, and each subresource encoded in place
+    WriteDDSHeader(target, source.Dimension(), source.Width(), source.Height(), source.Depth(),
+        mipCount, source.ArraySize(), source.IsCubeMap(), ddsFile);
+    size_t offset = ddsFile.size();
+    ddsFile.resize(offset + TextureBytes(target, source.Width(), source.Height(), source.Depth(), mipCount, source.ArraySize()));
+
+    std::vector<uint32_t> texels;
+    for (uint32_t item = 0; item < source.ArraySize(); item++)
+    {
+        for (uint32_t mip = 0; mip < source.MipCount(); mip++)
+        {
+            const DDSSubresource& subresource = source.Subresource(mip, item);
+            size_t slicePitch = 0;
+            size_t rowPitch = 0;
+            GetSurfaceInfo(subresource.Width, subresource.Height, target, &slicePitch, &rowPitch, nullptr);
+
+            for (uint32_t slice = 0; slice < subresource.Depth; slice++)
+            {
+                if (!LoadRGBA(source.Format(), subresource, slice, texels))
+                {
+                    ddsFile.clear();
+                    return DDS_NOT_SUPPORTED;
+                }
+
+                EncodeBC(target, reinterpret_cast<const uint8_t*>(texels.data()), subresource.Width * 4, subresource.Width, subresource.Height,
+                    &ddsFile[offset], rowPitch, quality, jobs);
+                offset += slicePitch;
+            }
+        }
+
+        // texels still hold the top level
+        if (generateMips)
+        {
+            EncodeMipChain(target, texels, source.Width(), source.Height(), mipCount, *missingMips, quality, jobs, ddsFile, offset);
+        }
+    }
+
+    return DDS_OK;
+}
+
+DDSStatus DirectX::GenerateDDSMips(const uint8_t* ddsData, size_t ddsDataSize, const MipGenerationSettings& settings,
+    JobSystem* jobs, std::vector<uint8_t>& ddsFile)
+{
+    ddsFile.clear();
+
+    DDSTexture source;
+    DDSStatus status = source.Parse(ddsData, ddsDataSize);
+    if (status != DDS_OK)
+    {
+        return status;
+    }
+
+    DXGI_FORMAT format = source.Format();
+    bool compressed = IsCompressed(format);
+    bool supported = compressed ? (CanEncodeBC(format) && BCDecodedFormat(format) == DXGI_FORMAT_R8G8B8A8_UNORM) : IsFourChannel8(format);
+    if (!supported || source.Dimension() != DDS_DIMENSION_TEXTURE2D)
+    {
+        return DDS_NOT_SUPPORTED;
+    }
+
+    // padding alpha means nothing to test
+    MipGenerationSettings levelSettings = settings;
+    if (format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+    {
+        levelSettings.AlphaCoverageReference = 0.0f;
+    }
+
+    uint32_t width = source.Width();
+    uint32_t height = source.Height();
+    uint32_t mipCount = FullMipCount(width, height);
+
+    WriteDDSHeader(format, source.Dimension(), width, height, 1, mipCount, source.ArraySize(), source.IsCubeMap(), ddsFile);
+    size_t offset = ddsFile.size();
+    ddsFile.resize(offset + TextureBytes(format, width, height, 1, mipCount, source.ArraySize()));
+
+    std::vector<uint32_t> texels;
+    for (uint32_t item = 0; item < source.ArraySize(); item++)
+    {
+        // the top level is kept exactly as it was
+        const DDSSubresource& top = source.Subresource(0, item);
+        size_t slicePitch = 0;
+        size_t rowPitch = 0;
+        GetSurfaceInfo(width, height, format, &slicePitch, &rowPitch, nullptr);
+        for (size_t row = 0; row < top.RowCount; row++)
+        {
+            memcpy(&ddsFile[offset + row * rowPitch], top.Data + row * top.RowPitch, rowPitch);
+        }
+
+        offset += slicePitch;
+
+        if (compressed)
+        {
+            if (!LoadRGBA(format, top, 0, texels))
+            {
+                ddsFile.clear();
+                return DDS_NOT_SUPPORTED;
+            }
+
+            EncodeMipChain(format, texels, width, height, mipCount, levelSettings, BC_ENCODE_FAST, jobs, ddsFile, offset);
+        }
+        else
+        {
+            GenerateMips(top.Data, top.RowPitch, width, height, mipCount, IsSRGB(format), levelSettings, &ddsFile[offset], jobs);
+            offset += MipChainSize(width, height, mipCount);
+        }
+    }
+
+    return DDS_OK;
+}
@@ -0,0 +1,41 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "BCEncode.h"
+#include "DDSTexture.h"
+#include "MipGenerator.h"
+
+class JobSystem;
+
+namespace DirectX
+{
+    //
+    // Bakes a DDS file into a block-compressed DDS file that CreateDDSTextureFromMemory
+    // loads. Every mip, array item, cube face and volume slice keeps its place. Sources may
+    // be R8G8B8A8, B8G8R8A8 or B8G8R8X8, or any block format DecodeBC turns into R8G8B8A8.
+    // sRGB sources give the sRGB variant of format. With missingMips, a 2D source with a
+    // single level gets a full chain filtered with those settings. 1D textures are not
+    // supported.
+    //
+    DDSStatus BakeDDS(const uint8_t* ddsData, size_t ddsDataSize, DXGI_FORMAT format, BCEncodeQuality quality,
+        const MipGenerationSettings* missingMips, JobSystem* jobs, std::vector<uint8_t>& ddsFile);
+
+    //
+    // Rewrites a 2D DDS file in the same format with a full mip chain built from the top
+    // level of every array item or cube face; the top level is copied as it is. Works on
+    // four-channel 8-bit formats, and on the block formats the encoder writes, whose new
+    // levels are encoded at BC_ENCODE_FAST to keep loading quick.
+    //
+    DDSStatus GenerateDDSMips(const uint8_t* ddsData, size_t ddsDataSize, const MipGenerationSettings& settings,
+        JobSystem* jobs, std::vector<uint8_t>& ddsFile);
+}
@@ -0,0 +1,719 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "pch.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "DDSTextureLoader.h"
+#include "TextureBake.h"
+#include "TextureStreamer.h"
+
+using namespace DirectX;
+using namespace Microsoft::WRL;
+using namespace VSD3DStarter;
+
+namespace
+{
+    const UINT NoRequest = ~0u;
+    const UINT MaxFailureBackoff = 8;           // in DemoteFrames, between retries of a texture that keeps failing
+}
+
+#pragma region StreamedTexture
+
+StreamedTexture::StreamedTexture() :
+    m_fileSize(0),
+    m_tailMip(0),
+    m_residentMip(0),
+    m_requestedMip(NoRequest),
+    m_demandMip(0),
+    m_lastRequestFrame(0),
+    m_lastUsedFrame(0),
+    m_failedFrame(0),
+    m_failures(0),
+    m_whole(false),
+    m_pending(false)
+{
+}
+
+std::uint64_t StreamedTexture::BytesFrom(UINT mip) const
+{
+    std::uint64_t bytes = 0;
+    for (UINT item = 0; item < m_layout.ArraySize(); item++)
+    {
+        for (UINT level = mip; level < m_layout.MipCount(); level++)
+        {
+            const DDSSubresource& subresource = m_layout.Subresource(level, item);
+            bytes += subresource.SlicePitch * subresource.Depth;
+        }
+    }
+
+    return bytes;
+}
+
+std::uint64_t StreamedTexture::ResidentBytes() const
+{
+    return m_view ? BytesFrom(m_residentMip) : 0;
+}
+
+#pragma endregion
+
+#pragma region TextureStreamer
+
+TextureStreamer::TextureStreamer() :
+    m_featureLevel(D3D_FEATURE_LEVEL_9_1),
+    m_files(nullptr),
+    m_jobs(nullptr),
+    m_generation(1),
+    m_frame(0),
+    m_pendingReads(0),
+    m_pendingBytes(0),
+    m_bytesRead(0),
+    m_promotions(0),
+    m_demotions(0),
+    m_hits(0),
+    m_misses(0),
+    m_evictions(0),
+    m_failures(0),
+    m_stopping(false)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    Shutdown();
+}
+
+void TextureStreamer::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, FileReader* files,
+    const TextureStreamingSettings& settings)
+{
+    Shutdown();
+
+    m_device = device;
+    m_deviceContext = deviceContext;
+    m_featureLevel = device->GetFeatureLevel();
+    m_files = files;
+    m_settings = settings;
+
+    m_stopping = false;
+    m_readThread = std::thread(&TextureStreamer::RunReads, this);
+}
+
+void TextureStreamer::Shutdown()
+{
+    if (m_readThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_readLock);
+            m_stopping = true;
+        }
+
+        m_readWake.notify_one();
+        m_readThread.join();
+    }
+
+    m_queuedReads.clear();
+    m_finishedReads.clear();
+    m_textures.clear();
+    m_generation++;
+    m_frame = 0;
+    m_pendingReads = 0;
+    m_pendingBytes = 0;
+    m_bytesRead = 0;
+    m_promotions = 0;
+    m_demotions = 0;
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+    m_failures = 0;
+
+    m_deviceContext = nullptr;
+    m_device = nullptr;
+    m_files = nullptr;
+}
+
+StreamedTextureReference TextureStreamer::GetOrOpen(const std::wstring& fileName)
+{
+    auto iter = m_textures.find(fileName);
+    if (iter != m_textures.end())
+    {
+        return StreamedTextureReference(this, iter->second.get());
+    }
+
+    //
+    // failures are remembered as null so the file is not read again
+    //
+    std::unique_ptr<StreamedTexture> texture(new StreamedTexture());
+    texture->m_fileName = fileName;
+    if (!m_device || !Open(*texture))
+    {
+        texture.reset();
+    }
+
+    StreamedTextureReference result(this, texture.get());
+    m_textures[fileName] = std::move(texture);
+    return result;
+}
+
+bool TextureStreamer::Open(StreamedTexture& texture)
+{
+    FileBuffer header;
+    if (!m_files->ReadRange(texture.m_fileName, 0, DDSTexture::MaxHeaderSize, header))
+    {
+        return false;
+    }
+
+    DDSTexture& layout = texture.m_layout;
+    std::uint64_t fileSize = header.FileSize();
+    if (fileSize == 0 || fileSize > SIZE_MAX || layout.ParseHeader(header.Data(), header.Size(), static_cast<size_t>(fileSize)) != DDS_OK)
+    {
+        return false;
+    }
+
+    header.Reset();
+    texture.m_fileSize = fileSize;
+    texture.m_lastRequestFrame = m_frame;
+    texture.m_lastUsedFrame = m_frame;
+
+    if (layout.Dimension() != DDS_DIMENSION_TEXTURE2D || layout.IsCubeMap() || layout.ArraySize() != 1 || layout.MipCount() < 2)
+    {
+        ReadRequest read;
+        read.Texture = &texture;
+        read.FirstMip = 0;
+        read.Offset = 0;
+        read.Size = static_cast<size_t>(fileSize);
+        read.GrowthBytes = 0;
+
+        texture.m_whole = true;
+        texture.m_tailMip = 0;
+        if (!Read(read, m_jobs))
+        {
+            return false;
+        }
+
+        m_bytesRead += read.Size;
+        return PromoteWhole(texture, read);
+    }
+
+    //
+    // the tail is every level no larger than TailSize, read in one piece from the end of the file
+    //
+    UINT mipCount = layout.MipCount();
+    UINT tail = 0;
+    while (tail + 1 < mipCount &&
+        (layout.Subresource(tail, 0).Width > m_settings.TailSize || layout.Subresource(tail, 0).Height > m_settings.TailSize))
+    {
+        tail++;
+    }
+
+    const DDSSubresource& last = layout.Subresource(mipCount - 1, 0);
+
+    ReadRequest read;
+    read.Texture = &texture;
+    read.FirstMip = tail;
+    read.Offset = layout.Subresource(tail, 0).Offset;
+    read.Size = static_cast<size_t>(last.Offset + last.SlicePitch - read.Offset);
+    read.GrowthBytes = 0;
+    read.Succeeded = Read(read, m_jobs);
+    if (!read.Succeeded)
+    {
+        return false;
+    }
+
+    m_bytesRead += read.Size;
+
+    texture.m_tailMip = tail;
+    texture.m_residentMip = mipCount;
+    texture.m_demandMip = tail;
+    return Promote(texture, read);
+}
+
+bool TextureStreamer::Read(ReadRequest& read, JobSystem* jobs)
+{
+    const std::wstring& fileName = read.Texture->m_fileName;
+    bool succeeded = read.Texture->m_whole ?
+        m_files->Read(fileName, read.Data, FILE_ACCESS_SEQUENTIAL) :
+        m_files->ReadRange(fileName, read.Offset, read.Size, read.Data, FILE_ACCESS_RANDOM);
+    if (!succeeded || read.Data.Size() != read.Size)
+    {
+        return false;
+    }
+
+    //
+    // whole files get their mips built here; the file bytes go back to the pool straight away
+    //
+    if (read.Texture->m_whole && GenerateMissingMips(read.Data.Data(), read.Data.Size(), m_featureLevel, jobs, read.Mipped))
+    {
+        read.Data.Reset();
+    }
+
+    return true;
+}
+
+bool TextureStreamer::CreateLevels(StreamedTexture& texture, UINT firstMip, ComPtr<ID3D11Texture2D>& resource, ComPtr<ID3D11ShaderResourceView>& view)
+{
+    const DDSTexture& layout = texture.m_layout;
+    const DDSSubresource& top = layout.Subresource(firstMip, 0);
+
+    D3D11_TEXTURE2D_DESC desc;
+    desc.Width = top.Width;
+    desc.Height = top.Height;
+    desc.MipLevels = layout.MipCount() - firstMip;
+    desc.ArraySize = 1;
+    desc.Format = layout.Format();
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = 0;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &resource)))
+    {
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+    memset(&viewDesc, 0, sizeof(viewDesc));
+    viewDesc.Format = desc.Format;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    viewDesc.Texture2D.MipLevels = desc.MipLevels;
+    return SUCCEEDED(m_device->CreateShaderResourceView(resource.Get(), &viewDesc, &view));
+}
+
+bool TextureStreamer::Promote(StreamedTexture& texture, ReadRequest& read)
+{
+    if (texture.m_whole)
+    {
+        return PromoteWhole(texture, read);
+    }
+
+    ComPtr<ID3D11Texture2D> resource;
+    ComPtr<ID3D11ShaderResourceView> view;
+    if (!CreateLevels(texture, read.FirstMip, resource, view))
+    {
+        return false;
+    }
+
+    const DDSTexture& layout = texture.m_layout;
+    for (UINT mip = read.FirstMip; mip < texture.m_residentMip; mip++)
+    {
+        const DDSSubresource& subresource = layout.Subresource(mip, 0);
+        m_deviceContext->UpdateSubresource(resource.Get(), mip - read.FirstMip, nullptr, read.Bytes() + (subresource.Offset - read.Offset),
+            static_cast<UINT>(subresource.RowPitch), static_cast<UINT>(subresource.SlicePitch));
+    }
+
+    //
+    // the levels already resident move across on the GPU
+    //
+    for (UINT mip = texture.m_residentMip; mip < layout.MipCount(); mip++)
+    {
+        m_deviceContext->CopySubresourceRegion(resource.Get(), mip - read.FirstMip, 0, 0, 0, texture.m_texture.Get(), mip - texture.m_residentMip, nullptr);
+    }
+
+    if (texture.m_texture)
+    {
+        m_promotions += texture.m_residentMip - read.FirstMip;
+    }
+
+    texture.m_texture = resource;
+    texture.m_view = view;
+    texture.m_residentMip = read.FirstMip;
+    return true;
+}
+
+bool TextureStreamer::PromoteWhole(StreamedTexture& texture, ReadRequest& read)
+{
+    ComPtr<ID3D11ShaderResourceView> view;
+    if (FAILED(CreateDDSTextureFromMemory(m_device.Get(), read.Bytes(), read.ByteCount(), nullptr, &view)))
+    {
+        return false;
+    }
+
+    //
+    // the layout follows the file as loaded, mips built for it included, so the bytes counted
+    // against the budget are those on the GPU
+    //
+    if (texture.m_layout.ParseHeader(read.Bytes(), read.ByteCount(), read.ByteCount()) != DDS_OK)
+    {
+        return false;
+    }
+
+    //
+    // an evicted texture has every level to bring back; one just opened has none counted
+    //
+    m_promotions += texture.m_residentMip;
+    texture.m_view = view;
+    texture.m_residentMip = 0;
+    texture.m_demandMip = 0;
+    return true;
+}
+
+void TextureStreamer::Demote(StreamedTexture& texture, UINT mip)
+{
+    ComPtr<ID3D11Texture2D> resource;
+    ComPtr<ID3D11ShaderResourceView> view;
+    if (!CreateLevels(texture, mip, resource, view))
+    {
+        return;
+    }
+
+    for (UINT level = mip; level < texture.m_layout.MipCount(); level++)
+    {
+        m_deviceContext->CopySubresourceRegion(resource.Get(), level - mip, 0, 0, 0, texture.m_texture.Get(), level - texture.m_residentMip, nullptr);
+    }
+
+    m_demotions += mip - texture.m_residentMip;
+    texture.m_texture = resource;
+    texture.m_view = view;
+    texture.m_residentMip = mip;
+}
+
+void TextureStreamer::Evict(StreamedTexture& texture)
+{
+    if (texture.m_whole)
+    {
+        m_demotions += texture.m_layout.MipCount() - texture.m_residentMip;
+        texture.m_view = nullptr;
+        texture.m_residentMip = texture.m_layout.MipCount();
+    }
+    else
+    {
+        Demote(texture, texture.m_tailMip);
+    }
+
+    //
+    // nothing is read back until the texture is drawn again
+    //
+    texture.m_demandMip = texture.m_residentMip;
+    texture.m_lastRequestFrame = m_frame;
+    m_evictions++;
+}
+
+std::uint64_t TextureStreamer::EvictLeastRecentlyUsed(std::uint64_t bytes, const StreamedTexture* keep)
+{
+    //
+    // textures drawn this frame, and those with reads in flight, stay
+    //
+    std::vector<StreamedTexture*> candidates;
+    for (auto& entry : m_textures)
+    {
+        StreamedTexture* texture = entry.second.get();
+        if (texture == nullptr || texture == keep || texture->m_pending || texture->m_lastUsedFrame == m_frame)
+        {
+            continue;
+        }
+
+        std::uint64_t floor = texture->m_whole ? 0 : texture->BytesFrom(texture->m_tailMip);
+        if (texture->ResidentBytes() > floor)
+        {
+            candidates.push_back(texture);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+        [](const StreamedTexture* a, const StreamedTexture* b) { return a->m_lastUsedFrame < b->m_lastUsedFrame; });
+
+    std::uint64_t freed = 0;
+    for (StreamedTexture* texture : candidates)
+    {
+        if (freed >= bytes)
+        {
+            break;
+        }
+
+        std::uint64_t before = texture->ResidentBytes();
+        Evict(*texture);
+        freed += before - texture->ResidentBytes();
+    }
+
+    return freed;
+}
+
+void TextureStreamer::QueueRead(StreamedTexture& texture, UINT firstMip, std::uint64_t growthBytes)
+{
+    std::unique_ptr<ReadRequest> read(new ReadRequest());
+    read->Texture = &texture;
+    read->FirstMip = firstMip;
+    read->GrowthBytes = growthBytes;
+    read->Succeeded = false;
+
+    if (texture.m_whole)
+    {
+        read->Offset = 0;
+        read->Size = static_cast<size_t>(texture.m_fileSize);
+    }
+    else
+    {
+        const DDSSubresource& first = texture.m_layout.Subresource(firstMip, 0);
+        const DDSSubresource& resident = texture.m_layout.Subresource(texture.m_residentMip, 0);
+        read->Offset = first.Offset;
+        read->Size = resident.Offset - first.Offset;
+    }
+
+    texture.m_pending = true;
+    m_pendingReads++;
+    m_pendingBytes += growthBytes;
+    {
+        std::lock_guard<std::mutex> lock(m_readLock);
+        m_queuedReads.push_back(std::move(read));
+    }
+
+    m_readWake.notify_one();
+}
+
+void TextureStreamer::Update()
+{
+    m_frame++;
+
+    std::vector<std::unique_ptr<ReadRequest>> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_readLock);
+        finished.swap(m_finishedReads);
+    }
+
+    for (std::unique_ptr<ReadRequest>& read : finished)
+    {
+        StreamedTexture& texture = *read->Texture;
+        texture.m_pending = false;
+        m_pendingReads--;
+        m_pendingBytes -= read->GrowthBytes;
+
+        if (read->Succeeded)
+        {
+            m_bytesRead += read->Size;
+        }
+
+        //
+        // a file that cannot be read or a level that cannot be created would otherwise be
+        // queued again the very next frame, so hold the texture at its resident levels for
+        // longer after every failure in a row
+        //
+        if (read->Succeeded && Promote(texture, *read))
+        {
+            texture.m_failures = 0;
+        }
+        else
+        {
+            texture.m_failedFrame = m_frame;
+            texture.m_failures = std::min(texture.m_failures + 1, MaxFailureBackoff);
+            m_failures++;
+        }
+    }
+
+    std::uint64_t residentBytes = 0;
+    for (auto& entry : m_textures)
+    {
+        if (!entry.second)
+        {
+            continue;
+        }
+
+        StreamedTexture& texture = *entry.second;
+        UINT requested = std::min(texture.m_requestedMip, texture.m_tailMip);
+        bool wasRequested = texture.m_requestedMip != NoRequest;
+        texture.m_requestedMip = NoRequest;
+
+        if (wasRequested)
+        {
+            texture.m_lastUsedFrame = m_frame;
+            if (requested >= texture.m_residentMip)
+            {
+                m_hits++;
+            }
+            else
+            {
+                m_misses++;
+            }
+        }
+
+        //
+        // finer demand takes effect at once; coarser demand, or none, only once the finer
+        // one has gone unrequested for DemoteFrames frames. An evicted texture's demand sits
+        // below its tail until it is drawn again.
+        //
+        if (wasRequested && requested <= texture.m_demandMip)
+        {
+            texture.m_demandMip = requested;
+            texture.m_lastRequestFrame = m_frame;
+        }
+        else if (m_frame - texture.m_lastRequestFrame > m_settings.DemoteFrames)
+        {
+            texture.m_demandMip = wasRequested ? requested : std::max(texture.m_tailMip, texture.m_demandMip);
+            texture.m_lastRequestFrame = m_frame;
+        }
+
+        residentBytes += texture.ResidentBytes();
+    }
+
+    std::uint64_t budget = m_settings.BudgetBytes;
+    if (budget != 0 && residentBytes > budget)
+    {
+        residentBytes -= EvictLeastRecentlyUsed(residentBytes - budget, nullptr);
+    }
+
+    for (auto& entry : m_textures)
+    {
+        if (!entry.second || entry.second->m_pending)
+        {
+            continue;
+        }
+
+        StreamedTexture& texture = *entry.second;
+        if (texture.m_demandMip < texture.m_residentMip)
+        {
+            if (m_pendingReads >= m_settings.MaxPendingReads ||
+                (texture.m_failures != 0 && m_frame - texture.m_failedFrame <= m_settings.DemoteFrames * texture.m_failures))
+            {
+                continue;
+            }
+
+            UINT firstMip = texture.m_demandMip;
+            std::uint64_t current = texture.ResidentBytes();
+            std::uint64_t growth = texture.BytesFrom(firstMip) - current;
+            if (budget != 0 && residentBytes + m_pendingBytes + growth > budget)
+            {
+                residentBytes -= EvictLeastRecentlyUsed(residentBytes + m_pendingBytes + growth - budget, &texture);
+
+                //
+                // whatever room is still short leaves the texture at coarser levels; a whole
+                // texture either fits or stays released
+                //
+                while (firstMip < texture.m_residentMip && residentBytes + m_pendingBytes + growth > budget)
+                {
+                    firstMip = texture.m_whole ? texture.m_residentMip : firstMip + 1;
+                    growth = texture.BytesFrom(firstMip) - current;
+                }
+
+                if (firstMip == texture.m_residentMip)
+                {
+                    continue;
+                }
+            }
+
+            QueueRead(texture, firstMip, growth);
+        }
+        else if (texture.m_demandMip > texture.m_residentMip)
+        {
+            residentBytes -= texture.ResidentBytes();
+            Demote(texture, texture.m_demandMip);
+            residentBytes += texture.ResidentBytes();
+        }
+    }
+}
+
+void TextureStreamer::RunReads()
+{
+    for (;;)
+    {
+        std::unique_ptr<ReadRequest> read;
+        {
+            std::unique_lock<std::mutex> lock(m_readLock);
+            m_readWake.wait(lock, [this]() { return m_stopping || !m_queuedReads.empty(); });
+            if (m_stopping)
+            {
+                return;
+            }
+
+            read = std::move(m_queuedReads.front());
+            m_queuedReads.pop_front();
+        }
+
+        read->Succeeded = Read(*read, nullptr);
+
+        std::lock_guard<std::mutex> lock(m_readLock);
+        m_finishedReads.push_back(std::move(read));
+    }
+}
+
+TextureStreamingStatistics TextureStreamer::Statistics() const
+{
+    TextureStreamingStatistics statistics;
+    statistics.Textures = 0;
+    statistics.PendingReads = m_pendingReads;
+    statistics.ResidentBytes = 0;
+    statistics.BytesRead = m_bytesRead;
+    statistics.Promotions = m_promotions;
+    statistics.Demotions = m_demotions;
+    statistics.Hits = m_hits;
+    statistics.Misses = m_misses;
+    statistics.Evictions = m_evictions;
+    statistics.Failures = m_failures;
+
+    for (const auto& entry : m_textures)
+    {
+        if (entry.second)
+        {
+            statistics.Textures++;
+            statistics.ResidentBytes += entry.second->ResidentBytes();
+        }
+    }
+
+    return statistics;
+}
+
+UINT TextureStreamer::MipForProjectedSize(UINT textureSize, float projectedPixels)
+{
+    //
+    // the smallest level still at least as large as its footprint
+    //
+    projectedPixels = std::max(projectedPixels, 1.0f);
+
+    UINT mip = 0;
+    while (textureSize > 1 && textureSize / 2 >= projectedPixels)
+    {
+        textureSize /= 2;
+        mip++;
+    }
+
+    return mip;
+}
+
+void TextureStreamer::GenerateMissingMips(std::vector<std::uint8_t>& ddsFile, D3D_FEATURE_LEVEL featureLevel, JobSystem* jobs)
+{
+    std::vector<std::uint8_t> mipped;
+    if (GenerateMissingMips(ddsFile.data(), ddsFile.size(), featureLevel, jobs, mipped))
+    {
+        ddsFile.swap(mipped);
+    }
+}
+
+bool TextureStreamer::GenerateMissingMips(const std::uint8_t* ddsData, size_t ddsDataSize, D3D_FEATURE_LEVEL featureLevel, JobSystem* jobs,
+    std::vector<std::uint8_t>& mipped)
+{
+    mipped.clear();
+
+    DDSTexture texture;
+    if (ddsDataSize == 0 || texture.Parse(ddsData, ddsDataSize) != DDS_OK || texture.MipCount() > 1)
+    {
+        return false;
+    }
+
+    UINT width = texture.Width();
+    UINT height = texture.Height();
+    bool powerOfTwo = (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+    if (featureLevel < D3D_FEATURE_LEVEL_10_0 && !powerOfTwo)
+    {
+        return false;
+    }
+
+    //
+    // the shared sampler wraps, so filter across the edges the same way
+    //
+    MipGenerationSettings settings;
+    settings.WrapEdges = true;
+
+    if (GenerateDDSMips(ddsData, ddsDataSize, settings, jobs, mipped) != DDS_OK)
+    {
+        mipped.clear();
+        return false;
+    }
+
+    return true;
+}
+
+#pragma endregion
@@ -0,0 +1,270 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <wrl/client.h>
+#include <d3d11.h>
+
+#include "DDSTexture.h"
+#include "FileReader.h"
+
+class JobSystem;
+
+namespace VSD3DStarter
+{
+    class StreamedTextureReference;
+
+    struct TextureStreamingSettings
+    {
+        TextureStreamingSettings() :
+            TailSize(64),
+            MaxPendingReads(4),
+            DemoteFrames(120),
+            BudgetBytes(0)
+        {
+        }
+
+        UINT TailSize;                  // levels no larger than this are loaded when a texture opens
+        UINT MaxPendingReads;           // file reads in flight at once
+        UINT DemoteFrames;              // frames without a request before levels above the demand are dropped
+        std::uint64_t BudgetBytes;      // resident bytes to stay within by evicting the least recently drawn textures; 0 for no limit
+    };
+
+    struct TextureStreamingStatistics
+    {
+        UINT Textures;
+        UINT PendingReads;
+        std::uint64_t ResidentBytes;    // of every level resident on the GPU
+        std::uint64_t BytesRead;        // from texture files since Initialize
+        std::uint64_t Promotions;       // finer levels made resident
+        std::uint64_t Demotions;        // levels dropped
+        std::uint64_t Hits;             // requests the resident levels already met
+        std::uint64_t Misses;           // requests that needed a read
+        std::uint64_t Evictions;        // textures dropped to their tail, or released, to stay within the budget
+        std::uint64_t Failures;         // reads or promotions that failed, each holding its texture back before a retry
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // StreamedTexture is a 2D DDS texture whose finer levels come and go with demand. Files
+    // that cannot stream level by level (cube maps, arrays, volumes) load whole instead and are
+    // only released to stay within the budget, when the view is null until the next request
+    // reads them back. The view is replaced whenever the resident levels change, so fetch it
+    // again for every draw.
+    //
+    class StreamedTexture
+    {
+    public:
+        ID3D11ShaderResourceView* GetView() const { return m_view.Get(); }
+
+        //
+        // asks for level mip this frame, 0 being the full size; the finest request wins
+        //
+        void RequestMip(UINT mip) { m_requestedMip = (mip < m_requestedMip) ? mip : m_requestedMip; }
+
+        const std::wstring& FileName() const { return m_fileName; }
+        UINT Width() const { return m_layout.Width(); }
+        UINT Height() const { return m_layout.Height(); }
+        UINT MipCount() const { return m_layout.MipCount(); }
+        UINT ResidentMip() const { return m_residentMip; }
+        bool IsWhole() const { return m_whole; }
+        std::uint64_t ResidentBytes() const;
+
+    private:
+        friend class TextureStreamer;
+
+        StreamedTexture();
+
+        //
+        // bytes of levels mip and smaller, from the sizes GetSurfaceInfo gives every subresource
+        //
+        std::uint64_t BytesFrom(UINT mip) const;
+
+        std::wstring m_fileName;
+        DirectX::DDSTexture m_layout;           // headers only; subresources carry file offsets
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> m_texture;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_view;
+        std::uint64_t m_fileSize;
+        UINT m_tailMip;                         // the coarsest level streaming may drop to
+        UINT m_residentMip;                     // the finest level resident; MipCount when none are
+        UINT m_requestedMip;                    // finest request since the last Update
+        UINT m_demandMip;                       // finest request over the last DemoteFrames frames
+        UINT m_lastRequestFrame;
+        UINT m_lastUsedFrame;                   // of the last request, for least recently used eviction
+        UINT m_failedFrame;                     // of the last failed read or promotion
+        UINT m_failures;                        // in a row; each adds DemoteFrames before the next read
+        bool m_whole;
+        bool m_pending;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // TextureStreamer opens DDS files with only their smallest levels, so textures are usable
+    // at once, and reads the byte ranges of finer levels on its own thread as draws request
+    // them. Update, once a frame on the rendering thread, swaps finished reads in and drops
+    // levels nothing has asked for lately. With a budget, reads that would overrun it first
+    // evict the textures drawn longest ago, and only stream as far as the room left allows.
+    //
+    class TextureStreamer
+    {
+    public:
+        TextureStreamer();
+        ~TextureStreamer();
+
+        void Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, FileReader* files,
+            const TextureStreamingSettings& settings = TextureStreamingSettings());
+        void Shutdown();
+
+        void SetBudget(std::uint64_t bytes) { m_settings.BudgetBytes = bytes; }
+
+        //
+        // builds mips for whole textures that have none, on the rendering thread while opening;
+        // reloads after eviction build them on the read thread
+        //
+        void SetJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+
+        //
+        // the texture read from fileName, opened on first use; null for files that are not DDS
+        //
+        StreamedTextureReference GetOrOpen(const std::wstring& fileName);
+
+        //
+        // moves on at every Shutdown, when the textures opened before it are freed
+        //
+        std::uint32_t Generation() const { return m_generation; }
+
+        void Update();
+
+        TextureStreamingStatistics Statistics() const;
+
+        //
+        // the level whose texels come closest to one per pixel when a texture of
+        // textureSize texels spans projectedPixels on screen
+        //
+        static UINT MipForProjectedSize(UINT textureSize, float projectedPixels);
+
+        //
+        // Replaces a 2D texture that has a single level with one carrying the full chain, so
+        // minified surfaces sample small levels instead of the whole image. Feature level 9
+        // devices cannot mip textures whose sides are not powers of two, so those are left
+        // alone, as are formats the generator cannot rebuild.
+        //
+        static void GenerateMissingMips(std::vector<std::uint8_t>& ddsFile, D3D_FEATURE_LEVEL featureLevel, JobSystem* jobs);
+
+        //
+        // the same, building the mipped file in mipped and leaving the source untouched; false
+        // when there was nothing to build
+        //
+        static bool GenerateMissingMips(const std::uint8_t* ddsData, size_t ddsDataSize, D3D_FEATURE_LEVEL featureLevel, JobSystem* jobs,
+            std::vector<std::uint8_t>& mipped);
+
+    private:
+        struct ReadRequest
+        {
+            StreamedTexture* Texture;
+            UINT FirstMip;                      // levels FirstMip up to the resident one
+            std::uint64_t Offset;
+            size_t Size;
+            std::uint64_t GrowthBytes;          // resident bytes the read adds once promoted
+            FileBuffer Data;
+            std::vector<std::uint8_t> Mipped;   // a whole file with the mips built for it, used instead of Data
+            bool Succeeded;
+
+            const std::uint8_t* Bytes() const { return Mipped.empty() ? Data.Data() : Mipped.data(); }
+            size_t ByteCount() const { return Mipped.empty() ? Data.Size() : Mipped.size(); }
+        };
+
+        TextureStreamer(const TextureStreamer&);
+        TextureStreamer& operator=(const TextureStreamer&);
+
+        bool Open(StreamedTexture& texture);
+        bool Read(ReadRequest& read, JobSystem* jobs);
+        bool Promote(StreamedTexture& texture, ReadRequest& read);
+        bool PromoteWhole(StreamedTexture& texture, ReadRequest& read);
+        void Demote(StreamedTexture& texture, UINT mip);
+        void Evict(StreamedTexture& texture);
+        std::uint64_t EvictLeastRecentlyUsed(std::uint64_t bytes, const StreamedTexture* keep);
+        void QueueRead(StreamedTexture& texture, UINT firstMip, std::uint64_t growthBytes);
+        bool CreateLevels(StreamedTexture& texture, UINT firstMip, Microsoft::WRL::ComPtr<ID3D11Texture2D>& resource,
+            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& view);
+        void RunReads();
+
+        Microsoft::WRL::ComPtr<ID3D11Device> m_device;
+        Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_deviceContext;
+        D3D_FEATURE_LEVEL m_featureLevel;
+        FileReader* m_files;
+        TextureStreamingSettings m_settings;
+        JobSystem* m_jobs;
+        std::map<std::wstring, std::unique_ptr<StreamedTexture>> m_textures;
+        std::uint32_t m_generation;
+        UINT m_frame;
+        UINT m_pendingReads;
+        std::uint64_t m_pendingBytes;           // GrowthBytes of the reads in flight
+        std::uint64_t m_bytesRead;
+        std::uint64_t m_promotions;
+        std::uint64_t m_demotions;
+        std::uint64_t m_hits;
+        std::uint64_t m_misses;
+        std::uint64_t m_evictions;
+        std::uint64_t m_failures;
+
+        // shared with the read thread
+        std::thread m_readThread;
+        std::mutex m_readLock;
+        std::condition_variable m_readWake;
+        std::deque<std::unique_ptr<ReadRequest>> m_queuedReads;
+        std::vector<std::unique_ptr<ReadRequest>> m_finishedReads;
+        bool m_stopping;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////////////////
+    //
+    // StreamedTextureReference is how materials hold a streamed texture. It remembers the
+    // streamer's generation, so once a device loss shuts the streamer down and frees the
+    // texture, Get returns null instead of the freed one. The streamer must outlive it.
+    //
+    class StreamedTextureReference
+    {
+    public:
+        StreamedTextureReference() : m_streamer(nullptr), m_texture(nullptr), m_generation(0) {}
+
+        StreamedTextureReference(const TextureStreamer* streamer, StreamedTexture* texture) :
+            m_streamer(streamer),
+            m_texture(texture),
+            m_generation(streamer->Generation())
+        {
+        }
+
+        StreamedTexture* Get() const
+        {
+            return (m_texture != nullptr && m_streamer->Generation() == m_generation) ? m_texture : nullptr;
+        }
+
+        void Reset()
+        {
+            m_streamer = nullptr;
+            m_texture = nullptr;
+            m_generation = 0;
+        }
+
+    private:
+        const TextureStreamer* m_streamer;
+        StreamedTexture* m_texture;
+        std::uint32_t m_generation;
+    };
+}
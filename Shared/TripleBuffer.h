@@ -0,0 +1,64 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#pragma once
+
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// TripleBuffer hands whole snapshots from one writer thread to one reader thread without
+// locks. The writer fills Back() and publishes it by swapping it with the middle slot; the
+// reader swaps the middle slot with its front slot only when something new was published.
+// Neither side ever waits for the other, and the reader always sees the latest complete
+// snapshot, skipping any it was too slow to pick up.
+//
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : m_back(0), m_middle(1), m_front(2) { }
+
+    //
+    // writer side: fill Back(), then Publish() it
+    //
+    T& Back() { return m_slots[m_back]; }
+
+    void Publish()
+    {
+        m_back = m_middle.exchange(m_back | FreshBit, std::memory_order_acq_rel) & IndexMask;
+    }
+
+    //
+    // reader side: Acquire() moves the latest published snapshot to Front(), and returns
+    // false when nothing was published since the previous call
+    //
+    bool Acquire()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & FreshBit) == 0)
+        {
+            return false;
+        }
+
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+
+    const T& Front() const { return m_slots[m_front]; }
+
+private:
+    static const unsigned int IndexMask = 3;
+    static const unsigned int FreshBit = 4;
+
+    TripleBuffer(const TripleBuffer&);
+    TripleBuffer& operator=(const TripleBuffer&);
+
+    T m_slots[3];
+    unsigned int m_back;                    // writer only
+    std::atomic<unsigned int> m_middle;     // slot index, plus FreshBit when not yet read
+    unsigned int m_front;                   // reader only
+};
@@ -15,8 +15,13 @@
 #include <map>
 #include <string>
 #include <algorithm>
+#include <cfloat>
 
 #include "DDSTextureLoader.h"
+#include "FileReader.h"
+#include "ResourceRegistry.h"
+#include "TextureAtlas.h"
+#include "TextureStreamer.h"
 
 namespace VSD3DStarter
 {
@@ -122,8 +127,8 @@ namespace VSD3DStarter
     //
     // resource management for pixel shaders and textures
     //
-    ID3D11PixelShader* GetOrCreatePixelShader(const std::wstring& shaderName);
-    ID3D11ShaderResourceView* GetOrCreateTexture(const std::wstring& textureName, bool generateMipsWhenNeeded);
+    PixelShaderReference GetOrCreatePixelShader(const std::wstring& shaderName);
+    TextureReference GetOrCreateTexture(const std::wstring& textureName, bool generateMipsWhenNeeded);
 
     //
     // methods to update constant buffers
@@ -184,9 +189,9 @@ namespace VSD3DStarter
     float Emissive[4];
     float SpecularPower;
 
-    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Textures[MaxTextures];
+    TextureReference Textures[MaxTextures];
     Microsoft::WRL::ComPtr<ID3D11VertexShader> VertexShader;
-    Microsoft::WRL::ComPtr<ID3D11PixelShader> PixelShader;
+    PixelShaderReference PixelShader;
     Microsoft::WRL::ComPtr<ID3D11SamplerState> SamplerState;
     };
 
@@ -864,11 +869,26 @@ namespace VSD3DStarter
     class Camera
     {
     public:
+        //
+        // frustum planes as (normal, distance) with normals pointing into the frustum
+        //
+        enum FrustumPlane
+        {
+            FrustumLeft = 0,
+            FrustumRight,
+            FrustumBottom,
+            FrustumTop,
+            FrustumNear,
+            FrustumFar,
+            FrustumPlaneCount
+        };
+
         Camera()
         {
             DirectX::XMMATRIX identity = DirectX::XMMatrixIdentity();
             DirectX::XMStoreFloat4x4(&m_view, identity);
             DirectX::XMStoreFloat4x4(&m_proj, identity);
+            DirectX::XMStoreFloat4x4(&m_orientationMatrix, identity);
 
             m_viewWidth = 1;
             m_viewHeight = 1;
@@ -876,12 +896,46 @@ namespace VSD3DStarter
             m_position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
             m_lookAt   = DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f);
             m_up       = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
+
+            m_dirty = DirtyView | DirtyViewProjection;
         }
 
-        const DirectX::XMMATRIX GetView() const  { return XMLoadFloat4x4(&m_view); }
+        //
+        // the matrices below are recomputed on first use after a setter changed them
+        //
+        const DirectX::XMMATRIX GetView() const { UpdateView(); return XMLoadFloat4x4(&m_view); }
         const DirectX::XMMATRIX GetProjection() const { return XMLoadFloat4x4(&m_proj); }
         const DirectX::XMMATRIX GetOrientationMatrix() const { return XMLoadFloat4x4(&m_orientationMatrix); }
 
+        //
+        // view * projection * orientation, the whole world to clip space transform
+        //
+        const DirectX::XMMATRIX GetViewProjection() const { UpdateViewProjection(); return XMLoadFloat4x4(&m_viewProjection); }
+
+        //
+        // inverse of view * projection without the orientation; pointer positions and the
+        // viewport are in logical, unrotated pixels, so they unproject through this
+        //
+        const DirectX::XMMATRIX GetInverseLogicalViewProjection() const { UpdateViewProjection(); return XMLoadFloat4x4(&m_inverseLogicalViewProjection); }
+
+        //
+        // world space frustum planes, indexed by FrustumPlane
+        //
+        const DirectX::XMFLOAT4* GetFrustumPlanes() const { UpdateViewProjection(); return m_frustumPlanes; }
+
+        bool XM_CALLCONV IsSphereVisible(DirectX::FXMVECTOR center, float radius) const
+        {
+            UpdateViewProjection();
+            for (UINT i = 0; i < FrustumPlaneCount; i++)
+            {
+                if (DirectX::XMVectorGetX(DirectX::XMPlaneDotCoord(DirectX::XMLoadFloat4(&m_frustumPlanes[i]), center)) < -radius)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
         const DirectX::XMFLOAT3& GetPosition() const { return m_position; }
         const DirectX::XMFLOAT3& GetLookAt() const { return m_lookAt; }
         const DirectX::XMFLOAT3& GetUpVector() const { return m_up; }
@@ -892,83 +946,135 @@ namespace VSD3DStarter
             m_viewHeight = h;
         }
 
+        UINT GetViewportWidth() const { return m_viewWidth; }
+        UINT GetViewportHeight() const { return m_viewHeight; }
+
         void SetProjection(float fovY, float aspect, float zn, float zf)
         {
             DirectX::XMMATRIX p = DirectX::XMMatrixPerspectiveFovRH(fovY, aspect, zn, zf);
             XMStoreFloat4x4(&m_proj, p);
+            m_dirty |= DirtyViewProjection;
         }
 
         void SetProjectionOrthographic(float viewWidth, float viewHeight, float zn, float zf)
         {
             DirectX::XMMATRIX p = DirectX::XMMatrixOrthographicRH(viewWidth, viewHeight, zn, zf);
             XMStoreFloat4x4(&m_proj, p);
+            m_dirty |= DirtyViewProjection;
         }
 
         void SetProjectionOrthographicOffCenter(float viewLeft, float viewRight, float viewBottom, float viewTop, float zn, float zf)
         {
             DirectX::XMMATRIX p = DirectX::XMMatrixOrthographicOffCenterRH(viewLeft, viewRight, viewBottom, viewTop, zn, zf);
             XMStoreFloat4x4(&m_proj, p);
+            m_dirty |= DirtyViewProjection;
         }
 
         void SetPosition(const DirectX::XMFLOAT3& position)
         {
             m_position = position;
-            this->UpdateView();
+            m_dirty |= DirtyView | DirtyViewProjection;
         }
 
         void SetLookAt(const DirectX::XMFLOAT3& lookAt)
         {
             m_lookAt = lookAt;
-            this->UpdateView();
+            m_dirty |= DirtyView | DirtyViewProjection;
         }
 
         void SetUpVector(const DirectX::XMFLOAT3& up)
         {
             m_up = up;
-            this->UpdateView();
+            m_dirty |= DirtyView | DirtyViewProjection;
         }
 
         void SetOrientationMatrix(const DirectX::XMFLOAT4X4& orientationMatrix)
         {
             m_orientationMatrix = orientationMatrix;
+            m_dirty |= DirtyViewProjection;
         }
 
-        void GetWorldLine(UINT pixelX, UINT pixelY, DirectX::XMFLOAT3* outPoint, DirectX::XMFLOAT3* outDir)
+        void GetWorldLine(UINT pixelX, UINT pixelY, DirectX::XMFLOAT3* outPoint, DirectX::XMFLOAT3* outDir) const
         {
-            DirectX::XMFLOAT4 p0 = DirectX::XMFLOAT4((float)pixelX, (float)pixelY, 0, 1);
-            DirectX::XMFLOAT4 p1 = DirectX::XMFLOAT4((float)pixelX, (float)pixelY, 1, 1);
-
-            DirectX::XMVECTOR screen0 =  DirectX::XMLoadFloat4(&p0);
-            DirectX::XMVECTOR screen1 = DirectX::XMLoadFloat4(&p1);
-
-            DirectX::XMMATRIX projMat = XMLoadFloat4x4(&m_proj);
-            DirectX::XMMATRIX viewMat = XMLoadFloat4x4(&m_view);
+            //
+            // logical pixel to unrotated clip space, then back to the world through the
+            // cached inverse
+            //
+            float x = 2.0f * pixelX / m_viewWidth - 1.0f;
+            float y = 1.0f - 2.0f * pixelY / m_viewHeight;
 
-            DirectX::XMVECTOR pp0 = DirectX::XMVector3Unproject(screen0, 0, 0, (float)m_viewWidth, (float)m_viewHeight, 0, 1, projMat, viewMat, DirectX::XMMatrixIdentity());
-            DirectX::XMVECTOR pp1 = DirectX::XMVector3Unproject(screen1, 0, 0, (float)m_viewWidth, (float)m_viewHeight, 0, 1, projMat, viewMat, DirectX::XMMatrixIdentity());
+            DirectX::XMMATRIX inverse = GetInverseLogicalViewProjection();
+            DirectX::XMVECTOR pp0 = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(x, y, 0.0f, 1.0f), inverse);
+            DirectX::XMVECTOR pp1 = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(x, y, 1.0f, 1.0f), inverse);
 
             DirectX::XMStoreFloat3(outPoint, pp0);
-            DirectX::XMStoreFloat3(outDir, pp1);
-
-            outDir->x -= outPoint->x;
-            outDir->y -= outPoint->y;
-            outDir->z -= outPoint->z;
+            DirectX::XMStoreFloat3(outDir, DirectX::XMVectorSubtract(pp1, pp0));
         }
 
     private:
-        void UpdateView()
+        static const UINT DirtyView = 1;
+        static const UINT DirtyViewProjection = 2;
+
+        void UpdateView() const
         {
+            if ((m_dirty & DirtyView) == 0)
+            {
+                return;
+            }
+
             DirectX::XMVECTOR vPosition = DirectX::XMLoadFloat3(&m_position);
             DirectX::XMVECTOR vLook = DirectX::XMLoadFloat3(&m_lookAt);
             DirectX::XMVECTOR vUp = DirectX::XMLoadFloat3(&m_up);
 
             DirectX::XMMATRIX v = DirectX::XMMatrixLookAtRH(vPosition, vLook, vUp);
             DirectX::XMStoreFloat4x4(&m_view, v);
+            m_dirty &= ~DirtyView;
+        }
+
+        void UpdateViewProjection() const
+        {
+            if ((m_dirty & DirtyViewProjection) == 0)
+            {
+                return;
+            }
+
+            UpdateView();
+
+            DirectX::XMMATRIX logicalViewProjection = XMLoadFloat4x4(&m_view) * XMLoadFloat4x4(&m_proj);
+            DirectX::XMMATRIX viewProjection = logicalViewProjection * XMLoadFloat4x4(&m_orientationMatrix);
+            DirectX::XMStoreFloat4x4(&m_viewProjection, viewProjection);
+            DirectX::XMStoreFloat4x4(&m_inverseLogicalViewProjection, DirectX::XMMatrixInverse(nullptr, logicalViewProjection));
+
+            //
+            // with row vectors clip = world * M, so each plane is a sum or difference of
+            // columns of M; D3D clip depth runs from 0 to w
+            //
+            DirectX::XMMATRIX columns = DirectX::XMMatrixTranspose(viewProjection);
+            DirectX::XMVECTOR planes[FrustumPlaneCount] =
+            {
+                DirectX::XMVectorAdd(columns.r[3], columns.r[0]),
+                DirectX::XMVectorSubtract(columns.r[3], columns.r[0]),
+                DirectX::XMVectorAdd(columns.r[3], columns.r[1]),
+                DirectX::XMVectorSubtract(columns.r[3], columns.r[1]),
+                columns.r[2],
+                DirectX::XMVectorSubtract(columns.r[3], columns.r[2]),
+            };
+
+            for (UINT i = 0; i < FrustumPlaneCount; i++)
+            {
+                DirectX::XMStoreFloat4(&m_frustumPlanes[i], DirectX::XMPlaneNormalize(planes[i]));
+            }
+
+            m_dirty &= ~DirtyViewProjection;
         }
 
-        DirectX::XMFLOAT4X4 m_view;
+        mutable DirectX::XMFLOAT4X4 m_view;
         DirectX::XMFLOAT4X4 m_proj;
         DirectX::XMFLOAT4X4 m_orientationMatrix;
+        mutable DirectX::XMFLOAT4X4 m_viewProjection;
+        mutable DirectX::XMFLOAT4X4 m_inverseLogicalViewProjection;
+        mutable DirectX::XMFLOAT4 m_frustumPlanes[FrustumPlaneCount];
+        mutable UINT m_dirty;
         DirectX::XMFLOAT3 m_position;
         DirectX::XMFLOAT3 m_lookAt;
         DirectX::XMFLOAT3 m_up;
@@ -980,6 +1086,9 @@ namespace VSD3DStarter
     ///////////////////////////////////////////////////////////////////////////////////////////
 
 
+    typedef ResourceReference<ID3D11PixelShader> PixelShaderReference;
+    typedef ResourceReference<ID3D11ShaderResourceView> TextureReference;
+
     ///////////////////////////////////////////////////////////////////////////////////////////
     //
     // Graphics wraps D3D engine and related constant buffers
@@ -990,7 +1099,9 @@ namespace VSD3DStarter
         //
         // construction/destruction
         //
-        Graphics()
+        Graphics() :
+            m_jobs(nullptr),
+            m_textureStreaming(false)
         {
         }
 
@@ -1099,15 +1210,18 @@ namespace VSD3DStarter
             INT32 white = 0xffffffff;
             m_deviceContext->UpdateSubresource(m_nullTexture.Get(), 0, nullptr, &white, sizeof(white), sizeof(white));
 
-            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> nullTextureView;
-            m_device->CreateShaderResourceView(m_nullTexture.Get(), nullptr, &nullTextureView);
-            m_textureResources[L""] = nullTextureView;
+            m_device->CreateShaderResourceView(m_nullTexture.Get(), nullptr, &m_nullTextureView);
+            m_textures.Add(HashResourceName(L""), m_nullTextureView.Get());
+
+            m_textureStreamer.Initialize(m_device.Get(), m_deviceContext.Get(), &m_files);
         }
 
         void Shutdown()
         {
-            m_pixelShaderResources.clear();
-            m_textureResources.clear();
+            m_textureStreamer.Shutdown();
+            m_pixelShaders.Clear();
+            m_textures.Clear();
+            m_files.Trim();
         }
 
         //
@@ -1125,62 +1239,144 @@ namespace VSD3DStarter
         ID3D11Buffer* GetMiscConstants() const { return m_miscConstants.Get(); }
 
         ID3D11SamplerState* GetSamplerState() const { return m_sampler.Get(); }
+        ID3D11ShaderResourceView* GetNullTextureView() const { return m_nullTextureView.Get(); }
         ID3D11InputLayout* GetVertexInputLayout() const { return m_vertexLayout.Get(); }
         ID3D11VertexShader* GetVertexShader() const { return m_vertexShader.Get(); }
 
-        ID3D11PixelShader* GetOrCreatePixelShader(const std::wstring& shaderName)
+        //
+        // jobs spread CPU texture work such as mip generation; without them it runs inline
+        //
+        void SetJobSystem(JobSystem* jobs)
         {
-            Microsoft::WRL::ComPtr<ID3D11PixelShader> result = nullptr;
+            m_jobs = jobs;
+            m_textureStreamer.SetJobSystem(jobs);
+        }
+
+        JobSystem* GetJobSystem() const { return m_jobs; }
+
+        //
+        // shader, texture and mesh files are all read through this; initialize it with other
+        // settings before loading, and read its statistics and timings to profile loads
+        //
+        FileReader& GetFileReader() { return m_files; }
 
-            auto iter = m_pixelShaderResources.find(shaderName);
-            if (iter != m_pixelShaderResources.end())
+        //
+        // reads a whole file into data, which goes back to the reader's pool once reset or
+        // destroyed; false, with data empty, when the file cannot be read
+        //
+        bool ReadFile(const std::wstring& filename, FileBuffer& data)
+        {
+            if (!m_files.Read(filename, data))
             {
-                result = iter->second;
+                std::wstring error = L"*** File could not be opened \"" + filename + L"\" \n";
+                OutputDebugString(error.c_str());
+                return false;
             }
-            else
+
+            return true;
+        }
+
+        //
+        // with streaming on, meshes load textures through GetOrOpenStreamedTexture and draws
+        // request the levels their screen size needs; call UpdateTextureStreaming once a frame.
+        // The budget bounds the bytes those textures keep resident, 0 leaving them unbounded.
+        //
+        void SetTextureStreaming(bool enabled) { m_textureStreaming = enabled; }
+        void SetTextureBudget(std::uint64_t bytes) { m_textureStreamer.SetBudget(bytes); }
+        bool IsTextureStreaming() const { return m_textureStreaming; }
+        TextureStreamer& GetTextureStreamer() { return m_textureStreamer; }
+
+        //
+        // resources are looked up by the hash of their name and shared through counted
+        // references; each is freed once the last material holding it goes
+        //
+        PixelShaderReference GetOrCreatePixelShader(const std::wstring& shaderName)
+        {
+            std::uint64_t nameHash = HashResourceName(shaderName);
+            ResourceHandle handle = m_pixelShaders.Find(nameHash);
+            if (handle.IsNull())
             {
-                std::vector<BYTE> psBuffer;
-                Graphics::ReadFile(shaderName, psBuffer);
-                if (psBuffer.size() > 0)
+                FileBuffer psBuffer;
+                this->ReadFile(shaderName, psBuffer);
+                if (!psBuffer.Empty())
                 {
-                    this->GetDevice()->CreatePixelShader(&psBuffer[0], psBuffer.size(), nullptr, &result);
+                    Microsoft::WRL::ComPtr<ID3D11PixelShader> result;
+                    this->GetDevice()->CreatePixelShader(psBuffer.Data(), psBuffer.Size(), nullptr, &result);
                     if (result == nullptr) 
                     {
                         throw std::exception("Pixel Shader could not be created");
                     }
 
-                    m_pixelShaderResources[shaderName] = result;
+                    handle = m_pixelShaders.Add(nameHash, result.Get());
                 }
             }
 
-            return result.Get();
+            return PixelShaderReference(&m_pixelShaders, handle);
         }
 
-        ID3D11ShaderResourceView* GetOrCreateTexture(const std::wstring& textureName)
+        TextureReference GetOrCreateTexture(const std::wstring& textureName, bool generateMipsWhenNeeded)
         {
-            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> result;
-
-            auto iter = m_textureResources.find(textureName);
-            if (iter != m_textureResources.end())
-            {
-                result = iter->second;
-            }
-            else
+            std::uint64_t nameHash = HashResourceName(textureName);
+            ResourceHandle handle = m_textures.Find(nameHash);
+            if (handle.IsNull())
             {
-                std::vector<BYTE> ddsBuffer;
-                Graphics::ReadFile(textureName, ddsBuffer);
-                if (ddsBuffer.size() > 0)
+                FileBuffer ddsBuffer;
+                this->ReadFile(textureName, ddsBuffer);
+                if (!ddsBuffer.Empty())
                 {
-                    result = this->CreateTextureFromDDSInMemory(&ddsBuffer[0], ddsBuffer.size());
+                    //
+                    // a file given mips is replaced by the mipped copy
+                    //
+                    std::vector<BYTE> mipped;
+                    const BYTE* ddsData = ddsBuffer.Data();
+                    size_t ddsDataSize = ddsBuffer.Size();
+                    if (generateMipsWhenNeeded && TextureStreamer::GenerateMissingMips(ddsData, ddsDataSize, m_deviceFeatureLevel, m_jobs, mipped))
+                    {
+                        ddsData = mipped.data();
+                        ddsDataSize = mipped.size();
+                    }
+
+                    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> result;
+                    result.Attach(this->CreateTextureFromDDSInMemory(ddsData, ddsDataSize));
                     if (result == nullptr) 
                     {
                         throw std::exception("Texture could not be created");
                     }
-                    m_textureResources[textureName] = result;
+
+                    handle = m_textures.Add(nameHash, result.Get());
                 }
             }
 
-            return result.Get();
+            return TextureReference(&m_textures, handle);
+        }
+
+        //
+        // registers a DDS file built in memory, such as a baked atlas, under textureName,
+        // replacing any texture of that name for later lookups
+        //
+        TextureReference CreateTexture(const std::wstring& textureName, const BYTE* ddsData, size_t ddsDataSize)
+        {
+            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> result;
+            result.Attach(this->CreateTextureFromDDSInMemory(ddsData, ddsDataSize));
+            if (result == nullptr)
+            {
+                return TextureReference();
+            }
+
+            return TextureReference(&m_textures, m_textures.Add(HashResourceName(textureName), result.Get()));
+        }
+
+        //
+        // null when streaming is off or the file cannot be read; load it with GetOrCreateTexture then
+        //
+        StreamedTextureReference GetOrOpenStreamedTexture(const std::wstring& textureName)
+        {
+            return m_textureStreaming ? m_textureStreamer.GetOrOpen(textureName) : StreamedTextureReference();
+        }
+
+        void UpdateTextureStreaming()
+        {
+            m_textureStreamer.Update();
         }
 
         //
@@ -1204,48 +1400,6 @@ namespace VSD3DStarter
         }
 
     private:
-        static void ReadFile(const std::wstring& filename, std::vector<BYTE>& data)
-        {
-            //
-            // clear file data
-            //
-            data.clear();
-
-            //
-            // open the file
-            //
-            FILE* fp = nullptr;
-            _wfopen_s(&fp, filename.c_str(), L"rb");
-            if (fp == nullptr)
-            {
-                std::wstring error = L"*** File could not be opened \"" + filename + L"\" \n";
-                OutputDebugString(error.c_str());
-            }
-            else
-            {
-                // 
-                // determine file size and prepare buffer to read all the data
-                //
-                fseek(fp, 0, SEEK_END);
-                long pos = ftell(fp);
-                data.resize(pos);
-                fseek(fp, 0, SEEK_SET);
-
-                //
-                // read data into the prepared buffer
-                //
-                if (pos > 0)
-                {
-                    fread(&data[0], 1, pos, fp);
-                }
-
-                //
-                // close the file
-                //
-                fclose(fp);
-            }
-        }
-
         ID3D11ShaderResourceView* CreateTextureFromDDSInMemory(const BYTE* ddsData, size_t ddsDataSize)
         {
             ID3D11ShaderResourceView* textureView = nullptr;
@@ -1267,8 +1421,12 @@ namespace VSD3DStarter
             return nullptr;
         }
         
-        std::map<std::wstring, Microsoft::WRL::ComPtr<ID3D11PixelShader>> m_pixelShaderResources;
-        std::map<std::wstring, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> m_textureResources;
+        FileReader m_files;
+        ResourceRegistry<ID3D11PixelShader> m_pixelShaders;
+        ResourceRegistry<ID3D11ShaderResourceView> m_textures;
+        TextureStreamer m_textureStreamer;
+        bool m_textureStreaming;
+        JobSystem* m_jobs;
 
         mutable Camera m_camera; 
 
@@ -1285,12 +1443,25 @@ namespace VSD3DStarter
         Microsoft::WRL::ComPtr<ID3D11InputLayout> m_vertexLayout;
         Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vertexShader;
         Microsoft::WRL::ComPtr<ID3D11Texture2D> m_nullTexture;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_nullTextureView;
     };
     //
     //
     ///////////////////////////////////////////////////////////////////////////////////////////
 
 
+    struct TexturePackSettings
+    {
+        TexturePackSettings() :
+            MaxTextureSize(256),
+            MaxAtlasSize(2048)
+        {
+        }
+
+        UINT MaxTextureSize;            // textures with a larger side keep a binding of their own
+        UINT MaxAtlasSize;
+    };
+
     ///////////////////////////////////////////////////////////////////////////////////////////
     //
     // Mesh is a class used to display meshes in 3d which are converted
@@ -1314,7 +1485,16 @@ namespace VSD3DStarter
 
         struct Material
         {
-            Material() { ZeroMemory(this, sizeof(Material)); }
+            Material() : SpecularPower(0.0f)
+            {
+                ZeroMemory(&UVTransform, sizeof(UVTransform));
+                ZeroMemory(Ambient, sizeof(Ambient));
+                ZeroMemory(Diffuse, sizeof(Diffuse));
+                ZeroMemory(Specular, sizeof(Specular));
+                ZeroMemory(Emissive, sizeof(Emissive));
+                ZeroMemory(UVMin, sizeof(UVMin));
+                ZeroMemory(UVMax, sizeof(UVMax));
+            }
             ~Material() { }
 
             std::wstring Name;
@@ -1327,10 +1507,15 @@ namespace VSD3DStarter
             float Emissive[4];
             float SpecularPower;
 
-            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Textures[MaxTextures];
+            TextureReference Textures[MaxTextures];
+            StreamedTextureReference StreamedTextures[MaxTextures]; // used instead of Textures when set
+            std::wstring TextureFiles[MaxTextures];             // as loaded, for packing
             Microsoft::WRL::ComPtr<ID3D11VertexShader> VertexShader;
-            Microsoft::WRL::ComPtr<ID3D11PixelShader> PixelShader;
+            PixelShaderReference PixelShader;
             Microsoft::WRL::ComPtr<ID3D11SamplerState> SamplerState;
+
+            float UVMin[2];                                     // bounds of the vertex UVs its submeshes use,
+            float UVMax[2];                                     // before UVTransform
         };
 
         struct MeshExtents
@@ -1431,14 +1616,13 @@ namespace VSD3DStarter
 
             BOOL supportsShaderResources = graphics.GetDeviceFeatureLevel() >= D3D_FEATURE_LEVEL_10_0;
 
-            const DirectX::XMMATRIX& view = graphics.GetCamera().GetView();
-            const DirectX::XMMATRIX& projection = graphics.GetCamera().GetProjection() * graphics.GetCamera().GetOrientationMatrix();
+            const Camera& camera = graphics.GetCamera();
+            const DirectX::XMMATRIX view = camera.GetView();
 
             //
-            // compute the object matrices
+            // compute the object matrices; the camera caches view * projection
             //
-            DirectX::XMMATRIX localToView = world * view;
-            DirectX::XMMATRIX localToProj = world * view * projection;
+            DirectX::XMMATRIX localToProj = world * camera.GetViewProjection();
 
             //
             // initialize object constants and update the constant buffer
@@ -1449,9 +1633,29 @@ namespace VSD3DStarter
             objConstants.WorldToLocal4x4 = DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, world));
             objConstants.WorldToView4x4 = DirectX::XMMatrixTranspose(view);
             objConstants.UvTransform4x4 = DirectX::XMMatrixIdentity();
-            objConstants.EyePosition = graphics.GetCamera().GetPosition();
+            objConstants.EyePosition = camera.GetPosition();
             graphics.UpdateObjectConstants(objConstants);
 
+            //
+            // screen height of the bounds, which sets the texture levels streamed textures need;
+            // nothing is requested while the mesh is off screen
+            //
+            float projectedPixels = 0.0f;
+            {
+                DirectX::XMVECTOR center = DirectX::XMVector3TransformCoord(
+                    DirectX::XMVectorSet(m_meshExtents.CenterX, m_meshExtents.CenterY, m_meshExtents.CenterZ, 1.0f), world);
+                float scale = std::max(std::max(DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[0])),
+                    DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[1]))), DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[2])));
+                float radius = m_meshExtents.Radius * scale;
+
+                if (camera.IsSphereVisible(center, radius))
+                {
+                    float w = DirectX::XMVectorGetW(DirectX::XMVector4Transform(DirectX::XMVectorSetW(center, 1.0f), camera.GetViewProjection()));
+                    float viewportSize = static_cast<float>(std::max(camera.GetViewportWidth(), camera.GetViewportHeight()));
+                    projectedPixels = radius * DirectX::XMVectorGetY(camera.GetProjection().r[1]) * viewportSize / std::max(w, radius);
+                }
+            }
+
             //
             // assign constant buffers to correct slots
             //
@@ -1472,6 +1676,12 @@ namespace VSD3DStarter
             //
             // loop over each submesh
             //
+            //
+            // submeshes sharing textures, such as those packed into one atlas, skip rebinding them
+            //
+            ID3D11ShaderResourceView* boundTextures[MaxTextures];
+            bool texturesBound = false;
+
             for (SubMesh& submesh : m_submeshes)
             {
                 //
@@ -1536,6 +1746,39 @@ namespace VSD3DStarter
                     {
                         ID3D11ShaderResourceView* texture = material.Textures[tex].Get();
 
+                        StreamedTexture* streamed = material.StreamedTextures[tex].Get();
+                        if (streamed != nullptr)
+                        {
+                            //
+                            // a texture repeated across the mesh spans a fraction of it per repeat
+                            //
+                            if (projectedPixels > 0.0f)
+                            {
+                                float repeat = std::max(
+                                    sqrtf(material.UVTransform._11 * material.UVTransform._11 + material.UVTransform._12 * material.UVTransform._12),
+                                    sqrtf(material.UVTransform._21 * material.UVTransform._21 + material.UVTransform._22 * material.UVTransform._22));
+                                UINT size = std::max(streamed->Width(), streamed->Height());
+                                streamed->RequestMip(TextureStreamer::MipForProjectedSize(size, projectedPixels / std::max(repeat, 1e-3f)));
+                            }
+
+                            //
+                            // white stands in for a texture evicted to stay within the budget
+                            // until its read comes back
+                            //
+                            texture = streamed->GetView();
+                            if (texture == nullptr)
+                            {
+                                texture = graphics.GetNullTextureView();
+                            }
+                        }
+
+                        if (texturesBound && boundTextures[tex] == texture)
+                        {
+                            continue;
+                        }
+
+                        boundTextures[tex] = texture;
+
                         if (supportsShaderResources)
                         {
                             deviceContext->VSSetShaderResources(0+tex, 1, &texture);
@@ -1546,6 +1789,8 @@ namespace VSD3DStarter
                         deviceContext->PSSetShaderResources(MaxTextures+tex, 1, &texture);
                     }
 
+                    texturesBound = true;
+
                     //
                     // draw the submesh
                     //
@@ -1554,6 +1799,209 @@ namespace VSD3DStarter
             }
         }
 
+        //
+        // Moves the small textures of materials across meshes into shared atlases and points
+        // the materials' UV transforms at their rects, so submeshes using one pack draw
+        // without rebinding textures. A material packs when every texture it has is 2D, no
+        // larger than MaxTextureSize, the same size as its others, and sampled within 0 to 1
+        // once transformed, since an atlas cannot wrap. Materials whose textures are the same
+        // size, with the same formats in the same slots, share an atlas per slot, laid out
+        // alike. Texture arrays would not bleed at the rect edges, but the material shaders
+        // sample a single 2D texture. Returns the number of materials repointed.
+        //
+        static UINT PackTextures(Graphics& graphics, const std::vector<Mesh*>& meshes, const TexturePackSettings& settings = TexturePackSettings())
+        {
+            struct PackGroup
+            {
+                std::vector<std::vector<std::wstring>> Entries;         // a file per slot, each set once
+                std::vector<std::pair<Material*, size_t>> Materials;    // and the entry each one uses
+            };
+
+            std::map<std::wstring, std::vector<BYTE>> files;
+            std::map<std::vector<UINT>, PackGroup> groups;              // by width and height, then the slot and format of each texture
+
+            auto loadFile = [&](const std::wstring& fileName) -> const std::vector<BYTE>&
+            {
+                auto iter = files.find(fileName);
+                if (iter == files.end())
+                {
+                    iter = files.insert(std::make_pair(fileName, std::vector<BYTE>())).first;
+
+                    FileBuffer data;
+                    if (graphics.ReadFile(fileName, data))
+                    {
+                        iter->second.assign(data.Data(), data.Data() + data.Size());
+                    }
+
+                    TextureStreamer::GenerateMissingMips(iter->second, graphics.GetDeviceFeatureLevel(), graphics.GetJobSystem());
+                }
+
+                return iter->second;
+            };
+
+            for (Mesh* mesh : meshes)
+            {
+                for (Material& material : mesh->m_materials)
+                {
+                    if (material.UVMin[0] > material.UVMax[0])
+                    {
+                        continue;
+                    }
+
+                    //
+                    // the matrix reaches the shader untransposed, so it maps column vectors
+                    //
+                    const DirectX::XMFLOAT4X4& uv = material.UVTransform;
+                    bool inside = true;
+                    for (UINT corner = 0; corner < 4; corner++)
+                    {
+                        float u = (corner & 1) ? material.UVMax[0] : material.UVMin[0];
+                        float v = (corner & 2) ? material.UVMax[1] : material.UVMin[1];
+                        float tu = uv._11 * u + uv._12 * v + uv._14;
+                        float tv = uv._21 * u + uv._22 * v + uv._24;
+                        inside = inside && tu >= -1e-3f && tu <= 1.001f && tv >= -1e-3f && tv <= 1.001f;
+                    }
+
+                    std::vector<UINT> key;
+                    std::vector<std::wstring> entry;
+                    UINT width = 0;
+                    UINT height = 0;
+                    for (UINT t = 0; inside && t < MaxTextures; t++)
+                    {
+                        if (material.TextureFiles[t].empty())
+                        {
+                            continue;
+                        }
+
+                        const std::vector<BYTE>& data = loadFile(material.TextureFiles[t]);
+                        DirectX::DDSTexture texture;
+                        inside = !data.empty() && texture.Parse(&data[0], data.size()) == DirectX::DDS_OK && DirectX::AtlasAlignment(texture) != 0 &&
+                            texture.Width() <= settings.MaxTextureSize && texture.Height() <= settings.MaxTextureSize &&
+                            (key.empty() || (texture.Width() == width && texture.Height() == height));
+
+                        width = texture.Width();
+                        height = texture.Height();
+                        key.push_back(t);
+                        key.push_back(texture.Format());
+                        entry.push_back(material.TextureFiles[t]);
+                    }
+
+                    if (!inside || key.empty())
+                    {
+                        continue;
+                    }
+
+                    //
+                    // only textures of one size share an atlas, so a small one cannot force a
+                    // large one onto a grid too fine to keep its mips
+                    //
+                    key.insert(key.begin(), height);
+                    key.insert(key.begin(), width);
+
+                    PackGroup& group = groups[key];
+                    size_t entryIndex = std::find(group.Entries.begin(), group.Entries.end(), entry) - group.Entries.begin();
+                    if (entryIndex == group.Entries.size())
+                    {
+                        group.Entries.push_back(entry);
+                    }
+
+                    group.Materials.push_back(std::make_pair(&material, entryIndex));
+                }
+            }
+
+            UINT packed = 0;
+            for (auto& keyAndGroup : groups)
+            {
+                const std::vector<UINT>& key = keyAndGroup.first;
+                size_t slotCount = (key.size() - 2) / 2;
+                PackGroup& group = keyAndGroup.second;
+                if (group.Entries.size() < 2)
+                {
+                    continue;
+                }
+
+                //
+                // one layout serves every slot, on the coarsest grid any of the textures needs;
+                // the textures are all one size, so that grid still divides every side. Levels
+                // where a texture is smaller than a compressed block cannot be kept in an atlas.
+                //
+                std::vector<DirectX::AtlasRect> rects(group.Entries.size());
+                uint32_t alignment = 0;
+                for (size_t e = 0; e < group.Entries.size(); e++)
+                {
+                    for (const std::wstring& fileName : group.Entries[e])
+                    {
+                        const std::vector<BYTE>& data = files[fileName];
+                        DirectX::DDSTexture texture;
+                        texture.Parse(&data[0], data.size());
+                        alignment = std::max(alignment, DirectX::AtlasAlignment(texture));
+                        rects[e].Width = texture.Width();
+                        rects[e].Height = texture.Height();
+                    }
+                }
+
+                uint32_t width;
+                uint32_t height;
+                if (!DirectX::PackAtlas(alignment, settings.MaxAtlasSize, rects, width, height))
+                {
+                    continue;
+                }
+
+                std::vector<TextureReference> atlases;
+                for (size_t s = 0; s < slotCount; s++)
+                {
+                    std::vector<const uint8_t*> data;
+                    std::vector<size_t> sizes;
+                    for (const std::vector<std::wstring>& entry : group.Entries)
+                    {
+                        const std::vector<BYTE>& file = files[entry[s]];
+                        data.push_back(&file[0]);
+                        sizes.push_back(file.size());
+                    }
+
+                    std::vector<uint8_t> atlas;
+                    if (DirectX::BakeDDSAtlas(&data[0], &sizes[0], &rects[0], rects.size(), width, height, atlas) != DirectX::DDS_OK)
+                    {
+                        break;
+                    }
+
+                    atlases.push_back(graphics.CreateTexture(L"atlas|" + group.Entries[0][s], &atlas[0], atlas.size()));
+                    if (atlases.back().Get() == nullptr)
+                    {
+                        break;
+                    }
+                }
+
+                if (atlases.size() != slotCount)
+                {
+                    continue;
+                }
+
+                for (auto& materialAndEntry : group.Materials)
+                {
+                    Material& material = *materialAndEntry.first;
+                    const DirectX::AtlasRect& rect = rects[materialAndEntry.second];
+
+                    DirectX::XMMATRIX place(
+                        static_cast<float>(rect.Width) / width, 0.0f, 0.0f, static_cast<float>(rect.X) / width,
+                        0.0f, static_cast<float>(rect.Height) / height, 0.0f, static_cast<float>(rect.Y) / height,
+                        0.0f, 0.0f, 1.0f, 0.0f,
+                        0.0f, 0.0f, 0.0f, 1.0f);
+                    DirectX::XMStoreFloat4x4(&material.UVTransform, DirectX::XMMatrixMultiply(place, DirectX::XMLoadFloat4x4(&material.UVTransform)));
+
+                    for (size_t s = 0; s < atlases.size(); s++)
+                    {
+                        material.Textures[key[2 + 2 * s]] = atlases[s];
+                        material.StreamedTextures[key[2 + 2 * s]].Reset();
+                    }
+
+                    packed++;
+                }
+            }
+
+            return packed;
+        }
+
         //
         // loads a scene from the specified file, returning a vector of mesh objects
         //
@@ -1575,11 +2023,10 @@ namespace VSD3DStarter
             }
 
             //
-            // open the mesh file
+            // read the whole mesh file, then parse it from memory
             //
-            FILE* fp = nullptr;
-            _wfopen_s(&fp, meshFilename.c_str(), L"rb"); 
-            if (fp == nullptr)
+            FileBuffer data;
+            if (!graphics.GetFileReader().Read(meshFilename, data))
             {
                 std::wstring error = L"Mesh file could not be opened " + meshFilename + L"\n";
                 OutputDebugString(error.c_str());
@@ -1589,8 +2036,9 @@ namespace VSD3DStarter
                 //
                 // read how many meshes are part of the scene
                 //
+                FileCursor file(data.Data(), data.Size());
                 UINT meshCount = 0;
-                fread(&meshCount, sizeof(meshCount), 1, fp);
+                file.Read(&meshCount, sizeof(meshCount), 1);
 
                 //
                 // for each mesh in the scene, load it from the file
@@ -1598,7 +2046,7 @@ namespace VSD3DStarter
                 for (UINT i = 0; i < meshCount; i++)
                 {
                     Mesh* mesh = nullptr;
-                    Mesh::Load(fp, graphics, shaderPathLocation, texturePathLocation, mesh);
+                    Mesh::Load(file, graphics, shaderPathLocation, texturePathLocation, mesh);
                     if (mesh != nullptr)
                     {
                         loadedMeshes.push_back(mesh);
@@ -1622,7 +2070,7 @@ namespace VSD3DStarter
             }
         }
 
-        static void Load(FILE* fp, Graphics& graphics, const std::wstring& shaderPathLocation, const std::wstring& texturePathLocation, Mesh*& outMesh)
+        static void Load(FileCursor& file, Graphics& graphics, const std::wstring& shaderPathLocation, const std::wstring& texturePathLocation, Mesh*& outMesh)
         {
             UNREFERENCED_PARAMETER(texturePathLocation);
 
@@ -1630,16 +2078,16 @@ namespace VSD3DStarter
             // initialize output mesh
             //
             outMesh = nullptr;
-            if (fp != nullptr)
+            if (file.Remaining() > 0)
             {
                 Mesh* mesh = new Mesh();
 
                 UINT nameLen = 0;
-                fread(&nameLen, sizeof(nameLen), 1, fp);
+                file.Read(&nameLen, sizeof(nameLen), 1);
                 if (nameLen > 0)
                 {
                     std::vector<wchar_t> objName(nameLen);
-                    fread(&objName[0], sizeof(wchar_t), nameLen, fp);
+                    file.Read(&objName[0], sizeof(wchar_t), nameLen);
                     mesh->m_name = &objName[0];
                 }
 
@@ -1647,7 +2095,7 @@ namespace VSD3DStarter
                 // read material count
                 //
                 UINT numMaterials = 0;
-                fread(&numMaterials, sizeof(UINT), 1, fp);
+                file.Read(&numMaterials, sizeof(UINT), 1);
                 mesh->m_materials.resize(numMaterials);
 
                 //
@@ -1661,23 +2109,26 @@ namespace VSD3DStarter
                     // read material name
                     //
                     UINT stringLen = 0;
-                    fread(&stringLen, sizeof(stringLen), 1, fp);
+                    file.Read(&stringLen, sizeof(stringLen), 1);
                     if (stringLen > 0)
                     {
                         std::vector<wchar_t> matName(stringLen);
-                        fread(&matName[0], sizeof(wchar_t), stringLen, fp);
+                        file.Read(&matName[0], sizeof(wchar_t), stringLen);
                         material.Name = &matName[0];
                     }
 
                     //
                     // read ambient and diffuse properties of material
                     //
-                    fread(material.Ambient, sizeof(material.Ambient), 1, fp);
-                    fread(material.Diffuse, sizeof(material.Diffuse), 1, fp);
-                    fread(material.Specular, sizeof(material.Specular), 1, fp);
-                    fread(&material.SpecularPower, sizeof(material.SpecularPower), 1, fp);
-                    fread(material.Emissive, sizeof(material.Emissive), 1, fp);
-                    fread(&material.UVTransform, sizeof(material.UVTransform), 1, fp);
+                    file.Read(material.Ambient, sizeof(material.Ambient), 1);
+                    file.Read(material.Diffuse, sizeof(material.Diffuse), 1);
+                    file.Read(material.Specular, sizeof(material.Specular), 1);
+                    file.Read(&material.SpecularPower, sizeof(material.SpecularPower), 1);
+                    file.Read(material.Emissive, sizeof(material.Emissive), 1);
+                    file.Read(&material.UVTransform, sizeof(material.UVTransform), 1);
+
+                    material.UVMin[0] = material.UVMin[1] = FLT_MAX;
+                    material.UVMax[0] = material.UVMax[1] = -FLT_MAX;
 
                     //
                     // assign vertex shader and sampler state
@@ -1690,14 +2141,14 @@ namespace VSD3DStarter
                     // read name of the pixel shader
                     //
                     stringLen = 0;
-                    fread(&stringLen, sizeof(stringLen), 1, fp);
+                    file.Read(&stringLen, sizeof(stringLen), 1);
                     if (stringLen > 0)
                     {
                         //
                         // read the pixel shader name
                         //
                         std::vector<wchar_t> pixelShaderName(stringLen);
-                        fread(&pixelShaderName[0], sizeof(wchar_t), stringLen, fp);
+                        file.Read(&pixelShaderName[0], sizeof(wchar_t), stringLen);
                         std::wstring sourceFile = &pixelShaderName[0];
 
                         //
@@ -1733,8 +2184,7 @@ namespace VSD3DStarter
                             //
                             // get or create pixel shader
                             //
-                            ID3D11PixelShader* materialPixelShader = graphics.GetOrCreatePixelShader(sourceFile);
-                            material.PixelShader = materialPixelShader;
+                            material.PixelShader = graphics.GetOrCreatePixelShader(sourceFile);
                         }
                     }
 
@@ -1747,21 +2197,29 @@ namespace VSD3DStarter
                         // read name of texture
                         //
                         stringLen = 0;
-                        fread(&stringLen, sizeof(stringLen), 1, fp);
+                        file.Read(&stringLen, sizeof(stringLen), 1);
                         if (stringLen > 0)
                         {
                             //
                             // read the texture name
                             //
                             std::vector<wchar_t> textureFilename(stringLen);
-                            fread(&textureFilename[0], sizeof(wchar_t), stringLen, fp);
+                            file.Read(&textureFilename[0], sizeof(wchar_t), stringLen);
                             std::wstring sourceFile = &textureFilename[0];
+                            material.TextureFiles[t] = sourceFile;
 
                             //
                             // get or create texture
                             //
-                            ID3D11ShaderResourceView* textureResource = graphics.GetOrCreateTexture(sourceFile);
-                            material.Textures[t] = textureResource;
+                            StreamedTextureReference streamed = graphics.GetOrOpenStreamedTexture(sourceFile);
+                            if (streamed.Get() != nullptr)
+                            {
+                                material.StreamedTextures[t] = streamed;
+                            }
+                            else
+                            {
+                                material.Textures[t] = graphics.GetOrCreateTexture(sourceFile, true);
+                            }
                         }
                     }
                 }
@@ -1770,17 +2228,17 @@ namespace VSD3DStarter
                 // does this object contain skeletal animation?
                 //
                 BYTE isSkeletalDataPresent = FALSE;
-                fread(&isSkeletalDataPresent, sizeof(BYTE), 1, fp);
+                file.Read(&isSkeletalDataPresent, sizeof(BYTE), 1);
 
                 //
                 // read submesh info
                 //
                 UINT numSubmeshes = 0;
-                fread(&numSubmeshes, sizeof(UINT), 1, fp);
+                file.Read(&numSubmeshes, sizeof(UINT), 1);
                 mesh->m_submeshes.resize(numSubmeshes);
                 for (UINT i = 0; i < numSubmeshes; i++)
                 {
-                    fread(&(mesh->m_submeshes[i]), sizeof(SubMesh), 1, fp);
+                    file.Read(&(mesh->m_submeshes[i]), sizeof(SubMesh), 1);
                 }
 
 
@@ -1788,7 +2246,7 @@ namespace VSD3DStarter
                 // read index buffers
                 //
                 UINT numIndexBuffers = 0;
-                fread(&numIndexBuffers, sizeof(UINT), 1, fp);
+                file.Read(&numIndexBuffers, sizeof(UINT), 1);
                 mesh->m_indexBuffers.resize(numIndexBuffers);
 
                 std::vector<std::vector<USHORT>> indexBuffers(numIndexBuffers);
@@ -1796,7 +2254,7 @@ namespace VSD3DStarter
                 for (UINT i = 0; i < numIndexBuffers; i++)
                 {
                     UINT ibCount = 0;
-                    fread (&ibCount, sizeof(UINT), 1, fp);
+                    file.Read(&ibCount, sizeof(UINT), 1);
                     if (ibCount > 0)
                     {
                         indexBuffers[i].resize(ibCount);
@@ -1804,7 +2262,7 @@ namespace VSD3DStarter
                         //
                         // read in the index data
                         //
-                        fread(&indexBuffers[i][0], sizeof(USHORT), ibCount, fp);
+                        file.Read(&indexBuffers[i][0], sizeof(USHORT), ibCount);
 
                         //
                         // create an index buffer for this data
@@ -1828,7 +2286,7 @@ namespace VSD3DStarter
                 // read vertex buffers
                 //
                 UINT numVertexBuffers = 0;
-                fread(&numVertexBuffers, sizeof(UINT), 1, fp);
+                file.Read(&numVertexBuffers, sizeof(UINT), 1);
                 mesh->m_vertexBuffers.resize(numVertexBuffers);
 
                 std::vector<std::vector<Vertex>> vertexBuffers(numVertexBuffers);
@@ -1836,7 +2294,7 @@ namespace VSD3DStarter
                 for (UINT i = 0; i < numVertexBuffers; i++)
                 {
                     UINT vbCount = 0;
-                    fread (&vbCount, sizeof(UINT), 1, fp);
+                    file.Read(&vbCount, sizeof(UINT), 1);
                     if (vbCount > 0)
                     {
                         vertexBuffers[i].resize(vbCount);
@@ -1844,7 +2302,7 @@ namespace VSD3DStarter
                         //
                         // read in the vertex data
                         //
-                        fread(&vertexBuffers[i][0], sizeof(Vertex), vbCount, fp);
+                        file.Read(&vertexBuffers[i][0], sizeof(Vertex), vbCount);
 
                         //
                         // create a vertex buffer for this data
@@ -1869,6 +2327,23 @@ namespace VSD3DStarter
                     std::vector<USHORT>& ib = indexBuffers[subMesh.IndexBufferIndex];
                     std::vector<Vertex>& vb = vertexBuffers[subMesh.VertexBufferIndex];
 
+                    //
+                    // the UVs each material is sampled at, which decide whether it can pack
+                    //
+                    if (subMesh.MaterialIndex < mesh->m_materials.size())
+                    {
+                        Material& material = mesh->m_materials[subMesh.MaterialIndex];
+                        UINT end = std::min(subMesh.StartIndex + subMesh.PrimCount * 3, static_cast<UINT>(ib.size()));
+                        for (UINT j = subMesh.StartIndex; j < end; j++)
+                        {
+                            const Vertex& v = vb[ib[j]];
+                            material.UVMin[0] = std::min(material.UVMin[0], v.u);
+                            material.UVMin[1] = std::min(material.UVMin[1], v.v);
+                            material.UVMax[0] = std::max(material.UVMax[0], v.u);
+                            material.UVMax[1] = std::max(material.UVMax[1], v.v);
+                        }
+                    }
+
                     for (UINT j = 0; j < ib.size(); j += 3)
                     {
                         Vertex& v0 = vb[ib[j]];
@@ -1900,12 +2375,12 @@ namespace VSD3DStarter
                 // read skinning vertex buffers
                 //
                 UINT numSkinningVertexBuffers = 0;
-                fread(&numSkinningVertexBuffers, sizeof(UINT), 1, fp);
+                file.Read(&numSkinningVertexBuffers, sizeof(UINT), 1);
                 mesh->m_skinningVertexBuffers.resize(numSkinningVertexBuffers);
                 for (UINT i = 0; i < numSkinningVertexBuffers; i++)
                 {
                     UINT vbCount = 0;
-                    fread (&vbCount, sizeof(UINT), 1, fp);
+                    file.Read(&vbCount, sizeof(UINT), 1);
                     if (vbCount > 0)
                     {
                         std::vector<SkinningVertex> verts(vbCount);
@@ -1914,7 +2389,7 @@ namespace VSD3DStarter
                         //
                         // read in the vertex data
                         //
-                        fread(&verts[0], sizeof(SkinningVertex), vbCount, fp);
+                        file.Read(&verts[0], sizeof(SkinningVertex), vbCount);
 
                         //
                         // convert indices to byte (to support D3D Feature Level 9)
@@ -1949,7 +2424,7 @@ namespace VSD3DStarter
                 //
                 // read extents
                 //
-                fread(&mesh->m_meshExtents, sizeof(MeshExtents), 1, fp);
+                file.Read(&mesh->m_meshExtents, sizeof(MeshExtents), 1);
 
                 //
                 // do we need to read bones and animation?
@@ -1960,7 +2435,7 @@ namespace VSD3DStarter
                     // read bones
                     //
                     UINT boneCount = 0;
-                    fread(&boneCount, sizeof(UINT), 1, fp);
+                    file.Read(&boneCount, sizeof(UINT), 1);
 
                     mesh->m_boneInfo.resize(boneCount);
 
@@ -1968,52 +2443,52 @@ namespace VSD3DStarter
                     {
                         // read the bone name (length, then chars)
                         UINT nameLength = 0;
-                        fread(&nameLength, sizeof(UINT), 1, fp);
+                        file.Read(&nameLength, sizeof(UINT), 1);
 
                         if (nameLength > 0)
                         {
                             std::vector<wchar_t> nameVec(nameLength);
-                            fread(&nameVec[0], sizeof(wchar_t), nameLength, fp);
+                            file.Read(&nameVec[0], sizeof(wchar_t), nameLength);
 
                             mesh->m_boneInfo[b].Name = &nameVec[0];
                         }
 
                         // read the transforms
-                        fread(&mesh->m_boneInfo[b].ParentIndex, sizeof(INT), 1, fp);
-                        fread(&mesh->m_boneInfo[b].InvBindPos, sizeof(DirectX::XMFLOAT4X4), 1, fp);
-                        fread(&mesh->m_boneInfo[b].BindPose, sizeof(DirectX::XMFLOAT4X4), 1, fp);
-                        fread(&mesh->m_boneInfo[b].BoneLocalTransform, sizeof(DirectX::XMFLOAT4X4), 1, fp);                    
+                        file.Read(&mesh->m_boneInfo[b].ParentIndex, sizeof(INT), 1);
+                        file.Read(&mesh->m_boneInfo[b].InvBindPos, sizeof(DirectX::XMFLOAT4X4), 1);
+                        file.Read(&mesh->m_boneInfo[b].BindPose, sizeof(DirectX::XMFLOAT4X4), 1);
+                        file.Read(&mesh->m_boneInfo[b].BoneLocalTransform, sizeof(DirectX::XMFLOAT4X4), 1);                    
                     }
 
                     //
                     // read animation clips
                     //
                     UINT clipCount = 0;
-                    fread(&clipCount, sizeof(UINT), 1, fp);
+                    file.Read(&clipCount, sizeof(UINT), 1);
 
                     for (UINT j = 0; j < clipCount; j++)
                     {
                         // read clip name
                         UINT len = 0;
-                        fread(&len, sizeof(UINT), 1, fp);
+                        file.Read(&len, sizeof(UINT), 1);
 
                         std::wstring clipName;
                         if (len > 0)
                         {
                             std::vector<wchar_t> clipNameVec(len);
-                            fread(&clipNameVec[0], sizeof(wchar_t), len, fp);
+                            file.Read(&clipNameVec[0], sizeof(wchar_t), len);
 
                             clipName = &clipNameVec[0];
                         }
 
-                        fread(&mesh->m_animationClips[clipName].StartTime, sizeof(float), 1, fp);
-                        fread(&mesh->m_animationClips[clipName].EndTime, sizeof(float), 1, fp);
+                        file.Read(&mesh->m_animationClips[clipName].StartTime, sizeof(float), 1);
+                        file.Read(&mesh->m_animationClips[clipName].EndTime, sizeof(float), 1);
 
                         KeyframeArray& keyframes = mesh->m_animationClips[clipName].Keyframes;
 
                         // read keyframecount
                         UINT kfCount = 0;
-                        fread(&kfCount, sizeof(UINT), 1, fp);
+                        file.Read(&kfCount, sizeof(UINT), 1);
 
                         // preallocate the memory
                         keyframes.reserve(kfCount);
@@ -2024,13 +2499,13 @@ namespace VSD3DStarter
                             Keyframe kf;
 
                             // read the bone
-                            fread(&kf.BoneIndex, sizeof(UINT), 1, fp);
+                            file.Read(&kf.BoneIndex, sizeof(UINT), 1);
 
                             // read the time
-                            fread(&kf.Time, sizeof(UINT), 1, fp);
+                            file.Read(&kf.Time, sizeof(UINT), 1);
 
                             // read the transform
-                            fread(&kf.Transform, sizeof(DirectX::XMFLOAT4X4), 1, fp);
+                            file.Read(&kf.Transform, sizeof(DirectX::XMFLOAT4X4), 1);
 
                             // add to collection
                             keyframes.push_back(kf);
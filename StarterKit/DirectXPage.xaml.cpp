@@ -58,9 +58,8 @@ DirectXPage::DirectXPage()
 
 	m_eventToken = CompositionTarget::Rendering::add(ref new EventHandler<Object^>(this, &DirectXPage::OnRendering));
 
-	m_timer = ref new BasicTimer();
-
 	m_renderer->Pause(true);
+	m_renderer->StartSimulation();
 }
 
 void DirectXPage::OnWindowSizeChanged(CoreWindow^ sender, WindowSizeChangedEventArgs^ args)
@@ -85,19 +84,18 @@ void DirectXPage::OnDisplayContentsInvalidated(Object^ sender)
 
 void DirectXPage::OnRendering(Object^ sender, Object^ args)
 {
-	m_timer->Update();
-	m_renderer->Update(m_timer->Total, m_timer->Delta);
+	// the simulation runs on its own thread; this only draws its latest state
 	m_renderer->Render();
 	m_renderer->Present();
 	if (m_renderer->GameFinished())
 	{
 		m_renderer->GameFinished(false);
-		m_timer = ref new BasicTimer();
+		m_renderer->ResetSimulationClock();
 	}
 	if (m_renderer->GameStarted())
 	{
 		m_renderer->GameStarted(false);
-		m_timer = ref new BasicTimer();
+		m_renderer->ResetSimulationClock();
 	}
 }
 
@@ -171,6 +169,7 @@ void MoonLander::DirectXPage::Exit_Click(Platform::Object^ sender, Windows::UI::
 	this->MenuButtons->Visibility = Windows::UI::Xaml::Visibility::Collapsed;
 	m_renderer->GameStarted(false);
 	m_renderer->Pause(false);
+	m_renderer->StopSimulation();
 	Application::Current->Exit();
 }
 
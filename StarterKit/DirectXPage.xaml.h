@@ -13,7 +13,6 @@
 
 #include "DirectXPage.g.h"
 #include "..\Shared\Game.h"
-#include "..\Shared\BasicTimer.h"
 
 namespace MoonLander
 {
@@ -44,7 +43,6 @@ namespace MoonLander
 
         Game^ m_renderer;
                 
-        BasicTimer^ m_timer;
 		void Button_Click(Platform::Object^ sender, Windows::UI::Xaml::RoutedEventArgs^ e);
 		void New_Game_Click(Platform::Object^ sender, Windows::UI::Xaml::RoutedEventArgs^ e);
 		void Exit_Click(Platform::Object^ sender, Windows::UI::Xaml::RoutedEventArgs^ e);